@@ -1,10 +1,11 @@
 #!/bin/bash
 #   Build the qprop library for Windows, Linux and macOS (ARM64)
 #   Requires Zig (https://ziglang.org/) to be in $PATH.
+#   Multithreading is enabled with -DQPROP_THREADS (remove it for a single-threaded build).
 
-zig cc ../src/qprop.c -o ./qprop-portable/qprop-lib-windows-x64.dll -shared -target x86_64-windows-gnu -lm -fPIC -O2 -Wall -Wextra
-zig cc ../src/qprop.c -o ./qprop-portable/qprop-lib-linux-x64.so -shared -target x86_64-linux-gnu -lm -fPIC -O2 -Wall -Wextra
-zig cc ../src/qprop.c -o ./qprop-portable/qprop-lib-macos-arm64.dylib -shared -target aarch64-macos -lm -fPIC -O2 -Wall -Wextra
+zig cc ../src/qprop.c -o ./qprop-portable/qprop-lib-windows-x64.dll -shared -target x86_64-windows-gnu -DQPROP_THREADS -lm -fPIC -O2 -Wall -Wextra
+zig cc ../src/qprop.c -o ./qprop-portable/qprop-lib-linux-x64.so -shared -target x86_64-linux-gnu -DQPROP_THREADS -lm -lpthread -fPIC -O2 -Wall -Wextra
+zig cc ../src/qprop.c -o ./qprop-portable/qprop-lib-macos-arm64.dylib -shared -target aarch64-macos -DQPROP_THREADS -lm -lpthread -fPIC -O2 -Wall -Wextra
 
 rm ./qprop-portable/qprop.lib
 rm ./qprop-portable/qprop-lib-windows-x64.pdb
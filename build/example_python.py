@@ -96,7 +96,7 @@ def main():
 
     #run qprop.c
     results = qprop.qprop(myrotor, Uinf, Ω)
-    for i in range(nsections):
+    for i in range(results.nelems):
         if abs(results.residuals[i]) > 1e-6:
             print("ERROR while running qprop: convergence not reached in one or more elements")
             break
@@ -70,7 +70,7 @@ def main():
     results = qprop.qprop(myrotor, Uinf, Ω)
 
     #check convergence
-    for i in range(nsections):
+    for i in range(results.nelems):
         if abs(results.residuals[i]) > 1e-6:
             print("ERROR while running qprop: convergence not reached in one or more elements")
             break
@@ -12,7 +12,23 @@ module QProp
 export Polar, Airfoil, Section, Rotor, RotorPerformance,
        deg2rad, read_xfoil_polar_from_file, import_xfoil_polars,
        analytic_polar_curves, import_rotor_geometry_apc,
-       import_rotor_geometry_uiuc, refine_rotor_sections, qprop;
+       import_rotor_geometry_uiuc, refine_rotor_sections, qprop,
+       QPROP_SPACING_UNIFORM, QPROP_SPACING_COSINE, QPROP_SPACING_TIP,
+       refine_rotor_sections_adaptive,
+       QPropOptions, QPROP_SOLVER_BISECTION, QPROP_SOLVER_BRENT,
+       qprop_default_options, qprop_ex,
+       PreparedRotor, prepare_rotor, RotorPerformanceBuffer,
+       alloc_rotor_performance, qprop_into!, qprop_batch,
+       QPROP_OK, QPROP_ERROR_MEMORY, QPROP_ERROR_INVALID_ARGUMENT,
+       QPROP_ERROR_FILE, QPROP_ERROR_NOT_CONVERGED,
+       QPropStats, stats_enabled, single_precision, fast_math, qprop_with_gradients,
+       qprop_trim, QPROP_TRIM_THRUST, QPROP_TRIM_TORQUE, QPROP_TRIM_POWER,
+       QPROP_TRIM_OMEGA, QPROP_TRIM_PITCH,
+       QPropCache, QPropCacheStats, alloc_qprop_cache, qprop_cache_attach, qprop_cached!, qprop_cache_stats,
+       RotorMap, RotorMapPoint, generate_rotor_map, lookup_rotor_map,
+       save_rotor_map_binary, load_rotor_map_binary, qprop_fleet,
+       QPropSink, QPROP_SINK_CSV, QPROP_SINK_BINARY, open_qprop_sink, qprop_sink_write,
+       close_qprop_sink, qprop_stream, read_qprop_sink;
 
 #import precompiled shared library for the current operating system
 lib_filename = "";
@@ -51,6 +67,7 @@ struct CPolar
     CL_ptr::Ptr{Cdouble}
     CD_ptr::Ptr{Cdouble}
     size::Cint
+    dalpha::Cdouble
 end
 struct Polar
     Re::Float64
@@ -64,6 +81,8 @@ end
 struct CAirfoil
     polars_ptr::Ptr{Ptr{CPolar}}
     size::Cint
+    compiled_ptr::Ptr{Cvoid}
+    refcount::Cint
 end
 struct Airfoil
     polars::Vector{Polar}
@@ -75,7 +94,7 @@ struct CSection
     c::Cdouble
     beta::Cdouble
     r::Cdouble
-    airfoil::CAirfoil
+    airfoil::Cint
 end
 
 struct CRotor
@@ -83,8 +102,18 @@ struct CRotor
     B::Cint
     nsections::Cint
     sections_ptr::Ptr{CSection}
+    airfoils_ptr::Ptr{Ptr{CAirfoil}}
+    nairfoils::Cint
+    elementairfoils_ptr::Ptr{Ptr{CAirfoil}}
 end
 
+#status codes reported by the library
+const QPROP_OK = Cint(0);
+const QPROP_ERROR_MEMORY = Cint(1);
+const QPROP_ERROR_INVALID_ARGUMENT = Cint(2);
+const QPROP_ERROR_FILE = Cint(3);
+const QPROP_ERROR_NOT_CONVERGED = Cint(4);
+
 struct CRotorPerformance
     T::Cdouble
     Q::Cdouble
@@ -100,6 +129,137 @@ struct CRotorPerformance
     dTdr_ptr::Ptr{Cdouble}
     dQdr_ptr::Ptr{Cdouble}
     nelems::Cint
+    nevals_ptr::Ptr{Cint}
+    converged_ptr::Ptr{Bool}
+    status::Cint
+end
+
+struct CRotorGradients
+    nsections::Cint
+    dTdc_ptr::Ptr{Cdouble}
+    dTdbeta_ptr::Ptr{Cdouble}
+    dQdc_ptr::Ptr{Cdouble}
+    dQdbeta_ptr::Ptr{Cdouble}
+    dTdUinf::Cdouble
+    dQdUinf::Cdouble
+    dTdOmega::Cdouble
+    dQdOmega::Cdouble
+end
+
+#root finding algorithms available for the blade element solution
+const QPROP_SOLVER_BISECTION = Cint(0);
+const QPROP_SOLVER_BRENT = Cint(1);
+
+#radial distributions of the sections available for the rotor refinement
+const QPROP_SPACING_UNIFORM = Cint(0);
+const QPROP_SPACING_COSINE = Cint(1);
+const QPROP_SPACING_TIP = Cint(2);
+
+#quantities matched and variables adjusted by the trim solver
+const QPROP_TRIM_THRUST = Cint(0);
+const QPROP_TRIM_TORQUE = Cint(1);
+const QPROP_TRIM_POWER = Cint(2);
+const QPROP_TRIM_OMEGA = Cint(0);
+const QPROP_TRIM_PITCH = Cint(1);
+
+#file formats of the streaming writers
+const QPROP_SINK_CSV = Cint(0);
+const QPROP_SINK_BINARY = Cint(1);
+
+#statistics of the analyses (collected only when the library is compiled with QPROP_STATS)
+mutable struct QPropStats
+    nelements::Clonglong
+    niterations::Clonglong
+    nevals::Clonglong
+    nalphaclamped::Clonglong
+    nReclamped::Clonglong
+    tsetup::Cdouble
+    tsolve::Cdouble
+    tintegrate::Cdouble
+end
+QPropStats() = QPropStats(0, 0, 0, 0, 0, 0.0, 0.0, 0.0);
+
+#counters of an operating point cache
+struct QPropCacheStats
+    hits::Clonglong
+    warmstarts::Clonglong
+    misses::Clonglong
+    evictions::Clonglong
+    entries::Cint
+end
+
+#operating point cache, freed by the garbage collector
+mutable struct QPropCache
+    ptr::Ptr{Cvoid}
+end
+
+#streaming writer of the results, closed by close_qprop_sink or by the garbage collector
+mutable struct QPropSink
+    ptr::Ptr{Cvoid}
+end
+
+#mirror of the C data structure of a performance map
+struct CRotorMap
+    nJ::Cint
+    nOmega::Cint
+    J::Ptr{Cdouble}
+    Omega::Ptr{Cdouble}
+    CTCP::Ptr{Cdouble}
+    dJ::Cdouble
+    dOmega::Cdouble
+    D::Cdouble
+    rho::Cdouble
+    mu::Cdouble
+    a::Cdouble
+    errCT::Cdouble
+    errCP::Cdouble
+    nfailed::Cint
+    mapping::Ptr{Cvoid}
+    mapsize::Csize_t
+end
+
+#performance map, freed by the garbage collector
+mutable struct RotorMap
+    ptr::Ptr{CRotorMap}
+    J::Vector{Float64}
+    Omega::Vector{Float64}
+    D::Float64
+    errCT::Float64
+    errCP::Float64
+    nfailed::Int
+end
+
+#output of a performance map lookup
+struct RotorMapPoint
+    T::Cdouble
+    Q::Cdouble
+    CT::Cdouble
+    CP::Cdouble
+    J::Cdouble
+    inside::Bool
+end
+
+#mirror of the C data structure of the results of a fleet analysis
+struct CFleetResults
+    nrotors::Cint
+    npoints::Cint
+    T::Ptr{Cdouble}
+    Q::Ptr{Cdouble}
+    CT::Ptr{Cdouble}
+    CP::Ptr{Cdouble}
+    J::Ptr{Cdouble}
+    converged::Ptr{Bool}
+    nairfoils::Cint
+    nfailed::Cint
+end
+
+#data structure for qprop_ex options
+struct QPropOptions
+    tol::Cdouble
+    itmax::Cint
+    solver::Cint
+    nthreads::Cint
+    stats::Ptr{QPropStats}
 end
 
 
@@ -121,6 +281,39 @@ struct Rotor
     sections::Vector{Section}
 end
 
+#rotor converted once to C format: the polars are shared with the Julia vectors
+#and the C structures are kept alive by this object, so it can be analyzed repeatedly
+mutable struct PreparedRotor
+    rotor::Rotor
+    crotor::Base.RefValue{CRotor}
+    csections::Vector{CSection}
+    cairfoils::Vector{CAirfoil}
+    cairfoils_ptr::Vector{Ptr{CAirfoil}}
+    cpolars::Vector{Vector{CPolar}}
+    cpolars_ptr::Vector{Vector{Ptr{CPolar}}}
+end
+
+#qprop output whose arrays are written directly by qprop_into!, without copies
+mutable struct RotorPerformanceBuffer
+    T::Float64
+    Q::Float64
+    CT::Float64
+    CP::Float64
+    J::Float64
+    residuals::Vector{Float64}
+    Gamma::Vector{Float64}
+    lambdaw::Vector{Float64}
+    r::Vector{Float64}
+    W::Vector{Float64}
+    phi::Vector{Float64}
+    dTdr::Vector{Float64}
+    dQdr::Vector{Float64}
+    nelems::Int
+    nevals::Vector{Cint}
+    converged::Vector{Bool}
+    status::Cint
+end
+
 struct RotorPerformance
     T::Float64
     Q::Float64
@@ -136,6 +329,9 @@ struct RotorPerformance
     dTdr::Vector{Float64}
     dQdr::Vector{Float64}
     nelems::Int
+    nevals::Vector{Int}
+    converged::Vector{Bool}
+    status::Int
 end
 
 
@@ -269,17 +465,20 @@ end
 function airfoil2cairfoil(airfoil::Airfoil)
     cpolars_ptr = Vector{Ptr{CPolar}}(undef, airfoil.size);
     cpolars = Vector{CPolar}(undef, airfoil.size);
+    order = sortperm([airfoil.polars[i].Re for i=1:airfoil.size]);     #qprop expects polars sorted by Re
     for i=1:airfoil.size
+        polar = airfoil.polars[order[i]];
         cpolars[i] = CPolar(
-            airfoil.polars[i].Re,
-            pointer(airfoil.polars[i].alpha),
-            pointer(airfoil.polars[i].CL),
-            pointer(airfoil.polars[i].CD),
-            airfoil.polars[i].size
+            polar.Re,
+            pointer(polar.alpha),
+            pointer(polar.CL),
+            pointer(polar.CD),
+            polar.size,
+            0.0                             #alpha spacing not checked (binary search)
         );
         cpolars_ptr[i] = pointer(cpolars, i);
     end
-    cairfoil = CAirfoil(pointer(cpolars_ptr), airfoil.size);
+    cairfoil = CAirfoil(pointer(cpolars_ptr), airfoil.size, C_NULL, 0);   #not compiled, managed by Julia
     return cairfoil;
 end
 
@@ -404,14 +603,14 @@ Example:
 """
 function import_rotor_geometry_apc(filename::String, airfoil::Airfoil)
     #convert airfoil to C format
-    cairfoil = airfoil2cairfoil(airfoil);
+    cairfoil = Ref(airfoil2cairfoil(airfoil));
 
     #get rotor in C format
     crotor_ptr = ccall(
         (:import_rotor_geometry_apc, lib_filename),     #C function
         Ptr{CRotor},                                    #return type
         (Ptr{UInt8}, Ptr{CAirfoil}),                    #parameters types
-        filename, Ref(cairfoil)                         #parameters
+        filename, cairfoil                              #parameters
     );
     if crotor_ptr == C_NULL
         error("ERROR in import_rotor_geometry_apc(): failed to read geometry from file");
@@ -419,19 +618,7 @@ function import_rotor_geometry_apc(filename::String, airfoil::Airfoil)
     crotor = unsafe_load(crotor_ptr);
 
     #convert to Julia format
-    newrotor = Rotor(crotor.D, crotor.B, crotor.nsections, Vector{Section}(undef, crotor.nsections));
-    for i=1:crotor.nsections
-        #extract i-th section in C format
-        csecti = unsafe_load(crotor.sections_ptr, i);
-
-        #convert i-th section to Julia format
-        newrotor.sections[i] = Section(
-            csecti.c,
-            csecti.beta,
-            csecti.r,
-            cairfoil2airfoil(csecti.airfoil)
-        );
-    end
+    newrotor = GC.@preserve cairfoil crotor2rotor(crotor);
 
     #clean memory
     free_rotor(crotor_ptr);
@@ -457,14 +644,14 @@ Example:
 """
 function import_rotor_geometry_uiuc(filename::String, airfoil::Airfoil, D::Float64, B::Int)
     #convert airfoil to C format
-    cairfoil = airfoil2cairfoil(airfoil);
+    cairfoil = Ref(airfoil2cairfoil(airfoil));
 
     #get rotor in C format
     crotor_ptr = ccall(
         (:import_rotor_geometry_uiuc, lib_filename),    #C function
         Ptr{CRotor},                                    #return type
         (Ptr{UInt8}, Ptr{CAirfoil}, Float64, Int),      #parameters types
-        filename, Ref(cairfoil), D, B                   #parameters
+        filename, cairfoil, D, B                        #parameters
     );
     if crotor_ptr == C_NULL
         error("ERROR in import_rotor_geometry_uiuc(): failed to read geometry from file");
@@ -472,19 +659,7 @@ function import_rotor_geometry_uiuc(filename::String, airfoil::Airfoil, D::Float
     crotor = unsafe_load(crotor_ptr);
 
     #convert to Julia format
-    newrotor = Rotor(crotor.D, crotor.B, crotor.nsections, Vector{Section}(undef, crotor.nsections));
-    for i=1:crotor.nsections
-        #extract i-th section in C format
-        csecti = unsafe_load(crotor.sections_ptr, i);
-
-        #convert i-th section to Julia format
-        newrotor.sections[i] = Section(
-            csecti.c,
-            csecti.beta,
-            csecti.r,
-            cairfoil2airfoil(csecti.airfoil)
-        );
-    end
+    newrotor = GC.@preserve cairfoil crotor2rotor(crotor);
 
     #clean memory
     free_rotor(crotor_ptr);
@@ -494,10 +669,11 @@ end
 
 """
 REFINE_ROTOR_SECTIONS creates a propeller geometry with the specified number
-of equally-spaced sections
+of sections
 Input:
     - oldrotor (Rotor): reference rotor geometry
-    - nsections: desired number of equally-spaced sections
+    - nsections: desired number of sections
+    - spacing: radial distribution of the sections (default: QPROP_SPACING_UNIFORM)
 Output:
     - (Rotor): refined rotor geometry
 Example:
@@ -505,47 +681,69 @@ Example:
     myairfoil = import_xfoil_polars(airfoil_filenames);
     reference_rotor = import_rotor_geometry_uiuc("apcsf_10x7_geom.txt", myairfoil, 10*0.0254, 2);
     myrotor = refine_rotor_sections(reference_rotor, 100);
+    tiprotor = refine_rotor_sections(reference_rotor, 40, QPROP_SPACING_TIP);
 """
-function refine_rotor_sections(oldrotor::Rotor, nsections::Int)
+function refine_rotor_sections(oldrotor::Rotor, nsections::Int, spacing::Integer=QPROP_SPACING_UNIFORM)
     #convert rotor in C format
-    coldsections = Vector{CSection}(undef, oldrotor.nsections);
-    for i=1:oldrotor.nsections
-        coldsections[i] = CSection(
-            oldrotor.sections[i].c,
-            oldrotor.sections[i].beta,
-            oldrotor.sections[i].r,
-            airfoil2cairfoil(oldrotor.sections[i].airfoil)
-        );
-    end
-    coldrotor = CRotor(oldrotor.D, oldrotor.B, oldrotor.nsections, pointer(coldsections));
+    coldrotor, coldsections, coldairfoils, coldairfoils_ptr = rotor2crotor(oldrotor);
 
     #get output in C format
-    cnewrotor_ptr = ccall(
-        (:refine_rotor_sections, lib_filename),             #C function
+    cnewrotor_ptr = GC.@preserve coldsections coldairfoils coldairfoils_ptr ccall(
+        (:refine_rotor_sections_ex, lib_filename),          #C function
         Ptr{CRotor},                                        #return type
-        (Ptr{CRotor}, Int),                                 #parameters types
-        Ref(coldrotor), nsections                           #parameters
+        (Ptr{CRotor}, Cint, Cint),                          #parameters types
+        Ref(coldrotor), nsections, spacing                  #parameters
     );
     if cnewrotor_ptr == C_NULL
         error("ERROR in refine_rotor_sections(): failed to discretize geometry");
     end
     cnewrotor = unsafe_load(cnewrotor_ptr);
 
-    #convert to Julia format
-    newrotor = Rotor(cnewrotor.D, cnewrotor.B, cnewrotor.nsections, Vector{Section}(undef, cnewrotor.nsections));
-    for i=1:cnewrotor.nsections
-        #extract i-th section in C format
-        csecti = unsafe_load(cnewrotor.sections_ptr, i);
+    #convert to Julia format (the new rotor shares the airfoil table of the old one)
+    newrotor = GC.@preserve coldairfoils coldairfoils_ptr crotor2rotor(cnewrotor);
+    
+    #clean memory
+    free_rotor(cnewrotor_ptr);
+    return newrotor;
+end
 
-        #convert i-th section to Julia format
-        newrotor.sections[i] = Section(
-            csecti.c,
-            csecti.beta,
-            csecti.r,
-            cairfoil2airfoil(csecti.airfoil)
-        );
+
+"""
+REFINE_ROTOR_SECTIONS_ADAPTIVE creates a propeller geometry with sections added
+only where the thrust distribution changes sharply at the given operating point
+Input:
+    - oldrotor (Rotor): reference rotor geometry
+    - Uinf: freestream velocity in m/s
+    - Omega: rotor speed in rad/s
+    - rho: air density in kg/m3 (default: 1.225)
+    - mu: air dynamic viscosity in Pa-s (default: 1.81e-5)
+    - a: speed of sound in m/s (default: 0.0) - set to 0 to disable Mach correction
+    - tol: relative tolerance on the thrust and torque (default: 1e-3)
+    - maxsections: maximum number of sections (default: 200)
+    - options (QPropOptions): solver options (default: qprop_default_options())
+Output:
+    - (Rotor): refined rotor geometry
+"""
+function refine_rotor_sections_adaptive(oldrotor::Rotor, Uinf::Float64, Omega::Float64, rho::Float64=1.225, mu::Float64=1.81e-5, a::Float64=0.0,
+                                        tol::Float64=1e-3, maxsections::Int=200, options::QPropOptions=qprop_default_options())
+    #convert rotor in C format
+    coldrotor, coldsections, coldairfoils, coldairfoils_ptr = rotor2crotor(oldrotor);
+
+    #get output in C format
+    cnewrotor_ptr = GC.@preserve coldsections coldairfoils coldairfoils_ptr ccall(
+        (:refine_rotor_sections_adaptive, lib_filename),                                                #C function
+        Ptr{CRotor},                                                                                    #return type
+        (Ptr{CRotor}, Float64, Float64, Float64, Float64, Float64, Float64, Cint, Ptr{QPropOptions}),   #parameters types
+        Ref(coldrotor), Uinf, Omega, rho, mu, a, tol, maxsections, Ref(options)                         #parameters
+    );
+    if cnewrotor_ptr == C_NULL
+        error("ERROR in refine_rotor_sections_adaptive(): failed to discretize geometry");
     end
-    
+    cnewrotor = unsafe_load(cnewrotor_ptr);
+
+    #convert to Julia format (the new rotor shares the airfoil table of the old one)
+    newrotor = GC.@preserve coldairfoils coldairfoils_ptr crotor2rotor(cnewrotor);
+
     #clean memory
     free_rotor(cnewrotor_ptr);
     return newrotor;
@@ -570,6 +768,66 @@ function free_rotor_performance(perf::Ptr{CRotorPerformance})
 end
 
 
+#convert CRotorPerformance to RotorPerformance
+function cperf2perf(cperf::CRotorPerformance)
+    residuals = [unsafe_load(cperf.residuals_ptr, i) for i=1:cperf.nelems];
+    Gamma = [unsafe_load(cperf.Gamma_ptr, i) for i=1:cperf.nelems];
+    lambdaw = [unsafe_load(cperf.lambdaw_ptr, i) for i=1:cperf.nelems];
+    r = [unsafe_load(cperf.r_ptr, i) for i=1:cperf.nelems];
+    W = [unsafe_load(cperf.W_ptr, i) for i=1:cperf.nelems];
+    phi = [unsafe_load(cperf.phi_ptr, i) for i=1:cperf.nelems];
+    dTdr = [unsafe_load(cperf.dTdr_ptr, i) for i=1:cperf.nelems];
+    dQdr = [unsafe_load(cperf.dQdr_ptr, i) for i=1:cperf.nelems];
+    nevals = [Int(unsafe_load(cperf.nevals_ptr, i)) for i=1:cperf.nelems];
+    converged = [unsafe_load(cperf.converged_ptr, i) for i=1:cperf.nelems];
+    return RotorPerformance(cperf.T, cperf.Q, cperf.CT, cperf.CP, cperf.J, residuals, Gamma, lambdaw, r, W, phi, dTdr, dQdr, cperf.nelems, nevals, converged, Int(cperf.status));
+end
+
+
+#convert Rotor to CRotor, with a table of the distinct airfoils of the sections
+#NOTE: the returned arrays must be kept alive (e.g. with GC.@preserve) while crotor is used
+function rotor2crotor(rotor::Rotor)
+    airfoils = Airfoil[];
+    csections = Vector{CSection}(undef, rotor.nsections);
+    for i=1:rotor.nsections
+        k = findfirst(airfoil -> airfoil === rotor.sections[i].airfoil, airfoils);
+        if isnothing(k)
+            push!(airfoils, rotor.sections[i].airfoil);
+            k = length(airfoils);
+        end
+        csections[i] = CSection(
+            rotor.sections[i].c,
+            rotor.sections[i].beta,
+            rotor.sections[i].r,
+            k-1                             #0-based index in the airfoil table
+        );
+    end
+    cairfoils = [airfoil2cairfoil(airfoil) for airfoil in airfoils];
+    cairfoils_ptr = [pointer(cairfoils, k) for k=1:length(cairfoils)];
+    crotor = CRotor(rotor.D, rotor.B, rotor.nsections, pointer(csections), pointer(cairfoils_ptr), length(cairfoils), C_NULL);
+    return crotor, csections, cairfoils, cairfoils_ptr;
+end
+
+#convert CRotor to Rotor
+function crotor2rotor(crotor::CRotor)
+    airfoils = [cairfoil2airfoil(unsafe_load(unsafe_load(crotor.airfoils_ptr, k))) for k=1:crotor.nairfoils];
+    newrotor = Rotor(crotor.D, crotor.B, crotor.nsections, Vector{Section}(undef, crotor.nsections));
+    for i=1:crotor.nsections
+        #extract i-th section in C format
+        csecti = unsafe_load(crotor.sections_ptr, i);
+
+        #convert i-th section to Julia format
+        newrotor.sections[i] = Section(
+            csecti.c,
+            csecti.beta,
+            csecti.r,
+            airfoils[csecti.airfoil+1]
+        );
+    end
+    return newrotor;
+end
+
+
 """
 QPROP runs the QProp algorithm as described by Drela for each blade element
 Input:
@@ -586,22 +844,15 @@ Output:
 Notes:
     - the current implementation assumes that there is no externally-induced
       tangential velocity (Ut = 0)
+    - when some blade elements do not converge, the outputs are returned anyway
+      with status QPROP_ERROR_NOT_CONVERGED and the flags of the elements in converged
 """
 function qprop(rotor::Rotor, Uinf::Float64, Omega::Float64, tol::Float64=1e-6, itmax::Int=100, rho::Float64=1.225, mu::Float64=1.81e-5, a::Float64=0.0)
     #convert rotor in C format
-    csections = Vector{CSection}(undef, rotor.nsections);
-    for i=1:rotor.nsections
-        csections[i] = CSection(
-            rotor.sections[i].c,
-            rotor.sections[i].beta,
-            rotor.sections[i].r,
-            airfoil2cairfoil(rotor.sections[i].airfoil)
-        );
-    end
-    crotor = CRotor(rotor.D, rotor.B, rotor.nsections, pointer(csections));
+    crotor, csections, cairfoils, cairfoils_ptr = rotor2crotor(rotor);
 
     #get output in C format
-    cperf_ptr = ccall(
+    cperf_ptr = GC.@preserve csections cairfoils cairfoils_ptr ccall(
         (:qprop, lib_filename),                                                     #C function
         Ptr{CRotorPerformance},                                                     #return type
         (Ptr{CRotor}, Float64, Float64, Float64, Int, Float64, Float64, Float64),   #parameters types
@@ -610,22 +861,799 @@ function qprop(rotor::Rotor, Uinf::Float64, Omega::Float64, tol::Float64=1e-6, i
     if cperf_ptr == C_NULL
         error("ERROR in qprop(): failed to run qprop iterations");
     end
-    cperf = unsafe_load(cperf_ptr);
+    perf = cperf2perf(unsafe_load(cperf_ptr));
 
-    #convert to Julia format
-    residuals = [unsafe_load(cperf.residuals_ptr, i) for i=1:cperf.nelems];
-    Gamma = [unsafe_load(cperf.Gamma_ptr, i) for i=1:cperf.nelems];
-    lambdaw = [unsafe_load(cperf.lambdaw_ptr, i) for i=1:cperf.nelems];
-    r = [unsafe_load(cperf.r_ptr, i) for i=1:cperf.nelems];
-    W = [unsafe_load(cperf.W_ptr, i) for i=1:cperf.nelems];
-    phi = [unsafe_load(cperf.phi_ptr, i) for i=1:cperf.nelems];
-    dTdr = [unsafe_load(cperf.dTdr_ptr, i) for i=1:cperf.nelems];
-    dQdr = [unsafe_load(cperf.dQdr_ptr, i) for i=1:cperf.nelems];
-    perf = RotorPerformance(cperf.T, cperf.Q, cperf.CT, cperf.CP, cperf.J, residuals, Gamma, lambdaw, r, W, phi, dTdr, dQdr, cperf.nelems);
+    #clean memory
+    free_rotor_performance(cperf_ptr);
+    return perf;
+end
+
+
+"""
+QPROP_DEFAULT_OPTIONS returns the default options for qprop_ex
+Input:
+    - none
+Output:
+    - (QPropOptions): default options (tol=1e-6, itmax=100, Brent's method, 1 thread)
+"""
+function qprop_default_options()
+    return ccall(
+        (:qprop_default_options, lib_filename),     #C function
+        QPropOptions,                               #return type
+        (),                                         #parameters types
+    );
+end
+
+
+"""
+STATS_ENABLED checks whether the library collects the statistics of the analyses
+Input:
+    - none
+Output:
+    - (Bool): true if the library is compiled with QPROP_STATS defined
+Notes:
+    - to collect the statistics, point options.stats to a zeroed QPropStats:
+      stats = QPropStats(); options = QPropOptions(1e-6, 100, QPROP_SOLVER_BRENT, 1, pointer_from_objref(stats))
+    - the QPropStats object must be preserved (GC.@preserve) while the options are in use
+"""
+function stats_enabled()
+    return ccall(
+        (:qprop_stats_enabled, lib_filename),       #C function
+        Bool,                                       #return type
+        (),                                         #parameters types
+    );
+end
+
+
+"""
+SINGLE_PRECISION checks whether the library uses single precision in the solver kernels
+Input:
+    - none
+Output:
+    - (Bool): true if the library is compiled with QPROP_SINGLE_PRECISION defined
+Notes:
+    - the roots are refined in double precision, so the results meet the same tolerance
+"""
+function single_precision()
+    return ccall(
+        (:qprop_single_precision, lib_filename),    #C function
+        Bool,                                       #return type
+        (),                                         #parameters types
+    );
+end
+
+
+"""
+FAST_MATH checks whether the residual functions use fast approximations of sin, cos, atan, exp and acos
+Input:
+    - none
+Output:
+    - (Bool): true if the library is compiled with QPROP_FAST_MATH defined
+Notes:
+    - the maximum errors of the approximations are below 1e-13, well below the solver tolerance
+"""
+function fast_math()
+    return ccall(
+        (:qprop_fast_math, lib_filename),           #C function
+        Bool,                                       #return type
+        (),                                         #parameters types
+    );
+end
+
+
+"""
+QPROP_EX runs the QProp algorithm with user-defined options
+Input:
+    - rotor (Rotor): struct containing the rotor data
+    - Uinf: freestream velocity in m/s
+    - Omega: rotor speed in rad/s
+    - rho: air density in kg/m3 (default value: 1.225)
+    - mu: air dynamic viscosity in Pa-s (default value: 1.81e-5)
+    - a: speed of sound in m/s (default value: 0.0) - set to 0 to disable Mach correction
+    - options (QPropOptions): solver options (default value: qprop_default_options())
+Output:
+    - (RotorPerformance): data structure containing the QProp outputs
+Notes:
+    - the number of residual evaluations used by each element is stored in
+      the output array nevals
+"""
+function qprop_ex(rotor::Rotor, Uinf::Float64, Omega::Float64, rho::Float64=1.225, mu::Float64=1.81e-5, a::Float64=0.0, options::QPropOptions=qprop_default_options())
+    #convert rotor in C format
+    crotor, csections, cairfoils, cairfoils_ptr = rotor2crotor(rotor);
+
+    #get output in C format
+    cperf_ptr = GC.@preserve csections cairfoils cairfoils_ptr ccall(
+        (:qprop_ex, lib_filename),                                                              #C function
+        Ptr{CRotorPerformance},                                                                 #return type
+        (Ptr{CRotor}, Float64, Float64, Float64, Float64, Float64, Ptr{QPropOptions}),          #parameters types
+        Ref(crotor), Uinf, Omega, rho, mu, a, Ref(options)                                      #parameters
+    );
+    if cperf_ptr == C_NULL
+        error("ERROR in qprop_ex(): failed to run qprop iterations");
+    end
+    perf = cperf2perf(unsafe_load(cperf_ptr));
 
     #clean memory
     free_rotor_performance(cperf_ptr);
     return perf;
 end
 
+
+"""
+PREPARE_ROTOR converts a rotor to C format once, to analyze it repeatedly
+without conversions
+Input:
+    - rotor (Rotor): struct containing the rotor data
+Output:
+    - (PreparedRotor): rotor in C format, to be used with qprop_ex and qprop_into!
+Notes:
+    - the C polars point to the vectors of the Julia polars without copies:
+      changes to their values are seen by the following analyses
+"""
+function prepare_rotor(rotor::Rotor)
+    airfoils = Airfoil[];
+    csections = Vector{CSection}(undef, rotor.nsections);
+    for i=1:rotor.nsections
+        k = findfirst(airfoil -> airfoil === rotor.sections[i].airfoil, airfoils);
+        if isnothing(k)
+            push!(airfoils, rotor.sections[i].airfoil);
+            k = length(airfoils);
+        end
+        csections[i] = CSection(rotor.sections[i].c, rotor.sections[i].beta, rotor.sections[i].r, k-1);
+    end
+    cpolars = Vector{Vector{CPolar}}(undef, length(airfoils));
+    cpolars_ptr = Vector{Vector{Ptr{CPolar}}}(undef, length(airfoils));
+    cairfoils = Vector{CAirfoil}(undef, length(airfoils));
+    for k=1:length(airfoils)
+        airfoil = airfoils[k];
+        order = sortperm([airfoil.polars[i].Re for i=1:airfoil.size]);     #qprop expects polars sorted by Re
+        cpolars[k] = [CPolar(polar.Re, pointer(polar.alpha), pointer(polar.CL), pointer(polar.CD), polar.size, 0.0) for polar in airfoil.polars[order]];
+        cpolars_ptr[k] = [pointer(cpolars[k], i) for i=1:airfoil.size];
+        cairfoils[k] = CAirfoil(pointer(cpolars_ptr[k]), airfoil.size, C_NULL, 0);     #not compiled, managed by Julia
+    end
+    cairfoils_ptr = [pointer(cairfoils, k) for k=1:length(cairfoils)];
+    crotor = Ref(CRotor(rotor.D, rotor.B, rotor.nsections, pointer(csections), pointer(cairfoils_ptr), length(cairfoils), C_NULL));
+    return PreparedRotor(rotor, crotor, csections, cairfoils, cairfoils_ptr, cpolars, cpolars_ptr);
+end
+
+
+"""
+QPROP_EX runs the QProp algorithm on a prepared rotor, without converting it
+"""
+function qprop_ex(prepared::PreparedRotor, Uinf::Float64, Omega::Float64, rho::Float64=1.225, mu::Float64=1.81e-5, a::Float64=0.0, options::QPropOptions=qprop_default_options())
+    cperf_ptr = GC.@preserve prepared ccall(
+        (:qprop_ex, lib_filename),                                                              #C function
+        Ptr{CRotorPerformance},                                                                 #return type
+        (Ptr{CRotor}, Float64, Float64, Float64, Float64, Float64, Ptr{QPropOptions}),          #parameters types
+        prepared.crotor, Uinf, Omega, rho, mu, a, Ref(options)                                  #parameters
+    );
+    if cperf_ptr == C_NULL
+        error("ERROR in qprop_ex(): failed to run qprop iterations");
+    end
+    perf = cperf2perf(unsafe_load(cperf_ptr));
+    free_rotor_performance(cperf_ptr);
+    return perf;
+end
+
+
+"""
+ALLOC_ROTOR_PERFORMANCE allocates a qprop output to be filled by qprop_into!
+Input:
+    - rotor (Rotor or PreparedRotor): rotor to be analyzed
+Output:
+    - (RotorPerformanceBuffer): output with one entry per blade element
+Notes:
+    - the arrays are ordinary Julia vectors, released by the garbage collector
+"""
+function alloc_rotor_performance(rotor::Union{Rotor,PreparedRotor})
+    nelems = (rotor isa PreparedRotor ? rotor.rotor.nsections : rotor.nsections) - 1;
+    return RotorPerformanceBuffer(0.0, 0.0, 0.0, 0.0, 0.0,
+        zeros(nelems), zeros(nelems), zeros(nelems), zeros(nelems),
+        zeros(nelems), zeros(nelems), zeros(nelems), zeros(nelems),
+        nelems, zeros(Cint, nelems), zeros(Bool, nelems), QPROP_OK);
+end
+
+
+"""
+QPROP_INTO! runs the QProp algorithm and stores the results in a previously allocated output
+Input:
+    - perf (RotorPerformanceBuffer): output allocated by alloc_rotor_performance
+    - prepared (PreparedRotor): rotor converted by prepare_rotor
+    - Uinf: freestream velocity in m/s
+    - Omega: rotor speed in rad/s
+    - rho: air density in kg/m3 (default value: 1.225)
+    - mu: air dynamic viscosity in Pa-s (default value: 1.81e-5)
+    - a: speed of sound in m/s (default value: 0.0) - set to 0 to disable Mach correction
+    - options (QPropOptions): solver options (default value: qprop_default_options())
+Output:
+    - (Bool): true if all the blade elements converged
+Notes:
+    - the C solver writes the per-element results directly into the vectors of perf:
+      neither the rotor nor the results are converted or copied
+"""
+function qprop_into!(perf::RotorPerformanceBuffer, prepared::PreparedRotor, Uinf::Float64, Omega::Float64, rho::Float64=1.225, mu::Float64=1.81e-5, a::Float64=0.0, options::QPropOptions=qprop_default_options())
+    cperf = Ref(CRotorPerformance(0.0, 0.0, 0.0, 0.0, 0.0,
+        pointer(perf.residuals), pointer(perf.Gamma), pointer(perf.lambdaw), pointer(perf.r),
+        pointer(perf.W), pointer(perf.phi), pointer(perf.dTdr), pointer(perf.dQdr),
+        perf.nelems, pointer(perf.nevals), pointer(perf.converged), QPROP_OK));
+    converged = GC.@preserve perf prepared ccall(
+        (:qprop_into, lib_filename),                                                                                #C function
+        Bool,                                                                                                       #return type
+        (Ptr{CRotorPerformance}, Ptr{CRotor}, Float64, Float64, Float64, Float64, Float64, Ptr{QPropOptions}),     #parameters types
+        cperf, prepared.crotor, Uinf, Omega, rho, mu, a, Ref(options)                                               #parameters
+    );
+    perf.T = cperf[].T;
+    perf.Q = cperf[].Q;
+    perf.CT = cperf[].CT;
+    perf.CP = cperf[].CP;
+    perf.J = cperf[].J;
+    perf.status = cperf[].status;
+    return converged;
+end
+
+
+"""
+QPROP_BATCH runs the QProp algorithm over a batch of operating points with a single call
+Input:
+    - rotor (Rotor or PreparedRotor): rotor to be analyzed
+    - Uinf: freestream velocities in m/s (number or array)
+    - Omega: rotor speeds in rad/s (number or array)
+    - rho: air densities in kg/m3 (default value: 1.225)
+    - mu: air dynamic viscosities in Pa-s (default value: 1.81e-5)
+    - a: speed of sound in m/s (default value: 0.0) - set to 0 to disable Mach correction
+    - options (QPropOptions): solver options (default value: qprop_default_options())
+Output:
+    - (NamedTuple): arrays T, Q, CT, CP, J and converged, with the broadcast shape of the inputs
+Notes:
+    - Uinf, Omega, rho and mu are broadcast together, like in qprop.(rotor, Uinf, Omega)
+    - the whole batch is solved by one C call
+Example:
+    results = qprop_batch(myrotor, range(0.0, 10.0, length=10000), 6000*pi/30);
+"""
+function qprop_batch(rotor::Union{Rotor,PreparedRotor}, Uinf, Omega, rho=1.225, mu=1.81e-5, a::Float64=0.0, options::QPropOptions=qprop_default_options())
+    prepared = (rotor isa PreparedRotor) ? rotor : prepare_rotor(rotor);
+    points = broadcast(tuple, Uinf, Omega, rho, mu);
+    if points isa Tuple
+        points = fill(points);          #single operating point (0-dimensional array)
+    end
+    Uinfs = Float64[p[1] for p in points];
+    Omegas = Float64[p[2] for p in points];
+    rhos = Float64[p[3] for p in points];
+    mus = Float64[p[4] for p in points];
+    npoints = length(Uinfs);
+    T = Vector{Float64}(undef, npoints);
+    Q = Vector{Float64}(undef, npoints);
+    CT = Vector{Float64}(undef, npoints);
+    CP = Vector{Float64}(undef, npoints);
+    J = Vector{Float64}(undef, npoints);
+    converged = zeros(Bool, npoints);
+    GC.@preserve prepared ccall(
+        (:qprop_batch, lib_filename),                                                                   #C function
+        Bool,                                                                                           #return type
+        (Ptr{CRotor}, Cint, Ptr{Float64}, Ptr{Float64}, Ptr{Float64}, Ptr{Float64}, Float64, Ptr{QPropOptions},
+         Ptr{Float64}, Ptr{Float64}, Ptr{Float64}, Ptr{Float64}, Ptr{Float64}, Ptr{Bool}),             #parameters types
+        prepared.crotor, npoints, Uinfs, Omegas, rhos, mus, a, Ref(options),
+        T, Q, CT, CP, J, converged                                                                      #parameters
+    );
+    dims = size(points);
+    return (T=reshape(T, dims), Q=reshape(Q, dims), CT=reshape(CT, dims), CP=reshape(CP, dims), J=reshape(J, dims), converged=reshape(converged, dims));
+end
+
+
+"""
+QPROP_WITH_GRADIENTS runs the QProp algorithm and computes the derivatives of thrust and torque
+Input:
+    - rotor (Rotor or PreparedRotor): rotor to be analyzed
+    - Uinf: freestream velocity in m/s
+    - Omega: rotor speed in rad/s
+    - rho: air density in kg/m3 (default value: 1.225)
+    - mu: air dynamic viscosity in Pa-s (default value: 1.81e-5)
+    - a: speed of sound in m/s (default value: 0.0) - set to 0 to disable Mach correction
+    - options (QPropOptions): solver options (default value: qprop_default_options())
+Output:
+    - (RotorPerformance): struct containing the QProp outputs
+    - (NamedTuple): vectors dTdc, dTdbeta, dQdc, dQdbeta (one entry per section) and
+      the scalars dTdUinf, dQdUinf, dTdOmega, dQdOmega
+Notes:
+    - the derivatives are computed analytically by the C library, at the cost of
+      about one residual evaluation per element
+"""
+function qprop_with_gradients(rotor::Union{Rotor,PreparedRotor}, Uinf::Float64, Omega::Float64, rho::Float64=1.225, mu::Float64=1.81e-5, a::Float64=0.0, options::QPropOptions=qprop_default_options())
+    prepared = (rotor isa PreparedRotor) ? rotor : prepare_rotor(rotor);
+    nsections = prepared.rotor.nsections;
+    dTdc = zeros(nsections);
+    dTdbeta = zeros(nsections);
+    dQdc = zeros(nsections);
+    dQdbeta = zeros(nsections);
+    cgradients = Ref(CRotorGradients(nsections, pointer(dTdc), pointer(dTdbeta), pointer(dQdc), pointer(dQdbeta), 0.0, 0.0, 0.0, 0.0));
+    cperf_ptr = GC.@preserve prepared dTdc dTdbeta dQdc dQdbeta ccall(
+        (:qprop_with_gradients, lib_filename),                                                                      #C function
+        Ptr{CRotorPerformance},                                                                                     #return type
+        (Ptr{CRotor}, Float64, Float64, Float64, Float64, Float64, Ptr{QPropOptions}, Ptr{CRotorGradients}),       #parameters types
+        prepared.crotor, Uinf, Omega, rho, mu, a, Ref(options), cgradients                                          #parameters
+    );
+    if cperf_ptr == C_NULL
+        error("ERROR in qprop_with_gradients(): failed to run qprop iterations");
+    end
+    perf = cperf2perf(unsafe_load(cperf_ptr));
+    free_rotor_performance(cperf_ptr);
+    gradients = (dTdc=dTdc, dTdbeta=dTdbeta, dQdc=dQdc, dQdbeta=dQdbeta,
+                 dTdUinf=cgradients[].dTdUinf, dQdUinf=cgradients[].dQdUinf,
+                 dTdOmega=cgradients[].dTdOmega, dQdOmega=cgradients[].dQdOmega);
+    return perf, gradients;
+end
+
+
+"""
+QPROP_TRIM finds the rotor speed or the collective pitch that gives a target thrust, torque or power
+Input:
+    - rotor (Rotor or PreparedRotor): rotor to be analyzed
+    - Uinf: freestream velocity in m/s
+    - Omega: rotor speed in rad/s - initial guess when variable is QPROP_TRIM_OMEGA
+    - target: QPROP_TRIM_THRUST, QPROP_TRIM_TORQUE or QPROP_TRIM_POWER
+    - value: required thrust (N), torque (N-m) or power (W)
+    - variable: QPROP_TRIM_OMEGA or QPROP_TRIM_PITCH (default value: QPROP_TRIM_OMEGA)
+    - rho: air density in kg/m3 (default value: 1.225)
+    - mu: air dynamic viscosity in Pa-s (default value: 1.81e-5)
+    - a: speed of sound in m/s (default value: 0.0) - set to 0 to disable Mach correction
+    - options (QPropOptions): solver options (default value: qprop_default_options())
+Output:
+    - (RotorPerformance): struct containing the QProp outputs at the trimmed point
+    - (Float64): trimmed rotor speed (rad/s) or collective pitch offset (rad)
+Notes:
+    - if the trim does not converge, status is QPROP_ERROR_NOT_CONVERGED
+"""
+function qprop_trim(rotor::Union{Rotor,PreparedRotor}, Uinf::Float64, Omega::Float64, target::Integer, value::Float64, variable::Integer=QPROP_TRIM_OMEGA,
+                    rho::Float64=1.225, mu::Float64=1.81e-5, a::Float64=0.0, options::QPropOptions=qprop_default_options())
+    prepared = (rotor isa PreparedRotor) ? rotor : prepare_rotor(rotor);
+    trimmed = Ref{Cdouble}(0.0);
+    cperf_ptr = GC.@preserve prepared ccall(
+        (:qprop_trim, lib_filename),                                                                                  #C function
+        Ptr{CRotorPerformance},                                                                                       #return type
+        (Ptr{CRotor}, Float64, Float64, Float64, Float64, Float64, Ptr{QPropOptions}, Cint, Float64, Cint, Ptr{Cdouble}),  #parameters types
+        prepared.crotor, Uinf, Omega, rho, mu, a, Ref(options), target, value, variable, trimmed                     #parameters
+    );
+    if cperf_ptr == C_NULL
+        error("ERROR in qprop_trim(): invalid arguments or memory allocation error");
+    end
+    perf = cperf2perf(unsafe_load(cperf_ptr));
+    free_rotor_performance(cperf_ptr);
+    return perf, trimmed[];
+end
+
+
+"""
+ALLOC_QPROP_CACHE allocates a cache of operating points, to be used by qprop_cached!
+Input:
+    - capacity: maximum number of cached operating points (default value: 1024)
+    - resolution: relative resolution of the operating conditions considered close
+      to each other (default value: 1e-3) - set to 0 to reuse only identical conditions
+    - distributions: if true, the per-element distributions are cached too (default value: false)
+Output:
+    - (QPropCache): cache, freed automatically by the garbage collector
+"""
+function alloc_qprop_cache(capacity::Integer=1024, resolution::Float64=1e-3, distributions::Bool=false)
+    ptr = ccall(
+        (:alloc_qprop_cache, lib_filename),         #C function
+        Ptr{Cvoid},                                 #return type
+        (Cint, Float64, Bool),                      #parameters types
+        capacity, resolution, distributions         #parameters
+    );
+    if ptr == C_NULL
+        error("ERROR in alloc_qprop_cache(): invalid arguments or memory allocation error");
+    end
+    cache = QPropCache(ptr);
+    finalizer(cache) do c
+        ccall((:free_qprop_cache, lib_filename), Cvoid, (Ptr{Cvoid},), c.ptr);
+        c.ptr = C_NULL;
+    end
+    return cache;
+end
+
+
+"""
+QPROP_CACHE_ATTACH computes the key identifying a rotor in an operating point cache
+Input:
+    - cache (QPropCache): cache allocated by alloc_qprop_cache
+    - prepared (PreparedRotor): rotor converted by prepare_rotor
+Output:
+    - (UInt64): key of the rotor, to be passed to qprop_cached!
+Notes:
+    - the key must be computed again after the rotor or its airfoils are modified
+"""
+function qprop_cache_attach(cache::QPropCache, prepared::PreparedRotor)
+    key = GC.@preserve cache prepared ccall(
+        (:qprop_cache_attach, lib_filename),        #C function
+        UInt64,                                     #return type
+        (Ptr{Cvoid}, Ptr{CRotor}),                  #parameters types
+        cache.ptr, prepared.crotor                  #parameters
+    );
+    if key == 0
+        error("ERROR in qprop_cache_attach(): invalid arguments");
+    end
+    return key;
+end
+
+
+"""
+QPROP_CACHED! runs the QProp algorithm through an operating point cache
+Input:
+    - perf (RotorPerformanceBuffer): output allocated by alloc_rotor_performance
+    - cache (QPropCache): cache allocated by alloc_qprop_cache
+    - key (UInt64): key of the rotor returned by qprop_cache_attach
+    - prepared (PreparedRotor): rotor converted by prepare_rotor
+    - Uinf: freestream velocity in m/s
+    - Omega: rotor speed in rad/s
+    - rho: air density in kg/m3 (default value: 1.225)
+    - mu: air dynamic viscosity in Pa-s (default value: 1.81e-5)
+    - a: speed of sound in m/s (default value: 0.0) - set to 0 to disable Mach correction
+    - options (QPropOptions): solver options (default value: qprop_default_options())
+Output:
+    - (Bool): true if all the blade elements converged
+Notes:
+    - identical operating points are copied from the cache, close ones are warm started
+"""
+function qprop_cached!(perf::RotorPerformanceBuffer, cache::QPropCache, key::UInt64, prepared::PreparedRotor, Uinf::Float64, Omega::Float64, rho::Float64=1.225, mu::Float64=1.81e-5, a::Float64=0.0, options::QPropOptions=qprop_default_options())
+    cperf = Ref(CRotorPerformance(0.0, 0.0, 0.0, 0.0, 0.0,
+        pointer(perf.residuals), pointer(perf.Gamma), pointer(perf.lambdaw), pointer(perf.r),
+        pointer(perf.W), pointer(perf.phi), pointer(perf.dTdr), pointer(perf.dQdr),
+        perf.nelems, pointer(perf.nevals), pointer(perf.converged), QPROP_OK));
+    converged = GC.@preserve perf cache prepared ccall(
+        (:qprop_cached, lib_filename),                                                                                                #C function
+        Bool,                                                                                                                         #return type
+        (Ptr{Cvoid}, UInt64, Ptr{CRotorPerformance}, Ptr{CRotor}, Float64, Float64, Float64, Float64, Float64, Ptr{QPropOptions}),    #parameters types
+        cache.ptr, key, cperf, prepared.crotor, Uinf, Omega, rho, mu, a, Ref(options)                                                 #parameters
+    );
+    perf.T = cperf[].T;
+    perf.Q = cperf[].Q;
+    perf.CT = cperf[].CT;
+    perf.CP = cperf[].CP;
+    perf.J = cperf[].J;
+    perf.status = cperf[].status;
+    return converged;
+end
+
+
+"""
+QPROP_CACHE_STATS returns the counters of an operating point cache
+Input:
+    - cache (QPropCache): cache allocated by alloc_qprop_cache
+Output:
+    - (QPropCacheStats): hits, warmstarts, misses, evictions and entries
+"""
+function qprop_cache_stats(cache::QPropCache)
+    return GC.@preserve cache ccall(
+        (:qprop_cache_stats, lib_filename),         #C function
+        QPropCacheStats,                            #return type
+        (Ptr{Cvoid},),                              #parameters types
+        cache.ptr                                   #parameters
+    );
+end
+
+#wrap a C performance map and register its finalizer
+function wrap_rotor_map(ptr::Ptr{CRotorMap})
+    cmap = unsafe_load(ptr);
+    rotormap = RotorMap(ptr,
+        copy(unsafe_wrap(Array, cmap.J, cmap.nJ)),
+        copy(unsafe_wrap(Array, cmap.Omega, cmap.nOmega)),
+        cmap.D, cmap.errCT, cmap.errCP, cmap.nfailed);
+    finalizer(rotormap) do m
+        ccall((:free_rotor_map, lib_filename), Cvoid, (Ptr{CRotorMap},), m.ptr);
+        m.ptr = C_NULL;
+    end
+    return rotormap;
+end
+
+
+"""
+GENERATE_ROTOR_MAP computes a performance map of a rotor on a grid of advance ratios and rotor speeds
+Input:
+    - rotor (Rotor or PreparedRotor): rotor to be analyzed
+    - J (Vector{Float64}): advance ratios in strictly ascending order (at least 2)
+    - Omega (Vector{Float64}): rotor speeds in rad/s, positive and in strictly ascending order (at least 2)
+    - rho: air density in kg/m3 (default value: 1.225)
+    - mu: air dynamic viscosity in Pa-s (default value: 1.81e-5)
+    - a: speed of sound in m/s (default value: 0.0) - set to 0 to disable Mach correction
+    - options (QPropOptions): solver options (default value: qprop_default_options())
+Output:
+    - (RotorMap): performance map, freed automatically by the garbage collector
+"""
+function generate_rotor_map(rotor::Union{Rotor,PreparedRotor}, J::Vector{Float64}, Omega::Vector{Float64}, rho::Float64=1.225, mu::Float64=1.81e-5, a::Float64=0.0, options::QPropOptions=qprop_default_options())
+    prepared = (rotor isa PreparedRotor) ? rotor : prepare_rotor(rotor);
+    ptr = GC.@preserve prepared ccall(
+        (:generate_rotor_map, lib_filename),                                                            #C function
+        Ptr{CRotorMap},                                                                                 #return type
+        (Ptr{CRotor}, Ptr{Float64}, Cint, Ptr{Float64}, Cint, Float64, Float64, Float64, Ptr{QPropOptions}),   #parameters types
+        prepared.crotor, J, length(J), Omega, length(Omega), rho, mu, a, Ref(options)                   #parameters
+    );
+    if ptr == C_NULL
+        error("ERROR in generate_rotor_map(): invalid arguments or memory allocation error");
+    end
+    return wrap_rotor_map(ptr);
+end
+
+
+"""
+LOOKUP_ROTOR_MAP interpolates a performance map
+Input:
+    - rotormap (RotorMap): performance map
+    - Uinf: freestream velocity in m/s
+    - Omega: rotor speed in rad/s
+    - rho: air density in kg/m3 (default value: 1.225)
+Output:
+    - (RotorMapPoint): T, Q, CT, CP and J at the operating point, and inside=false
+      if the query was clamped to the edges of the map
+"""
+function lookup_rotor_map(rotormap::RotorMap, Uinf::Float64, Omega::Float64, rho::Float64=1.225)
+    return GC.@preserve rotormap ccall(
+        (:lookup_rotor_map, lib_filename),                          #C function
+        RotorMapPoint,                                              #return type
+        (Ptr{CRotorMap}, Float64, Float64, Float64),                #parameters types
+        rotormap.ptr, Uinf, Omega, rho                              #parameters
+    );
+end
+
+
+"""
+SAVE_ROTOR_MAP_BINARY saves a performance map in a compact binary file
+Input:
+    - rotormap (RotorMap): performance map
+    - filename (String): name of the binary file to be written
+Output:
+    - (Bool): true if the file was written successfully
+"""
+function save_rotor_map_binary(rotormap::RotorMap, filename::String)
+    return GC.@preserve rotormap ccall(
+        (:save_rotor_map_binary, lib_filename),     #C function
+        Bool,                                       #return type
+        (Ptr{CRotorMap}, Ptr{UInt8}),               #parameters types
+        rotormap.ptr, filename                      #parameters
+    );
+end
+
+
+"""
+LOAD_ROTOR_MAP_BINARY loads a performance map from a binary file written by save_rotor_map_binary
+Input:
+    - filename (String): name of the binary file
+Output:
+    - (RotorMap): performance map (memory-mapped), freed automatically by the garbage collector
+"""
+function load_rotor_map_binary(filename::String)
+    ptr = ccall(
+        (:load_rotor_map_binary, lib_filename),     #C function
+        Ptr{CRotorMap},                             #return type
+        (Ptr{UInt8},),                              #parameters types
+        filename                                    #parameters
+    );
+    if ptr == C_NULL
+        error("ERROR in load_rotor_map_binary(): unable to load " * filename);
+    end
+    return wrap_rotor_map(ptr);
+end
+
+
+"""
+QPROP_FLEET runs the QProp algorithm for multiple rotors at the same operating points
+Input:
+    - rotors (Vector of Rotor or PreparedRotor): rotors to be analyzed, e.g. a catalog of propellers
+    - Uinf: freestream velocities in m/s (scalar or array)
+    - Omega: rotor speeds in rad/s (scalar or array)
+    - rho: air densities in kg/m3 (default value: 1.225)
+    - mu: air dynamic viscosities in Pa-s (default value: 1.81e-5)
+    - a: speed of sound in m/s (default value: 0.0) - set to 0 to disable Mach correction
+    - options (QPropOptions): solver options (default value: qprop_default_options())
+Output:
+    - (NamedTuple): matrices T, Q, CT, CP, J and converged, with one row per rotor and one
+      column per operating point, and the counters nairfoils (distinct airfoils shared by
+      the rotors) and nfailed (points that did not converge)
+Notes:
+    - the results are the same as calling qprop_batch for each rotor
+"""
+function qprop_fleet(rotors::AbstractVector, Uinf, Omega, rho=1.225, mu=1.81e-5, a::Float64=0.0, options::QPropOptions=qprop_default_options())
+    prepared = [(rotor isa PreparedRotor) ? rotor : prepare_rotor(rotor) for rotor in rotors];
+    points = broadcast(tuple, Uinf, Omega, rho, mu);
+    if points isa Tuple
+        points = fill(points);          #single operating point (0-dimensional array)
+    end
+    Uinfs = Float64[p[1] for p in points];
+    Omegas = Float64[p[2] for p in points];
+    rhos = Float64[p[3] for p in points];
+    mus = Float64[p[4] for p in points];
+    npoints = length(Uinfs);
+    nrotors = length(prepared);
+    ptr = GC.@preserve prepared begin
+        crotors = Ptr{CRotor}[Base.unsafe_convert(Ptr{CRotor}, p.crotor) for p in prepared];
+        ccall(
+            (:qprop_fleet, lib_filename),                                                               #C function
+            Ptr{CFleetResults},                                                                         #return type
+            (Ptr{Ptr{CRotor}}, Cint, Cint, Ptr{Float64}, Ptr{Float64}, Ptr{Float64}, Ptr{Float64},
+             Float64, Ptr{QPropOptions}),                                                               #parameters types
+            crotors, nrotors, npoints, Uinfs, Omegas, rhos, mus, a, Ref(options)                        #parameters
+        );
+    end
+    if ptr == C_NULL
+        error("ERROR in qprop_fleet(): invalid arguments or memory allocation error");
+    end
+    #the C columns store the points of each rotor contiguously
+    results = unsafe_load(ptr);
+    rows(column) = permutedims(reshape(copy(unsafe_wrap(Array, column, nrotors*npoints)), npoints, nrotors));
+    outputs = (T=rows(results.T), Q=rows(results.Q), CT=rows(results.CT), CP=rows(results.CP), J=rows(results.J),
+               converged=rows(results.converged), nairfoils=Int(results.nairfoils), nfailed=Int(results.nfailed));
+    ccall(
+        (:free_fleet_results, lib_filename),        #C function
+        Cvoid,                                      #return type
+        (Ptr{CFleetResults},),                      #parameters types
+        ptr                                         #parameters
+    );
+    return outputs;
+end
+
+
+
+"""
+OPEN_QPROP_SINK opens a file where the results of many operating points are streamed
+Input:
+    - filename (String): name of the file to be written
+    - format: QPROP_SINK_CSV or QPROP_SINK_BINARY (default value: QPROP_SINK_BINARY)
+    - nelems: number of blade elements of the distributions r, W, phi, Gamma, dTdr and dQdr
+      (default value: 0) - set to 0 to write only the totals
+    - batchsize: number of points buffered in memory before they are written (default value: 1024)
+Output:
+    - (QPropSink): sink, to be closed with close_qprop_sink to complete the file
+Notes:
+    - the CSV files can be loaded with CSV.jl, the binary files with read_qprop_sink
+"""
+function open_qprop_sink(filename::String, format::Integer=QPROP_SINK_BINARY, nelems::Integer=0, batchsize::Integer=1024)
+    ptr = ccall(
+        (:open_qprop_sink, lib_filename),           #C function
+        Ptr{Cvoid},                                 #return type
+        (Ptr{UInt8}, Cint, Cint, Cint),             #parameters types
+        filename, format, nelems, batchsize         #parameters
+    );
+    if ptr == C_NULL
+        error("ERROR in open_qprop_sink(): invalid arguments or unable to write " * filename);
+    end
+    sink = QPropSink(ptr);
+    finalizer(close_qprop_sink, sink);
+    return sink;
+end
+
+
+"""
+QPROP_SINK_WRITE writes the results of one operating point to a sink
+Input:
+    - sink (QPropSink): sink opened by open_qprop_sink
+    - perf (RotorPerformanceBuffer): output filled by qprop_into! or qprop_cached!
+    - Uinf: freestream velocity of the point in m/s
+    - Omega: rotor speed of the point in rad/s
+Output:
+    - (Bool): false if the arguments are not valid or if the file could not be written
+"""
+function qprop_sink_write(sink::QPropSink, perf::RotorPerformanceBuffer, Uinf::Float64, Omega::Float64)
+    cperf = Ref(CRotorPerformance(perf.T, perf.Q, perf.CT, perf.CP, perf.J,
+        pointer(perf.residuals), pointer(perf.Gamma), pointer(perf.lambdaw), pointer(perf.r),
+        pointer(perf.W), pointer(perf.phi), pointer(perf.dTdr), pointer(perf.dQdr),
+        perf.nelems, pointer(perf.nevals), pointer(perf.converged), perf.status));
+    return GC.@preserve perf sink ccall(
+        (:qprop_sink_write, lib_filename),                                      #C function
+        Bool,                                                                   #return type
+        (Ptr{Cvoid}, Ptr{CRotorPerformance}, Float64, Float64),                 #parameters types
+        sink.ptr, cperf, Uinf, Omega                                            #parameters
+    );
+end
+
+
+"""
+CLOSE_QPROP_SINK writes the buffered points of a sink, completes its file and frees the sink
+Input:
+    - sink (QPropSink): sink opened by open_qprop_sink
+Output:
+    - (Bool): true if all the points were written successfully
+"""
+function close_qprop_sink(sink::QPropSink)
+    if sink.ptr == C_NULL
+        return false;
+    end
+    success = ccall(
+        (:close_qprop_sink, lib_filename),          #C function
+        Bool,                                       #return type
+        (Ptr{Cvoid},),                              #parameters types
+        sink.ptr                                    #parameters
+    );
+    sink.ptr = C_NULL;
+    return success;
+end
+
+
+"""
+QPROP_STREAM runs the QProp algorithm over a batch of operating points, streaming the results to a sink
+Input:
+    - sink (QPropSink): sink opened by open_qprop_sink
+    - rotor (Rotor or PreparedRotor): rotor to be analyzed
+    - Uinf: freestream velocities in m/s (number or array)
+    - Omega: rotor speeds in rad/s (number or array)
+    - rho: air densities in kg/m3 (default value: 1.225)
+    - mu: air dynamic viscosities in Pa-s (default value: 1.81e-5)
+    - a: speed of sound in m/s (default value: 0.0) - set to 0 to disable Mach correction
+    - options (QPropOptions): solver options (default value: qprop_default_options())
+Output:
+    - (Bool): true if all the points converged and were written successfully
+Notes:
+    - the results are the same as qprop_batch, but only the buffer of the sink is kept in memory
+"""
+function qprop_stream(sink::QPropSink, rotor::Union{Rotor,PreparedRotor}, Uinf, Omega, rho=1.225, mu=1.81e-5, a::Float64=0.0, options::QPropOptions=qprop_default_options())
+    prepared = (rotor isa PreparedRotor) ? rotor : prepare_rotor(rotor);
+    points = broadcast(tuple, Uinf, Omega, rho, mu);
+    if points isa Tuple
+        points = fill(points);          #single operating point (0-dimensional array)
+    end
+    Uinfs = Float64[p[1] for p in points];
+    Omegas = Float64[p[2] for p in points];
+    rhos = Float64[p[3] for p in points];
+    mus = Float64[p[4] for p in points];
+    return GC.@preserve prepared sink ccall(
+        (:qprop_stream, lib_filename),                                                                  #C function
+        Bool,                                                                                           #return type
+        (Ptr{CRotor}, Cint, Ptr{Float64}, Ptr{Float64}, Ptr{Float64}, Ptr{Float64}, Float64, Ptr{QPropOptions},
+         Ptr{Cvoid}),                                                                                   #parameters types
+        prepared.crotor, length(Uinfs), Uinfs, Omegas, rhos, mus, a, Ref(options), sink.ptr              #parameters
+    );
+end
+
+
+"""
+READ_QPROP_SINK reads a binary file written by a sink (QPROP_SINK_BINARY)
+Input:
+    - filename (String): name of the binary file
+Output:
+    - (Dict{String,Any}): one entry per column: vectors Uinf, Omega, T, Q, CT, CP, J and converged,
+      and the distributions r, W, phi, Gamma, dTdr and dQdr (if written) as matrices with
+      one row per operating point and one column per blade element
+Notes:
+    - the file is read one record batch at a time, in little-endian order on all the machines
+"""
+function read_qprop_sink(filename::String)
+    return open(filename, "r") do fileio
+        magic = read(fileio, 8);
+        if length(magic) < 8 || magic != UInt8['Q', 'P', 'R', 'O', 'P', 'S', 'K', 0]
+            error("ERROR in read_qprop_sink(): " * filename * " is not a valid binary file");
+        end
+        version = ltoh(read(fileio, UInt32));
+        endianness = ltoh(read(fileio, UInt32));
+        nelems = ltoh(read(fileio, Int32));
+        ncolumns = ltoh(read(fileio, Int32));
+        if version != 1 || endianness != 0x01020304
+            error("ERROR in read_qprop_sink(): " * filename * " was written by an incompatible version");
+        end
+        seek(fileio, 64);
+        names = String[];
+        widths = Int[];
+        for c=1:ncolumns
+            name = read(fileio, 12);
+            push!(names, String(name[1:something(findfirst(==(0x00), name), 13)-1]));
+            push!(widths, ltoh(read(fileio, Int32)));
+        end
+        batches = Dict(name => Vector{Float64}[] for name in names);
+        while !eof(fileio)
+            nrows = ltoh(read(fileio, Int64));
+            for (name, width) in zip(names, widths)
+                values = Vector{Float64}(undef, nrows*width);
+                read!(fileio, values);
+                push!(batches[name], ltoh.(values));
+            end
+        end
+        columns = Dict{String,Any}();
+        for (name, width) in zip(names, widths)
+            values = reduce(vcat, batches[name]; init=Float64[]);
+            #the distributions of each point are contiguous, i.e. the rows of the matrix
+            columns[name] = (width == 1) ? values : permutedims(reshape(values, width, :));
+        end
+        if haskey(columns, "converged")
+            columns["converged"] = columns["converged"] .!= 0.0;
+        end
+        columns
+    end
+end
+
 end #module
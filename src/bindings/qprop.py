@@ -9,9 +9,17 @@
 #   Author: Andrea Pavan
 #   License: MIT
 #-------------------------------------------------------------------------------
+import array
 import ctypes
 import os
 import platform
+import struct
+import sys
+import weakref
+try:
+    import numpy                #optional: per-element results as NumPy arrays
+except ImportError:
+    numpy = None
 
 #import precompiled shared library for the current operating system
 lib_filename = ""
@@ -48,14 +56,17 @@ class Polar(ctypes.Structure):
         ("alpha", ctypes.POINTER(ctypes.c_double)),
         ("CL", ctypes.POINTER(ctypes.c_double)),
         ("CD", ctypes.POINTER(ctypes.c_double)),
-        ("size", ctypes.c_int)
+        ("size", ctypes.c_int),
+        ("dalpha", ctypes.c_double)
     ]
 
 # data structure for airfoils
 class Airfoil(ctypes.Structure):
     _fields_ = [
         ("polars", ctypes.POINTER(ctypes.POINTER(Polar))),
-        ("size", ctypes.c_int)
+        ("size", ctypes.c_int),
+        ("compiled", ctypes.c_void_p),
+        ("refcount", ctypes.c_int)
     ]
 
 # data structure for blade elements
@@ -64,7 +75,7 @@ class Section(ctypes.Structure):
         ("c", ctypes.c_double),
         ("beta", ctypes.c_double),
         ("r", ctypes.c_double),
-        ("airfoil", Airfoil)
+        ("airfoil", ctypes.c_int)
     ]
 
 # data structure for rotors
@@ -73,9 +84,22 @@ class Rotor(ctypes.Structure):
         ("D", ctypes.c_double),
         ("B", ctypes.c_int),
         ("nsections", ctypes.c_int),
-        ("sections", ctypes.POINTER(Section))
+        ("sections", ctypes.POINTER(Section)),
+        ("airfoils", ctypes.POINTER(ctypes.POINTER(Airfoil))),
+        ("nairfoils", ctypes.c_int),
+        ("elementairfoils", ctypes.POINTER(ctypes.POINTER(Airfoil)))
     ]
 
+# status codes reported by the library
+QPROP_OK = 0
+QPROP_ERROR_MEMORY = 1
+QPROP_ERROR_INVALID_ARGUMENT = 2
+QPROP_ERROR_FILE = 3
+QPROP_ERROR_NOT_CONVERGED = 4
+
+# user function receiving the messages of the library: callback(status, message, userdata)
+QPropLogCallback = ctypes.CFUNCTYPE(None, ctypes.c_int, ctypes.c_char_p, ctypes.c_void_p)
+
 # data structure for qprop output
 class RotorPerformance(ctypes.Structure):
     _fields_ = [
@@ -92,7 +116,120 @@ class RotorPerformance(ctypes.Structure):
         ("phi", ctypes.POINTER(ctypes.c_double)),
         ("dTdr", ctypes.POINTER(ctypes.c_double)),
         ("dQdr", ctypes.POINTER(ctypes.c_double)),
-        ("nelems", ctypes.c_int)
+        ("nelems", ctypes.c_int),
+        ("nevals", ctypes.POINTER(ctypes.c_int)),
+        ("converged", ctypes.POINTER(ctypes.c_bool)),
+        ("status", ctypes.c_int)
+    ]
+
+class RotorGradients(ctypes.Structure):
+    _fields_ = [
+        ("nsections", ctypes.c_int),
+        ("dTdc", ctypes.POINTER(ctypes.c_double)),
+        ("dTdbeta", ctypes.POINTER(ctypes.c_double)),
+        ("dQdc", ctypes.POINTER(ctypes.c_double)),
+        ("dQdbeta", ctypes.POINTER(ctypes.c_double)),
+        ("dTdUinf", ctypes.c_double),
+        ("dQdUinf", ctypes.c_double),
+        ("dTdOmega", ctypes.c_double),
+        ("dQdOmega", ctypes.c_double)
+    ]
+
+class RotorMap(ctypes.Structure):
+    _fields_ = [
+        ("nJ", ctypes.c_int),
+        ("nOmega", ctypes.c_int),
+        ("J", ctypes.POINTER(ctypes.c_double)),
+        ("Omega", ctypes.POINTER(ctypes.c_double)),
+        ("CTCP", ctypes.POINTER(ctypes.c_double)),
+        ("dJ", ctypes.c_double),
+        ("dOmega", ctypes.c_double),
+        ("D", ctypes.c_double),
+        ("rho", ctypes.c_double),
+        ("mu", ctypes.c_double),
+        ("a", ctypes.c_double),
+        ("errCT", ctypes.c_double),
+        ("errCP", ctypes.c_double),
+        ("nfailed", ctypes.c_int),
+        ("mapping", ctypes.c_void_p),
+        ("mapsize", ctypes.c_size_t)
+    ]
+
+class RotorMapPoint(ctypes.Structure):
+    _fields_ = [
+        ("T", ctypes.c_double),
+        ("Q", ctypes.c_double),
+        ("CT", ctypes.c_double),
+        ("CP", ctypes.c_double),
+        ("J", ctypes.c_double),
+        ("inside", ctypes.c_bool)
+    ]
+
+class FleetResults(ctypes.Structure):
+    _fields_ = [
+        ("nrotors", ctypes.c_int),
+        ("npoints", ctypes.c_int),
+        ("T", ctypes.POINTER(ctypes.c_double)),
+        ("Q", ctypes.POINTER(ctypes.c_double)),
+        ("CT", ctypes.POINTER(ctypes.c_double)),
+        ("CP", ctypes.POINTER(ctypes.c_double)),
+        ("J", ctypes.POINTER(ctypes.c_double)),
+        ("converged", ctypes.POINTER(ctypes.c_bool)),
+        ("nairfoils", ctypes.c_int),
+        ("nfailed", ctypes.c_int)
+    ]
+
+# root finding algorithms available for the blade element solution
+QPROP_SOLVER_BISECTION = 0
+QPROP_SOLVER_BRENT = 1
+
+# radial distributions of the sections available for the rotor refinement
+QPROP_SPACING_UNIFORM = 0
+QPROP_SPACING_COSINE = 1
+QPROP_SPACING_TIP = 2
+
+# quantities matched and variables adjusted by the trim solver
+QPROP_TRIM_THRUST = 0
+QPROP_TRIM_TORQUE = 1
+QPROP_TRIM_POWER = 2
+QPROP_TRIM_OMEGA = 0
+QPROP_TRIM_PITCH = 1
+
+# file formats of the streaming writers
+QPROP_SINK_CSV = 0
+QPROP_SINK_BINARY = 1
+
+# statistics of the analyses (collected only when the library is compiled with QPROP_STATS)
+class QPropStats(ctypes.Structure):
+    _fields_ = [
+        ("nelements", ctypes.c_longlong),
+        ("niterations", ctypes.c_longlong),
+        ("nevals", ctypes.c_longlong),
+        ("nalphaclamped", ctypes.c_longlong),
+        ("nReclamped", ctypes.c_longlong),
+        ("tsetup", ctypes.c_double),
+        ("tsolve", ctypes.c_double),
+        ("tintegrate", ctypes.c_double)
+    ]
+
+# counters of an operating point cache
+class QPropCacheStats(ctypes.Structure):
+    _fields_ = [
+        ("hits", ctypes.c_longlong),
+        ("warmstarts", ctypes.c_longlong),
+        ("misses", ctypes.c_longlong),
+        ("evictions", ctypes.c_longlong),
+        ("entries", ctypes.c_int)
+    ]
+
+# data structure for qprop_ex options
+class QPropOptions(ctypes.Structure):
+    _fields_ = [
+        ("tol", ctypes.c_double),
+        ("itmax", ctypes.c_int),
+        ("solver", ctypes.c_int),
+        ("nthreads", ctypes.c_int),
+        ("stats", ctypes.POINTER(QPropStats))
     ]
 
 
@@ -102,9 +239,32 @@ class RotorPerformance(ctypes.Structure):
 #----------------------------
 
 
+def double_buffer(values, size):
+    """
+    DOUBLE_BUFFER returns a C array of doubles sharing the memory of values when possible
+    Input:
+        - values: NumPy array, array.array("d"), or any sequence of numbers
+        - size: number of values
+    Output:
+        - (ctypes array): array of size doubles
+    Notes:
+        - writable, contiguous float64 buffers (NumPy arrays, array.array("d"))
+          are shared without copies: C reads and writes the same memory, and
+          the returned array keeps values alive
+        - other sequences are copied once in a single pass
+    """
+    try:
+        view = memoryview(values)
+        if view.format in ("d", "<d", "=d") and view.c_contiguous and not view.readonly and view.nbytes >= size*8:
+            return (ctypes.c_double * size).from_buffer(values)
+    except TypeError:
+        pass
+    return (ctypes.c_double * size).from_buffer(array.array("d", values[:size]))
+
+
 def create_polar(Re, alpha, CL, CD, size):
     """
-    CREATE_POLAR creates a Polar object from Python lists
+    CREATE_POLAR creates a Polar object from Python lists or NumPy arrays
     Input:
         - Re: Reynolds number
         - alpha: array of angle of attacks (rad)
@@ -113,13 +273,16 @@ def create_polar(Re, alpha, CL, CD, size):
         - size: number of points in the polar
     Output:
         - (Polar): data structure containing the polar data
+    Notes:
+        - float64 NumPy arrays are passed to C without copies (see double_buffer)
     """
     newpolar = Polar()
     newpolar.Re = Re
-    newpolar.alpha = (ctypes.c_double * size)(*alpha)
-    newpolar.CL = (ctypes.c_double * size)(*CL)
-    newpolar.CD = (ctypes.c_double * size)(*CD)
+    newpolar.alpha = double_buffer(alpha, size)
+    newpolar.CL = double_buffer(CL, size)
+    newpolar.CD = double_buffer(CD, size)
     newpolar.size = size
+    newpolar.dalpha = 0.0       # alpha spacing not checked (binary search)
     return newpolar
 
 
@@ -133,8 +296,12 @@ def create_airfoil(polars, size):
         - (Airfoil): data structure containing the specified airfoil polars
     """
     newairfoil = Airfoil()
-    newairfoil.polars = (Polar * size)(*polars)
+    polars = sorted(polars[:size], key=lambda polar: polar.Re)     # qprop expects polars sorted by Re
+    newairfoil.polars = (ctypes.POINTER(Polar) * size)(*[ctypes.pointer(polar) for polar in polars])
+    newairfoil.polar_objects = polars     # keep the polars alive as long as the airfoil
     newairfoil.size = size
+    newairfoil.compiled = None      # not compiled
+    newairfoil.refcount = 0         # managed by Python
     return newairfoil
 
 
@@ -153,7 +320,7 @@ def create_section(c, beta, r, airfoil):
     newsection.c = c
     newsection.beta = beta
     newsection.r = r
-    newsection.airfoil = airfoil
+    newsection.airfoil_object = airfoil       # the index in the airfoil table is set by create_rotor
     return newsection
 
 
@@ -173,6 +340,40 @@ def create_rotor(D, B, nsections, sections):
     newrotor.B = B
     newrotor.nsections = nsections
     newrotor.sections = (Section * nsections)(*sections)
+
+    # build the airfoil table, without duplicates
+    airfoils = []
+    for i in range(nsections):
+        airfoil = sections[i].airfoil_object
+        indices = [k for k in range(len(airfoils)) if ctypes.addressof(airfoils[k]) == ctypes.addressof(airfoil)]
+        if not indices:
+            airfoils.append(airfoil)
+            indices = [len(airfoils)-1]
+        newrotor.sections[i].airfoil = indices[0]
+    airfoil_pointers = [ctypes.pointer(airfoil) for airfoil in airfoils]
+
+    # blend the airfoils of the elements bounded by different airfoils once, like push_rotor_section,
+    # so that the analyses do not blend them at each call; the blends are released with the rotor
+    blends = {}
+    for i in range(nsections-1):
+        pair = (newrotor.sections[i].airfoil, newrotor.sections[i+1].airfoil)
+        if pair[0] != pair[1] and pair not in blends:
+            blended = lib.blend_airfoils(airfoil_pointers[pair[0]], airfoil_pointers[pair[1]], 0.5)
+            if not blended:
+                for other in blends.values():
+                    lib.free_airfoil(other)
+                raise MemoryError("ERROR in create_rotor(): unable to blend the airfoils of the rotor")
+            blends[pair] = blended
+    newrotor.elementairfoils = None
+    if blends:
+        elementairfoils = [blends.get((newrotor.sections[i].airfoil, newrotor.sections[i+1].airfoil),
+                                      airfoil_pointers[newrotor.sections[i+1].airfoil]) for i in range(nsections-1)]
+        newrotor.elementairfoils = (ctypes.POINTER(Airfoil) * (nsections-1))(*elementairfoils)
+        airfoil_pointers += list(blends.values())
+        weakref.finalize(newrotor, lambda blends: [lib.free_airfoil(blended) for blended in blends], list(blends.values()))
+    newrotor.airfoils = (ctypes.POINTER(Airfoil) * len(airfoil_pointers))(*airfoil_pointers)
+    newrotor.nairfoils = len(airfoil_pointers)
+    newrotor.airfoil_objects = airfoils     # keep the airfoils alive as long as the rotor
     return newrotor
 
 
@@ -269,6 +470,10 @@ def import_xfoil_polars(filenames):
     return lib.import_xfoil_polars(filenames_array, len(filenames)).contents
 
 
+lib.blend_airfoils.argtypes = [ctypes.POINTER(Airfoil), ctypes.POINTER(Airfoil), ctypes.c_double]
+lib.blend_airfoils.restype = ctypes.POINTER(Airfoil)
+
+
 lib.analytic_polar_curves.argtypes = [ctypes.c_double, ctypes.c_double, ctypes.c_double, ctypes.c_double,
                                     ctypes.c_double, ctypes.c_double, ctypes.c_double, ctypes.c_double,
                                     ctypes.c_double, ctypes.c_double]
@@ -358,6 +563,118 @@ def refine_rotor_sections(oldrotor, nsections):
     return lib.refine_rotor_sections(ctypes.byref(oldrotor), nsections).contents
 
 
+lib.refine_rotor_sections_ex.argtypes = [ctypes.POINTER(Rotor), ctypes.c_int, ctypes.c_int]
+lib.refine_rotor_sections_ex.restype = ctypes.POINTER(Rotor)
+def refine_rotor_sections_ex(oldrotor, nsections, spacing=QPROP_SPACING_UNIFORM):
+    """
+    REFINE_ROTOR_SECTIONS_EX creates a propeller geometry with the specified number
+    of sections and radial distribution
+    Input:
+        - oldrotor (Rotor): reference rotor geometry
+        - nsections: desired number of sections
+        - spacing: QPROP_SPACING_UNIFORM, QPROP_SPACING_COSINE or QPROP_SPACING_TIP
+    Output:
+        - (Rotor): refined rotor geometry, or None on errors
+    Example:
+        myrotor = refine_rotor_sections_ex(reference_rotor, 40, QPROP_SPACING_TIP)
+    """
+    newrotor = lib.refine_rotor_sections_ex(ctypes.byref(oldrotor), nsections, spacing)
+    return newrotor.contents if newrotor else None
+
+
+lib.refine_rotor_sections_adaptive.argtypes = [ctypes.POINTER(Rotor), ctypes.c_double, ctypes.c_double, ctypes.c_double, ctypes.c_double, ctypes.c_double, ctypes.c_double, ctypes.c_int, ctypes.POINTER(QPropOptions)]
+lib.refine_rotor_sections_adaptive.restype = ctypes.POINTER(Rotor)
+def refine_rotor_sections_adaptive(oldrotor, Uinf, Omega, rho=1.225, mu=1.81e-5, a=0.0, tol=1e-3, maxsections=200, options=None):
+    """
+    REFINE_ROTOR_SECTIONS_ADAPTIVE creates a propeller geometry with sections added
+    only where the thrust distribution changes sharply at the given operating point
+    Input:
+        - oldrotor (Rotor): reference rotor geometry
+        - Uinf: freestream velocity in m/s
+        - Omega: rotor speed in rad/s
+        - rho: air density in kg/m3 (default: 1.225)
+        - mu: air dynamic viscosity in Pa-s (default: 1.81e-5)
+        - a: speed of sound in m/s (default: 0.0) - set to 0 to disable Mach correction
+        - tol: relative tolerance on the thrust and torque (default: 1e-3)
+        - maxsections: maximum number of sections (default: 200)
+        - options (QPropOptions): solver options (default: qprop_default_options())
+    Output:
+        - (Rotor): refined rotor geometry, or None on errors
+    """
+    if options is None:
+        options = qprop_default_options()
+    newrotor = lib.refine_rotor_sections_adaptive(ctypes.byref(oldrotor), Uinf, Omega, rho, mu, a, tol, maxsections, ctypes.byref(options))
+    return newrotor.contents if newrotor else None
+
+
+lib.save_airfoil_binary.argtypes = [ctypes.POINTER(Airfoil), ctypes.c_char_p]
+lib.save_airfoil_binary.restype = ctypes.c_bool
+def save_airfoil_binary(airfoil, filename):
+    """
+    SAVE_AIRFOIL_BINARY saves an airfoil in a compact binary file
+    Input:
+        - airfoil (Airfoil): airfoil to be saved
+        - filename (String): name of the binary file to be written
+    Output:
+        - (bool): true if the file was written successfully
+    Notes:
+        - the file is written in the native byte order, so it can only be loaded
+          on machines with the same architecture
+    Example:
+        myairfoil = import_xfoil_polars(airfoil_filenames)
+        save_airfoil_binary(myairfoil, "naca4412.bin")
+    """
+    return lib.save_airfoil_binary(ctypes.byref(airfoil), filename.encode())
+
+
+lib.load_airfoil_binary.argtypes = [ctypes.c_char_p]
+lib.load_airfoil_binary.restype = ctypes.POINTER(Airfoil)
+def load_airfoil_binary(filename):
+    """
+    LOAD_AIRFOIL_BINARY loads an airfoil from a binary file written by save_airfoil_binary
+    Input:
+        - filename (String): name of the binary file
+    Output:
+        - (Airfoil): loaded airfoil, or None if the file is not valid
+    Notes:
+        - the file is memory-mapped and used without copies; the polars are read-only
+        - the mapping is released by free_airfoil(Airfoil)
+    """
+    airfoil = lib.load_airfoil_binary(filename.encode())
+    return airfoil.contents if airfoil else None
+
+
+lib.save_rotor_binary.argtypes = [ctypes.POINTER(Rotor), ctypes.c_char_p]
+lib.save_rotor_binary.restype = ctypes.c_bool
+def save_rotor_binary(rotor, filename):
+    """
+    SAVE_ROTOR_BINARY saves the geometry of a rotor in a compact binary file
+    Input:
+        - rotor (Rotor): rotor to be saved
+        - filename (String): name of the binary file to be written
+    Output:
+        - (bool): true if the file was written successfully
+    Notes:
+        - the airfoils of the sections are not saved, use save_airfoil_binary
+    """
+    return lib.save_rotor_binary(ctypes.byref(rotor), filename.encode())
+
+
+lib.load_rotor_binary.argtypes = [ctypes.c_char_p, ctypes.POINTER(Airfoil)]
+lib.load_rotor_binary.restype = ctypes.POINTER(Rotor)
+def load_rotor_binary(filename, airfoil):
+    """
+    LOAD_ROTOR_BINARY loads the geometry of a rotor from a binary file written by save_rotor_binary
+    Input:
+        - filename (String): name of the binary file
+        - airfoil (Airfoil): airfoil of all the sections
+    Output:
+        - (Rotor): loaded rotor, or None if the file is not valid
+    """
+    rotor = lib.load_rotor_binary(filename.encode(), ctypes.byref(airfoil))
+    return rotor.contents if rotor else None
+
+
 lib.free_rotor.argtypes = [ctypes.POINTER(Rotor)]
 lib.free_rotor.restype = None
 def free_rotor(currentrotor):
@@ -390,10 +707,158 @@ def qprop(rotor, Uinf, Omega, tol=1e-6, itmax=100, rho=1.225, mu=1.81e-5, a=0.0)
     Notes:
         - the current implementation assumes that there is no externally-induced
           tangential velocity (Ut = 0)
+        - when some blade elements do not converge, the outputs are returned anyway
+          with status QPROP_ERROR_NOT_CONVERGED and the flags of the elements in converged
     """
     return lib.qprop(ctypes.byref(rotor), Uinf, Omega, tol, itmax, rho, mu, a).contents
 
 
+lib.qprop_set_log_callback.argtypes = [QPropLogCallback, ctypes.c_void_p]
+lib.qprop_set_log_callback.restype = None
+log_callback = None         # keep the current callback alive while the library uses it
+def set_log_callback(callback):
+    """
+    SET_LOG_CALLBACK selects the function receiving the messages of the library
+    Input:
+        - callback: function(status, message) with the status code (int) and the
+          message (str) - set to None to print the messages on stdout
+    Output:
+        - none
+    Notes:
+        - the callback should be set before starting the analyses, not while other
+          threads are using the library
+    """
+    global log_callback
+    if callback is None:
+        log_callback = None
+        lib.qprop_set_log_callback(ctypes.cast(None, QPropLogCallback), None)
+        return
+    log_callback = QPropLogCallback(lambda status, message, userdata: callback(status, message.decode("utf-8", "replace")))
+    lib.qprop_set_log_callback(log_callback, None)
+
+
+lib.qprop_default_options.argtypes = []
+lib.qprop_default_options.restype = QPropOptions
+def qprop_default_options():
+    """
+    QPROP_DEFAULT_OPTIONS returns the default options for qprop_ex
+    Input:
+        - none
+    Output:
+        - (QPropOptions): default options (tol=1e-6, itmax=100, Brent's method, 1 thread)
+    """
+    return lib.qprop_default_options()
+
+
+lib.qprop_stats_enabled.argtypes = []
+lib.qprop_stats_enabled.restype = ctypes.c_bool
+def stats_enabled():
+    """
+    STATS_ENABLED checks whether the library collects the statistics of the analyses
+    Input:
+        - none
+    Output:
+        - (bool): True if the library is compiled with QPROP_STATS defined
+    Notes:
+        - to collect the statistics, zero a QPropStats and point options.stats to it:
+          stats = QPropStats(); options.stats = ctypes.pointer(stats)
+        - the Python object must be kept alive while the options are in use
+    """
+    return lib.qprop_stats_enabled()
+
+
+lib.qprop_single_precision.argtypes = []
+lib.qprop_single_precision.restype = ctypes.c_bool
+def single_precision():
+    """
+    SINGLE_PRECISION checks whether the library uses single precision in the solver kernels
+    Input:
+        - none
+    Output:
+        - (bool): True if the library is compiled with QPROP_SINGLE_PRECISION defined
+    Notes:
+        - the roots are refined in double precision, so the results meet the same tolerance
+    """
+    return lib.qprop_single_precision()
+
+
+lib.qprop_fast_math.argtypes = []
+lib.qprop_fast_math.restype = ctypes.c_bool
+def fast_math():
+    """
+    FAST_MATH checks whether the residual functions use fast approximations of sin, cos, atan, exp and acos
+    Input:
+        - none
+    Output:
+        - (bool): True if the library is compiled with QPROP_FAST_MATH defined
+    Notes:
+        - the maximum errors of the approximations are below 1e-13, well below the solver tolerance
+    """
+    return lib.qprop_fast_math()
+
+
+lib.qprop_ex.argtypes = [ctypes.POINTER(Rotor), ctypes.c_double, ctypes.c_double, ctypes.c_double, ctypes.c_double, ctypes.c_double, ctypes.POINTER(QPropOptions)]
+lib.qprop_ex.restype = ctypes.POINTER(RotorPerformance)
+def qprop_ex(rotor, Uinf, Omega, rho=1.225, mu=1.81e-5, a=0.0, options=None):
+    """
+    QPROP_EX runs the QProp algorithm with user-defined options
+    Input:
+        - rotor (Rotor): rotor geometry
+        - Uinf: freestream velocity in m/s
+        - Omega: rotor speed in rad/s
+        - rho: air density in kg/m3 (default: 1.225)
+        - mu: air dynamic viscosity in Pa-s (default: 1.81e-5)
+        - a: speed of sound in m/s (default: 0.0) - set to 0 to disable Mach correction
+        - options (QPropOptions): solver options (default: qprop_default_options())
+    Output:
+        - (RotorPerformance): data structure containing the QProp outputs
+    Notes:
+        - the number of residual evaluations used by each element is stored in
+          the output array nevals
+    """
+    if options is None:
+        options = qprop_default_options()
+    return lib.qprop_ex(ctypes.byref(rotor), Uinf, Omega, rho, mu, a, ctypes.byref(options)).contents
+
+
+lib.alloc_rotor_performance.argtypes = [ctypes.POINTER(Rotor), ctypes.c_bool]
+lib.alloc_rotor_performance.restype = ctypes.POINTER(RotorPerformance)
+def alloc_rotor_performance(rotor, totals_only=False):
+    """
+    ALLOC_ROTOR_PERFORMANCE allocates a QProp output that can be reused by qprop_into
+    Input:
+        - rotor (Rotor): rotor geometry that will be analyzed
+        - totals_only: if True, only T, Q, CT, CP and J are computed (default: False)
+    Output:
+        - (RotorPerformance): data structure that will contain the QProp outputs
+    Notes:
+        - the output must be freed with free_rotor_performance() when no longer needed
+    """
+    return lib.alloc_rotor_performance(ctypes.byref(rotor), totals_only).contents
+
+
+lib.qprop_into.argtypes = [ctypes.POINTER(RotorPerformance), ctypes.POINTER(Rotor), ctypes.c_double, ctypes.c_double, ctypes.c_double, ctypes.c_double, ctypes.c_double, ctypes.POINTER(QPropOptions)]
+lib.qprop_into.restype = ctypes.c_bool
+def qprop_into(perf, rotor, Uinf, Omega, rho=1.225, mu=1.81e-5, a=0.0, options=None):
+    """
+    QPROP_INTO runs the QProp algorithm and stores the results in a previously allocated output
+    Input:
+        - perf (RotorPerformance): output allocated by alloc_rotor_performance()
+        - rotor (Rotor): rotor geometry
+        - Uinf: freestream velocity in m/s
+        - Omega: rotor speed in rad/s
+        - rho: air density in kg/m3 (default: 1.225)
+        - mu: air dynamic viscosity in Pa-s (default: 1.81e-5)
+        - a: speed of sound in m/s (default: 0.0) - set to 0 to disable Mach correction
+        - options (QPropOptions): solver options (default: qprop_default_options())
+    Output:
+        - (bool): True if all the blade elements converged
+    """
+    if options is None:
+        options = qprop_default_options()
+    return lib.qprop_into(ctypes.byref(perf), ctypes.byref(rotor), Uinf, Omega, rho, mu, a, ctypes.byref(options))
+
+
 lib.free_rotor_performance.argtypes = [ctypes.POINTER(RotorPerformance)]
 lib.free_rotor_performance.restype = None
 def free_rotor_performance(perf):
@@ -406,3 +871,602 @@ def free_rotor_performance(perf):
     """
     lib.free_rotor_performance(ctypes.byref(perf))
 
+
+
+def rotor_performance_arrays(perf, free_on_release=False):
+    """
+    ROTOR_PERFORMANCE_ARRAYS returns the per-element results of a qprop output
+    as arrays backed by the C memory, without copies
+    Input:
+        - perf (RotorPerformance): qprop output
+        - free_on_release (bool): free perf when the arrays are garbage-collected (default: False)
+    Output:
+        - (dict): arrays residuals, Gamma, lambdaw, r, W, phi, dTdr, dQdr, nevals and converged
+          (NumPy arrays if NumPy is installed, memoryviews otherwise)
+    Notes:
+        - the fields that are not stored (totals-only outputs) are set to None
+        - with free_on_release=True, perf is freed by free_rotor_performance once
+          the arrays and perf itself are no longer referenced: do not free it explicitly
+    """
+    owner = RotorPerformanceOwner(perf, free_on_release)
+    perf.owner = owner              # perf keeps the C memory alive after the arrays are dropped
+    arrays = {}
+    types = {"nevals": (ctypes.c_int, "i"), "converged": (ctypes.c_bool, "?")}
+    for name in ("residuals", "Gamma", "lambdaw", "r", "W", "phi", "dTdr", "dQdr", "nevals", "converged"):
+        ptr = getattr(perf, name)
+        if not ptr:
+            arrays[name] = None
+            continue
+        ctype, code = types.get(name, (ctypes.c_double, "d"))
+        buffer = (ctype * perf.nelems).from_address(ctypes.addressof(ptr.contents))
+        buffer.owner = owner        # the C memory is released only after the last array
+        if numpy is not None:
+            arrays[name] = numpy.frombuffer(buffer, dtype=code)
+        else:
+            arrays[name] = memoryview(buffer).cast("B").cast(code)
+    return arrays
+
+
+class RotorPerformanceOwner:
+    """
+    ROTOR_PERFORMANCE_OWNER keeps a qprop output alive while its arrays are used,
+    optionally freeing it with a finalizer
+    """
+    def __init__(self, perf, free_on_release):
+        self.perf = perf
+        self.finalizer = None
+        if free_on_release:
+            self.finalizer = weakref.finalize(self, lib.free_rotor_performance, ctypes.cast(ctypes.addressof(perf), ctypes.POINTER(RotorPerformance)))
+
+
+lib.qprop_sweep.argtypes = [ctypes.POINTER(Rotor), ctypes.POINTER(ctypes.c_double), ctypes.POINTER(ctypes.c_double), ctypes.c_int, ctypes.c_double, ctypes.c_double, ctypes.c_double, ctypes.POINTER(QPropOptions)]
+lib.qprop_sweep.restype = ctypes.POINTER(ctypes.POINTER(RotorPerformance))
+lib.free_rotor_performances.argtypes = [ctypes.POINTER(ctypes.POINTER(RotorPerformance)), ctypes.c_int]
+lib.free_rotor_performances.restype = None
+def qprop_sweep(rotor, Uinf, Omega, rho=1.225, mu=1.81e-5, a=0.0, options=None):
+    """
+    QPROP_SWEEP runs the QProp algorithm over multiple operating points
+    Input:
+        - rotor (Rotor): rotor geometry
+        - Uinf: array of freestream velocities in m/s (list or NumPy array)
+        - Omega: array of rotor speeds in rad/s - same size as Uinf
+        - rho: air density in kg/m3 (default: 1.225)
+        - mu: air dynamic viscosity in Pa-s (default: 1.81e-5)
+        - a: speed of sound in m/s (default: 0.0) - set to 0 to disable Mach correction
+        - options (QPropOptions): solver options (default: qprop_default_options())
+    Output:
+        - (list of RotorPerformance): outputs of the operating points, None if a point failed
+    Notes:
+        - float64 NumPy arrays are passed to C without copies (see double_buffer)
+        - the outputs are freed automatically once none of them is referenced
+          (do not free them explicitly): use rotor_performance_arrays(perf) to
+          read their per-element results without copies
+    """
+    if options is None:
+        options = qprop_default_options()
+    npoints = len(Uinf)
+    perfs = lib.qprop_sweep(ctypes.byref(rotor), double_buffer(Uinf, npoints), double_buffer(Omega, npoints), npoints, rho, mu, a, ctypes.byref(options))
+    if not perfs:
+        return None
+    owner = RotorPerformanceSweepOwner(perfs, npoints)
+    results = []
+    for k in range(npoints):
+        if not perfs[k]:
+            results.append(None)
+            continue
+        perf = perfs[k].contents
+        perf.owner = owner          # the sweep is released only after its last output
+        results.append(perf)
+    return results
+
+
+class RotorPerformanceSweepOwner:
+    """
+    ROTOR_PERFORMANCE_SWEEP_OWNER frees the outputs of qprop_sweep with a
+    finalizer, once none of them is referenced
+    """
+    def __init__(self, perfs, npoints):
+        weakref.finalize(self, lib.free_rotor_performances, perfs, npoints)
+
+
+lib.qprop_batch.argtypes = [ctypes.POINTER(Rotor), ctypes.c_int, ctypes.POINTER(ctypes.c_double), ctypes.POINTER(ctypes.c_double),
+                            ctypes.POINTER(ctypes.c_double), ctypes.POINTER(ctypes.c_double), ctypes.c_double, ctypes.POINTER(QPropOptions),
+                            ctypes.POINTER(ctypes.c_double), ctypes.POINTER(ctypes.c_double), ctypes.POINTER(ctypes.c_double),
+                            ctypes.POINTER(ctypes.c_double), ctypes.POINTER(ctypes.c_double), ctypes.POINTER(ctypes.c_bool)]
+lib.qprop_batch.restype = ctypes.c_bool
+def qprop_batch(rotor, Uinf, Omega, rho=1.225, mu=1.81e-5, a=0.0, options=None):
+    """
+    QPROP_BATCH runs the QProp algorithm over a batch of operating points with a single call
+    Input:
+        - rotor (Rotor): rotor geometry
+        - Uinf: freestream velocities in m/s (scalar, list or NumPy array)
+        - Omega: rotor speeds in rad/s (scalar, list or NumPy array)
+        - rho: air densities in kg/m3 (default: 1.225)
+        - mu: air dynamic viscosities in Pa-s (default: 1.81e-5)
+        - a: speed of sound in m/s (default: 0.0) - set to 0 to disable Mach correction
+        - options (QPropOptions): solver options (default: qprop_default_options())
+    Output:
+        - (dict): arrays T, Q, CT, CP, J and converged, one entry per operating point
+    Notes:
+        - with NumPy, the inputs are broadcast together and the outputs are NumPy
+          arrays with the broadcast shape; without NumPy, the inputs are scalars or
+          sequences of the same length and the outputs are array.array objects
+        - the whole batch is solved by one C call, which releases the GIL
+    """
+    if options is None:
+        options = qprop_default_options()
+    if numpy is not None:
+        inputs = numpy.broadcast_arrays(*[numpy.asarray(x, dtype=numpy.float64) for x in (Uinf, Omega, rho, mu)])
+        shape = inputs[0].shape
+        inputs = [numpy.ascontiguousarray(x.ravel()) for x in inputs]
+        npoints = inputs[0].size
+        outputs = {name: numpy.empty(npoints) for name in ("T", "Q", "CT", "CP", "J")}
+        outputs["converged"] = numpy.zeros(npoints, dtype=numpy.bool_)
+        pointers = [x.ctypes.data_as(ctypes.POINTER(ctypes.c_double)) for x in inputs]
+        out_pointers = [outputs[name].ctypes.data_as(ctypes.POINTER(ctypes.c_double)) for name in ("T", "Q", "CT", "CP", "J")]
+        converged_pointer = outputs["converged"].ctypes.data_as(ctypes.POINTER(ctypes.c_bool))
+    else:
+        inputs = [x if hasattr(x, "__len__") else None for x in (Uinf, Omega, rho, mu)]
+        npoints = max([len(x) for x in inputs if x is not None] or [1])
+        inputs = [array.array("d", x) if hasattr(x, "__len__") else array.array("d", [x]*npoints) for x in (Uinf, Omega, rho, mu)]
+        if any(len(x) != npoints for x in inputs):
+            raise ValueError("ERROR in qprop_batch(): the inputs must have the same length")
+        outputs = {name: array.array("d", [0.0]*npoints) for name in ("T", "Q", "CT", "CP", "J")}
+        outputs["converged"] = (ctypes.c_bool * npoints)()
+        pointers = [double_buffer(x, npoints) for x in inputs]
+        out_pointers = [double_buffer(outputs[name], npoints) for name in ("T", "Q", "CT", "CP", "J")]
+        converged_pointer = outputs["converged"]
+    lib.qprop_batch(ctypes.byref(rotor), npoints, *pointers, a, ctypes.byref(options), *out_pointers, converged_pointer)
+    if numpy is not None:
+        outputs = {name: value.reshape(shape) for name, value in outputs.items()}
+    else:
+        outputs["converged"] = list(outputs["converged"])
+    return outputs
+
+
+lib.qprop_with_gradients.argtypes = [ctypes.POINTER(Rotor), ctypes.c_double, ctypes.c_double, ctypes.c_double, ctypes.c_double, ctypes.c_double,
+                                     ctypes.POINTER(QPropOptions), ctypes.POINTER(RotorGradients)]
+lib.qprop_with_gradients.restype = ctypes.POINTER(RotorPerformance)
+def qprop_with_gradients(rotor, Uinf, Omega, rho=1.225, mu=1.81e-5, a=0.0, options=None):
+    """
+    QPROP_WITH_GRADIENTS runs the QProp algorithm and computes the derivatives of thrust and torque
+    Input:
+        - rotor (Rotor): rotor geometry
+        - Uinf: freestream velocity in m/s
+        - Omega: rotor speed in rad/s
+        - rho: air density in kg/m3 (default: 1.225)
+        - mu: air dynamic viscosity in Pa-s (default: 1.81e-5)
+        - a: speed of sound in m/s (default: 0.0) - set to 0 to disable Mach correction
+        - options (QPropOptions): solver options (default: qprop_default_options())
+    Output:
+        - (RotorPerformance): data structure containing the QProp outputs
+        - (dict): arrays dTdc, dTdbeta, dQdc, dQdbeta (one entry per section) and the
+          scalars dTdUinf, dQdUinf, dTdOmega, dQdOmega
+    Notes:
+        - the derivatives are computed analytically by the C library, at the cost of
+          about one residual evaluation per element
+        - the arrays are NumPy arrays when NumPy is available, array.array objects otherwise
+    """
+    if options is None:
+        options = qprop_default_options()
+    nsections = rotor.nsections
+    names = ("dTdc", "dTdbeta", "dQdc", "dQdbeta")
+    if numpy is not None:
+        arrays = {name: numpy.zeros(nsections) for name in names}
+    else:
+        arrays = {name: array.array("d", [0.0]*nsections) for name in names}
+    buffers = [double_buffer(arrays[name], nsections) for name in names]
+    pointers = [ctypes.cast(buffer, ctypes.POINTER(ctypes.c_double)) for buffer in buffers]
+    gradients = RotorGradients(nsections, *pointers, 0.0, 0.0, 0.0, 0.0)
+    perf = lib.qprop_with_gradients(ctypes.byref(rotor), Uinf, Omega, rho, mu, a, ctypes.byref(options), ctypes.byref(gradients))
+    if not perf:
+        raise RuntimeError("ERROR in qprop_with_gradients(): failed to run qprop iterations")
+    for name in ("dTdUinf", "dQdUinf", "dTdOmega", "dQdOmega"):
+        arrays[name] = getattr(gradients, name)
+    return perf.contents, arrays
+
+
+lib.qprop_trim.argtypes = [ctypes.POINTER(Rotor), ctypes.c_double, ctypes.c_double, ctypes.c_double, ctypes.c_double, ctypes.c_double,
+                           ctypes.POINTER(QPropOptions), ctypes.c_int, ctypes.c_double, ctypes.c_int, ctypes.POINTER(ctypes.c_double)]
+lib.qprop_trim.restype = ctypes.POINTER(RotorPerformance)
+def qprop_trim(rotor, Uinf, Omega, target, value, variable=QPROP_TRIM_OMEGA, rho=1.225, mu=1.81e-5, a=0.0, options=None):
+    """
+    QPROP_TRIM finds the rotor speed or the collective pitch that gives a target thrust, torque or power
+    Input:
+        - rotor (Rotor): rotor geometry
+        - Uinf: freestream velocity in m/s
+        - Omega: rotor speed in rad/s - initial guess when variable is QPROP_TRIM_OMEGA
+        - target: QPROP_TRIM_THRUST, QPROP_TRIM_TORQUE or QPROP_TRIM_POWER
+        - value: required thrust (N), torque (N-m) or power (W)
+        - variable: QPROP_TRIM_OMEGA or QPROP_TRIM_PITCH (default: QPROP_TRIM_OMEGA)
+        - rho: air density in kg/m3 (default: 1.225)
+        - mu: air dynamic viscosity in Pa-s (default: 1.81e-5)
+        - a: speed of sound in m/s (default: 0.0) - set to 0 to disable Mach correction
+        - options (QPropOptions): solver options (default: qprop_default_options())
+    Output:
+        - (RotorPerformance): data structure containing the QProp outputs at the trimmed point
+        - (float): trimmed rotor speed (rad/s) or collective pitch offset (rad)
+    Notes:
+        - if the trim does not converge, status is QPROP_ERROR_NOT_CONVERGED
+        - the output must be freed with free_rotor_performance(...)
+    """
+    if options is None:
+        options = qprop_default_options()
+    trimmed = ctypes.c_double(0.0)
+    perf = lib.qprop_trim(ctypes.byref(rotor), Uinf, Omega, rho, mu, a, ctypes.byref(options), target, value, variable, ctypes.byref(trimmed))
+    if not perf:
+        raise RuntimeError("ERROR in qprop_trim(): invalid arguments or memory allocation error")
+    return perf.contents, trimmed.value
+
+
+lib.alloc_qprop_cache.argtypes = [ctypes.c_int, ctypes.c_double, ctypes.c_bool]
+lib.alloc_qprop_cache.restype = ctypes.c_void_p
+def alloc_qprop_cache(capacity=1024, resolution=1e-3, distributions=False):
+    """
+    ALLOC_QPROP_CACHE allocates a cache of operating points, to be used by qprop_cached
+    Input:
+        - capacity: maximum number of cached operating points (default: 1024)
+        - resolution: relative resolution of the operating conditions considered close
+          to each other (default: 1e-3) - set to 0 to reuse only identical conditions
+        - distributions: if True, the per-element distributions are cached too (default: False)
+    Output:
+        - (ctypes.c_void_p): handle of the cache
+    Notes:
+        - the cache must be freed with free_qprop_cache() when no longer needed
+    """
+    cache = lib.alloc_qprop_cache(capacity, resolution, distributions)
+    if not cache:
+        raise RuntimeError("ERROR in alloc_qprop_cache(): invalid arguments or memory allocation error")
+    return ctypes.c_void_p(cache)
+
+
+lib.qprop_cache_attach.argtypes = [ctypes.c_void_p, ctypes.POINTER(Rotor)]
+lib.qprop_cache_attach.restype = ctypes.c_uint64
+def qprop_cache_attach(cache, rotor):
+    """
+    QPROP_CACHE_ATTACH computes the key identifying a rotor in an operating point cache
+    Input:
+        - cache: handle returned by alloc_qprop_cache()
+        - rotor (Rotor): rotor geometry
+    Output:
+        - (int): key of the rotor, to be passed to qprop_cached()
+    Notes:
+        - qprop_cached() checks the rotor geometry on each call, but the key must be
+          computed again after the airfoils are modified
+    """
+    key = lib.qprop_cache_attach(cache, ctypes.byref(rotor))
+    if key == 0:
+        raise RuntimeError("ERROR in qprop_cache_attach(): invalid arguments")
+    return key
+
+
+lib.qprop_cached.argtypes = [ctypes.c_void_p, ctypes.c_uint64, ctypes.POINTER(RotorPerformance), ctypes.POINTER(Rotor), ctypes.c_double, ctypes.c_double,
+                             ctypes.c_double, ctypes.c_double, ctypes.c_double, ctypes.POINTER(QPropOptions)]
+lib.qprop_cached.restype = ctypes.c_bool
+def qprop_cached(cache, key, perf, rotor, Uinf, Omega, rho=1.225, mu=1.81e-5, a=0.0, options=None):
+    """
+    QPROP_CACHED runs the QProp algorithm through an operating point cache
+    Input:
+        - cache: handle returned by alloc_qprop_cache()
+        - key: key of the rotor returned by qprop_cache_attach()
+        - perf (RotorPerformance): output allocated by alloc_rotor_performance()
+        - rotor (Rotor): rotor geometry
+        - Uinf: freestream velocity in m/s
+        - Omega: rotor speed in rad/s
+        - rho: air density in kg/m3 (default: 1.225)
+        - mu: air dynamic viscosity in Pa-s (default: 1.81e-5)
+        - a: speed of sound in m/s (default: 0.0) - set to 0 to disable Mach correction
+        - options (QPropOptions): solver options (default: qprop_default_options())
+    Output:
+        - (bool): True if all the blade elements converged
+    Notes:
+        - identical operating points are copied from the cache, close ones are warm started
+    """
+    if options is None:
+        options = qprop_default_options()
+    return lib.qprop_cached(cache, key, ctypes.byref(perf), ctypes.byref(rotor), Uinf, Omega, rho, mu, a, ctypes.byref(options))
+
+
+lib.qprop_cache_stats.argtypes = [ctypes.c_void_p]
+lib.qprop_cache_stats.restype = QPropCacheStats
+def qprop_cache_stats(cache):
+    """
+    QPROP_CACHE_STATS returns the counters of an operating point cache
+    Input:
+        - cache: handle returned by alloc_qprop_cache()
+    Output:
+        - (QPropCacheStats): hits, warmstarts, misses, evictions and entries
+    """
+    return lib.qprop_cache_stats(cache)
+
+
+lib.free_qprop_cache.argtypes = [ctypes.c_void_p]
+lib.free_qprop_cache.restype = None
+def free_qprop_cache(cache):
+    """
+    FREE_QPROP_CACHE frees the memory allocated in an operating point cache
+    Input:
+        - cache: handle returned by alloc_qprop_cache()
+    Output:
+        - none
+    """
+    lib.free_qprop_cache(cache)
+
+
+lib.generate_rotor_map.argtypes = [ctypes.POINTER(Rotor), ctypes.POINTER(ctypes.c_double), ctypes.c_int, ctypes.POINTER(ctypes.c_double), ctypes.c_int,
+                                   ctypes.c_double, ctypes.c_double, ctypes.c_double, ctypes.POINTER(QPropOptions)]
+lib.generate_rotor_map.restype = ctypes.POINTER(RotorMap)
+def generate_rotor_map(rotor, J, Omega, rho=1.225, mu=1.81e-5, a=0.0, options=None):
+    """
+    GENERATE_ROTOR_MAP computes a performance map of a rotor on a grid of advance ratios and rotor speeds
+    Input:
+        - rotor (Rotor): rotor geometry
+        - J: advance ratios in strictly ascending order (at least 2)
+        - Omega: rotor speeds in rad/s, positive and in strictly ascending order (at least 2)
+        - rho: air density in kg/m3 (default: 1.225)
+        - mu: air dynamic viscosity in Pa-s (default: 1.81e-5)
+        - a: speed of sound in m/s (default: 0.0) - set to 0 to disable Mach correction
+        - options (QPropOptions): solver options (default: qprop_default_options())
+    Output:
+        - (RotorMap): performance map, with the interpolation errors in errCT and errCP
+    Notes:
+        - the map must be freed with free_rotor_map() when no longer needed
+    """
+    if options is None:
+        options = qprop_default_options()
+    nJ = len(J)
+    nOmega = len(Omega)
+    newmap = lib.generate_rotor_map(ctypes.byref(rotor), double_buffer(J, nJ), nJ, double_buffer(Omega, nOmega), nOmega, rho, mu, a, ctypes.byref(options))
+    if not newmap:
+        raise RuntimeError("ERROR in generate_rotor_map(): invalid arguments or memory allocation error")
+    return newmap.contents
+
+
+lib.lookup_rotor_map.argtypes = [ctypes.POINTER(RotorMap), ctypes.c_double, ctypes.c_double, ctypes.c_double]
+lib.lookup_rotor_map.restype = RotorMapPoint
+def lookup_rotor_map(rotormap, Uinf, Omega, rho=1.225):
+    """
+    LOOKUP_ROTOR_MAP interpolates a performance map
+    Input:
+        - rotormap (RotorMap): performance map
+        - Uinf: freestream velocity in m/s
+        - Omega: rotor speed in rad/s
+        - rho: air density in kg/m3 (default: 1.225)
+    Output:
+        - (RotorMapPoint): T, Q, CT, CP and J at the operating point, and inside=False
+          if the query was clamped to the edges of the map
+    """
+    return lib.lookup_rotor_map(ctypes.byref(rotormap), Uinf, Omega, rho)
+
+
+lib.save_rotor_map_binary.argtypes = [ctypes.POINTER(RotorMap), ctypes.c_char_p]
+lib.save_rotor_map_binary.restype = ctypes.c_bool
+def save_rotor_map_binary(rotormap, filename):
+    """
+    SAVE_ROTOR_MAP_BINARY saves a performance map in a compact binary file
+    Input:
+        - rotormap (RotorMap): performance map
+        - filename: name of the binary file to be written
+    Output:
+        - (bool): True if the file was written successfully
+    """
+    return lib.save_rotor_map_binary(ctypes.byref(rotormap), filename.encode())
+
+
+lib.load_rotor_map_binary.argtypes = [ctypes.c_char_p]
+lib.load_rotor_map_binary.restype = ctypes.POINTER(RotorMap)
+def load_rotor_map_binary(filename):
+    """
+    LOAD_ROTOR_MAP_BINARY loads a performance map from a binary file written by save_rotor_map_binary
+    Input:
+        - filename: name of the binary file
+    Output:
+        - (RotorMap): performance map (memory-mapped)
+    Notes:
+        - the map must be freed with free_rotor_map() when no longer needed
+    """
+    newmap = lib.load_rotor_map_binary(filename.encode())
+    if not newmap:
+        raise RuntimeError("ERROR in load_rotor_map_binary(): unable to load " + filename)
+    return newmap.contents
+
+
+lib.free_rotor_map.argtypes = [ctypes.POINTER(RotorMap)]
+lib.free_rotor_map.restype = None
+def free_rotor_map(rotormap):
+    """
+    FREE_ROTOR_MAP frees the memory allocated in a performance map
+    Input:
+        - rotormap (RotorMap): performance map that is no longer needed
+    Output:
+        - none
+    """
+    lib.free_rotor_map(ctypes.byref(rotormap))
+
+
+lib.qprop_fleet.argtypes = [ctypes.POINTER(ctypes.POINTER(Rotor)), ctypes.c_int, ctypes.c_int, ctypes.POINTER(ctypes.c_double), ctypes.POINTER(ctypes.c_double),
+                            ctypes.POINTER(ctypes.c_double), ctypes.POINTER(ctypes.c_double), ctypes.c_double, ctypes.POINTER(QPropOptions)]
+lib.qprop_fleet.restype = ctypes.POINTER(FleetResults)
+lib.free_fleet_results.argtypes = [ctypes.POINTER(FleetResults)]
+lib.free_fleet_results.restype = None
+def qprop_fleet(rotors, Uinf, Omega, rho=1.225, mu=1.81e-5, a=0.0, options=None):
+    """
+    QPROP_FLEET runs the QProp algorithm for multiple rotors at the same operating points
+    Input:
+        - rotors (list of Rotor): rotor geometries, e.g. a catalog of propellers
+        - Uinf: freestream velocities in m/s (scalar or sequence)
+        - Omega: rotor speeds in rad/s (scalar or sequence)
+        - rho: air densities in kg/m3 (default: 1.225)
+        - mu: air dynamic viscosities in Pa-s (default: 1.81e-5)
+        - a: speed of sound in m/s (default: 0.0) - set to 0 to disable Mach correction
+        - options (QPropOptions): solver options (default: qprop_default_options())
+    Output:
+        - (dict): T, Q, CT, CP, J and converged, with one row per rotor and one column per
+          operating point, and the counters nairfoils (distinct airfoils shared by the rotors)
+          and nfailed (points that did not converge)
+    Notes:
+        - the rows are NumPy arrays when NumPy is available, array.array objects otherwise
+        - the results are the same as calling qprop_batch for each rotor
+    """
+    if options is None:
+        options = qprop_default_options()
+    inputs = [x if hasattr(x, "__len__") else None for x in (Uinf, Omega, rho, mu)]
+    npoints = max([len(x) for x in inputs if x is not None] or [1])
+    inputs = [array.array("d", x) if hasattr(x, "__len__") else array.array("d", [x]*npoints) for x in (Uinf, Omega, rho, mu)]
+    if any(len(x) != npoints for x in inputs):
+        raise ValueError("ERROR in qprop_fleet(): the inputs must have the same length")
+    nrotors = len(rotors)
+    pointers = (ctypes.POINTER(Rotor) * max(nrotors, 1))(*[ctypes.pointer(rotor) for rotor in rotors])
+    results = lib.qprop_fleet(pointers, nrotors, npoints, *[double_buffer(x, npoints) for x in inputs], a, ctypes.byref(options))
+    if not results:
+        raise RuntimeError("ERROR in qprop_fleet(): invalid arguments or memory allocation error")
+    fleet = results.contents
+    outputs = {}
+    for name in ("T", "Q", "CT", "CP", "J"):
+        column = getattr(fleet, name)
+        if numpy is not None:
+            outputs[name] = numpy.array(column[:nrotors*npoints], dtype=numpy.float64).reshape(nrotors, npoints)
+        else:
+            outputs[name] = [array.array("d", column[i*npoints:(i+1)*npoints]) for i in range(nrotors)]
+    outputs["converged"] = [list(fleet.converged[i*npoints:(i+1)*npoints]) for i in range(nrotors)]
+    outputs["nairfoils"] = fleet.nairfoils
+    outputs["nfailed"] = fleet.nfailed
+    lib.free_fleet_results(results)
+    return outputs
+
+
+lib.open_qprop_sink.argtypes = [ctypes.c_char_p, ctypes.c_int, ctypes.c_int, ctypes.c_int]
+lib.open_qprop_sink.restype = ctypes.c_void_p
+def open_qprop_sink(filename, format=QPROP_SINK_BINARY, nelems=0, batchsize=1024):
+    """
+    OPEN_QPROP_SINK opens a file where the results of many operating points are streamed
+    Input:
+        - filename: name of the file to be written
+        - format: QPROP_SINK_CSV or QPROP_SINK_BINARY (default: QPROP_SINK_BINARY)
+        - nelems: number of blade elements of the distributions r, W, phi, Gamma, dTdr
+          and dQdr (default: 0) - set to 0 to write only the totals
+        - batchsize: number of points buffered in memory before they are written (default: 1024)
+    Output:
+        - (ctypes.c_void_p): handle of the sink
+    Notes:
+        - the sink must be closed with close_qprop_sink() to complete the file
+        - the CSV files can be loaded with pandas.read_csv(), the binary files with read_qprop_sink()
+    """
+    sink = lib.open_qprop_sink(filename.encode(), format, nelems, batchsize)
+    if not sink:
+        raise RuntimeError("ERROR in open_qprop_sink(): invalid arguments or unable to write " + filename)
+    return ctypes.c_void_p(sink)
+
+
+lib.qprop_sink_write.argtypes = [ctypes.c_void_p, ctypes.POINTER(RotorPerformance), ctypes.c_double, ctypes.c_double]
+lib.qprop_sink_write.restype = ctypes.c_bool
+def qprop_sink_write(sink, perf, Uinf, Omega):
+    """
+    QPROP_SINK_WRITE writes the results of one operating point to a sink
+    Input:
+        - sink: handle returned by open_qprop_sink()
+        - perf (RotorPerformance): QProp output of the point
+        - Uinf: freestream velocity of the point in m/s
+        - Omega: rotor speed of the point in rad/s
+    Output:
+        - (bool): False if the arguments are not valid or if the file could not be written
+    """
+    return lib.qprop_sink_write(sink, ctypes.byref(perf), Uinf, Omega)
+
+
+lib.close_qprop_sink.argtypes = [ctypes.c_void_p]
+lib.close_qprop_sink.restype = ctypes.c_bool
+def close_qprop_sink(sink):
+    """
+    CLOSE_QPROP_SINK writes the buffered points of a sink, completes its file and frees the sink
+    Input:
+        - sink: handle returned by open_qprop_sink()
+    Output:
+        - (bool): True if all the points were written successfully
+    """
+    return lib.close_qprop_sink(sink)
+
+
+lib.qprop_stream.argtypes = [ctypes.POINTER(Rotor), ctypes.c_int, ctypes.POINTER(ctypes.c_double), ctypes.POINTER(ctypes.c_double),
+                             ctypes.POINTER(ctypes.c_double), ctypes.POINTER(ctypes.c_double), ctypes.c_double, ctypes.POINTER(QPropOptions),
+                             ctypes.c_void_p]
+lib.qprop_stream.restype = ctypes.c_bool
+def qprop_stream(sink, rotor, Uinf, Omega, rho=1.225, mu=1.81e-5, a=0.0, options=None):
+    """
+    QPROP_STREAM runs the QProp algorithm over a batch of operating points, streaming the results to a sink
+    Input:
+        - sink: handle returned by open_qprop_sink()
+        - rotor (Rotor): rotor geometry
+        - Uinf: freestream velocities in m/s (scalar or sequence)
+        - Omega: rotor speeds in rad/s (scalar or sequence)
+        - rho: air densities in kg/m3 (default: 1.225)
+        - mu: air dynamic viscosities in Pa-s (default: 1.81e-5)
+        - a: speed of sound in m/s (default: 0.0) - set to 0 to disable Mach correction
+        - options (QPropOptions): solver options (default: qprop_default_options())
+    Output:
+        - (bool): True if all the points converged and were written successfully
+    Notes:
+        - the results are the same as qprop_batch, but only the buffer of the sink is kept in memory
+    """
+    if options is None:
+        options = qprop_default_options()
+    inputs = [x if hasattr(x, "__len__") else None for x in (Uinf, Omega, rho, mu)]
+    npoints = max([len(x) for x in inputs if x is not None] or [1])
+    inputs = [array.array("d", x) if hasattr(x, "__len__") else array.array("d", [x]*npoints) for x in (Uinf, Omega, rho, mu)]
+    if any(len(x) != npoints for x in inputs):
+        raise ValueError("ERROR in qprop_stream(): the inputs must have the same length")
+    return lib.qprop_stream(ctypes.byref(rotor), npoints, *[double_buffer(x, npoints) for x in inputs], a, ctypes.byref(options), sink)
+
+
+def read_qprop_sink(filename):
+    """
+    READ_QPROP_SINK reads a binary file written by a sink (QPROP_SINK_BINARY)
+    Input:
+        - filename: name of the binary file
+    Output:
+        - (dict): one entry per column: Uinf, Omega, T, Q, CT, CP, J and converged with one
+          value per point, and the distributions r, W, phi, Gamma, dTdr and dQdr (if written)
+          with one row of nelems values per point
+    Notes:
+        - with NumPy, the totals are 1-D arrays and the distributions are 2-D arrays,
+          e.g. pandas.DataFrame({k: v for k, v in columns.items() if v.ndim == 1});
+          without NumPy, they are array.array objects and lists of array.array rows
+        - the file is read one record batch at a time, in little-endian order on all the machines
+    """
+    with open(filename, "rb") as fileio:
+        header = fileio.read(64)
+        if len(header) < 64 or header[:8] != b"QPROPSK\0":
+            raise ValueError("ERROR in read_qprop_sink(): " + filename + " is not a valid binary file")
+        version, endianness, nelems, ncolumns, filesize, npoints = struct.unpack("<IIiiqd", header[8:40])
+        if version != 1 or endianness != 0x01020304:
+            raise ValueError("ERROR in read_qprop_sink(): " + filename + " was written by an incompatible version")
+        table = [struct.unpack("<12si", fileio.read(16)) for c in range(ncolumns)]
+        names = [name.rstrip(b"\0").decode() for name, width in table]
+        widths = [width for name, width in table]
+        batches = {name: [] for name in names}
+        while True:
+            chunk = fileio.read(8)
+            if len(chunk) < 8:
+                break
+            nrows = struct.unpack("<q", chunk)[0]
+            for name, width in zip(names, widths):
+                if numpy is not None:
+                    values = numpy.frombuffer(fileio.read(8*nrows*width), dtype="<f8").astype(numpy.float64)
+                else:
+                    values = array.array("d", fileio.read(8*nrows*width))
+                    if sys.byteorder == "big":
+                        values.byteswap()
+                batches[name].append(values)
+    columns = {}
+    for name, width in zip(names, widths):
+        if numpy is not None:
+            values = numpy.concatenate(batches[name]) if batches[name] else numpy.empty(0)
+            columns[name] = values if width == 1 else values.reshape(-1, width)
+        else:
+            values = array.array("d")
+            for batch in batches[name]:
+                values.extend(batch)
+            columns[name] = values if width == 1 else [values[j*width:(j+1)*width] for j in range(len(values)//width)]
+    if "converged" in columns:
+        columns["converged"] = (columns["converged"] != 0.0) if numpy is not None else [x != 0.0 for x in columns["converged"]]
+    return columns
@@ -23,118 +23,993 @@
     License: MIT
 *******************************************************************************/
 #include <ctype.h>
+#include <float.h>
 #include <math.h>
+#include <stdarg.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
+#if defined(QPROP_STATS)
+#include <time.h>
+#endif
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#if defined(QPROP_THREADS) && !defined(_WIN32)
+#include <pthread.h>
+#endif
 #include "qprop.h"
 
 #define PI 3.14159265358979323846
 #define MAX_LINE_LENGTH 256     //maximum length of a line in a xfoil polar file
+#define WARMSTART_BRACKET 0.05  //initial half-width of the psi bracket when warm starting (rad)
+#define UNIFORM_ALPHA_TOL 1e-6  //relative tolerance on the alpha spacing of uniformly-spaced polars
+#define COMPILED_ALIGNMENT 64   //alignment of the compiled polar tables (bytes)
+#define QPROP_BATCH_SIZE 8      //number of blade elements evaluated together by the batched residual
+#define SWEEP_CHUNK_SIZE 16     //number of consecutive operating points solved by the same thread in a sweep
+#define MIN_ELEMENTS_PER_THREAD 32  //minimum number of blade elements solved by each thread of a parallel analysis
+#define MAX_POOL_THREADS 256    //maximum number of worker threads of the thread pool
+#define BINARY_VERSION 1        //version of the binary airfoil and rotor files
+#define BINARY_HEADER_SIZE 64   //size of the header of the binary files (bytes)
+#define ADAPTIVE_INITIAL_SECTIONS 9 //number of equally-spaced sections of the first adaptive refinement
+#define MAX_LOG_LENGTH 512      //maximum length of a message passed to the log callback
+#define TRIM_MAX_PITCH_STEP 0.1 //maximum change of the collective pitch in a trim iteration (rad)
+#define CACHE_SHARDS 16         //number of independently locked shards of an operating point cache
+#define CACHE_STACK_ELEMENTS 256    //maximum number of elements whose psi is copied on the stack by qprop_cached
+#define REFINE_BRACKET 1e-4     //tolerance of the single-precision bisection and initial half-width of the bracket of its refinement (rad)
 
 
+//-----------------
+//  LOGGING
+//-----------------
+//The messages are passed to the user callback, if any, or printed on stdout.
+//The callback is the only global state of the library: it is set by the user
+//before the analyses and only read afterwards.
+
+//user function receiving the messages (NULL: print on stdout)
+//INTERNAL USE ONLY
+static QPropLogCallback qprop_log_callback = NULL;
+static void* qprop_log_userdata = NULL;
+
+//select the function receiving the messages of the library
+void qprop_set_log_callback(QPropLogCallback callback, void* userdata) {
+    qprop_log_callback = callback;
+    qprop_log_userdata = userdata;
+}
+
+//report a message with its status code
+//INTERNAL USE ONLY
+void qprop_log(QPropStatus status, const char* format, ...) {
+    char message[MAX_LOG_LENGTH];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+    if (qprop_log_callback) {
+        qprop_log_callback(status, message, qprop_log_userdata);
+    }
+    else {
+        printf("%s\n", message);
+    }
+}
+
+
+//-----------------
+//  STATISTICS
+//-----------------
+//When QPROP_STATS is defined, the solver counts the residual evaluations, the root finding iterations
+//and the polar queries out of range, and it measures the wall time of each stage of the analyses.
+//The counters of each blade element are stored separately and merged once the elements are solved,
+//so no data is shared between the threads. Without QPROP_STATS, the counting macro is empty.
+#if defined(QPROP_STATS)
+#define QPROP_STATS_ADD(counter, value) ((counter) += (value))
+#else
+#define QPROP_STATS_ADD(counter, value) ((void) 0)
+#endif
+
+//check if the library collects the statistics of the analyses
+bool qprop_stats_enabled(void) {
+#if defined(QPROP_STATS)
+    return true;
+#else
+    return false;
+#endif
+}
+
+#if defined(QPROP_STATS)
+//get the wall clock time in seconds
+//INTERNAL USE ONLY
+double stats_wall_time(void) {
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return (double) now.tv_sec + 1e-9 * (double) now.tv_nsec;
+}
+
+//add the statistics in stats to total
+//INTERNAL USE ONLY
+void merge_stats(QPropStats* total, const QPropStats* stats) {
+    total->nelements += stats->nelements;
+    total->niterations += stats->niterations;
+    total->nevals += stats->nevals;
+    total->nalphaclamped += stats->nalphaclamped;
+    total->nReclamped += stats->nReclamped;
+    total->tsetup += stats->tsetup;
+    total->tsolve += stats->tsolve;
+    total->tintegrate += stats->tintegrate;
+}
+#endif
+
+//allocate the statistics of the chunks of a sweep, which are solved in parallel
+//returns NULL if the statistics are not collected
+//INTERNAL USE ONLY
+QPropStats* new_chunk_stats(const QPropOptions* opts, int nchunks) {
+#if defined(QPROP_STATS)
+    if (opts->stats && nchunks > 0) {
+        return calloc(nchunks, sizeof(QPropStats));
+    }
+#endif
+    (void) opts;
+    (void) nchunks;
+    return NULL;
+}
+
+//merge the statistics of the chunks of a sweep in order, then free them
+//INTERNAL USE ONLY
+void merge_chunk_stats(const QPropOptions* opts, QPropStats* chunkstats, int nchunks) {
+    if (!chunkstats) {
+        return;
+    }
+#if defined(QPROP_STATS)
+    for (int k=0; k<nchunks; ++k) {
+        merge_stats(opts->stats, &(chunkstats[k]));
+    }
+#endif
+    (void) opts;
+    (void) nchunks;
+    free(chunkstats);
+}
+
+
+//----------------
+//  PRECISION
+//----------------
+//When QPROP_SINGLE_PRECISION is defined, qprop_real is float: the interpolation reads a float copy
+//of the compiled polar tables, with half the memory traffic, and the batched residual runs in single
+//precision, with twice the SIMD width. Near the root, the float residuals have round-off errors of
+//about 1e-5, so the roots found by the batched bisection are refined in double precision with a few
+//steps of Brent's method. The scalar residual, the loads of the elements and the integration of
+//thrust and torque are always performed in double precision.
+//The math functions below follow qprop_real, so the double build is unchanged.
+//With QPROP_FAST_MATH, the transcendental functions are the approximations of the FAST MATH section
+//in both builds, with the single-precision sine and cosine in the single-precision build.
+#define REAL(x) ((qprop_real) (x))
+#if defined(QPROP_SINGLE_PRECISION) && defined(QPROP_FAST_MATH)
+#define REAL_SINCOS fast_sincosf
+#define REAL_ATAN fast_atan
+#define REAL_ACOS fast_acos
+#define REAL_EXP fast_exp
+#define REAL_SQRT sqrtf
+#elif defined(QPROP_SINGLE_PRECISION)
+#define REAL_SINCOS(x, s, c) (*(s) = sinf(x), *(c) = cosf(x))
+#define REAL_ATAN atanf
+#define REAL_ACOS acosf
+#define REAL_EXP expf
+#define REAL_SQRT sqrtf
+#else
+#define REAL_SINCOS MATH_SINCOS
+#define REAL_ATAN MATH_ATAN
+#define REAL_ACOS MATH_ACOS
+#define REAL_EXP MATH_EXP
+#define REAL_SQRT sqrt
+#endif
+
+//check if the residual kernels run in single precision
+bool qprop_single_precision(void) {
+#if defined(QPROP_SINGLE_PRECISION)
+    return true;
+#else
+    return false;
+#endif
+}
+
+//size of the working-precision copy of the compiled polar tables (bytes), 0 in double precision
+//INTERNAL USE ONLY
+size_t compiled_real_table_size(int nRe, int nalpha) {
+    return (sizeof(qprop_real) == sizeof(double))? 0 : 2*(size_t)nRe*nalpha*sizeof(qprop_real);
+}
+
+//point the working-precision table of a compiled airfoil to its (CL,CD) pairs
+//table: storage of compiled_real_table_size() bytes, filled with the converted pairs in single precision
+//INTERNAL USE ONLY
+void set_compiled_real_table(CompiledAirfoil* compiled, void* table) {
+#if defined(QPROP_SINGLE_PRECISION)
+    size_t size = 2*(size_t)compiled->nRe*compiled->nalpha;
+    compiled->CLCDr = (qprop_real*) table;
+    for (size_t i=0; i<size; ++i) {
+        compiled->CLCDr[i] = (qprop_real) compiled->CLCD[i];
+    }
+#else
+    (void) table;
+    compiled->CLCDr = compiled->CLCD;
+#endif
+}
+
+
+//-----------------
+//  FAST MATH
+//-----------------
+//When QPROP_FAST_MATH is defined, the residual functions replace the calls to sin, cos, atan, exp
+//and acos of libm with the polynomial approximations below. They are tuned to the arguments that occur
+//in the residual: psi in [-pi/2, pi/2], the flow angle atan(Wa/Wt), and the tip loss factor
+//acos(exp(-f)) with f > 0. The approximations have no data-dependent branches (only selects), so the
+//compiler can inline and vectorize them in the batched residual, the sine and cosine of psi are
+//computed together, and the polynomials are evaluated with Estrin's scheme, which has a shorter
+//dependency chain than Horner's rule (the residual is a chain of these functions). The coefficients
+//are fitted at the Chebyshev nodes of each reduced interval, and the maximum absolute errors are below
+//1e-13, well below the solver tolerance (see test/16_test_fast_math.c).
+//Without the flag, the MATH_* macros are the functions of libm.
+#if defined(QPROP_FAST_MATH)
+#define MATH_SINCOS fast_sincos
+#define MATH_ATAN fast_atan
+#define MATH_ACOS fast_acos
+#define MATH_EXP fast_exp
+#else
+#define MATH_SINCOS(x, s, c) (*(s) = sin(x), *(c) = cos(x))
+#define MATH_ATAN atan
+#define MATH_ACOS acos
+#define MATH_EXP exp
+#endif
+
+//check if the residual functions use the fast approximations of the transcendental functions
+bool qprop_fast_math(void) {
+#if defined(QPROP_FAST_MATH)
+    return true;
+#else
+    return false;
+#endif
+}
+
+//compute the sine and the cosine of an angle with two polynomials of x^2
+//x: angle in [-pi/2, pi/2] (rad), the maximum errors are 8e-14 (sine) and 3e-15 (cosine)
+//INTERNAL USE ONLY
+void fast_sincos(double x, double* s, double* c) {
+    double x2 = x*x;
+    double x4 = x2*x2;
+    double x8 = x4*x4;
+    double ps = (0.9999999999999498 - 0.16666666666466867*x2) + x4*(8.333333320364865e-03 - 1.984126668397851e-04*x2)
+                + x8*((2.7556952964927606e-06 - 2.5030269719641544e-08*x2) + x4*1.5411237166805076e-10);
+    double pc = (0.9999999999999981 - 0.4999999999998998*x2) + x4*(4.1666666665811536e-02 - 1.3888888861102737e-03*x2)
+                + x8*((2.48015828692945e-05 - 2.7556935226478234e-07*x2) + x4*(2.0858308564198636e-09 - 1.1007814132431588e-11*x2));
+    *s = x*ps;
+    *c = pc;
+}
+
+//single-precision version of fast_sincos(), used by the batched residual of the single-precision build
+//x: angle in [-pi/2, pi/2] (rad), the maximum errors are 5e-8 (sine) and 3e-8 (cosine)
+//NOTE: the polynomials have lower degrees and are evaluated in float, so the batched residual
+//has no conversions to double
+//INTERNAL USE ONLY
+void fast_sincosf(float x, float* s, float* c) {
+    float x2 = x*x;
+    float x4 = x2*x2;
+    float ps = (1.0f - 0.16666658f*x2) + x4*((8.3330497e-03f - 1.9809017e-04f*x2) + x4*2.6051077e-06f);
+    float pc = (1.0f - 0.5f*x2) + x4*((4.1666634e-02f - 1.3888361e-03f*x2) + x4*(2.4760109e-05f - 2.6050657e-07f*x2));
+    *s = x*ps;
+    *c = pc;
+}
+
+//compute the arc tangent of any real number (rad), with a maximum error of 2e-14
+//NOTE: |x| is reduced to t in [-tan(pi/8), tan(pi/8)] with atan(x) = pi/2 + atan(-1/x) for x > tan(3*pi/8)
+//and atan(x) = pi/4 + atan((x - 1)/(x + 1)) for x > tan(pi/8), so the reduction takes a single division
+//and the result is an odd polynomial of t
+//INTERNAL USE ONLY
+double fast_atan(double x) {
+    double a = fabs(x);
+    bool upper = (a > 2.414213562373095);
+    bool middle = (a > 0.41421356237309503);
+    double num = upper? -1.0 : (middle? a - 1.0 : a);
+    double den = upper? a : (middle? a + 1.0 : 1.0);
+    double offset = upper? 0.5*PI : (middle? 0.25*PI : 0.0);
+    double t = num/den;
+    double t2 = t*t;
+    double t4 = t2*t2;
+    double t8 = t4*t4;
+    double p = (0.9999999999999732 - 0.3333333333080463*t2) + t4*(0.19999999605075697 - 0.142856904325861*t2)
+               + t8*((0.11110385244255064 - 0.09078394485148579*t2) + t4*(0.0756371973974816 - 0.058745620566435834*t2)
+               + t8*0.03066323962981372);
+    return copysign(offset + t*p, x);
+}
+
+//compute the exponential of x, with a maximum relative error of 1e-15
+//x is clamped to [-708, 709], the range of the normal double-precision results, and NaN is returned as is
+//NOTE: exp(x) = 2^k * exp(x - k*ln(2)), with an integer k such that |r| = |x - k*ln(2)| <= ln(2)/2,
+//and exp(r) = 1 + r*P(r) is exact at r = 0, so that acos(exp(-f)) is accurate also for f -> 0
+//INTERNAL USE ONLY
+double fast_exp(double x) {
+    //the comparisons are false for NaN, so the clamped value is always in range for the cast to int
+    double xc = (x >= -708.0)? ((x <= 709.0)? x : 709.0) : ((x < -708.0)? -708.0 : 0.0);
+    double k = (double) (int) (xc*1.4426950408889634 + ((xc < 0)? -0.5 : 0.5));
+    double r = (xc - k*6.93147180369123816490e-01) - k*1.90821492927058770002e-10;
+    double r2 = r*r;
+    double r4 = r2*r2;
+    double r8 = r4*r4;
+    double p = (1.000000000000001 + 0.49999999999999917*r) + r2*(0.16666666666616375 + 4.1666666666668094e-02*r)
+               + r4*((8.333333367234096e-03 + 1.3888888917605539e-03*r) + r2*(1.9841190669913923e-04 + 2.4801510970707517e-05*r))
+               + r8*(2.7632638661251808e-06 + 2.762644154122846e-07*r);
+    p = 1.0 + r*p;
+    //scale by 2^k, writing the exponent bits directly
+    uint64_t bits = (uint64_t) ((int64_t) k + 1023) << 52;
+    double scale;
+    memcpy(&scale, &bits, sizeof(double));
+    return (x == x)? p*scale : x;
+}
+
+//compute the arc cosine of x in [0, 1] (rad), the range of exp(-f) in the tip loss factor,
+//with a maximum error of 7e-14
+//NOTE: acos(x) = pi/2 - asin(x) for x < 0.5, otherwise acos(x) = 2*asin(sqrt((1 - x)/2)),
+//so the odd polynomial of asin is only evaluated in [0, 0.5]
+//INTERNAL USE ONLY
+double fast_acos(double x) {
+    bool upper = (x >= 0.5);
+    double z = upper? sqrt(0.5*(1.0 - x)) : x;
+    double z2 = z*z;
+    double z4 = z2*z2;
+    double z8 = z4*z4;
+    double p = (0.9999999999999493 + 0.16666666670725297*z2) + z4*(0.07499999467419062 + 0.044643126915984044*z2)
+               + z8*((0.03037504680436677 + 0.02247262693118416*z2) + z4*(0.01647276684965474 + 0.018638358629010757*z2)
+               + z8*(-0.0028559769092427315 + 0.031943629930022206*z2));
+    p = z*p;
+    return upper? 2.0*p : 0.5*PI - p;
+}
+
+
+//-----------------
+//  MULTITHREADING
+//-----------------
+//Threads are enabled at compile time by defining QPROP_THREADS:
+//  - on Windows, the native Win32 threads are used
+//  - elsewhere, POSIX threads are used (link with -pthread)
+//Without QPROP_THREADS, all the loops below run serially on the calling thread.
+
+//data structure for a loop executed in parallel
+//INTERNAL USE ONLY
+typedef struct {
+    int n;                                  //number of iterations
+    int next;                               //next iteration to be executed
+    void (*task)(int i, void* ctx);         //function executing the i-th iteration
+    void* ctx;                              //context shared by all the iterations
+    bool parallel;                          //true if the iterations are shared among multiple threads
+#if defined(QPROP_THREADS) && defined(_WIN32)
+    CRITICAL_SECTION lock;
+#elif defined(QPROP_THREADS)
+    pthread_mutex_t lock;
+#endif
+} ParallelLoop;
+
+//get the number of available cores
+//INTERNAL USE ONLY
+int available_threads(void) {
+#if defined(QPROP_THREADS) && defined(_WIN32)
+    SYSTEM_INFO sysinfo;
+    GetSystemInfo(&sysinfo);
+    return (sysinfo.dwNumberOfProcessors > 0)? (int) sysinfo.dwNumberOfProcessors : 1;
+#elif defined(QPROP_THREADS)
+    long ncores = sysconf(_SC_NPROCESSORS_ONLN);
+    return (ncores > 0)? (int) ncores : 1;
+#else
+    return 1;
+#endif
+}
+
+//execute the iterations of a parallel loop until none is left
+//the iterations are handed out one at a time, so that slow ones do not stall the other threads
+//INTERNAL USE ONLY
+void parallel_loop_worker(ParallelLoop* loop) {
+    while (true) {
+        int i = 0;
+        if (!loop->parallel) {
+            i = loop->next++;
+        }
+        else {
+#if defined(QPROP_THREADS) && defined(_WIN32)
+            EnterCriticalSection(&(loop->lock));
+            i = loop->next++;
+            LeaveCriticalSection(&(loop->lock));
+#elif defined(QPROP_THREADS)
+            pthread_mutex_lock(&(loop->lock));
+            i = loop->next++;
+            pthread_mutex_unlock(&(loop->lock));
+#endif
+        }
+        if (i >= loop->n) {
+            return;
+        }
+        loop->task(i, loop->ctx);
+    }
+}
+
+#if defined(QPROP_THREADS)
+//persistent pool of worker threads shared by all the parallel loops
+//the workers are started the first time they are needed and then sleep between the loops,
+//so that a parallel loop costs a wake-up per worker instead of the creation of a thread
+//INTERNAL USE ONLY
+typedef struct {
+    int nworkers;                           //number of worker threads started so far
+    int nhelpers;                           //number of workers taking part in the current loop
+    int active;                             //number of workers still executing the current loop
+    unsigned long generation;               //incremented every time a new loop is posted
+    bool busy;                              //true while a loop is being executed by the pool
+    ParallelLoop* loop;                     //loop being executed
+#if defined(_WIN32)
+    CRITICAL_SECTION lock;
+    CONDITION_VARIABLE wake;
+    CONDITION_VARIABLE done;
+#else
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+#endif
+} ThreadPool;
+
+//data structure passed to each worker of the pool at startup
+//INTERNAL USE ONLY
+typedef struct {
+    int index;                              //index of the worker (0, 1, ...)
+    unsigned long generation;               //generation of the pool when the worker was started
+} ThreadPoolWorker;
+
+static ThreadPool thread_pool;
+
+//lock, unlock and wait on the thread pool
+//INTERNAL USE ONLY
+#if defined(_WIN32)
+static INIT_ONCE thread_pool_once = INIT_ONCE_STATIC_INIT;
+BOOL CALLBACK init_thread_pool(PINIT_ONCE once, PVOID param, PVOID* context) {
+    (void) once;
+    (void) param;
+    (void) context;
+    InitializeCriticalSection(&(thread_pool.lock));
+    InitializeConditionVariable(&(thread_pool.wake));
+    InitializeConditionVariable(&(thread_pool.done));
+    return TRUE;
+}
+#define THREAD_POOL_INIT() InitOnceExecuteOnce(&thread_pool_once, init_thread_pool, NULL, NULL)
+#define THREAD_POOL_LOCK() EnterCriticalSection(&(thread_pool.lock))
+#define THREAD_POOL_UNLOCK() LeaveCriticalSection(&(thread_pool.lock))
+#define THREAD_POOL_WAIT(cond) SleepConditionVariableCS(&(thread_pool.cond), &(thread_pool.lock), INFINITE)
+#define THREAD_POOL_WAKE_ALL(cond) WakeAllConditionVariable(&(thread_pool.cond))
+#else
+static pthread_once_t thread_pool_once = PTHREAD_ONCE_INIT;
+void init_thread_pool(void) {
+    pthread_mutex_init(&(thread_pool.lock), NULL);
+    pthread_cond_init(&(thread_pool.wake), NULL);
+    pthread_cond_init(&(thread_pool.done), NULL);
+}
+#define THREAD_POOL_INIT() pthread_once(&thread_pool_once, init_thread_pool)
+#define THREAD_POOL_LOCK() pthread_mutex_lock(&(thread_pool.lock))
+#define THREAD_POOL_UNLOCK() pthread_mutex_unlock(&(thread_pool.lock))
+#define THREAD_POOL_WAIT(cond) pthread_cond_wait(&(thread_pool.cond), &(thread_pool.lock))
+#define THREAD_POOL_WAKE_ALL(cond) pthread_cond_broadcast(&(thread_pool.cond))
+#endif
+
+//main function of a worker of the pool: wait for a loop, take part in it if needed, and repeat
+//INTERNAL USE ONLY
+void thread_pool_worker(ThreadPoolWorker* worker) {
+    int index = worker->index;
+    unsigned long seen = worker->generation;
+    free(worker);
+    THREAD_POOL_LOCK();
+    while (true) {
+        while (thread_pool.generation == seen) {
+            THREAD_POOL_WAIT(wake);
+        }
+        seen = thread_pool.generation;
+        if (index < thread_pool.nhelpers) {
+            ParallelLoop* loop = thread_pool.loop;
+            THREAD_POOL_UNLOCK();
+            parallel_loop_worker(loop);
+            THREAD_POOL_LOCK();
+            thread_pool.active -= 1;
+            if (thread_pool.active == 0) {
+                THREAD_POOL_WAKE_ALL(done);
+            }
+        }
+    }
+}
+
+#if defined(_WIN32)
+DWORD WINAPI thread_pool_thread(LPVOID worker) {
+    thread_pool_worker((ThreadPoolWorker*) worker);
+    return 0;
+}
+#else
+void* thread_pool_thread(void* worker) {
+    thread_pool_worker((ThreadPoolWorker*) worker);
+    return NULL;
+}
+#endif
+
+//start new workers until the pool has at least nworkers of them (the pool must be locked)
+//returns the number of workers available
+//INTERNAL USE ONLY
+int grow_thread_pool(int nworkers) {
+    if (nworkers > MAX_POOL_THREADS) {
+        nworkers = MAX_POOL_THREADS;
+    }
+    while (thread_pool.nworkers < nworkers) {
+        ThreadPoolWorker* worker = malloc(sizeof(ThreadPoolWorker));
+        if (!worker) {
+            break;
+        }
+        worker->index = thread_pool.nworkers;
+        worker->generation = thread_pool.generation;
+#if defined(_WIN32)
+        HANDLE thread = CreateThread(NULL, 0, thread_pool_thread, worker, 0, NULL);
+        if (!thread) {
+            free(worker);
+            break;
+        }
+        CloseHandle(thread);
+#else
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, thread_pool_thread, worker) != 0) {
+            free(worker);
+            break;
+        }
+        pthread_detach(thread);
+#endif
+        thread_pool.nworkers += 1;
+    }
+    return thread_pool.nworkers;
+}
+#endif
+
+//run task(i, ctx) for each i in [0,n) using up to nthreads threads (0: all the available cores)
+//the calling thread takes part in the loop and returns only when all the iterations are completed
+//NOTE: the pool executes one loop at a time; a loop started while the pool is busy (e.g. nested
+//      in another parallel loop, or by another thread of the application) runs serially
+//INTERNAL USE ONLY
+void parallel_for(int n, int nthreads, void (*task)(int i, void* ctx), void* ctx) {
+    ParallelLoop loop;
+    loop.n = n;
+    loop.next = 0;
+    loop.task = task;
+    loop.ctx = ctx;
+    loop.parallel = false;
+    if (nthreads <= 0) {
+        nthreads = available_threads();
+    }
+    if (nthreads > n) {
+        nthreads = n;
+    }
+#if defined(QPROP_THREADS)
+    if (nthreads > 1) {
+        THREAD_POOL_INIT();
+        THREAD_POOL_LOCK();
+        int nhelpers = (thread_pool.busy)? 0 : grow_thread_pool(nthreads-1);
+        if (nhelpers > nthreads-1) {
+            nhelpers = nthreads-1;
+        }
+        if (nhelpers > 0) {
+#if defined(_WIN32)
+            InitializeCriticalSection(&(loop.lock));
+#else
+            pthread_mutex_init(&(loop.lock), NULL);
+#endif
+            loop.parallel = true;
+            thread_pool.busy = true;
+            thread_pool.loop = &loop;
+            thread_pool.nhelpers = nhelpers;
+            thread_pool.active = nhelpers;
+            thread_pool.generation += 1;
+            THREAD_POOL_WAKE_ALL(wake);
+            THREAD_POOL_UNLOCK();
+            parallel_loop_worker(&loop);
+            THREAD_POOL_LOCK();
+            while (thread_pool.active > 0) {
+                THREAD_POOL_WAIT(done);
+            }
+            thread_pool.busy = false;
+            thread_pool.loop = NULL;
+            THREAD_POOL_UNLOCK();
+#if defined(_WIN32)
+            DeleteCriticalSection(&(loop.lock));
+#else
+            pthread_mutex_destroy(&(loop.lock));
+#endif
+            return;
+        }
+        THREAD_POOL_UNLOCK();
+    }
+#endif
+    //serial execution on the calling thread
+    parallel_loop_worker(&loop);
+}
+
+//limit the number of threads of a loop over nelems blade elements, so that each thread gets at least
+//MIN_ELEMENTS_PER_THREAD of them: below that, waking up a thread costs more than it saves
+//INTERNAL USE ONLY
+int element_threads(int nelems, int nthreads) {
+    if (nthreads <= 0) {
+        nthreads = available_threads();
+    }
+    int maxthreads = nelems / MIN_ELEMENTS_PER_THREAD;
+    if (nthreads > maxthreads) {
+        nthreads = (maxthreads > 1)? maxthreads : 1;
+    }
+    return nthreads;
+}
+
 //converts degrees to radians
 double deg2rad(double deg) {
     return deg*PI/180.0;
 }
 
-//read xfoil polar from file
-//WARNING: the content of the file is not checked
-//the polar is supposed to start at min(alpha), go to 0 and finish at max(alpha)
-Polar* read_xfoil_polar_from_file(const char *filename) {
+//compute the spacing of an array sorted in ascending order
+//return zero if the spacing is not uniform
+//INTERNAL USE ONLY
+double uniform_spacing(const double* x, int size) {
+    if (size < 3) {
+        return 0.0;
+    }
+    double dx = (x[size-1] - x[0]) / (size-1);
+    if (!(dx > 0.0)) {
+        return 0.0;
+    }
+    for (int i=1; i<size; ++i) {
+        if (fabs(x[i] - (x[0] + i*dx)) > UNIFORM_ALPHA_TOL*dx) {
+            return 0.0;
+        }
+    }
+    return dx;
+}
+
+//detect whether the angles of attack of a polar are uniformly spaced
+//the spacing is stored in currentpolar->dalpha, or set to zero if the spacing is not uniform
+//INTERNAL USE ONLY
+void update_polar_spacing(Polar* currentpolar) {
+    currentpolar->dalpha = uniform_spacing(currentpolar->alpha, currentpolar->size);
+}
+
+//decimal separator of the current locale, used by printf and strtod (e.g. ',' in de_DE)
+//it is detected by formatting a number, since localeconv() is not thread-safe
+//INTERNAL USE ONLY
+char locale_decimal_separator(void) {
+    char separator[8];
+    snprintf(separator, sizeof(separator), "%.1f", 0.5);
+    return (separator[1] != '\0' && separator[2] == '5')? separator[1] : '.';
+}
+
+//parse a decimal number starting at s, without reading past end
+//it is locale-independent and it returns the same value of strtod in the "C" locale: numbers with up
+//to 19 significant digits and small exponents are converted exactly with a single rounding, the others
+//fall back to strtod, with the decimal point adapted to the current locale
+//*next is set to the first character after the number (to s if no number is found, and 0 is returned)
+//INTERNAL USE ONLY
+double parse_number(const char* s, const char* end, const char** next) {
+    static const double powers_of_ten[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    const char* p = s;
+    while (p < end && (*p == ' ' || *p == '\t')) {
+        ++p;
+    }
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        ++p;
+    }
+
+    //read mantissa digits
+    unsigned long long mantissa = 0;
+    int ndigits = 0;            //significant digits in the mantissa
+    int exponent = 0;           //decimal exponent of the mantissa
+    bool found_digits = false;
+    bool exact = true;
+    for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+        found_digits = true;
+        if (mantissa == 0 && *p == '0') {
+            continue;
+        }
+        if (ndigits < 19) {
+            mantissa = 10*mantissa + (unsigned long long) (*p - '0');
+            ++ndigits;
+        }
+        else {
+            exact = false;
+            ++exponent;
+        }
+    }
+    if (p < end && *p == '.') {
+        for (++p; p < end && *p >= '0' && *p <= '9'; ++p) {
+            found_digits = true;
+            if (mantissa == 0 && *p == '0') {
+                --exponent;
+                continue;
+            }
+            if (ndigits < 19) {
+                mantissa = 10*mantissa + (unsigned long long) (*p - '0');
+                ++ndigits;
+                --exponent;
+            }
+            else {
+                exact = false;
+            }
+        }
+    }
+    if (!found_digits) {
+        *next = s;
+        return 0.0;
+    }
+
+    //read exponent
+    if (p+1 < end && (*p == 'e' || *p == 'E')) {
+        const char* q = p+1;
+        bool negative_exponent = false;
+        if (*q == '-' || *q == '+') {
+            negative_exponent = (*q == '-');
+            ++q;
+        }
+        if (q < end && *q >= '0' && *q <= '9') {
+            int value = 0;
+            for (; q < end && *q >= '0' && *q <= '9'; ++q) {
+                if (value < 10000) {
+                    value = 10*value + (*q - '0');
+                }
+            }
+            exponent += (negative_exponent)? -value : value;
+            p = q;
+        }
+    }
+    *next = p;
+
+    //convert
+    double result = 0.0;
+    if (exact && mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22) {
+        //both the mantissa and the power of ten are exact, so a single rounding is performed
+        result = (exponent < 0)? (double) mantissa / powers_of_ten[-exponent] : (double) mantissa * powers_of_ten[exponent];
+    }
+    else {
+        //slow path: copy the number to a null-terminated buffer
+        char buffer[64];
+        size_t length = (size_t) (p - s);
+        if (length > sizeof(buffer)-1) {
+            length = sizeof(buffer)-1;
+        }
+        memcpy(buffer, s, length);
+        buffer[length] = '\0';
+
+        //strtod follows the decimal separator of the current locale (e.g. "0,5" in de_DE), so the
+        //separator of the locale replaces the point of the polar file
+        char* point = memchr(buffer, '.', length);
+        if (point) {
+            *point = locale_decimal_separator();
+        }
+        return strtod(buffer, NULL);
+    }
+    return (negative)? -result : result;
+}
+
+//check if a line of the given length contains a string
+//INTERNAL USE ONLY
+bool line_contains(const char* line, size_t length, const char* str) {
+    size_t n = strlen(str);
+    for (size_t i=0; i+n <= length; ++i) {
+        if (memcmp(line+i, str, n) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+//parse a xfoil polar from a buffer in memory, in a single pass
+//the arrays grow geometrically and are trimmed at the end
+//name: name of the source, used in the error messages
+//Re: Reynolds number of the polar, or 0 to read it from the buffer
+//INTERNAL USE ONLY
+Polar* parse_xfoil_polar(const char* buffer, size_t size, const char* name, double Re) {
     Polar* newpolar = calloc(1, sizeof(Polar));
     if (!newpolar) {
-        printf("ERROR: memory allocation error in read_xfoil_polar_from_file()\n");
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in read_xfoil_polar_from_file()");
         return NULL;
     }
-    newpolar->Re = 0.0;
+    newpolar->Re = Re;
     newpolar->alpha = NULL;
     newpolar->CL = NULL;
     newpolar->CD = NULL;
     newpolar->size = 0;
+    newpolar->dalpha = 0.0;
+    int capacity = 0;
 
-    FILE* fileio = fopen(filename, "rb");
-    if (!fileio) {
-        printf("ERROR opening file %s\n", filename);
-        free(newpolar);
-        return NULL;
-    }
-
-    //read file line by line
-    char line[MAX_LINE_LENGTH];
-    bool read_reynolds_number = true;
+    //read buffer line by line
+    bool read_reynolds_number = (Re <= 0.0);
     bool read_polar_points = false;
-    while (fgets(line, MAX_LINE_LENGTH, fileio)) {
+    const char* end = buffer + size;
+    const char* line = buffer;
+    while (line < end) {
+        const char* lineend = memchr(line, '\n', (size_t) (end - line));
+        if (!lineend) {
+            lineend = end;
+        }
+        size_t length = (size_t) (lineend - line);
+
         //read Reynolds number
-        if (read_reynolds_number && strstr(line, "Re =")) {     //if line contains "Re ="
+        if (read_reynolds_number && line_contains(line, length, "Re =")) {
             //line now is looking like this:
             //line = " Mach =   0.000     Re =     0.300 e 6     Ncrit =   9.000";
-            char* token = strtok(line, " ");                    //split line into tokens
-            while (token) {
-                //printf("Token: %s\n", token);
-                if (strcmp(token, "Re") == 0) {
-                    //found the "Re" token
-                    token = strtok(NULL, " ");                  //get the next token "="
-                    token = strtok(NULL, " ");                  //get the next token "0.300"
-                    double mantissa = atof(token);
-                    double exponent = 0.0;
-                    token = strtok(NULL, " ");                  //get the next token "e"
-                    if (strcmp(token, "e") == 0) {
-                        token = strtok(NULL, " ");              //get the next token "6"
-                        exponent = atof(token);
-                    }
-                    newpolar->Re = mantissa*pow(10,exponent);
-                    break;
-                }
-                token = strtok(NULL, " ");                      //get the next token
+            const char* p = line;
+            while (memcmp(p, "Re =", 4) != 0) {
+                ++p;
+            }
+            double mantissa = parse_number(p+4, lineend, &p);
+            double exponent = 0.0;
+            while (p < lineend && *p == ' ') {
+                ++p;
+            }
+            if (p+1 < lineend && *p == 'e' && p[1] == ' ') {
+                //mantissa and exponent are separated, as in "0.300 e 6"
+                exponent = parse_number(p+1, lineend, &p);
             }
+            newpolar->Re = mantissa*pow(10,exponent);
             read_reynolds_number = false;
         }
 
         //read polar points
-        if (read_polar_points && !strstr(line, "---")) {
+        else if (read_polar_points && !line_contains(line, length, "---")) {
             //line now is looking like this:
             //line = "   0.000   0.8022   0.01019   0.00422  -0.1836   0.7434   0.5993";
-            //printf("line = \"%s\"\n",line);
-            char* token = strtok(line, " ");                    //split line into tokens
-            if (!token || strlen(token)<=2) {
+            const char* token = line;
+            while (token < lineend && *token == ' ') {
+                ++token;
+            }
+            const char* tokenend = token;
+            while (tokenend < lineend && *tokenend != ' ') {
+                ++tokenend;
+            }
+            size_t tokenlength = (size_t) (tokenend - token);
+            if (tokenend == lineend && lineend < end) {
+                tokenlength += 1;           //count the newline as part of the last token
+            }
+            if (tokenlength <= 2) {
                 //empty line
                 break;
             }
 
             //add an element to alpha, CL, CD
-            newpolar->alpha = (double*) realloc(newpolar->alpha, (newpolar->size+1)*sizeof(double));
-            newpolar->CL = (double*) realloc(newpolar->CL, (newpolar->size+1)*sizeof(double));
-            newpolar->CD = (double*) realloc(newpolar->CD, (newpolar->size+1)*sizeof(double));
-            newpolar->size += 1;
+            if (newpolar->size == capacity) {
+                capacity = (capacity > 0)? 2*capacity : 64;
+                double* alpha = realloc(newpolar->alpha, capacity*sizeof(double));
+                if (alpha) newpolar->alpha = alpha;
+                double* CL = realloc(newpolar->CL, capacity*sizeof(double));
+                if (CL) newpolar->CL = CL;
+                double* CD = realloc(newpolar->CD, capacity*sizeof(double));
+                if (CD) newpolar->CD = CD;
+                if (!alpha || !CL || !CD) {
+                    qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in read_xfoil_polar_from_file()");
+                    newpolar->size = 0;
+                    break;
+                }
+            }
 
             //set the last element of alpha, CL, CD
-            newpolar->alpha[newpolar->size-1] = deg2rad(atof(token));
-            token = strtok(NULL, " ");                          //get the next token "0.8022"
-            newpolar->CL[newpolar->size-1] = atof(token);
-            token = strtok(NULL, " ");                          //get the next token "0.01019"
-            newpolar->CD[newpolar->size-1] = atof(token);
+            const char* p = token;
+            newpolar->alpha[newpolar->size] = deg2rad(parse_number(p, lineend, &p));
+            newpolar->CL[newpolar->size] = parse_number(p, lineend, &p);
+            newpolar->CD[newpolar->size] = parse_number(p, lineend, &p);
+            newpolar->size += 1;
         }
 
         //check if line contains "alpha", "CL", "CD" to eventually start reading polar points
-        if (!read_reynolds_number && !read_polar_points && strstr(line, "alpha") && strstr(line, "CL") && strstr(line, "CD")) {
+        else if (!read_reynolds_number && !read_polar_points && line_contains(line, length, "alpha")
+                 && line_contains(line, length, "CL") && line_contains(line, length, "CD")) {
             //starting reading polar points from the line following the next one
             read_polar_points = true;
         }
+        line = lineend + 1;
     }
-    fclose(fileio);
     if (newpolar->Re==0 || newpolar->size==0) {
-        printf("ERROR unable to parse polar from %s\n", filename);
+        qprop_log(QPROP_ERROR_FILE, "ERROR unable to parse polar from %s", name);
         free(newpolar->alpha);
         free(newpolar->CL);
         free(newpolar->CD);
         free(newpolar);
         return NULL;
     }
+
+    //trim the arrays to the number of points
+    double* alpha = realloc(newpolar->alpha, newpolar->size*sizeof(double));
+    if (alpha) newpolar->alpha = alpha;
+    double* CL = realloc(newpolar->CL, newpolar->size*sizeof(double));
+    if (CL) newpolar->CL = CL;
+    double* CD = realloc(newpolar->CD, newpolar->size*sizeof(double));
+    if (CD) newpolar->CD = CD;
+    update_polar_spacing(newpolar);
+    return newpolar;
+}
+
+//read xfoil polar from a buffer in memory
+//WARNING: the content of the buffer is not checked
+//the polar is supposed to start at min(alpha), go to 0 and finish at max(alpha)
+Polar* read_xfoil_polar_from_buffer(const char* buffer, size_t size) {
+    return parse_xfoil_polar(buffer, size, "buffer", 0.0);
+}
+
+//read xfoil polar from file, with a known Reynolds number (or 0 to read it from the file)
+//INTERNAL USE ONLY
+Polar* read_xfoil_polar_from_file_with_reynolds(const char *filename, double Re) {
+    FILE* fileio = fopen(filename, "rb");
+    if (!fileio) {
+        qprop_log(QPROP_ERROR_FILE, "ERROR opening file %s", filename);
+        return NULL;
+    }
+
+    //read the whole file at once
+    char* buffer = NULL;
+    size_t size = 0;
+    size_t capacity = 0;
+    while (true) {
+        if (size == capacity) {
+            capacity = (capacity > 0)? 2*capacity : 16384;
+            char* newbuffer = realloc(buffer, capacity);
+            if (!newbuffer) {
+                qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in read_xfoil_polar_from_file()");
+                free(buffer);
+                fclose(fileio);
+                return NULL;
+            }
+            buffer = newbuffer;
+        }
+        size_t nread = fread(buffer + size, 1, capacity - size, fileio);
+        size += nread;
+        if (nread == 0) {
+            break;
+        }
+    }
+    fclose(fileio);
+
+    Polar* newpolar = parse_xfoil_polar(buffer, size, filename, Re);
+    free(buffer);
     return newpolar;
 }
 
+//read xfoil polar from file
+//WARNING: the content of the file is not checked
+//the polar is supposed to start at min(alpha), go to 0 and finish at max(alpha)
+Polar* read_xfoil_polar_from_file(const char *filename) {
+    return read_xfoil_polar_from_file_with_reynolds(filename, 0.0);
+}
+
+//infer the Reynolds number from a XFLR5 file name, e.g. "NACA 4412_T1_Re0.300_M0.00_N6.0.txt"
+//returns 0 if the name does not contain the pattern "_Re<millions>_"
+double reynolds_number_from_filename(const char* filename) {
+    double Re = 0.0;
+    const char* p = filename;
+    while ((p = strstr(p, "_Re")) != NULL) {
+        const char* end = p + 3;
+        while (isdigit((unsigned char) *end) || *end == '.') {
+            ++end;
+        }
+        if (end > p+3 && *end == '_') {
+            const char* next;
+            double millions = parse_number(p+3, end, &next);
+            if (next == end) {
+                //XFLR5 writes the Reynolds number in millions with three decimals
+                Re = floor(millions*1e6 + 0.5);
+            }
+        }
+        p += 3;
+    }
+    return Re;
+}
+
 //free allocated memory on a polar
 void free_polar(Polar* currentpolar) {
     if (currentpolar->alpha) {
@@ -153,19 +1028,75 @@ void free_polar(Polar* currentpolar) {
     currentpolar = NULL;
 }
 
-//free allocated memory on an airfoil
+//unmap a binary file loaded in memory
+//INTERNAL USE ONLY
+void unmap_binary_file(void* mapping, size_t mapsize) {
+#if defined(_WIN32)
+    (void) mapsize;
+    UnmapViewOfFile(mapping);
+#else
+    munmap(mapping, mapsize);
+#endif
+}
+
+//free allocated memory on compiled polars
+void free_compiled_airfoil(CompiledAirfoil* compiled) {
+    if (compiled->mapping) {
+        //the arrays are stored in a memory-mapped file (and their single-precision copy after the structure)
+        unmap_binary_file(compiled->mapping, compiled->mapsize);
+        compiled->mapping = NULL;
+    }
+    //otherwise the arrays are stored in the same block of the structure
+    free(compiled);
+}
+
+//free allocated memory on an airfoil, if it is not used by other rotors
 void free_airfoil(Airfoil* currentairfoil) {
+    if (currentairfoil->refcount > 1) {
+        //still referenced by some rotors
+        currentairfoil->refcount -= 1;
+        return;
+    }
+    if (currentairfoil->compiled && currentairfoil->compiled->mapping) {
+        //the polars of a memory-mapped airfoil live in a single block, pointing to the mapping
+        free(currentairfoil->polars);
+        currentairfoil->polars = NULL;
+        currentairfoil->size = 0;
+    }
     for (int i=0; i<currentairfoil->size; ++i) {
         free_polar(currentairfoil->polars[i]);
         currentairfoil->polars[i] = NULL;
     }
     free(currentairfoil->polars);
     currentairfoil->polars = NULL;
+    if (currentairfoil->compiled) {
+        free_compiled_airfoil(currentairfoil->compiled);
+        currentairfoil->compiled = NULL;
+    }
     free(currentairfoil);
     currentairfoil = NULL;
 }
 
-//sort airfoil polars from lowest to highest Re - selection sort algorithm
+//compare two polars by Reynolds number, for qsort
+//INTERNAL USE ONLY
+int compare_polars_reynolds(const void* a, const void* b) {
+    double x = (*(Polar* const*) a)->Re;
+    double y = (*(Polar* const*) b)->Re;
+    return (x > y) - (x < y);
+}
+
+//check if the airfoil polars are sorted from lowest to highest Re
+//INTERNAL USE ONLY
+bool airfoil_polars_sorted(const Airfoil* currentairfoil) {
+    for (int i=1; i<currentairfoil->size; ++i) {
+        if (currentairfoil->polars[i]->Re < currentairfoil->polars[i-1]->Re) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//sort airfoil polars from lowest to highest Re
 //INTERNAL USE ONLY
 void sort_airfoil_polars(Airfoil* currentairfoil)
 {
@@ -173,23 +1104,12 @@ void sort_airfoil_polars(Airfoil* currentairfoil)
         //nothing to sort
         return;
     }
-
-    for (int i=0; i<currentairfoil->size; ++i) {
-        //find the lowest Re
-        int lowest_idx = i;
-        for (int j=i; j<currentairfoil->size; ++j) {
-            if (currentairfoil->polars[j]->Re < currentairfoil->polars[lowest_idx]->Re) {
-                lowest_idx = j;
-            }
-        }
-
-        //place smallest Re first
-        Polar* tmp = currentairfoil->polars[i];
-        currentairfoil->polars[i] = currentairfoil->polars[lowest_idx];
-        currentairfoil->polars[lowest_idx] = tmp;
-    }
-    return;
-}
+    if (airfoil_polars_sorted(currentairfoil)) {
+        return;
+    }
+    qsort(currentairfoil->polars, currentairfoil->size, sizeof(Polar*), compare_polars_reynolds);
+    return;
+}
 
 //import xfoil polars from multiple files
 //WARNING: safety checks on user input are not implemented yet
@@ -197,13 +1117,14 @@ void sort_airfoil_polars(Airfoil* currentairfoil)
 Airfoil* import_xfoil_polars(const char *filenames[], int number_of_files) {
     Airfoil* newairfoil = calloc(1, sizeof(Airfoil));
     if (!newairfoil) {
-        printf("ERROR: memory allocation error in import_xfoil_polars()\n");
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in import_xfoil_polars()");
         return NULL;
     }
     newairfoil->polars = calloc(number_of_files, sizeof(Polar*));
     newairfoil->size = 0;
+    newairfoil->refcount = 1;
     if (!newairfoil->polars) {
-        printf("ERROR: memory allocation error in import_xfoil_polars()\n");
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in import_xfoil_polars()");
         free(newairfoil);
         return NULL;
     }
@@ -220,16 +1141,133 @@ Airfoil* import_xfoil_polars(const char *filenames[], int number_of_files) {
     //sort polars from lowest to highest Re
     sort_airfoil_polars(newairfoil);
 
+    //compile polars for a faster interpolation
+    compile_airfoil(newairfoil);
+
     return newairfoil;
 }
 
+//data structure for the parallel import of polar files
+//INTERNAL USE ONLY
+typedef struct {
+    const char** filenames;         //names of all the polar files
+    Polar** polars;                 //imported polars (NULL if the file could not be read)
+    bool reynolds_from_filename;    //true to take Re from the XFLR5 file names when available
+} PolarImport;
+
+//read the i-th polar file of a parallel import
+//INTERNAL USE ONLY
+void import_polar_file(int i, void* polarimport) {
+    PolarImport* import = (PolarImport*) polarimport;
+    double Re = (import->reynolds_from_filename)? reynolds_number_from_filename(import->filenames[i]) : 0.0;
+    import->polars[i] = read_xfoil_polar_from_file_with_reynolds(import->filenames[i], Re);
+}
+
+//sort and compile the i-th airfoil of a parallel import
+//INTERNAL USE ONLY
+void compile_imported_airfoil(int i, void* airfoils) {
+    Airfoil* currentairfoil = ((Airfoil**) airfoils)[i];
+    if (currentairfoil) {
+        sort_airfoil_polars(currentairfoil);
+        compile_airfoil(currentairfoil);
+    }
+}
+
+//import several airfoils at once, reading the polar files in parallel
+//the files that cannot be read are skipped and flagged in loaded (if not NULL)
+Airfoil** import_xfoil_polars_parallel(const char** filenames[], const int number_of_files[], int number_of_airfoils,
+                                       bool reynolds_from_filename, int nthreads, bool* loaded) {
+    if (number_of_airfoils < 1) {
+        return NULL;
+    }
+    int ntotal = 0;
+    for (int k=0; k<number_of_airfoils; ++k) {
+        ntotal += number_of_files[k];
+    }
+    Airfoil** airfoils = calloc(number_of_airfoils, sizeof(Airfoil*));
+    const char** allfilenames = malloc((ntotal > 0 ? ntotal : 1)*sizeof(const char*));
+    Polar** allpolars = calloc((ntotal > 0 ? ntotal : 1), sizeof(Polar*));
+    if (!airfoils || !allfilenames || !allpolars) {
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in import_xfoil_polars_parallel()");
+        free(airfoils);
+        free(allfilenames);
+        free(allpolars);
+        return NULL;
+    }
+
+    //read all the files in parallel
+    int n = 0;
+    for (int k=0; k<number_of_airfoils; ++k) {
+        for (int i=0; i<number_of_files[k]; ++i) {
+            allfilenames[n++] = filenames[k][i];
+        }
+    }
+    PolarImport import = {allfilenames, allpolars, reynolds_from_filename};
+    parallel_for(ntotal, nthreads, import_polar_file, &import);
+
+    //group the polars into airfoils
+    n = 0;
+    for (int k=0; k<number_of_airfoils; ++k) {
+        int nloaded = 0;
+        for (int i=0; i<number_of_files[k]; ++i) {
+            if (loaded) {
+                loaded[n+i] = (allpolars[n+i] != NULL);
+            }
+            nloaded += (allpolars[n+i] != NULL);
+        }
+        if (nloaded > 0) {
+            airfoils[k] = calloc(1, sizeof(Airfoil));
+            if (airfoils[k]) {
+                airfoils[k]->polars = malloc(nloaded*sizeof(Polar*));
+                airfoils[k]->refcount = 1;
+                if (!airfoils[k]->polars) {
+                    free(airfoils[k]);
+                    airfoils[k] = NULL;
+                }
+            }
+        }
+        for (int i=0; i<number_of_files[k]; ++i) {
+            if (allpolars[n+i] && airfoils[k]) {
+                airfoils[k]->polars[airfoils[k]->size++] = allpolars[n+i];
+            }
+            else if (allpolars[n+i]) {
+                qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in import_xfoil_polars_parallel()");
+                free_polar(allpolars[n+i]);
+                if (loaded) {
+                    loaded[n+i] = false;
+                }
+            }
+        }
+        n += number_of_files[k];
+    }
+
+    //sort and compile the airfoils in parallel
+    parallel_for(number_of_airfoils, nthreads, compile_imported_airfoil, airfoils);
+    free(allfilenames);
+    free(allpolars);
+    return airfoils;
+}
+
+//free allocated memory on an array of airfoils
+void free_airfoils(Airfoil** airfoils, int number_of_airfoils) {
+    if (!airfoils) {
+        return;
+    }
+    for (int k=0; k<number_of_airfoils; ++k) {
+        if (airfoils[k]) {
+            free_airfoil(airfoils[k]);
+        }
+    }
+    free(airfoils);
+}
+
 //generate polars using the simple analytic model described by Drela in the QPROP user guide
 Airfoil* analytic_polar_curves(double CL0, double CL_a, double CLmin, double CLmax,
                               double CD0, double CD2u, double CD2l, double CLCD0,
                               double REref, double REexp) {
     Airfoil* newairfoil = calloc(1, sizeof(Airfoil));
     if (!newairfoil) {
-        printf("ERROR: memory allocation error in analytic_polar_curves()\n");
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in analytic_polar_curves()");
         return NULL;
     }
 
@@ -246,6 +1284,7 @@ Airfoil* analytic_polar_curves(double CL0, double CL_a, double CLmin, double CLm
     //Airfoil newairfoil;
     newairfoil->polars = calloc(size_Re, sizeof(Polar*));
     newairfoil->size = size_Re;
+    newairfoil->refcount = 1;
     for (int i=0; i<size_Re; ++i) {
         newairfoil->polars[i] = calloc(1, sizeof(Polar));
         newairfoil->polars[i]->Re = Re[i];
@@ -276,7 +1315,11 @@ Airfoil* analytic_polar_curves(double CL0, double CL_a, double CLmin, double CLm
             newairfoil->polars[i]->CL[j] = CL;
             newairfoil->polars[i]->CD[j] = CD;
         }
+        update_polar_spacing(newairfoil->polars[i]);
     }
+
+    //compile polars for a faster interpolation
+    compile_airfoil(newairfoil);
     return newairfoil;
 }
 
@@ -297,14 +1340,91 @@ typedef struct {
     double CD;
 } PolarPoint;
 
-//interpolate airfoil coefficient across a polar
+//data structure for the last brackets found when interpolating airfoil polars
+//consecutive queries are usually close to each other, so the search restarts from here
+//NOTE: a zero index means that no bracket is available
 //INTERNAL USE ONLY
-PolarPoint* interpolate_polar(Polar* currentpolar, double alpha) {
-    PolarPoint* query = calloc(1, sizeof(PolarPoint));
-    if (!query) {
-        printf("ERROR: memory allocation error in interpolate_polar()\n");
-        return NULL;
+typedef struct {
+    int polar;          //index of the upper polar bracketing Re
+    int lower;          //index of the upper point bracketing alpha in the lower polar
+    int upper;          //index of the upper point bracketing alpha in the upper polar
+#if defined(QPROP_STATS)
+    int nalphaclamped;  //number of queries beyond the alpha range
+    int nReclamped;     //number of queries beyond the Re range
+#endif
+} InterpolationHint;
+
+//find the index i such that x[i-1] < xq <= x[i], for x sorted in ascending order and x[0] < xq <= x[size-1]
+//the previous index (hint) and its neighbours are tried first, then the index is either computed
+//directly (uniform spacing dx > 0) or found by binary search
+//INTERNAL USE ONLY
+int find_bracket(const double* x, int size, double xq, double dx, int hint) {
+    if (hint >= 1 && hint < size) {
+        if (x[hint-1] < xq && xq <= x[hint]) {
+            return hint;
+        }
+        if (hint+1 < size && x[hint] < xq && xq <= x[hint+1]) {
+            return hint+1;
+        }
+        if (hint >= 2 && x[hint-2] < xq && xq <= x[hint-1]) {
+            return hint-1;
+        }
+    }
+    int i = 1;
+    if (dx > 0.0) {
+        //guess the index from the uniform spacing, then correct any round-off error
+        double guess = ceil((xq - x[0]) / dx);
+        i = (guess < 1.0)? 1 : (guess > size-1)? size-1 : (int) guess;
+        while (i > 1 && x[i-1] >= xq) {
+            --i;
+        }
+        while (i < size-1 && x[i] < xq) {
+            ++i;
+        }
+        return i;
+    }
+    //binary search for the first point not lower than xq
+    int lo = 1;
+    int hi = size-1;
+    while (lo < hi) {
+        int mid = lo + (hi-lo)/2;
+        if (x[mid] < xq) {
+            lo = mid+1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+//find the index i such that polars[i-1]->Re < Re <= polars[i]->Re, for polars sorted in ascending Re
+//INTERNAL USE ONLY
+int find_polar_bracket(Airfoil* currentairfoil, double Re, int hint) {
+    Polar** polars = currentairfoil->polars;
+    int size = currentairfoil->size;
+    if (hint >= 1 && hint < size && polars[hint-1]->Re < Re && Re <= polars[hint]->Re) {
+        return hint;
+    }
+    int lo = 1;
+    int hi = size-1;
+    while (lo < hi) {
+        int mid = lo + (hi-lo)/2;
+        if (polars[mid]->Re < Re) {
+            lo = mid+1;
+        }
+        else {
+            hi = mid;
+        }
     }
+    return lo;
+}
+
+//interpolate airfoil coefficient across a polar, writing the result into a caller-provided point
+//hint: index of the last alpha bracket found on this polar (0 if not available), updated on exit
+//no memory is allocated, so it can be safely used in the inner iterations
+//INTERNAL USE ONLY
+void interpolate_polar_hint(PolarPoint* query, Polar* currentpolar, double alpha, int* hint) {
     query->alpha = alpha;
     query->CL = 0.0;
     query->CD = 0.0;
@@ -323,7 +1443,7 @@ PolarPoint* interpolate_polar(Polar* currentpolar, double alpha) {
         //ALTERNATIVE: constant cap on the left
         //query->CL = currentpolar->CL[0];
         //query->CD = currentpolar->CD[0];
-        return query;
+        return;
     }
     else if (alpha > currentpolar->alpha[currentpolar->size-1]) {
         //above maximum AoA
@@ -339,87 +1459,184 @@ PolarPoint* interpolate_polar(Polar* currentpolar, double alpha) {
         //ALTERNATIVE: constant cap on the right
         //query->CL = currentpolar->CL[currentpolar->size-1];
         //query->CD = currentpolar->CD[currentpolar->size-1];
-        return query;
+        return;
     }
     
     //interpolate between two alpha
-    for (int i=1; i<(currentpolar->size); ++i) {
-        if (currentpolar->alpha[i-1] < alpha && alpha <= currentpolar->alpha[i]) {
-            query->CL = interp1(
-                currentpolar->alpha[i-1],       //x1
-                currentpolar->CL[i-1],          //y1
-                currentpolar->alpha[i],         //x2
-                currentpolar->CL[i],            //y2
-                alpha                           //xq
-            );
-            query->CD = interp1(
-                currentpolar->alpha[i-1],       //x1
-                currentpolar->CD[i-1],          //y1
-                currentpolar->alpha[i],         //x2
-                currentpolar->CD[i],            //y2
-                alpha                           //xq
-            );
-            break;
-        }
-    }
-    return query;
+    int i = find_bracket(currentpolar->alpha, currentpolar->size, alpha, currentpolar->dalpha, *hint);
+    *hint = i;
+    query->CL = interp1(
+        currentpolar->alpha[i-1],       //x1
+        currentpolar->CL[i-1],          //y1
+        currentpolar->alpha[i],         //x2
+        currentpolar->CL[i],            //y2
+        alpha                           //xq
+    );
+    query->CD = interp1(
+        currentpolar->alpha[i-1],       //x1
+        currentpolar->CD[i-1],          //y1
+        currentpolar->alpha[i],         //x2
+        currentpolar->CD[i],            //y2
+        alpha                           //xq
+    );
 }
 
-//interpolate airfoil polars
+//interpolate airfoil coefficient across a polar, writing the result into a caller-provided point
+//no memory is allocated, so it can be safely used in the inner iterations
 //INTERNAL USE ONLY
-PolarPoint* interpolate_airfoil_polars(Airfoil* currentairfoil, double alpha, double Re, double Mach) {
-    //find the two polars that bracket the query point
+void interpolate_polar_into(PolarPoint* query, Polar* currentpolar, double alpha) {
+    int hint = 0;
+    interpolate_polar_hint(query, currentpolar, alpha, &hint);
+}
+
+//interpolate airfoil coefficient across a polar
+//NOTE: the returned point must be freed by the caller
+//INTERNAL USE ONLY
+PolarPoint* interpolate_polar(Polar* currentpolar, double alpha) {
     PolarPoint* query = calloc(1, sizeof(PolarPoint));
     if (!query) {
-        printf("ERROR: memory allocation error in interpolate_airfoil_polars()\n");
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in interpolate_polar()");
         return NULL;
     }
+    interpolate_polar_into(query, currentpolar, alpha);
+    return query;
+}
+
+//interpolate compiled airfoil polars, writing the result into a caller-provided point
+//the polars share the same alpha grid, so a single alpha bracket is searched for both of them
+//hint: last brackets found on this airfoil (all zeros if not available), updated on exit
+//INTERNAL USE ONLY
+void interpolate_compiled_airfoil_hint(PolarPoint* query, const CompiledAirfoil* compiled, double alpha, double Re, double Mach, InterpolationHint* hint) {
+    query->alpha = alpha;
+    int nalpha = compiled->nalpha;
+    const double* alphas = compiled->alpha;
+
+    //find the two polars that bracket the query point
+    int lower_polar_idx = 0;
+    int upper_polar_idx = compiled->nRe - 1;
+    if (Re <= compiled->Re[0]) {
+        //use the lowest polar
+        upper_polar_idx = 0;
+        QPROP_STATS_ADD(hint->nReclamped, (Re < compiled->Re[0]));
+    }
+    else if (Re > compiled->Re[compiled->nRe-1]) {
+        //use the highest polar
+        lower_polar_idx = compiled->nRe - 1;
+        QPROP_STATS_ADD(hint->nReclamped, 1);
+    }
+    else {
+        //interpolate between two polars
+        upper_polar_idx = find_bracket(compiled->Re, compiled->nRe, Re, 0.0, hint->polar);
+        lower_polar_idx = upper_polar_idx - 1;
+        hint->polar = upper_polar_idx;
+    }
+    const qprop_real* lower = compiled->CLCDr + 2*lower_polar_idx*nalpha;
+    const qprop_real* upper = compiled->CLCDr + 2*upper_polar_idx*nalpha;
+
+    //interpolate across alpha at the lower and upper polars
+    double CLlower, CDlower, CLupper, CDupper;
+    if (alpha <= alphas[0]) {
+        //below minimum AoA
+        //interpolate to retrieve CD=2.0 at alpha=-90°
+        CLlower = lower[0];
+        CLupper = upper[0];
+        QPROP_STATS_ADD(hint->nalphaclamped, (alpha < alphas[0]));
+        CDlower = interp1(-PI/2, 2.0, alphas[0], lower[1], alpha);
+        CDupper = interp1(-PI/2, 2.0, alphas[0], upper[1], alpha);
+    }
+    else if (alpha > alphas[nalpha-1]) {
+        //above maximum AoA
+        //interpolate to retrieve CD=2.0 at alpha=+90°
+        CLlower = lower[2*nalpha-2];
+        CLupper = upper[2*nalpha-2];
+        QPROP_STATS_ADD(hint->nalphaclamped, 1);
+        CDlower = interp1(alphas[nalpha-1], lower[2*nalpha-1], PI/2, 2.0, alpha);
+        CDupper = interp1(alphas[nalpha-1], upper[2*nalpha-1], PI/2, 2.0, alpha);
+    }
+    else {
+        //interpolate between two alpha
+        int i = find_bracket(alphas, nalpha, alpha, compiled->dalpha, hint->lower);
+        hint->lower = i;
+        CLlower = interp1(alphas[i-1], lower[2*i-2], alphas[i], lower[2*i], alpha);
+        CDlower = interp1(alphas[i-1], lower[2*i-1], alphas[i], lower[2*i+1], alpha);
+        CLupper = interp1(alphas[i-1], upper[2*i-2], alphas[i], upper[2*i], alpha);
+        CDupper = interp1(alphas[i-1], upper[2*i-1], alphas[i], upper[2*i+1], alpha);
+    }
+
+    //interpolate across Re
+    query->CL = interp1(compiled->Re[lower_polar_idx], CLlower, compiled->Re[upper_polar_idx], CLupper, Re);
+    query->CD = interp1(compiled->Re[lower_polar_idx], CDlower, compiled->Re[upper_polar_idx], CDupper, Re);
+
+    //optional: correct for Mach number using the Prantdl-Meyer compressibility factor
+    if (Mach > 0.01 && Mach < 0.99){
+        query->CL = query->CL / sqrt(1.0 - Mach*Mach);
+    }
+}
+
+//interpolate airfoil polars, writing the result into a caller-provided point
+//hint: last brackets found on this airfoil (all zeros if not available), updated on exit
+//no memory is allocated, so it can be safely used in the inner iterations
+//INTERNAL USE ONLY
+void interpolate_airfoil_polars_hint(PolarPoint* query, Airfoil* currentairfoil, double alpha, double Re, double Mach, InterpolationHint* hint) {
+    if (currentairfoil->compiled) {
+        //fast path on the compiled polars
+        interpolate_compiled_airfoil_hint(query, currentairfoil->compiled, alpha, Re, Mach, hint);
+        return;
+    }
     query->alpha = alpha;
     query->CL = 0.0;
     query->CD = 0.0;
 
+    //find the two polars that bracket the query point
     int lower_polar_idx = 0;
     int upper_polar_idx = currentairfoil->size - 1;
     if (Re <= currentairfoil->polars[0]->Re) {
         //use the lowest polar
         upper_polar_idx = 0;
+        QPROP_STATS_ADD(hint->nReclamped, (Re < currentairfoil->polars[0]->Re));
     }
     else if (Re > currentairfoil->polars[currentairfoil->size-1]->Re) {
         //use the highest polar
         lower_polar_idx = currentairfoil->size - 1;
+        QPROP_STATS_ADD(hint->nReclamped, 1);
     }
     else {
         //interpolate between two polars
-        for (int i=1; i<(currentairfoil->size); ++i) {
-            if (Re > currentairfoil->polars[i-1]->Re && Re <= currentairfoil->polars[i]->Re) {
-                lower_polar_idx = i-1;
-                upper_polar_idx = i;
-                break;
-            }
-        }
+        upper_polar_idx = find_polar_bracket(currentairfoil, Re, hint->polar);
+        lower_polar_idx = upper_polar_idx - 1;
+    }
+    if (upper_polar_idx != hint->polar) {
+        //the alpha brackets refer to different polars
+        hint->polar = upper_polar_idx;
+        hint->lower = 0;
+        hint->upper = 0;
     }
 
     //interpolate across alpha at the lower and upper polars
-    PolarPoint* lower = interpolate_polar(currentairfoil->polars[lower_polar_idx], alpha);
-    PolarPoint* upper = interpolate_polar(currentairfoil->polars[upper_polar_idx], alpha);
+    PolarPoint lower;
+    PolarPoint upper;
+    interpolate_polar_hint(&lower, currentairfoil->polars[lower_polar_idx], alpha, &(hint->lower));
+    interpolate_polar_hint(&upper, currentairfoil->polars[upper_polar_idx], alpha, &(hint->upper));
+#if defined(QPROP_STATS)
+    const Polar* upperpolar = currentairfoil->polars[upper_polar_idx];
+    hint->nalphaclamped += (alpha < upperpolar->alpha[0] || alpha > upperpolar->alpha[upperpolar->size-1]);
+#endif
 
     //interpolate across Re
     query->CL = interp1(
         currentairfoil->polars[lower_polar_idx]->Re,    //x1
-        lower->CL,                                      //y1
+        lower.CL,                                       //y1
         currentairfoil->polars[upper_polar_idx]->Re,    //x2
-        upper->CL,                                      //y2
+        upper.CL,                                       //y2
         Re                                              //xq
     );
     query->CD = interp1(
         currentairfoil->polars[lower_polar_idx]->Re,    //x1
-        lower->CD,                                      //y1
+        lower.CD,                                       //y1
         currentairfoil->polars[upper_polar_idx]->Re,    //x2
-        upper->CD,                                      //y2
+        upper.CD,                                       //y2
         Re                                              //xq
     );
-    free(lower);
-    free(upper);
 
     //optional: correct for Mach number using the Prantdl-Meyer compressibility factor
     //set Mach = 0 to disable correction
@@ -429,98 +1646,665 @@ PolarPoint* interpolate_airfoil_polars(Airfoil* currentairfoil, double alpha, do
         //no warning will be issued, as this call may be part of an inner iteration
         //it is the user's responsibility to perform a sanity check on the final result
     }
+}
+
+//interpolate airfoil polars, writing the result into a caller-provided point
+//no memory is allocated, so it can be safely used in the inner iterations
+//INTERNAL USE ONLY
+void interpolate_airfoil_polars_into(PolarPoint* query, Airfoil* currentairfoil, double alpha, double Re, double Mach) {
+    InterpolationHint hint = {0};
+    interpolate_airfoil_polars_hint(query, currentairfoil, alpha, Re, Mach, &hint);
+}
+
+//interpolate airfoil polars
+//NOTE: the returned point must be freed by the caller
+//INTERNAL USE ONLY
+PolarPoint* interpolate_airfoil_polars(Airfoil* currentairfoil, double alpha, double Re, double Mach) {
+    PolarPoint* query = calloc(1, sizeof(PolarPoint));
+    if (!query) {
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in interpolate_airfoil_polars()");
+        return NULL;
+    }
+    interpolate_airfoil_polars_into(query, currentairfoil, alpha, Re, Mach);
     return query;
 }
 
-//append a new section at the end of the rotor
-//NOTE: the rotor diameter is NOT updated!
-void push_rotor_section(Rotor* rotor, double c, double beta, double r, Airfoil* airfoil) {
-    if (!rotor) {
+//data structure of the interpolated coefficients of an airfoil with their local slopes
+//INTERNAL USE ONLY
+typedef struct {
+    double CL;
+    double CD;
+    double dCLdalpha;   //(1/rad)
+    double dCDdalpha;   //(1/rad)
+    double dCLdRe;
+    double dCDdRe;
+} PolarSlopes;
+
+//interpolate CL and CD across alpha and compute their slopes, with the same extrapolation of interpolate_polar_hint
+//CL and CD are read with the given stride, so that both the polars and the compiled tables can be used
+//output: CL, CD, dCL/dalpha, dCD/dalpha
+//INTERNAL USE ONLY
+void interpolate_alpha_slopes(double* output, const double* alphas, const double* CL, const double* CD, int stride, int size, double dalpha, double alpha) {
+    if (alpha <= alphas[0]) {
+        //below minimum AoA: constant CL, CD interpolated to 2.0 at alpha=-90°
+        output[0] = CL[0];
+        output[1] = interp1(-PI/2, 2.0, alphas[0], CD[0], alpha);
+        output[2] = 0.0;
+        output[3] = (CD[0] - 2.0) / (alphas[0] + PI/2);
         return;
     }
-    rotor->sections = realloc(rotor->sections, (rotor->nsections+1)*sizeof(Section));
-    rotor->nsections += 1;
-    rotor->sections[rotor->nsections-1].c = c;
-    rotor->sections[rotor->nsections-1].beta = beta;
-    rotor->sections[rotor->nsections-1].r = r;
-    rotor->sections[rotor->nsections-1].airfoil = *airfoil;
+    if (alpha > alphas[size-1]) {
+        //above maximum AoA: constant CL, CD interpolated to 2.0 at alpha=+90°
+        output[0] = CL[(size-1)*stride];
+        output[1] = interp1(alphas[size-1], CD[(size-1)*stride], PI/2, 2.0, alpha);
+        output[2] = 0.0;
+        output[3] = (2.0 - CD[(size-1)*stride]) / (PI/2 - alphas[size-1]);
+        return;
+    }
+    int i = find_bracket(alphas, size, alpha, dalpha, 0);
+    double h = alphas[i] - alphas[i-1];
+    output[2] = (CL[i*stride] - CL[(i-1)*stride]) / h;
+    output[3] = (CD[i*stride] - CD[(i-1)*stride]) / h;
+    output[0] = CL[(i-1)*stride] + (alpha - alphas[i-1])*output[2];
+    output[1] = CD[(i-1)*stride] + (alpha - alphas[i-1])*output[3];
 }
 
-//read propeller geometry from APC PE0 file
-Rotor* import_rotor_geometry_apc(const char *filename, Airfoil* airfoil) {
-    Rotor* newrotor = calloc(1, sizeof(Rotor));
-    if (!newrotor) {
-        printf("ERROR: memory allocation error in import_rotor_geometry_apc()\n");
-        return NULL;
+//interpolate airfoil polars and compute the slopes of CL and CD with respect to alpha and Re
+//the interpolation is the same of interpolate_airfoil_polars_hint, without the Mach correction
+//INTERNAL USE ONLY
+void interpolate_airfoil_polars_slopes(PolarSlopes* query, Airfoil* currentairfoil, double alpha, double Re) {
+    const CompiledAirfoil* compiled = currentairfoil->compiled;
+    int nRe = (compiled)? compiled->nRe : currentairfoil->size;
+
+    //find the two polars that bracket the query point
+    int lower_polar_idx = 0;
+    int upper_polar_idx = nRe - 1;
+    double Relow = (compiled)? compiled->Re[0] : currentairfoil->polars[0]->Re;
+    double Rehigh = (compiled)? compiled->Re[nRe-1] : currentairfoil->polars[nRe-1]->Re;
+    if (Re <= Relow) {
+        upper_polar_idx = 0;
+    }
+    else if (Re > Rehigh) {
+        lower_polar_idx = nRe - 1;
+    }
+    else {
+        upper_polar_idx = (compiled)? find_bracket(compiled->Re, nRe, Re, 0.0, 0) : find_polar_bracket(currentairfoil, Re, 0);
+        lower_polar_idx = upper_polar_idx - 1;
     }
-    newrotor->D = 0.0;
-    newrotor->B = 0;
-    newrotor->nsections = 0;
-    newrotor->sections = NULL;
 
-    FILE* fileio = fopen(filename, "rb");
-    if (!fileio) {
-        printf("ERROR opening file %s\n", filename);
-        free(newrotor);
+    //interpolate across alpha at the lower and upper polars
+    double lower[4];
+    double upper[4];
+    double Re1, Re2;
+    if (compiled) {
+        const double* lowerCLCD = compiled->CLCD + 2*lower_polar_idx*compiled->nalpha;
+        const double* upperCLCD = compiled->CLCD + 2*upper_polar_idx*compiled->nalpha;
+        interpolate_alpha_slopes(lower, compiled->alpha, lowerCLCD, lowerCLCD+1, 2, compiled->nalpha, compiled->dalpha, alpha);
+        interpolate_alpha_slopes(upper, compiled->alpha, upperCLCD, upperCLCD+1, 2, compiled->nalpha, compiled->dalpha, alpha);
+        Re1 = compiled->Re[lower_polar_idx];
+        Re2 = compiled->Re[upper_polar_idx];
+    }
+    else {
+        const Polar* lowerpolar = currentairfoil->polars[lower_polar_idx];
+        const Polar* upperpolar = currentairfoil->polars[upper_polar_idx];
+        interpolate_alpha_slopes(lower, lowerpolar->alpha, lowerpolar->CL, lowerpolar->CD, 1, lowerpolar->size, lowerpolar->dalpha, alpha);
+        interpolate_alpha_slopes(upper, upperpolar->alpha, upperpolar->CL, upperpolar->CD, 1, upperpolar->size, upperpolar->dalpha, alpha);
+        Re1 = lowerpolar->Re;
+        Re2 = upperpolar->Re;
+    }
+
+    //interpolate across Re (constant beyond the range)
+    double t = (Re2 != Re1)? (Re - Re1)/(Re2 - Re1) : 0.0;
+    query->CL = lower[0] + t*(upper[0] - lower[0]);
+    query->CD = lower[1] + t*(upper[1] - lower[1]);
+    query->dCLdalpha = lower[2] + t*(upper[2] - lower[2]);
+    query->dCDdalpha = lower[3] + t*(upper[3] - lower[3]);
+    query->dCLdRe = (Re2 != Re1)? (upper[0] - lower[0])/(Re2 - Re1) : 0.0;
+    query->dCDdRe = (Re2 != Re1)? (upper[1] - lower[1])/(Re2 - Re1) : 0.0;
+}
+
+//compare two doubles for qsort
+//INTERNAL USE ONLY
+int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*) a;
+    double y = *(const double*) b;
+    return (x > y) - (x < y);
+}
+
+//resample the polars of an airfoil on a common alpha grid, within a single contiguous block
+//the airfoil is not modified: the caller owns the returned table (see compile_airfoil)
+//INTERNAL USE ONLY
+CompiledAirfoil* build_compiled_airfoil(const Airfoil* airfoil) {
+    if (!airfoil || !airfoil->polars || airfoil->size < 1) {
+        qprop_log(QPROP_ERROR_INVALID_ARGUMENT, "ERROR in compile_airfoil(): the airfoil has no polars");
         return NULL;
     }
+    int npoints = 0;
+    for (int j=0; j<airfoil->size; ++j) {
+        if (!airfoil->polars[j] || airfoil->polars[j]->size < 1) {
+            qprop_log(QPROP_ERROR_INVALID_ARGUMENT, "ERROR in compile_airfoil(): polar #%d is empty", j);
+            return NULL;
+        }
+        npoints += airfoil->polars[j]->size;
+    }
 
-    //read file line by line
-    char line[MAX_LINE_LENGTH];
-    int parse_line = false;
-    while (fgets(line, MAX_LINE_LENGTH, fileio)) {
-        //check if line contains unique keywords like "STATION" and "MAX-THICK"
-        //to start parsing from the next line
-        if (!parse_line && strstr(line, "STATION") && strstr(line, "MAX-THICK")) {
-            //printf("Enable parse line\n");
-            parse_line = true;
+    //build the common alpha grid with the angles of attack of all the polars
+    double* grid = malloc(npoints*sizeof(double));
+    int* order = malloc(airfoil->size*sizeof(int));
+    if (!grid || !order) {
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in compile_airfoil()");
+        free(grid);
+        free(order);
+        return NULL;
+    }
+    npoints = 0;
+    for (int j=0; j<airfoil->size; ++j) {
+        memcpy(grid + npoints, airfoil->polars[j]->alpha, airfoil->polars[j]->size*sizeof(double));
+        npoints += airfoil->polars[j]->size;
+    }
+    qsort(grid, npoints, sizeof(double), compare_doubles);
+    int nalpha = 1;
+    for (int i=1; i<npoints; ++i) {
+        if (grid[i] != grid[nalpha-1]) {
+            grid[nalpha++] = grid[i];
         }
+    }
 
-        //count number of items in the line
-        int token_counter = 0;
-        if (parse_line) {
-            bool in_value = false;      //keep track if current char is a value
-            if (!isblank(line[0]) && isgraph(line[0])) {
-                //printf("Starting line in value\n");
-                in_value = true;
-                token_counter += 1;
-            }
-            for (int i=1; i<MAX_LINE_LENGTH; ++i) {
-                if (line[i] == '\0' || line[i] == '\n') {
-                    break;
-                }
-                
-                if (!isblank(line[i]) && isgraph(line[i])) {
-                    if (!in_value) {
-                        token_counter += 1;
-                        //printf("New token starting from: %c (position: %i)\n", line[i],i);
-                        in_value = true;
-                    }
-                }
-                else {
-                    if (in_value) {
-                        in_value = false;
-                    }
-                }
-            }
-            //printf("Number of tokens: %i\n", token_counter);
+    //sort the polars by Re (stable, without modifying the airfoil)
+    for (int j=0; j<airfoil->size; ++j) {
+        int k = j;
+        while (k > 0 && airfoil->polars[order[k-1]]->Re > airfoil->polars[j]->Re) {
+            order[k] = order[k-1];
+            --k;
         }
+        order[k] = j;
+    }
 
-        //check if line is no longer valid for parsing
-        //note that the lines containing the header and the units of the table must be skipped
-        if (parse_line && token_counter > 2
-                && !strstr(line, "STATION") && !strstr(line, "MAX-THICK")       //skip header line
-                && !strstr(line, "(QUOTED)") && !strstr(line, "(LE-TE)")) {     //skip units line
-            for (int i=0; i<MAX_LINE_LENGTH; ++i) {
-                if (line[i] == '\0') {
-                    break;
-                }
+    //allocate the structure and its arrays in a single block, aligned to the cache lines
+    int nRe = airfoil->size;
+    size_t nbytes = (nRe + nalpha + 2*(size_t)nRe*nalpha) * sizeof(double) + compiled_real_table_size(nRe, nalpha);
+    char* block = malloc(sizeof(CompiledAirfoil) + COMPILED_ALIGNMENT + nbytes);
+    if (!block) {
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in compile_airfoil()");
+        free(grid);
+        free(order);
+        return NULL;
+    }
+    CompiledAirfoil* compiled = (CompiledAirfoil*) block;
+    size_t offset = sizeof(CompiledAirfoil) + COMPILED_ALIGNMENT - ((size_t) block + sizeof(CompiledAirfoil)) % COMPILED_ALIGNMENT;
+    compiled->nRe = nRe;
+    compiled->nalpha = nalpha;
+    compiled->mapping = NULL;
+    compiled->mapsize = 0;
+    compiled->Re = (double*) (block + offset);
+    compiled->alpha = compiled->Re + nRe;
+    compiled->CLCD = compiled->alpha + nalpha;
+    memcpy(compiled->alpha, grid, nalpha*sizeof(double));
+    compiled->dalpha = uniform_spacing(compiled->alpha, nalpha);
 
-                //if (isalpha(line[i]) || ispunct(line[i])) {
-                if (!isdigit(line[i]) && line[i] != '.' && line[i] != '-' && line[i] != 'e' && isgraph(line[i])) {
-                    //printf("Disable parse line at char %c\n", line[i]);
-                    parse_line = false;
-                    break;
+    //resample each polar on the common grid
+    //NOTE: the original polar is piecewise linear between grid points (also beyond its
+    //own alpha range), so the resampled polar interpolates to the same coefficients
+    for (int j=0; j<nRe; ++j) {
+        Polar* currentpolar = airfoil->polars[order[j]];
+        compiled->Re[j] = currentpolar->Re;
+        int hint = 0;
+        for (int i=0; i<nalpha; ++i) {
+            PolarPoint point;
+            interpolate_polar_hint(&point, currentpolar, compiled->alpha[i], &hint);
+            compiled->CLCD[2*(j*nalpha+i)] = point.CL;
+            compiled->CLCD[2*(j*nalpha+i)+1] = point.CD;
+        }
+    }
+    set_compiled_real_table(compiled, compiled->CLCD + 2*(size_t)nRe*nalpha);
+    free(grid);
+    free(order);
+    return compiled;
+}
+
+//compile the polars of an airfoil, replacing any previous compiled table
+CompiledAirfoil* compile_airfoil(Airfoil* airfoil) {
+    if (airfoil && airfoil->compiled && airfoil->compiled->mapping) {
+        //memory-mapped airfoils are read-only and already compiled
+        return airfoil->compiled;
+    }
+    CompiledAirfoil* compiled = build_compiled_airfoil(airfoil);
+    if (!compiled) {
+        return NULL;
+    }
+    if (airfoil->compiled) {
+        free_compiled_airfoil(airfoil->compiled);
+    }
+    airfoil->compiled = compiled;
+    return compiled;
+}
+
+//merge two sorted arrays, removing the duplicates - returns the size of the merged array
+//INTERNAL USE ONLY
+int merge_sorted_unique(const double* x1, int n1, const double* x2, int n2, double* merged) {
+    int i = 0, j = 0, n = 0;
+    while (i < n1 || j < n2) {
+        double x = (j >= n2 || (i < n1 && x1[i] <= x2[j]))? x1[i] : x2[j];
+        if (n == 0 || x != merged[n-1]) {
+            merged[n++] = x;
+        }
+        if (i < n1 && x1[i] == x) ++i;
+        if (j < n2 && x2[j] == x) ++j;
+    }
+    return n;
+}
+
+//blend two compiled airfoils: the coefficients are (1-w)*compiled1 + w*compiled2
+//INTERNAL USE ONLY
+Airfoil* blend_compiled_airfoils(const CompiledAirfoil* compiled1, const CompiledAirfoil* compiled2, double w) {
+    //build the common grids
+    double* Re = malloc((compiled1->nRe + compiled2->nRe)*sizeof(double));
+    double* alpha = malloc((compiled1->nalpha + compiled2->nalpha)*sizeof(double));
+    Airfoil* newairfoil = calloc(1, sizeof(Airfoil));
+    if (!Re || !alpha || !newairfoil) {
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in blend_airfoils()");
+        free(Re);
+        free(alpha);
+        free(newairfoil);
+        return NULL;
+    }
+    int nRe = merge_sorted_unique(compiled1->Re, compiled1->nRe, compiled2->Re, compiled2->nRe, Re);
+    int nalpha = merge_sorted_unique(compiled1->alpha, compiled1->nalpha, compiled2->alpha, compiled2->nalpha, alpha);
+
+    //tabulate the blended polars
+    newairfoil->polars = calloc(nRe, sizeof(Polar*));
+    newairfoil->size = 0;
+    newairfoil->refcount = 1;
+    bool success = (newairfoil->polars != NULL);
+    for (int j=0; j<nRe && success; ++j) {
+        Polar* newpolar = calloc(1, sizeof(Polar));
+        if (!newpolar) {
+            success = false;
+            break;
+        }
+        newairfoil->polars[j] = newpolar;
+        newairfoil->size += 1;
+        newpolar->Re = Re[j];
+        newpolar->alpha = malloc(nalpha*sizeof(double));
+        newpolar->CL = malloc(nalpha*sizeof(double));
+        newpolar->CD = malloc(nalpha*sizeof(double));
+        newpolar->size = nalpha;
+        if (!newpolar->alpha || !newpolar->CL || !newpolar->CD) {
+            success = false;
+            break;
+        }
+        InterpolationHint hint1 = {0};
+        InterpolationHint hint2 = {0};
+        for (int i=0; i<nalpha; ++i) {
+            PolarPoint point1, point2;
+            interpolate_compiled_airfoil_hint(&point1, compiled1, alpha[i], Re[j], 0.0, &hint1);
+            interpolate_compiled_airfoil_hint(&point2, compiled2, alpha[i], Re[j], 0.0, &hint2);
+            newpolar->alpha[i] = alpha[i];
+            newpolar->CL[i] = (1.0-w)*point1.CL + w*point2.CL;
+            newpolar->CD[i] = (1.0-w)*point1.CD + w*point2.CD;
+        }
+        update_polar_spacing(newpolar);
+    }
+    free(Re);
+    free(alpha);
+    if (!success || !compile_airfoil(newairfoil)) {
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in blend_airfoils()");
+        free_airfoil(newairfoil);
+        return NULL;
+    }
+    return newairfoil;
+}
+
+//blend two airfoils: the coefficients are (1-w)*airfoil1 + w*airfoil2
+//the blended polars are tabulated on the union of the Re and alpha grids of the two compiled airfoils,
+//where the bilinear interpolation of each airfoil is exact, so the blended airfoil interpolates
+//to the same coefficients of the two airfoils blended at every query
+Airfoil* blend_airfoils(Airfoil* airfoil1, Airfoil* airfoil2, double w) {
+    //the airfoils are only read: the missing compiled tables are built temporarily
+    CompiledAirfoil* temporary1 = (airfoil1 && airfoil1->compiled)? NULL : build_compiled_airfoil(airfoil1);
+    CompiledAirfoil* temporary2 = (airfoil2 && airfoil2->compiled)? NULL : build_compiled_airfoil(airfoil2);
+    const CompiledAirfoil* compiled1 = (temporary1)? temporary1 : (airfoil1)? airfoil1->compiled : NULL;
+    const CompiledAirfoil* compiled2 = (temporary2)? temporary2 : (airfoil2)? airfoil2->compiled : NULL;
+    Airfoil* newairfoil = (compiled1 && compiled2)? blend_compiled_airfoils(compiled1, compiled2, w) : NULL;
+    if (!compiled1 || !compiled2) {
+        qprop_log(QPROP_ERROR_INVALID_ARGUMENT, "ERROR in blend_airfoils(): invalid airfoils");
+    }
+    if (temporary1) {
+        free_compiled_airfoil(temporary1);
+    }
+    if (temporary2) {
+        free_compiled_airfoil(temporary2);
+    }
+    return newairfoil;
+}
+
+//add a reference to an airfoil
+//NOTE: airfoils with refcount=0 are managed by the caller, and they are never freed by the rotors
+//INTERNAL USE ONLY
+Airfoil* retain_airfoil(Airfoil* airfoil) {
+    if (airfoil && airfoil->refcount > 0) {
+        airfoil->refcount += 1;
+    }
+    return airfoil;
+}
+
+//find an airfoil in the airfoil table of a rotor, adding it if needed
+//returns the index of the airfoil in the table, or -1 if the table cannot be extended
+//INTERNAL USE ONLY
+int rotor_airfoil_index(Rotor* rotor, Airfoil* airfoil) {
+    for (int k=0; k<rotor->nairfoils; ++k) {
+        if (rotor->airfoils[k] == airfoil) {
+            return k;
+        }
+    }
+    Airfoil** airfoils = realloc(rotor->airfoils, (rotor->nairfoils+1)*sizeof(Airfoil*));
+    if (!airfoils) {
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in push_rotor_section()");
+        return -1;
+    }
+    rotor->airfoils = airfoils;
+    rotor->airfoils[rotor->nairfoils] = retain_airfoil(airfoil);
+    rotor->nairfoils += 1;
+    return rotor->nairfoils-1;
+}
+
+//add an airfoil created by the rotor to its airfoil table, transferring its reference
+//returns the index of the airfoil in the table, or -1 on errors
+//INTERNAL USE ONLY
+int add_owned_rotor_airfoil(Rotor* rotor, Airfoil* airfoil) {
+    if (!airfoil) {
+        return -1;
+    }
+    int airfoil_idx = rotor_airfoil_index(rotor, airfoil);
+    free_airfoil(airfoil);          //the rotor table now holds the only reference
+    return airfoil_idx;
+}
+
+//check if two airfoils have the same polar data
+//INTERNAL USE ONLY
+bool airfoils_identical(const Airfoil* airfoil1, const Airfoil* airfoil2) {
+    if (airfoil1 == airfoil2) {
+        return true;
+    }
+    const CompiledAirfoil* compiled1 = airfoil1->compiled;
+    const CompiledAirfoil* compiled2 = airfoil2->compiled;
+    if (compiled1 && compiled2) {
+        //the compiled tables are the ones used by the interpolation
+        size_t size = 2*(size_t)compiled1->nRe*compiled1->nalpha;
+        return compiled1->nRe == compiled2->nRe && compiled1->nalpha == compiled2->nalpha
+               && memcmp(compiled1->Re, compiled2->Re, compiled1->nRe*sizeof(double)) == 0
+               && memcmp(compiled1->alpha, compiled2->alpha, compiled1->nalpha*sizeof(double)) == 0
+               && memcmp(compiled1->CLCD, compiled2->CLCD, size*sizeof(double)) == 0;
+    }
+    if (compiled1 || compiled2 || airfoil1->size != airfoil2->size) {
+        return false;
+    }
+    for (int k=0; k<airfoil1->size; ++k) {
+        const Polar* polar1 = airfoil1->polars[k];
+        const Polar* polar2 = airfoil2->polars[k];
+        if (polar1->Re != polar2->Re || polar1->size != polar2->size
+                || memcmp(polar1->alpha, polar2->alpha, polar1->size*sizeof(double)) != 0
+                || memcmp(polar1->CL, polar2->CL, polar1->size*sizeof(double)) != 0
+                || memcmp(polar1->CD, polar2->CD, polar1->size*sizeof(double)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//add an airfoil created by the rotor to its airfoil table, unless the table already holds one with
+//the same data: in that case the new airfoil is released and the existing one is reused
+//returns the index of the airfoil in the table, or -1 on errors
+//INTERNAL USE ONLY
+int add_unique_rotor_airfoil(Rotor* rotor, Airfoil* airfoil) {
+    if (!airfoil) {
+        return -1;
+    }
+    for (int k=0; k<rotor->nairfoils; ++k) {
+        if (airfoils_identical(rotor->airfoils[k], airfoil)) {
+            free_airfoil(airfoil);
+            return k;
+        }
+    }
+    return add_owned_rotor_airfoil(rotor, airfoil);
+}
+
+//copy the airfoil table of a rotor, adding a reference to each airfoil
+//INTERNAL USE ONLY
+bool copy_rotor_airfoils(Rotor* newrotor, const Rotor* oldrotor) {
+    newrotor->airfoils = NULL;
+    newrotor->nairfoils = 0;
+    if (oldrotor->nairfoils < 1) {
+        return true;
+    }
+    newrotor->airfoils = malloc(oldrotor->nairfoils*sizeof(Airfoil*));
+    if (!newrotor->airfoils) {
+        return false;
+    }
+    for (int k=0; k<oldrotor->nairfoils; ++k) {
+        newrotor->airfoils[k] = retain_airfoil(oldrotor->airfoils[k]);
+    }
+    newrotor->nairfoils = oldrotor->nairfoils;
+    return true;
+}
+
+//airfoil that a rotor can use in place of the given one
+//the solver relies on the polars being ordered by Re (or compiled), but the airfoil may be shared
+//with other threads and it is not sorted in place: an unsorted airfoil is replaced by a sorted copy,
+//added to the airfoil table of the rotor only once (the copies made for the following sections have
+//the same data of the one in the table, so they are released and all the sections use the same index)
+//INTERNAL USE ONLY
+Airfoil* rotor_sorted_airfoil(Rotor* rotor, Airfoil* airfoil) {
+    if (!airfoil || airfoil->compiled || !airfoil->polars || airfoil->size < 1 || airfoil_polars_sorted(airfoil)) {
+        return airfoil;
+    }
+    int airfoil_idx = add_unique_rotor_airfoil(rotor, blend_airfoils(airfoil, airfoil, 0.0));
+    return (airfoil_idx < 0)? NULL : rotor->airfoils[airfoil_idx];
+}
+
+//extend the blended airfoils of the elements of a rotor with the element between its last section
+//and a new section with the given airfoil (index in the table), before the section is appended
+//the airfoils are precomputed only once a pair of sections has different airfoils: then the new
+//element reuses the blend of a previous element with the same pair, or blends the two airfoils
+//INTERNAL USE ONLY
+bool push_element_airfoil(Rotor* rotor, int upper) {
+    if (rotor->nsections < 1 || (!rotor->elementairfoils && rotor->sections[rotor->nsections-1].airfoil == upper)) {
+        return true;
+    }
+    if (!rotor->elementairfoils && rotor->nsections > 1 && !blend_rotor_airfoils(rotor)) {
+        return false;
+    }
+    int i = rotor->nsections - 1;       //index of the new element
+    Airfoil** elementairfoils = realloc(rotor->elementairfoils, (i+1)*sizeof(Airfoil*));
+    if (!elementairfoils) {
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in push_rotor_section()");
+        return false;
+    }
+    rotor->elementairfoils = elementairfoils;
+    int lower = rotor->sections[i].airfoil;
+    elementairfoils[i] = (lower == upper)? rotor->airfoils[upper] : NULL;
+    for (int j=0; j<i && !elementairfoils[i]; ++j) {
+        if (rotor->sections[j].airfoil == lower && rotor->sections[j+1].airfoil == upper) {
+            elementairfoils[i] = elementairfoils[j];
+        }
+    }
+    if (!elementairfoils[i]) {
+        //NOTE: the element is at mid-span between the two sections, as in blend_rotor_airfoils()
+        int blended = add_unique_rotor_airfoil(rotor, blend_airfoils(rotor->airfoils[lower], rotor->airfoils[upper], 0.5));
+        if (blended < 0) {
+            return false;
+        }
+        elementairfoils[i] = rotor->airfoils[blended];
+    }
+    return true;
+}
+
+//append a new section at the end of the rotor
+//the airfoil of the new blade element is blended here, so that the analyses do not blend it again
+//NOTE: the rotor diameter is NOT updated!
+void push_rotor_section(Rotor* rotor, double c, double beta, double r, Airfoil* airfoil) {
+    if (!rotor || !airfoil) {
+        return;
+    }
+    airfoil = rotor_sorted_airfoil(rotor, airfoil);
+    int airfoil_idx = (airfoil)? rotor_airfoil_index(rotor, airfoil) : -1;
+    if (airfoil_idx >= 0 && !push_element_airfoil(rotor, airfoil_idx)) {
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: unable to blend the airfoils in push_rotor_section()");
+        return;
+    }
+    Section* sections = realloc(rotor->sections, (rotor->nsections+1)*sizeof(Section));
+    if (airfoil_idx < 0 || !sections) {
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in push_rotor_section()");
+        rotor->sections = (sections)? sections : rotor->sections;
+        return;
+    }
+    rotor->sections = sections;
+    rotor->nsections += 1;
+    rotor->sections[rotor->nsections-1].c = c;
+    rotor->sections[rotor->nsections-1].beta = beta;
+    rotor->sections[rotor->nsections-1].r = r;
+    rotor->sections[rotor->nsections-1].airfoil = airfoil_idx;
+}
+
+//check if some blade elements are bounded by sections with different airfoils
+//INTERNAL USE ONLY
+bool rotor_needs_blending(const Rotor* rotor) {
+    for (int i=0; i<rotor->nsections-1; ++i) {
+        if (rotor->sections[i].airfoil != rotor->sections[i+1].airfoil) {
+            return true;
+        }
+    }
+    return false;
+}
+
+//precompute the airfoil of each blade element, blending the airfoils of its two sections
+bool blend_rotor_airfoils(Rotor* rotor) {
+    if (!rotor || rotor->nsections < 2) {
+        return false;
+    }
+    int nelems = rotor->nsections - 1;
+    Airfoil** elementairfoils = malloc(nelems*sizeof(Airfoil*));
+    if (!elementairfoils) {
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in blend_rotor_airfoils()");
+        return false;
+    }
+    for (int i=0; i<nelems; ++i) {
+        int lower = rotor->sections[i].airfoil;
+        int upper = rotor->sections[i+1].airfoil;
+        if (lower == upper) {
+            elementairfoils[i] = rotor->airfoils[upper];
+            continue;
+        }
+
+        //reuse the blend of a previous element with the same pair of airfoils
+        elementairfoils[i] = NULL;
+        for (int j=0; j<i; ++j) {
+            if (rotor->sections[j].airfoil == lower && rotor->sections[j+1].airfoil == upper) {
+                elementairfoils[i] = elementairfoils[j];
+                break;
+            }
+        }
+        if (!elementairfoils[i]) {
+            //NOTE: the element is at mid-span between the two sections
+            //the blends added by the previous calls are found in the table, so the table does not grow
+            int blended = add_unique_rotor_airfoil(rotor, blend_airfoils(rotor->airfoils[lower], rotor->airfoils[upper], 0.5));
+            if (blended < 0) {
+                free(elementairfoils);
+                return false;
+            }
+            elementairfoils[i] = rotor->airfoils[blended];
+        }
+    }
+    free(rotor->elementairfoils);
+    rotor->elementairfoils = elementairfoils;
+    return true;
+}
+
+//airfoil of the i-th blade element of a rotor (between the i-th and the (i+1)-th sections)
+//INTERNAL USE ONLY
+Airfoil* rotor_element_airfoil(const Rotor* rotor, int i) {
+    if (rotor->elementairfoils) {
+        return rotor->elementairfoils[i];
+    }
+    return rotor->airfoils[rotor->sections[i+1].airfoil];
+}
+
+//read propeller geometry from APC PE0 file
+Rotor* import_rotor_geometry_apc(const char *filename, Airfoil* airfoil) {
+    Rotor* newrotor = calloc(1, sizeof(Rotor));
+    if (!newrotor) {
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in import_rotor_geometry_apc()");
+        return NULL;
+    }
+    newrotor->D = 0.0;
+    newrotor->B = 0;
+    newrotor->nsections = 0;
+    newrotor->sections = NULL;
+
+    FILE* fileio = fopen(filename, "rb");
+    if (!fileio) {
+        qprop_log(QPROP_ERROR_FILE, "ERROR opening file %s", filename);
+        free(newrotor);
+        return NULL;
+    }
+    airfoil = rotor_sorted_airfoil(newrotor, airfoil);     //an unsorted airfoil is copied once for all the sections
+
+    //read file line by line
+    char line[MAX_LINE_LENGTH];
+    int parse_line = false;
+    while (fgets(line, MAX_LINE_LENGTH, fileio)) {
+        //check if line contains unique keywords like "STATION" and "MAX-THICK"
+        //to start parsing from the next line
+        if (!parse_line && strstr(line, "STATION") && strstr(line, "MAX-THICK")) {
+            //printf("Enable parse line\n");
+            parse_line = true;
+        }
+
+        //count number of items in the line
+        int token_counter = 0;
+        if (parse_line) {
+            bool in_value = false;      //keep track if current char is a value
+            if (!isblank(line[0]) && isgraph(line[0])) {
+                //printf("Starting line in value\n");
+                in_value = true;
+                token_counter += 1;
+            }
+            for (int i=1; i<MAX_LINE_LENGTH; ++i) {
+                if (line[i] == '\0' || line[i] == '\n') {
+                    break;
+                }
+                
+                if (!isblank(line[i]) && isgraph(line[i])) {
+                    if (!in_value) {
+                        token_counter += 1;
+                        //printf("New token starting from: %c (position: %i)\n", line[i],i);
+                        in_value = true;
+                    }
+                }
+                else {
+                    if (in_value) {
+                        in_value = false;
+                    }
+                }
+            }
+            //printf("Number of tokens: %i\n", token_counter);
+        }
+
+        //check if line is no longer valid for parsing
+        //note that the lines containing the header and the units of the table must be skipped
+        if (parse_line && token_counter > 2
+                && !strstr(line, "STATION") && !strstr(line, "MAX-THICK")       //skip header line
+                && !strstr(line, "(QUOTED)") && !strstr(line, "(LE-TE)")) {     //skip units line
+            for (int i=0; i<MAX_LINE_LENGTH; ++i) {
+                if (line[i] == '\0') {
+                    break;
+                }
+
+                //if (isalpha(line[i]) || ispunct(line[i])) {
+                if (!isdigit(line[i]) && line[i] != '.' && line[i] != '-' && line[i] != 'e' && isgraph(line[i])) {
+                    //printf("Disable parse line at char %c\n", line[i]);
+                    parse_line = false;
+                    break;
                 }
             }
         }
@@ -544,19 +2328,17 @@ Rotor* import_rotor_geometry_apc(const char *filename, Airfoil* airfoil) {
         }
 
         //read number of blades
-        if (newrotor->B == 0 && strstr(line, "BLADES:")) {
-            char* token = strtok(line, " ");
-            if (strcmp(token, "BLADES:") == 0) {
-                token = strtok(NULL, " ");              //get the next token
-                newrotor->B = atof(token);
-            }
+        //NOTE: strtok is not used, as it is not reentrant
+        char* token = strstr(line, "BLADES:");
+        if (newrotor->B == 0 && token) {
+            token += strlen("BLADES:");             //get the next token
+            newrotor->B = atof(token);
         }
     }
     fclose(fileio);
     if (newrotor->nsections == 0 || newrotor->D == 0 || newrotor->B == 0) {
-        printf("ERROR unable to parse rotor from %s\n", filename);
-        free(newrotor->sections);
-        free(newrotor);
+        qprop_log(QPROP_ERROR_FILE, "ERROR unable to parse rotor from %s", filename);
+        free_rotor(newrotor);
         return NULL;
     }
     return newrotor;
@@ -566,7 +2348,7 @@ Rotor* import_rotor_geometry_apc(const char *filename, Airfoil* airfoil) {
 Rotor* import_rotor_geometry_uiuc(const char *filename, Airfoil* airfoil, double D, int B) {
     Rotor* newrotor = calloc(1, sizeof(Rotor));
     if (!newrotor) {
-        printf("ERROR: memory allocation error in import_rotor_geometry_uiuc()\n");
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in import_rotor_geometry_uiuc()");
         return NULL;
     }
     newrotor->D = D;
@@ -576,10 +2358,11 @@ Rotor* import_rotor_geometry_uiuc(const char *filename, Airfoil* airfoil, double
 
     FILE* fileio = fopen(filename, "rb");
     if (!fileio) {
-        printf("ERROR opening file %s\n", filename);
+        qprop_log(QPROP_ERROR_FILE, "ERROR opening file %s", filename);
         free(newrotor);
         return NULL;
     }
+    airfoil = rotor_sorted_airfoil(newrotor, airfoil);     //an unsorted airfoil is copied once for all the sections
 
     //read file line by line
     char line[MAX_LINE_LENGTH];
@@ -642,38 +2425,55 @@ Rotor* import_rotor_geometry_uiuc(const char *filename, Airfoil* airfoil, double
     }
     fclose(fileio);
     if (newrotor->nsections == 0 || newrotor->D == 0 || newrotor->B == 0) {
-        printf("ERROR unable to parse rotor from %s\n", filename);
-        free(newrotor->sections);
-        free(newrotor);
+        qprop_log(QPROP_ERROR_FILE, "ERROR unable to parse rotor from %s", filename);
+        free_rotor(newrotor);
         return NULL;
     }
     return newrotor;
 }
 
 //change number of sections in a propeller geometry
-Rotor* refine_rotor_sections(Rotor* oldrotor, int nsections) {
+//create a propeller geometry with sections at the given radial positions (in ascending order)
+//INTERNAL USE ONLY
+Rotor* resample_rotor_sections(Rotor* oldrotor, const double* r, int nsections) {
     //initialize variables
     Rotor* newrotor = calloc(1, sizeof(Rotor));
     if (!newrotor) {
-        printf("ERROR: memory allocation error in refine_rotor_sections()\n");
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in refine_rotor_sections()");
         return NULL;
     }
     newrotor->D = oldrotor->D;
     newrotor->B = oldrotor->B;
     newrotor->nsections = nsections;
     newrotor->sections = (Section*) calloc(nsections, sizeof(Section));
-    if (!newrotor->sections) {
-        printf("ERROR: memory allocation error in refine_rotor_sections()\n");
+    if (!newrotor->sections || !copy_rotor_airfoils(newrotor, oldrotor)) {
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in refine_rotor_sections()");
+        free_rotor(newrotor);
+        return NULL;
+    }
+
+    //blends already added to the table, keyed on (lower airfoil, upper airfoil, weight) of the old rotor,
+    //so that the sections with the same key share one blend without blending the polars again
+    int* blendkeys = malloc(nsections*2*sizeof(int));
+    double* blendweights = malloc(nsections*sizeof(double));
+    int* blendindices = malloc(nsections*sizeof(int));
+    int nblends = 0;
+    if (!blendkeys || !blendweights || !blendindices) {
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in refine_rotor_sections()");
+        free(blendkeys);
+        free(blendweights);
+        free(blendindices);
+        free_rotor(newrotor);
         return NULL;
     }
 
     //linearly interpolate sections
-    double dr = (oldrotor->sections[oldrotor->nsections-1].r - oldrotor->sections[0].r) / (nsections-1);
+    int j = 0;                      //old element containing the new section (merged sweep)
     for (int i=0; i<nsections; ++i) {
         //find nearest old sections
         int lower_section_idx = 0;
         int upper_section_idx = oldrotor->nsections-1;
-        double rnew = oldrotor->sections[0].r + i*dr;
+        double rnew = r[i];
         if (rnew <= oldrotor->sections[0].r) {
             //use the hub section
             upper_section_idx = 0;
@@ -684,13 +2484,11 @@ Rotor* refine_rotor_sections(Rotor* oldrotor, int nsections) {
         }
         else {
             //use two intermediate sections
-            for (int j=0; j<oldrotor->nsections-1; ++j) {
-                if (oldrotor->sections[j].r < rnew && rnew <= oldrotor->sections[j+1].r) {
-                    lower_section_idx = j;
-                    upper_section_idx = j+1;
-                    break;
-                }
+            while (j < oldrotor->nsections-2 && oldrotor->sections[j+1].r < rnew) {
+                ++j;
             }
+            lower_section_idx = j;
+            upper_section_idx = j+1;
         }
 
         //create new section
@@ -710,47 +2508,614 @@ Rotor* refine_rotor_sections(Rotor* oldrotor, int nsections) {
             oldrotor->sections[upper_section_idx].beta,
             rnew
         );
-        newsection.airfoil = oldrotor->sections[upper_section_idx].airfoil;
-        //
-        //TODO: interpolate airfoils between the two sections
-        //
+        int lower_airfoil = oldrotor->sections[lower_section_idx].airfoil;
+        int upper_airfoil = oldrotor->sections[upper_section_idx].airfoil;
+        double w = (upper_section_idx > lower_section_idx)?
+                   (rnew - oldrotor->sections[lower_section_idx].r) / (oldrotor->sections[upper_section_idx].r - oldrotor->sections[lower_section_idx].r) : 1.0;
+        if (lower_airfoil == upper_airfoil || w >= 1.0) {
+            newsection.airfoil = upper_airfoil;     //same airfoil table of the old rotor
+        }
+        else if (w <= 0.0) {
+            newsection.airfoil = lower_airfoil;
+        }
+        else {
+            //blend the airfoils of the two sections, reusing the blends with the same key or the same data
+            newsection.airfoil = -1;
+            for (int k=0; k<nblends; ++k) {
+                if (blendkeys[2*k] == lower_airfoil && blendkeys[2*k+1] == upper_airfoil && blendweights[k] == w) {
+                    newsection.airfoil = blendindices[k];
+                    break;
+                }
+            }
+            if (newsection.airfoil < 0) {
+                newsection.airfoil = add_unique_rotor_airfoil(newrotor,
+                    blend_airfoils(oldrotor->airfoils[lower_airfoil], oldrotor->airfoils[upper_airfoil], w));
+                if (newsection.airfoil < 0) {
+                    free(blendkeys);
+                    free(blendweights);
+                    free(blendindices);
+                    free_rotor(newrotor);
+                    return NULL;
+                }
+                blendkeys[2*nblends] = lower_airfoil;
+                blendkeys[2*nblends+1] = upper_airfoil;
+                blendweights[nblends] = w;
+                blendindices[nblends] = newsection.airfoil;
+                nblends += 1;
+            }
+        }
         newrotor->sections[i] = newsection;
     }
+    free(blendkeys);
+    free(blendweights);
+    free(blendindices);
+
+    //precompute the blended airfoils of the elements
+    if (rotor_needs_blending(newrotor) && !blend_rotor_airfoils(newrotor)) {
+        free_rotor(newrotor);
+        return NULL;
+    }
     return newrotor;
 }
 
-//free allocated memory on a Rotor
-void free_rotor(Rotor* currentrotor) {
-    free(currentrotor->sections);
-    currentrotor->sections = NULL;
-    free(currentrotor);
-    currentrotor = NULL;
+//refine propeller sections with equally-spaced sections
+Rotor* refine_rotor_sections(Rotor* oldrotor, int nsections) {
+    return refine_rotor_sections_ex(oldrotor, nsections, QPROP_SPACING_UNIFORM);
 }
 
-//data structure for blade elements
-//INTERNAL USE ONLY
-typedef struct {
-    double c;           //chord length (m)
-    double beta;        //twist angle (rad)
-    double r;           //radial distance (m)
-    double dr;          //element width (m)
-    Airfoil* airfoil;   //local airfoil data
-} Element;
+//refine propeller sections with the given spacing
+Rotor* refine_rotor_sections_ex(Rotor* oldrotor, int nsections, QPropSpacing spacing) {
+    if (!oldrotor || oldrotor->nsections < 1 || nsections < 2) {
+        qprop_log(QPROP_ERROR_INVALID_ARGUMENT, "ERROR in refine_rotor_sections(): invalid number of sections");
+        return NULL;
+    }
+    double* r = malloc(nsections*sizeof(double));
+    if (!r) {
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in refine_rotor_sections()");
+        return NULL;
+    }
+    double rhub = oldrotor->sections[0].r;
+    double rtip = oldrotor->sections[oldrotor->nsections-1].r;
+    double dr = (rtip - rhub) / (nsections-1);
+    for (int i=0; i<nsections; ++i) {
+        double t = (double) i / (nsections-1);
+        switch (spacing) {
+            case QPROP_SPACING_COSINE:
+                r[i] = rhub + 0.5*(1.0 - cos(PI*t))*(rtip - rhub);
+                break;
+            case QPROP_SPACING_TIP:
+                r[i] = rhub + sin(0.5*PI*t)*(rtip - rhub);
+                break;
+            default:
+                r[i] = rhub + i*dr;
+                break;
+        }
+    }
+    Rotor* newrotor = resample_rotor_sections(oldrotor, r, nsections);
+    free(r);
+    return newrotor;
+}
 
-//data structure for the residual output
-//INTERNAL USE ONLY
-typedef struct {
-    double residual;
-    double W;
-    double phi;
-    double Gamma;
-    double lambdaw;
-    double va;
+//refine propeller sections where the thrust distribution changes sharply
+Rotor* refine_rotor_sections_adaptive(Rotor* oldrotor, double Uinf, double Omega, double rho, double mu, double a,
+                                      double tol, int maxsections, const QPropOptions* options) {
+    if (!oldrotor || oldrotor->nsections < 2 || maxsections < 2 || tol <= 0) {
+        qprop_log(QPROP_ERROR_INVALID_ARGUMENT, "ERROR in refine_rotor_sections_adaptive(): invalid arguments");
+        return NULL;
+    }
+    double* r = malloc(2*maxsections*sizeof(double));
+    bool* split = malloc(maxsections*sizeof(bool));
+    if (!r || !split) {
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in refine_rotor_sections_adaptive()");
+        free(r);
+        free(split);
+        return NULL;
+    }
+    double* rnext = r + maxsections;
+
+    //start from a coarse equally-spaced discretization
+    int nsections = (maxsections < ADAPTIVE_INITIAL_SECTIONS)? maxsections : ADAPTIVE_INITIAL_SECTIONS;
+    double rhub = oldrotor->sections[0].r;
+    double rtip = oldrotor->sections[oldrotor->nsections-1].r;
+    for (int i=0; i<nsections; ++i) {
+        r[i] = rhub + i*(rtip - rhub)/(nsections-1);
+    }
+    r[nsections-1] = rtip;
+
+    Rotor* newrotor = NULL;
+    double Tprev = NAN;
+    double Qprev = NAN;
+    while (true) {
+        //analyze the current discretization
+        if (newrotor) {
+            free_rotor(newrotor);
+        }
+        newrotor = resample_rotor_sections(oldrotor, r, nsections);
+        RotorPerformance* perf = (newrotor)? qprop_ex(newrotor, Uinf, Omega, rho, mu, a, options) : NULL;
+        if (!perf) {
+            qprop_log(QPROP_ERROR_INVALID_ARGUMENT, "ERROR in refine_rotor_sections_adaptive(): unable to analyze the rotor");
+            if (newrotor) {
+                free_rotor(newrotor);
+            }
+            newrotor = NULL;
+            break;
+        }
+
+        //stop when the integrated thrust and torque converged
+        bool converged = fabs(perf->T - Tprev) <= tol*fabs(perf->T) && fabs(perf->Q - Qprev) <= tol*fabs(perf->Q);
+        Tprev = perf->T;
+        Qprev = perf->Q;
+
+        //split the elements where the slope of dT/dr changes, i.e. where dT/dr deviates
+        //from the linear trend of the neighbouring elements by more than tol times the blade thrust
+        int nelems = nsections-1;
+        double Tblade = 0.0;
+        for (int i=0; i<nelems; ++i) {
+            Tblade += fabs(perf->dTdr[i]) * (r[i+1] - r[i]);
+            split[i] = false;
+        }
+        for (int i=1; i<nelems-1; ++i) {
+            double dTdr_linear = interp1(perf->r[i-1], perf->dTdr[i-1], perf->r[i+1], perf->dTdr[i+1], perf->r[i]);
+            if (fabs(perf->dTdr[i] - dTdr_linear) * (r[i+1] - r[i]) > tol*Tblade) {
+                split[i-1] = true;
+                split[i] = true;
+                split[i+1] = true;
+            }
+        }
+        int nsplit = 0;
+        for (int i=0; i<nelems; ++i) {
+            nsplit += (split[i])? 1 : 0;
+        }
+        free_rotor_performance(perf);
+        if (converged || nsplit == 0 || nsections + nsplit > maxsections) {
+            break;
+        }
+
+        //add the midpoints of the split elements
+        int n = 0;
+        for (int i=0; i<nelems; ++i) {
+            rnext[n++] = r[i];
+            if (split[i]) {
+                rnext[n++] = 0.5*(r[i] + r[i+1]);
+            }
+        }
+        rnext[n++] = r[nsections-1];
+        memcpy(r, rnext, n*sizeof(double));
+        nsections = n;
+    }
+    free(r);
+    free(split);
+    return newrotor;
+}
+
+//copy a rotor, sharing its airfoils
+Rotor* copy_rotor(Rotor* oldrotor) {
+    if (!oldrotor) {
+        return NULL;
+    }
+    Rotor* newrotor = calloc(1, sizeof(Rotor));
+    if (!newrotor) {
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in copy_rotor()");
+        return NULL;
+    }
+    newrotor->D = oldrotor->D;
+    newrotor->B = oldrotor->B;
+    newrotor->nsections = oldrotor->nsections;
+    newrotor->sections = malloc((oldrotor->nsections > 0 ? oldrotor->nsections : 1)*sizeof(Section));
+    if (!newrotor->sections || !copy_rotor_airfoils(newrotor, oldrotor)) {
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in copy_rotor()");
+        free_rotor(newrotor);
+        return NULL;
+    }
+    memcpy(newrotor->sections, oldrotor->sections, oldrotor->nsections*sizeof(Section));
+    if (oldrotor->elementairfoils && oldrotor->nsections > 1) {
+        //the blended airfoils are in the shared airfoil table
+        newrotor->elementairfoils = malloc((oldrotor->nsections-1)*sizeof(Airfoil*));
+        if (!newrotor->elementairfoils) {
+            qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in copy_rotor()");
+            free_rotor(newrotor);
+            return NULL;
+        }
+        memcpy(newrotor->elementairfoils, oldrotor->elementairfoils, (oldrotor->nsections-1)*sizeof(Airfoil*));
+    }
+    return newrotor;
+}
+
+//free allocated memory on a Rotor, releasing its airfoils
+void free_rotor(Rotor* currentrotor) {
+    for (int k=0; k<currentrotor->nairfoils; ++k) {
+        if (currentrotor->airfoils[k] && currentrotor->airfoils[k]->refcount > 0) {
+            free_airfoil(currentrotor->airfoils[k]);
+        }
+    }
+    free(currentrotor->airfoils);
+    currentrotor->airfoils = NULL;
+    currentrotor->nairfoils = 0;
+    free(currentrotor->elementairfoils);
+    currentrotor->elementairfoils = NULL;
+    free(currentrotor->sections);
+    currentrotor->sections = NULL;
+    free(currentrotor);
+    currentrotor = NULL;
+}
+
+
+//-----------------
+//  BINARY FILES
+//-----------------
+//Airfoils and rotors can be saved in a compact binary format, which is much faster to load than
+//the text files. Binary airfoils are memory-mapped: the polars and the compiled tables point
+//directly to the file pages, which are shared by all the processes loading the same file.
+//The files are written in the native byte order and are not portable across architectures.
+
+//header of the binary files
+//INTERNAL USE ONLY
+typedef struct {
+    char magic[8];          //"QPROPAF" for airfoils, "QPROPRT" for rotors, "QPROPMP" for performance maps
+    uint32_t version;       //BINARY_VERSION
+    uint32_t endianness;    //0x01020304 written in the native byte order
+    int32_t n1;             //airfoils: number of polars - rotors: number of blades - maps: number of J
+    int32_t n2;             //airfoils: number of compiled alphas - rotors: number of sections - maps: number of Omega
+    int64_t filesize;       //total size of the file (bytes)
+    double value;           //airfoils: compiled alpha spacing - rotors and maps: diameter
+    char reserved[24];      //padding to BINARY_HEADER_SIZE
+} BinaryHeader;
+
+//fill the header of a binary file
+//INTERNAL USE ONLY
+void set_binary_header(BinaryHeader* header, const char* magic, int n1, int n2, int64_t filesize, double value) {
+    memset(header, 0, sizeof(BinaryHeader));
+    memcpy(header->magic, magic, strlen(magic));
+    header->version = BINARY_VERSION;
+    header->endianness = 0x01020304;
+    header->n1 = n1;
+    header->n2 = n2;
+    header->filesize = filesize;
+    header->value = value;
+}
+
+//check the header of a binary file mapped in memory
+//INTERNAL USE ONLY
+bool check_binary_header(const BinaryHeader* header, size_t mapsize, const char* magic, const char* filename) {
+    if (mapsize < BINARY_HEADER_SIZE || strncmp(header->magic, magic, sizeof(header->magic)) != 0) {
+        qprop_log(QPROP_ERROR_FILE, "ERROR %s is not a valid binary file", filename);
+        return false;
+    }
+    if (header->version != BINARY_VERSION || header->endianness != 0x01020304) {
+        qprop_log(QPROP_ERROR_FILE, "ERROR %s was written by an incompatible version or architecture", filename);
+        return false;
+    }
+    if (header->filesize != (int64_t) mapsize || header->n1 < 1 || header->n2 < 1) {
+        qprop_log(QPROP_ERROR_FILE, "ERROR %s is corrupted", filename);
+        return false;
+    }
+    return true;
+}
+
+//map a whole file in memory (read-only)
+//INTERNAL USE ONLY
+void* map_binary_file(const char* filename, size_t* mapsize) {
+    void* mapping = NULL;
+    *mapsize = 0;
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        qprop_log(QPROP_ERROR_FILE, "ERROR opening file %s", filename);
+        return NULL;
+    }
+    LARGE_INTEGER size;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+        HANDLE filemapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (filemapping) {
+            mapping = MapViewOfFile(filemapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(filemapping);
+        }
+        *mapsize = (size_t) size.QuadPart;
+    }
+    CloseHandle(file);
+#else
+    int file = open(filename, O_RDONLY);
+    if (file < 0) {
+        qprop_log(QPROP_ERROR_FILE, "ERROR opening file %s", filename);
+        return NULL;
+    }
+    struct stat info;
+    if (fstat(file, &info) == 0 && info.st_size > 0) {
+        mapping = mmap(NULL, (size_t) info.st_size, PROT_READ, MAP_SHARED, file, 0);
+        if (mapping == MAP_FAILED) {
+            mapping = NULL;
+        }
+        *mapsize = (size_t) info.st_size;
+    }
+    close(file);
+#endif
+    if (!mapping) {
+        qprop_log(QPROP_ERROR_FILE, "ERROR unable to map file %s in memory", filename);
+        *mapsize = 0;
+    }
+    return mapping;
+}
+
+//offset of the arrays in a binary airfoil file
+//INTERNAL USE ONLY
+size_t binary_airfoil_data_offset(int nRe) {
+    size_t offset = BINARY_HEADER_SIZE + nRe*sizeof(int32_t);
+    return (offset + COMPILED_ALIGNMENT - 1) / COMPILED_ALIGNMENT * COMPILED_ALIGNMENT;
+}
+
+//save an airfoil in a binary file, together with its compiled polars
+bool save_airfoil_binary(Airfoil* airfoil, const char* filename) {
+    if (!airfoil || !airfoil->polars || airfoil->size < 1) {
+        qprop_log(QPROP_ERROR_INVALID_ARGUMENT, "ERROR in save_airfoil_binary(): the airfoil has no polars");
+        return false;
+    }
+    //the airfoil is only read: a missing compiled table is built temporarily
+    CompiledAirfoil* temporary = (airfoil->compiled && airfoil->compiled->nRe == airfoil->size)? NULL : build_compiled_airfoil(airfoil);
+    const CompiledAirfoil* compiled = (temporary)? temporary : airfoil->compiled;
+    if (!compiled || compiled->nRe != airfoil->size) {
+        return false;
+    }
+
+    //compute the size of the file
+    int nRe = airfoil->size;
+    int nalpha = compiled->nalpha;
+    size_t npoints = 0;
+    for (int j=0; j<nRe; ++j) {
+        npoints += airfoil->polars[j]->size;
+    }
+    size_t offset = binary_airfoil_data_offset(nRe);
+    size_t filesize = offset + (nRe + nalpha + 2*(size_t)nRe*nalpha + 2*nRe + 3*npoints)*sizeof(double);
+
+    FILE* fileio = fopen(filename, "wb");
+    if (!fileio) {
+        qprop_log(QPROP_ERROR_FILE, "ERROR opening file %s", filename);
+        if (temporary) {
+            free_compiled_airfoil(temporary);
+        }
+        return false;
+    }
+
+    //header and sizes of the polars
+    BinaryHeader header;
+    set_binary_header(&header, "QPROPAF", nRe, nalpha, filesize, compiled->dalpha);
+    bool success = (fwrite(&header, sizeof(BinaryHeader), 1, fileio) == 1);
+    for (int j=0; j<nRe && success; ++j) {
+        int32_t size = airfoil->polars[j]->size;
+        success = (fwrite(&size, sizeof(int32_t), 1, fileio) == 1);
+    }
+    const char padding[COMPILED_ALIGNMENT] = {0};
+    size_t npadding = offset - BINARY_HEADER_SIZE - nRe*sizeof(int32_t);
+    success = success && (fwrite(padding, 1, npadding, fileio) == npadding);
+
+    //compiled polars
+    success = success && (fwrite(compiled->Re, sizeof(double), nRe, fileio) == (size_t) nRe);
+    success = success && (fwrite(compiled->alpha, sizeof(double), nalpha, fileio) == (size_t) nalpha);
+    success = success && (fwrite(compiled->CLCD, sizeof(double), 2*(size_t)nRe*nalpha, fileio) == 2*(size_t)nRe*nalpha);
+
+    //original polars
+    for (int j=0; j<nRe && success; ++j) {
+        success = (fwrite(&airfoil->polars[j]->Re, sizeof(double), 1, fileio) == 1);
+    }
+    for (int j=0; j<nRe && success; ++j) {
+        success = (fwrite(&airfoil->polars[j]->dalpha, sizeof(double), 1, fileio) == 1);
+    }
+    for (int j=0; j<nRe && success; ++j) {
+        size_t size = airfoil->polars[j]->size;
+        success = (fwrite(airfoil->polars[j]->alpha, sizeof(double), size, fileio) == size)
+                  && (fwrite(airfoil->polars[j]->CL, sizeof(double), size, fileio) == size)
+                  && (fwrite(airfoil->polars[j]->CD, sizeof(double), size, fileio) == size);
+    }
+    if (temporary) {
+        free_compiled_airfoil(temporary);
+    }
+    if (fclose(fileio) != 0 || !success) {
+        qprop_log(QPROP_ERROR_FILE, "ERROR writing file %s", filename);
+        return false;
+    }
+    return true;
+}
+
+//load an airfoil from a binary file, mapping it in memory
+//the polars are read-only: they point to the memory-mapped file, which is released by free_airfoil()
+Airfoil* load_airfoil_binary(const char* filename) {
+    size_t mapsize;
+    char* mapping = map_binary_file(filename, &mapsize);
+    if (!mapping) {
+        return NULL;
+    }
+    const BinaryHeader* header = (const BinaryHeader*) mapping;
+    if (!check_binary_header(header, mapsize, "QPROPAF", filename)) {
+        unmap_binary_file(mapping, mapsize);
+        return NULL;
+    }
+    int nRe = header->n1;
+    int nalpha = header->n2;
+    size_t offset = binary_airfoil_data_offset(nRe);
+    size_t npoints = 0;
+    bool valid = (offset <= mapsize);
+    for (int j=0; j<nRe && valid; ++j) {
+        int32_t size;
+        memcpy(&size, mapping + BINARY_HEADER_SIZE + j*sizeof(int32_t), sizeof(int32_t));
+        valid = (size > 0);
+        npoints += size;
+    }
+    if (!valid || mapsize != offset + (nRe + nalpha + 2*(size_t)nRe*nalpha + 2*nRe + 3*npoints)*sizeof(double)) {
+        qprop_log(QPROP_ERROR_FILE, "ERROR %s is corrupted", filename);
+        unmap_binary_file(mapping, mapsize);
+        return NULL;
+    }
+
+    //allocate the airfoil, the compiled table and the polars (in a single block)
+    Airfoil* newairfoil = calloc(1, sizeof(Airfoil));
+    CompiledAirfoil* compiled = calloc(1, sizeof(CompiledAirfoil) + compiled_real_table_size(nRe, nalpha));
+    char* polars = malloc(nRe*(sizeof(Polar*) + sizeof(Polar)));
+    if (!newairfoil || !compiled || !polars) {
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in load_airfoil_binary()");
+        free(newairfoil);
+        free(compiled);
+        free(polars);
+        unmap_binary_file(mapping, mapsize);
+        return NULL;
+    }
+
+    //point the arrays to the mapped file
+    double* data = (double*) (mapping + offset);
+    compiled->nRe = nRe;
+    compiled->nalpha = nalpha;
+    compiled->dalpha = header->value;
+    compiled->Re = data;
+    compiled->alpha = compiled->Re + nRe;
+    compiled->CLCD = compiled->alpha + nalpha;
+    compiled->mapping = mapping;
+    compiled->mapsize = mapsize;
+    set_compiled_real_table(compiled, compiled + 1);
+    const double* polarRe = compiled->CLCD + 2*(size_t)nRe*nalpha;
+    const double* polardalpha = polarRe + nRe;
+    data = (double*) (polardalpha + nRe);
+    newairfoil->polars = (Polar**) polars;
+    newairfoil->size = nRe;
+    newairfoil->refcount = 1;
+    newairfoil->compiled = compiled;
+    for (int j=0; j<nRe; ++j) {
+        Polar* currentpolar = (Polar*) (polars + nRe*sizeof(Polar*)) + j;
+        int32_t size;
+        memcpy(&size, mapping + BINARY_HEADER_SIZE + j*sizeof(int32_t), sizeof(int32_t));
+        currentpolar->Re = polarRe[j];
+        currentpolar->size = size;
+        currentpolar->dalpha = polardalpha[j];
+        currentpolar->alpha = data;
+        currentpolar->CL = data + size;
+        currentpolar->CD = data + 2*size;
+        data += 3*size;
+        newairfoil->polars[j] = currentpolar;
+    }
+    return newairfoil;
+}
+
+//save the geometry of a rotor in a binary file
+//NOTE: the airfoils are not saved, use save_airfoil_binary() for them
+bool save_rotor_binary(Rotor* rotor, const char* filename) {
+    if (!rotor || rotor->nsections < 1) {
+        qprop_log(QPROP_ERROR_INVALID_ARGUMENT, "ERROR in save_rotor_binary(): the rotor has no sections");
+        return false;
+    }
+    //the file has no airfoil indices, and load_rotor_binary assigns one airfoil to all the sections
+    for (int i=1; i<rotor->nsections; ++i) {
+        if (rotor->sections[i].airfoil != rotor->sections[0].airfoil) {
+            qprop_log(QPROP_ERROR_INVALID_ARGUMENT, "ERROR in save_rotor_binary(): the sections of the rotor use more than one airfoil");
+            return false;
+        }
+    }
+    FILE* fileio = fopen(filename, "wb");
+    if (!fileio) {
+        qprop_log(QPROP_ERROR_FILE, "ERROR opening file %s", filename);
+        return false;
+    }
+    BinaryHeader header;
+    size_t filesize = BINARY_HEADER_SIZE + 3*rotor->nsections*sizeof(double);
+    set_binary_header(&header, "QPROPRT", rotor->B, rotor->nsections, filesize, rotor->D);
+    bool success = (fwrite(&header, sizeof(BinaryHeader), 1, fileio) == 1);
+    for (int i=0; i<rotor->nsections && success; ++i) {
+        double section[3] = {rotor->sections[i].c, rotor->sections[i].beta, rotor->sections[i].r};
+        success = (fwrite(section, sizeof(double), 3, fileio) == 3);
+    }
+    if (fclose(fileio) != 0 || !success) {
+        qprop_log(QPROP_ERROR_FILE, "ERROR writing file %s", filename);
+        return false;
+    }
+    return true;
+}
+
+//load the geometry of a rotor from a binary file
+Rotor* load_rotor_binary(const char* filename, Airfoil* airfoil) {
+    size_t mapsize;
+    char* mapping = map_binary_file(filename, &mapsize);
+    if (!mapping) {
+        return NULL;
+    }
+    const BinaryHeader* header = (const BinaryHeader*) mapping;
+    if (!check_binary_header(header, mapsize, "QPROPRT", filename)) {
+        unmap_binary_file(mapping, mapsize);
+        return NULL;
+    }
+    if (mapsize != BINARY_HEADER_SIZE + 3*(size_t)header->n2*sizeof(double)) {
+        qprop_log(QPROP_ERROR_FILE, "ERROR %s is corrupted", filename);
+        unmap_binary_file(mapping, mapsize);
+        return NULL;
+    }
+    Rotor* newrotor = calloc(1, sizeof(Rotor));
+    if (!newrotor) {
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in load_rotor_binary()");
+        unmap_binary_file(mapping, mapsize);
+        return NULL;
+    }
+    newrotor->D = header->value;
+    newrotor->B = header->n1;
+    const double* sections = (const double*) (mapping + BINARY_HEADER_SIZE);
+    airfoil = rotor_sorted_airfoil(newrotor, airfoil);     //an unsorted airfoil is copied once for all the sections
+    for (int i=0; i<header->n2; ++i) {
+        push_rotor_section(newrotor, sections[3*i], sections[3*i+1], sections[3*i+2], airfoil);
+        if (newrotor->nsections != i+1) {
+            //the section was not added (invalid airfoil or allocation error): do not return a partial rotor
+            qprop_log((airfoil)? QPROP_ERROR_MEMORY : QPROP_ERROR_INVALID_ARGUMENT,
+                      "ERROR unable to build the rotor of %s in load_rotor_binary()", filename);
+            free_rotor(newrotor);
+            unmap_binary_file(mapping, mapsize);
+            return NULL;
+        }
+    }
+    unmap_binary_file(mapping, mapsize);
+    return newrotor;
+}
+
+//data structure for blade elements
+//INTERNAL USE ONLY
+typedef struct {
+    double c;           //chord length (m)
+    double beta;        //twist angle (rad)
+    double r;           //radial distance (m)
+    double dr;          //element width (m)
+    Airfoil* airfoil;   //local airfoil data
+} Element;
+
+//data structure for the residual output
+//INTERNAL USE ONLY
+typedef struct {
+    double residual;
+    double W;
+    double phi;
+    double Gamma;
+    double lambdaw;
+    double va;
     double vt;
     double Cn;
     double Ct;
 } ResidualOutput;
 
+//data structure for the quantities of a blade element that do not change while solving for psi
+//INTERNAL USE ONLY
+typedef struct {
+    bool prepared;      //true if the quantities below have been computed
+    double U;           //magnitude of the undisturbed velocity, sqrt(Ua^2+Ut^2) (m/s)
+    double rR;          //relative radial position r/R
+    double ftip;        //tip loss exponent factor (1-r/R)*B/2, divided by lambdaw in the residual
+    double Gammaf;      //circulation factor 4*pi*r/B (m)
+    double lambdaf;     //wake advance ratio factor 4*R/(pi*B*r)
+    double Ref;         //Reynolds number factor rho*c/mu (s/m)
+} ElementInvariants;
+
+//compute the quantities of a blade element that do not change while solving for psi
+//INTERNAL USE ONLY
+void prepare_element_invariants(ElementInvariants* inv, double Ua, double Ut, double R, int B, double c, double r, double rho, double mu) {
+    inv->U = sqrt(Ua*Ua + Ut*Ut);
+    inv->rR = r/R;
+    inv->ftip = (1.0 - r/R) * 0.5 * B;
+    inv->Gammaf = 4.0*PI*r / B;
+    inv->lambdaf = 4*R / (PI*B*r);
+    inv->Ref = rho * c / mu;
+    inv->prepared = true;
+}
+
 //data structure for the residual inputs
 //INTERNAL USE ONLY
 typedef struct {
@@ -762,8 +3127,38 @@ typedef struct {
     double rho;
     double mu;
     double a;
+    int nevals;         //number of residual evaluations performed with these args
+    InterpolationHint hint;     //last polar brackets found for this element
+    ElementInvariants inv;      //element quantities computed at the first residual evaluation
 } ResidualArgs;
 
+//data structure for a batch of blade elements, stored as a structure of arrays
+//the columns read by the residual kernel are stored in the working precision (see qprop_real)
+//INTERNAL USE ONLY
+typedef struct {
+    int n;                                      //number of elements in the batch
+    qprop_real c[QPROP_BATCH_SIZE];             //chord lengths (m)
+    qprop_real beta[QPROP_BATCH_SIZE];          //pitch angles (rad)
+    double r[QPROP_BATCH_SIZE];                 //radial positions (m)
+    double dr[QPROP_BATCH_SIZE];                //widths (m)
+    qprop_real Ua[QPROP_BATCH_SIZE];            //axial velocities (m/s)
+    qprop_real Ut[QPROP_BATCH_SIZE];            //tangential velocities (m/s)
+    Airfoil* airfoil[QPROP_BATCH_SIZE];         //airfoil polars
+    InterpolationHint hint[QPROP_BATCH_SIZE];   //last polar brackets found for each element
+    int nevals[QPROP_BATCH_SIZE];               //number of residual evaluations of each element
+    qprop_real U[QPROP_BATCH_SIZE];             //element invariants (see ElementInvariants)
+    qprop_real rR[QPROP_BATCH_SIZE];
+    qprop_real ftip[QPROP_BATCH_SIZE];
+    qprop_real Gammaf[QPROP_BATCH_SIZE];
+    qprop_real lambdaf[QPROP_BATCH_SIZE];
+    qprop_real Ref[QPROP_BATCH_SIZE];
+    double R;
+    int B;
+    double rho;
+    double mu;
+    double a;
+} ElementBatch;
+
 //define the QProp residual function
 //NOTE: the implementation is an exact replica of the steps described in the QProp theory document
 //INTERNAL USE ONLY
@@ -771,52 +3166,140 @@ void residual(ResidualOutput* output, double psi, ResidualArgs* args) {
     //extract args
     double Ua = args->Ua;
     double Ut = args->Ut;
-    double R = args->R;
-    int B = args->B;
     Element* currentelement = args->currentelement;
-    /*printf("  size = %i\n", currentelement->airfoil->size);
-    for (int i=0; i<currentelement->airfoil->size; ++i) {
-        printf("Re[%i] = %f\n", i, currentelement->airfoil->polars[i]->Re);
-    }*/
-    double rho = args->rho;
-    double mu = args->mu;
     double a = args->a;
+    args->nevals += 1;
+    if (!args->inv.prepared) {
+        prepare_element_invariants(&(args->inv), Ua, Ut, args->R, args->B, currentelement->c, currentelement->r, args->rho, args->mu);
+    }
+    const ElementInvariants* inv = &(args->inv);
 
     //calculate velocity components
-    double U = sqrt(Ua*Ua + Ut*Ut);
-    double Wa = 0.5*Ua + 0.5*U*sin(psi);
-    double Wt = 0.5*Ut + 0.5*U*cos(psi);
+    double sinpsi, cospsi;
+    MATH_SINCOS(psi, &sinpsi, &cospsi);
+    double Wa = 0.5*Ua + 0.5*inv->U*sinpsi;
+    double Wt = 0.5*Ut + 0.5*inv->U*cospsi;
     output->va = Wa - Ua;
     output->vt = Ut - Wt;
 
     //determine relative wind velocity and angle of attack
     output->W = sqrt(Wa*Wa + Wt*Wt);
-    double Re = rho * output->W * (currentelement->c) / mu;
-    output->phi = atan(Wa/Wt);
+    double Re = inv->Ref * output->W;
+    output->phi = MATH_ATAN(Wa/Wt);
     double alpha = currentelement->beta - output->phi;
 
     //interpolate airfoil aerodynamic coefficients
     double Mach = (a > 0)? sqrt(output->W/a) : 0.0;
-    PolarPoint* operatingpoint = interpolate_airfoil_polars(currentelement->airfoil, alpha, Re, Mach);
+    PolarPoint operatingpoint;
+    interpolate_airfoil_polars_hint(&operatingpoint, currentelement->airfoil, alpha, Re, Mach, &(args->hint));
 
     //calculate tip losses
-    output->lambdaw = ((currentelement->r)/R)*(Wa/Wt);
-    double f = (1.0 - (currentelement->r)/R) * 0.5 * B / output->lambdaw;
+    output->lambdaw = inv->rR*(Wa/Wt);
+    double f = inv->ftip / output->lambdaw;
     //double F = acos(exp(-f)) * 2.0 / PI;
     double F = 0.0;
     if (f>0) {
-        F = acos(exp(-f)) * 2.0 / PI;
+        F = MATH_ACOS(MATH_EXP(-f)) * 2.0 / PI;
     }
 
     //determine circulation and rotor coefficients
-    output->Gamma = output->vt * (4.0*PI*(currentelement->r) / B) * F * sqrt(1.0 + pow(4*output->lambdaw*R/(PI*B*(currentelement->r)), 2));
-    output->residual = output->Gamma - 0.5 * output->W * (currentelement->c) * operatingpoint->CL;
-    output->Cn = operatingpoint->CL* Wt / output->W - operatingpoint->CD * Wa / output->W;
-    output->Ct = operatingpoint->CL* Wa / output->W + operatingpoint->CD * Wt / output->W;
-    free(operatingpoint);
+    double lambdaterm = output->lambdaw * inv->lambdaf;
+    output->Gamma = output->vt * inv->Gammaf * F * sqrt(1.0 + lambdaterm*lambdaterm);
+    output->residual = output->Gamma - 0.5 * output->W * (currentelement->c) * operatingpoint.CL;
+    output->Cn = operatingpoint.CL* Wt / output->W - operatingpoint.CD * Wa / output->W;
+    output->Ct = operatingpoint.CL* Wa / output->W + operatingpoint.CD * Wt / output->W;
+}
+
+//inputs of the element sensitivities
+//INTERNAL USE ONLY
+enum {SENS_PSI, SENS_C, SENS_BETA, SENS_UA, SENS_UT, NSENS};
+
+//data structure for the derivatives of the residual and of the loads of a blade element
+//with respect to psi, c, beta, Ua and Ut (indexed by SENS_PSI, SENS_C, ...)
+//INTERNAL USE ONLY
+typedef struct {
+    double residual[NSENS];     //derivatives of the residual
+    double dTdr[NSENS];         //derivatives of the thrust per unit span of a blade
+    double dQdr[NSENS];         //derivatives of the torque per unit span of a blade
+} ElementSensitivities;
+
+//differentiate the residual function and the loads of an element at a given psi
+//NOTE: the same steps of residual() are differentiated with the chain rule; the derivatives
+//are exact for the piecewise-linear polars, except at their breakpoints (one-sided slopes)
+//INTERNAL USE ONLY
+void residual_sensitivities(ElementSensitivities* sens, double psi, const ResidualArgs* args) {
+    double Ua = args->Ua;
+    double Ut = args->Ut;
+    const Element* currentelement = args->currentelement;
+    double c = currentelement->c;
+    double rho = args->rho;
+    double a = args->a;
+    ElementInvariants inv;
+    prepare_element_invariants(&inv, Ua, Ut, args->R, args->B, c, currentelement->r, rho, args->mu);
+
+    //repeat the steps of the residual function
+    double sinpsi = sin(psi);
+    double cospsi = cos(psi);
+    double Wa = 0.5*Ua + 0.5*inv.U*sinpsi;
+    double Wt = 0.5*Ut + 0.5*inv.U*cospsi;
+    double vt = Ut - Wt;
+    double W = sqrt(Wa*Wa + Wt*Wt);
+    double Re = inv.Ref * W;
+    double alpha = currentelement->beta - atan(Wa/Wt);
+    PolarSlopes polar;
+    interpolate_airfoil_polars_slopes(&polar, currentelement->airfoil, alpha, Re);
+    double Mach = (a > 0)? sqrt(W/a) : 0.0;
+    double Machfactor = 1.0;
+    double dMachfactordW = 0.0;
+    if (Mach > 0.01 && Mach < 0.99) {
+        Machfactor = 1.0 / sqrt(1.0 - Mach*Mach);
+        dMachfactordW = 0.5 * Machfactor*Machfactor*Machfactor / a;
+    }
+    double CL = polar.CL * Machfactor;
+    double CD = polar.CD;
+    double lambdaw = inv.rR*(Wa/Wt);
+    double f = inv.ftip / lambdaw;
+    double F = 0.0;
+    double dFdf = 0.0;
+    if (f>0) {
+        double expf = exp(-f);
+        F = acos(expf) * 2.0 / PI;
+        dFdf = 2.0 / PI * expf / sqrt(1.0 - expf*expf);
+    }
+    double lambdaterm = lambdaw * inv.lambdaf;
+    double S = sqrt(1.0 + lambdaterm*lambdaterm);
+    double N = CL*Wt - CD*Wa;       //Cn*W
+    double M = CL*Wa + CD*Wt;       //Ct*W
+
+    //propagate the derivative of each input
+    for (int k=0; k<NSENS; ++k) {
+        double dpsi = (k == SENS_PSI);
+        double dc = (k == SENS_C);
+        double dbeta = (k == SENS_BETA);
+        double dUa = (k == SENS_UA);
+        double dUt = (k == SENS_UT);
+        double dU = (Ua*dUa + Ut*dUt) / inv.U;
+        double dWa = 0.5*dUa + 0.5*(dU*sinpsi + inv.U*cospsi*dpsi);
+        double dWt = 0.5*dUt + 0.5*(dU*cospsi - inv.U*sinpsi*dpsi);
+        double dvt = dUt - dWt;
+        double dW = (Wa*dWa + Wt*dWt) / W;
+        double dalpha = dbeta - (Wt*dWa - Wa*dWt) / (W*W);
+        double dRe = inv.Ref*dW + rho/args->mu*W*dc;
+        double dCL = (polar.dCLdalpha*dalpha + polar.dCLdRe*dRe)*Machfactor + polar.CL*dMachfactordW*dW;
+        double dCD = polar.dCDdalpha*dalpha + polar.dCDdRe*dRe;
+        double dlambdaw = inv.rR*(dWa*Wt - Wa*dWt) / (Wt*Wt);
+        double dF = -dFdf * inv.ftip / (lambdaw*lambdaw) * dlambdaw;
+        double dS = lambdaterm * inv.lambdaf * dlambdaw / S;
+        double dGamma = inv.Gammaf * (dvt*F*S + vt*dF*S + vt*F*dS);
+        double dN = dCL*Wt + CL*dWt - dCD*Wa - CD*dWa;
+        double dM = dCL*Wa + CL*dWa + dCD*Wt + CD*dWt;
+        sens->residual[k] = dGamma - 0.5*(dW*c*CL + W*dc*CL + W*c*dCL);
+        sens->dTdr[k] = 0.5*rho*(dc*W*N + c*dW*N + c*W*dN);
+        sens->dQdr[k] = 0.5*rho*currentelement->r*(dc*W*M + c*dW*M + c*W*dM);
+    }
 }
 
-//wrap the residual function so it can be passed to fzero
+//wrap the residual function so it can be passed to fzero
 //INTERNAL USE ONLY
 double residual_wrapper(double psi, void* args) {
     ResidualOutput output;      //= {0.0, 0.0, 0.0, 0, NULL, 0.0, 0.0, 0.0}
@@ -824,13 +3307,34 @@ double residual_wrapper(double psi, void* args) {
     return output.residual;
 }
 
+//data structure for the solution of a blade element
+//it keeps the last residual output, so that it can be reused at convergence
+//INTERNAL USE ONLY
+typedef struct {
+    ResidualArgs args;
+    double last_psi;
+    ResidualOutput last;
+#if defined(QPROP_STATS)
+    int nbracket;       //number of residual evaluations spent bracketing the root
+#endif
+} ElementSolution;
+
+//wrap the residual function so it can be passed to fzero, keeping the last output
+//INTERNAL USE ONLY
+double residual_wrapper_cached(double psi, void* solution) {
+    ElementSolution* currentsolution = (ElementSolution*) solution;
+    residual(&(currentsolution->last), psi, &(currentsolution->args));
+    currentsolution->last_psi = psi;
+    return currentsolution->last.residual;
+}
+
 //find the root of a function f(x)=0 using the bisection method
 //INTERNAL USE ONLY
 double fzero(double (*f)(double x, void* args), double a, double b, double tol, int itmax, void* args) {
     double fa = f(a, args);
     double fb = f(b, args);
     if (fa*fb > 0) {
-        printf("ERROR when using fzero: f(a) and f(b) must have opposite signs\n");
+        //no sign change: the caller detects it from the residual
         return a;
     }
 
@@ -857,109 +3361,2521 @@ double fzero(double (*f)(double x, void* args), double a, double b, double tol,
             fa = fc;
         }
     }
-
-    printf("ERROR while using fzero: maximum number of iterations reached\n");
+    //maximum number of iterations reached: the caller detects it from the residual
     return c;
 }
 
-//run qprop iterations
-RotorPerformance* qprop(Rotor* rotor, double Uinf, double Omega, double tol, int itmax, double rho, double mu, double a) {
-    //initialize variables
+//find the root of a function f(x)=0 using Brent's method, starting from a bracket [a,b]
+//where the function values fa=f(a) and fb=f(b) are already known
+//it combines inverse quadratic interpolation, secant and bisection steps,
+//so it converges superlinearly while keeping the root bracketed
+//INTERNAL USE ONLY
+double fzero_brent_bracketed(double (*f)(double x, void* args), double a, double fa, double b, double fb, double tol, int itmax, void* args) {
+    if (fa*fb > 0) {
+        //no sign change: the caller detects it from the residual
+        return a;
+    }
+
+    //iterate
+    double c = b;               //contrapoint: the root is always between b and c
+    double fc = fb;
+    double d = b - a;           //current step
+    double e = d;               //step before the last one
+    for (int i=0; i<itmax; ++i) {
+        if (fb*fc > 0) {
+            //restore the bracket
+            c = a;
+            fc = fa;
+            d = b - a;
+            e = d;
+        }
+        if (fabs(fc) < fabs(fb)) {
+            //make b the best estimate so far
+            a = b;
+            b = c;
+            c = a;
+            fa = fb;
+            fb = fc;
+            fc = fa;
+        }
+
+        //stopping criterion on residual and convergence (same as the bisection method)
+        double tol1 = 2.0*DBL_EPSILON*fabs(b) + tol;
+        double m = 0.5*(c - b);
+        if (fb == 0.0 || (fabs(m) <= tol1 && fabs(fb) <= tol)) {
+            return b;
+        }
+
+        if (fabs(m) > tol1 && fabs(e) >= tol1 && fabs(fa) > fabs(fb)) {
+            //attempt inverse quadratic interpolation (or secant if only two points are available)
+            double s = fb/fa;
+            double p = 0.0;
+            double q = 0.0;
+            if (a == c) {
+                p = 2.0*m*s;
+                q = 1.0 - s;
+            }
+            else {
+                double qa = fa/fc;
+                double rb = fb/fc;
+                p = s*(2.0*m*qa*(qa - rb) - (b - a)*(rb - 1.0));
+                q = (qa - 1.0)*(rb - 1.0)*(s - 1.0);
+            }
+            if (p > 0) {
+                q = -q;
+            }
+            else {
+                p = -p;
+            }
+
+            //accept the interpolation only if it falls well within the bracket
+            if (2.0*p < fmin(3.0*m*q - fabs(tol1*q), fabs(e*q))) {
+                e = d;
+                d = p/q;
+            }
+            else {
+                d = m;
+                e = m;
+            }
+        }
+        else {
+            //bisection step
+            //NOTE: when the bracket is already narrow but the residual is still too large,
+            //      keep halving the domain as the bisection method does
+            d = m;
+            e = m;
+        }
+
+        //evaluate new point
+        a = b;
+        fa = fb;
+        if (fabs(d) > tol1 || fabs(m) <= tol1) {
+            b += d;
+        }
+        else {
+            b += (m > 0)? tol1 : -tol1;
+        }
+        fb = f(b, args);
+    }
+    //maximum number of iterations reached: the caller detects it from the residual
+    return b;
+}
+
+//find the root of a function f(x)=0 using Brent's method
+//INTERNAL USE ONLY
+double fzero_brent(double (*f)(double x, void* args), double a, double b, double tol, int itmax, void* args) {
+    double fa = f(a, args);
+    double fb = f(b, args);
+    return fzero_brent_bracketed(f, a, fa, b, fb, tol, itmax, args);
+}
+
+//get the default options for qprop_ex
+QPropOptions qprop_default_options(void) {
+    QPropOptions options;
+    options.tol = 1e-6;
+    options.itmax = 100;
+    options.solver = QPROP_SOLVER_BRENT;
+    options.nthreads = 1;
+    options.stats = NULL;
+    return options;
+}
+
+//allocate an empty qprop output for the given number of elements
+//all the per-element arrays are stored in a single block starting at perf->residuals,
+//in this order: residuals, dTdr, dQdr, Gamma, lambdaw, r, W, phi, nevals, converged
+//in totals-only mode, dTdr and dQdr are kept in the block as internal storage,
+//while the per-element distributions are not allocated and their pointers are NULL
+//INTERNAL USE ONLY
+RotorPerformance* new_rotor_performance_ex(int nelems, bool totals_only) {
     RotorPerformance* perf = calloc(1, sizeof(RotorPerformance));
     if (!perf) {
-        printf("ERROR: memory allocation error in qprop()\n");
         return NULL;
     }
-    int nelems = rotor->nsections - 1;      //number of elements discretizing the blade
+    int narrays = (totals_only)? 3 : 8;
+    double* block = calloc(1, narrays*nelems*sizeof(double) + nelems*(sizeof(int) + sizeof(bool)));
+    if (!block) {
+        free(perf);
+        return NULL;
+    }
     perf->T = 0.0;
     perf->Q = 0.0;
     perf->CT = 0.0;
     perf->CP = 0.0;
     perf->J = 0.0;
-    perf->residuals = calloc(nelems, sizeof(double));
-    perf->Gamma = calloc(nelems, sizeof(double));
-    perf->lambdaw = calloc(nelems, sizeof(double));
-    perf->r = calloc(nelems, sizeof(double));
-    perf->W = calloc(nelems, sizeof(double));
-    perf->phi = calloc(nelems, sizeof(double));
-    perf->dTdr = calloc(nelems, sizeof(double));
-    perf->dQdr = calloc(nelems, sizeof(double));
+    perf->residuals = block;
+    perf->dTdr = (totals_only)? NULL : block + nelems;
+    perf->dQdr = (totals_only)? NULL : block + 2*nelems;
+    perf->Gamma = (totals_only)? NULL : block + 3*nelems;
+    perf->lambdaw = (totals_only)? NULL : block + 4*nelems;
+    perf->r = (totals_only)? NULL : block + 5*nelems;
+    perf->W = (totals_only)? NULL : block + 6*nelems;
+    perf->phi = (totals_only)? NULL : block + 7*nelems;
     perf->nelems = nelems;
+    perf->nevals = (int*) (block + narrays*nelems);
+    perf->converged = (bool*) (perf->nevals + nelems);
+    perf->status = QPROP_OK;
+    return perf;
+}
 
-    //iterate over each element in the blade
-    for (int i=0; i<nelems; ++i) {
-        //build the i-th element, between the i-th and the (i+1)-th sections
-        Element currentelement;     //= {0, 0, 0, 0, (*airfoil)};
-        currentelement.c = 0.5*(rotor->sections[i].c + rotor->sections[i+1].c);
-        currentelement.beta = 0.5*(rotor->sections[i].beta + rotor->sections[i+1].beta);
-        currentelement.r = 0.5*(rotor->sections[i].r + rotor->sections[i+1].r);
-        currentelement.dr = rotor->sections[i+1].r - rotor->sections[i].r;
-        currentelement.airfoil = &(rotor->sections[i+1].airfoil);
-        //
-        //TODO: interpolate airfoils between the two sections
-        //
-
-        //check airfoil polars
-        for (int j=1; j<currentelement.airfoil->size; ++j) {
-            if (currentelement.airfoil->polars[j]->Re <= currentelement.airfoil->polars[j-1]->Re) {
-                //j-th polar has a lower Reynolds number than the preceding polar
-                sort_airfoil_polars(currentelement.airfoil);
-                break;
-            }
-        }
-        
-        //find the value of psi that makes the residual function equal to zero
-        ResidualArgs args = {Uinf, Omega*currentelement.r, rotor->D/2, rotor->B, &currentelement, rho, mu, a};
-        double psi = fzero(residual_wrapper, -PI/2, +PI/2, tol, itmax, &args);
+//allocate an empty qprop output for the given number of elements
+//INTERNAL USE ONLY
+RotorPerformance* new_rotor_performance(int nelems) {
+    return new_rotor_performance_ex(nelems, false);
+}
 
-        //calculate element thrust and torque
-        ResidualOutput res;     //= {0.0, 0.0, 0.0, 0, NULL, 0.0, 0.0, 0.0}
-        residual(&res, psi, &args);
-        if (fabs(res.residual) > tol) {
-            printf("ERROR when using qprop at blade location #%i: unable to find psi value that is zeroing the residual function (residual=%e exceeds tolerance=%e)\n", i, perf->residuals[i], tol);
-            free_rotor_performance(perf);
-            return NULL;
+//get the thrust and torque distributions of a qprop output
+//in totals-only mode they are the internal storage following the residuals in the block,
+//otherwise they are the output arrays, which may belong to the caller (e.g. the Julia buffers)
+//INTERNAL USE ONLY
+double* performance_dTdr(RotorPerformance* perf) {
+    return (perf->dTdr)? perf->dTdr : perf->residuals + perf->nelems;
+}
+
+//INTERNAL USE ONLY
+double* performance_dQdr(RotorPerformance* perf) {
+    return (perf->dQdr)? perf->dQdr : perf->residuals + 2*perf->nelems;
+}
+
+//allocate a qprop output to be filled by qprop_into
+RotorPerformance* alloc_rotor_performance(Rotor* rotor, bool totals_only) {
+    RotorPerformance* perf = new_rotor_performance_ex(rotor->nsections - 1, totals_only);
+    if (!perf) {
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in alloc_rotor_performance()");
+    }
+    return perf;
+}
+
+//find the value of psi that makes the residual function of an element equal to zero
+//when warmstart is true, the search starts from a narrow bracket around psi0 (half-width dpsi),
+//which is widened only if the residual does not change sign
+//INTERNAL USE ONLY
+double solve_element_psi(ElementSolution* solution, const QPropOptions* opts, double psi0, double dpsi, bool warmstart) {
+    double (*f)(double x, void* args) = residual_wrapper_cached;
+    double a = -PI/2;
+    double b = +PI/2;
+    if (warmstart) {
+        //look for a bracket around the initial guess
+        double fa = 0.0;
+        double fb = 0.0;
+        while (true) {
+            a = fmax(psi0 - dpsi, -PI/2);
+            b = fmin(psi0 + dpsi, +PI/2);
+            fa = f(a, solution);
+            fb = f(b, solution);
+            QPROP_STATS_ADD(solution->nbracket, 2);
+            if (fa*fb <= 0 || (a <= -PI/2 && b >= +PI/2)) {
+                break;
+            }
+            dpsi *= 4.0;
+        }
+        if (opts->solver == QPROP_SOLVER_BRENT) {
+            return fzero_brent_bracketed(f, a, fa, b, fb, opts->tol, opts->itmax, solution);
+        }
+        return fzero(f, a, b, opts->tol, opts->itmax, solution);
+    }
+
+    //search over the full domain
+    QPROP_STATS_ADD(solution->nbracket, 2);
+    if (opts->solver == QPROP_SOLVER_BRENT) {
+        return fzero_brent(f, a, b, opts->tol, opts->itmax, solution);
+    }
+    return fzero(f, a, b, opts->tol, opts->itmax, solution);
+}
+
+//data structure for the solution of a whole rotor at an operating point
+//INTERNAL USE ONLY
+typedef struct {
+    RotorPerformance* perf;
+    Rotor* rotor;
+    double Uinf;
+    double Omega;
+    double rho;
+    double mu;
+    double a;
+    const QPropOptions* opts;
+    double* psi;
+    bool warmstart;
+    QPropStats* elementstats;   //statistics of each element (NULL if not collected)
+} RotorSolution;
+
+//store the solution of the i-th blade element in the rotor solution
+//INTERNAL USE ONLY
+void store_element_solution(RotorSolution* sol, int i, double psii, const ResidualOutput* res, double c, double r, int nevals) {
+    RotorPerformance* perf = sol->perf;
+    if (sol->psi && fabs(res->residual) <= sol->opts->tol) {
+        sol->psi[i] = psii;
+    }
+    //NOTE: dTdr and dQdr are always stored, also in totals-only mode
+    perf->residuals[i] = res->residual;
+    performance_dTdr(perf)[i] = 0.5 * sol->rho * res->W * res->W * res->Cn * c;
+    performance_dQdr(perf)[i] = 0.5 * sol->rho * res->W * res->W * res->Ct * c * r;
+    perf->nevals[i] = nevals;
+    if (perf->Gamma) {
+        perf->Gamma[i] = res->Gamma;
+        perf->lambdaw[i] = res->lambdaw;
+        perf->r[i] = r;
+        perf->W[i] = res->W;
+        perf->phi[i] = res->phi;
+    }
+}
+
+#if defined(QPROP_STATS)
+//store the statistics of the i-th blade element in the rotor solution
+//INTERNAL USE ONLY
+void store_element_stats(RotorSolution* sol, int i, int nevals, int nbracket, const InterpolationHint* hint) {
+    if (!sol->elementstats) {
+        return;
+    }
+    QPropStats* stats = &(sol->elementstats[i]);
+    stats->nelements = 1;
+    stats->nevals = nevals;
+    stats->niterations = nevals - nbracket;
+    stats->nalphaclamped = hint->nalphaclamped;
+    stats->nReclamped = hint->nReclamped;
+}
+#endif
+
+//build the i-th blade element of a rotor, between the i-th and the (i+1)-th sections
+//INTERNAL USE ONLY
+void set_rotor_element(Element* element, const Rotor* rotor, int i) {
+    element->c = 0.5*(rotor->sections[i].c + rotor->sections[i+1].c);
+    element->beta = 0.5*(rotor->sections[i].beta + rotor->sections[i+1].beta);
+    element->r = 0.5*(rotor->sections[i].r + rotor->sections[i+1].r);
+    element->dr = rotor->sections[i+1].r - rotor->sections[i].r;
+    element->airfoil = rotor_element_airfoil(rotor, i);
+}
+
+//solve the i-th blade element of a rotor and store the results in the rotor solution
+//if warmstart is true, the search starts from psi0, in a bracket of half-width dpsi
+//hint0, nevals0, nbracket0: interpolation hint and evaluations already spent on the element
+//by a previous solver (see solve_rotor_batch), NULL and 0 when solving it from scratch
+//INTERNAL USE ONLY
+void solve_rotor_element_from(RotorSolution* sol, int i, const QPropOptions* opts, double psi0, double dpsi, bool warmstart,
+                              const InterpolationHint* hint0, int nevals0, int nbracket0) {
+    Rotor* rotor = sol->rotor;
+
+    //build the i-th element, between the i-th and the (i+1)-th sections
+    Element currentelement;     //= {0, 0, 0, 0, (*airfoil)};
+    set_rotor_element(&currentelement, rotor, i);
+
+    //find the value of psi that makes the residual function equal to zero
+    ElementSolution solution;
+    ResidualArgs args = {sol->Uinf, sol->Omega*currentelement.r, rotor->D/2, rotor->B, &currentelement, sol->rho, sol->mu, sol->a, 0, {0}, {false, 0, 0, 0, 0, 0, 0}};
+    solution.args = args;
+    solution.args.nevals = nevals0;
+    if (hint0) {
+        solution.args.hint = *hint0;
+    }
+    solution.last_psi = NAN;
+#if defined(QPROP_STATS)
+    solution.nbracket = nbracket0;
+#else
+    (void) nbracket0;
+#endif
+    double psii = solve_element_psi(&solution, opts, psi0, dpsi, warmstart);
+
+    //calculate element thrust and torque
+    //NOTE: the residual evaluated at the solution is reused when available
+    ResidualOutput res;     //= {0.0, 0.0, 0.0, 0, NULL, 0.0, 0.0, 0.0}
+    if (solution.last_psi == psii) {
+        res = solution.last;
+    }
+    else {
+        residual(&res, psii, &(solution.args));
+    }
+    store_element_solution(sol, i, psii, &res, currentelement.c, currentelement.r, solution.args.nevals);
+#if defined(QPROP_STATS)
+    store_element_stats(sol, i, solution.args.nevals, solution.nbracket, &(solution.args.hint));
+#endif
+}
+
+//solve the i-th blade element of a rotor and store the results in the rotor solution
+//INTERNAL USE ONLY
+void solve_rotor_element(int i, void* rotorsolution) {
+    RotorSolution* sol = (RotorSolution*) rotorsolution;
+    bool warmstart = sol->psi && sol->warmstart;
+    double psi0 = (warmstart)? sol->psi[i] : 0.0;
+    solve_rotor_element_from(sol, i, sol->opts, psi0, WARMSTART_BRACKET, warmstart, NULL, 0, 0);
+}
+
+//set the j-th element of a batch and compute its invariants
+//batch->R, batch->B, batch->rho and batch->mu must be already set
+//INTERNAL USE ONLY
+void set_batch_element(ElementBatch* batch, int j, double c, double beta, double r, double dr, double Ua, double Ut, Airfoil* airfoil) {
+    batch->c[j] = c;
+    batch->beta[j] = beta;
+    batch->r[j] = r;
+    batch->dr[j] = dr;
+    batch->Ua[j] = Ua;
+    batch->Ut[j] = Ut;
+    batch->airfoil[j] = airfoil;
+    batch->hint[j] = (InterpolationHint) {0};
+    batch->nevals[j] = 0;
+    ElementInvariants inv;
+    prepare_element_invariants(&inv, Ua, Ut, batch->R, batch->B, c, r, batch->rho, batch->mu);
+    batch->U[j] = inv.U;
+    batch->rR[j] = inv.rR;
+    batch->ftip[j] = inv.ftip;
+    batch->Gammaf[j] = inv.Gammaf;
+    batch->lambdaf[j] = inv.lambdaf;
+    batch->Ref[j] = inv.Ref;
+}
+
+//define the QProp residual function on a batch of blade elements
+//it performs the same steps of residual(), but each step is applied to all the elements of the batch
+//before moving to the next one, so that the arithmetic can be vectorized by the compiler;
+//only the polar interpolation is performed element by element, on the active elements only
+//INTERNAL USE ONLY
+void residual_batch(ResidualOutput* output, const double* psi, const bool* active, ElementBatch* batch) {
+    const int n = batch->n;
+    qprop_real Wa[QPROP_BATCH_SIZE];
+    qprop_real Wt[QPROP_BATCH_SIZE];
+    qprop_real W[QPROP_BATCH_SIZE];
+    qprop_real Re[QPROP_BATCH_SIZE];
+    qprop_real phi[QPROP_BATCH_SIZE];
+    qprop_real alpha[QPROP_BATCH_SIZE];
+    qprop_real CL[QPROP_BATCH_SIZE] = {0};
+    qprop_real CD[QPROP_BATCH_SIZE] = {0};
+    qprop_real lambdaw[QPROP_BATCH_SIZE];
+    qprop_real F[QPROP_BATCH_SIZE];
+    qprop_real Gamma[QPROP_BATCH_SIZE];
+
+    //calculate velocity components, relative wind velocity and angle of attack
+    for (int k=0; k<n; ++k) {
+        qprop_real sinpsi, cospsi;
+        REAL_SINCOS(REAL(psi[k]), &sinpsi, &cospsi);
+        Wa[k] = REAL(0.5)*batch->Ua[k] + REAL(0.5)*batch->U[k]*sinpsi;
+        Wt[k] = REAL(0.5)*batch->Ut[k] + REAL(0.5)*batch->U[k]*cospsi;
+        W[k] = REAL_SQRT(Wa[k]*Wa[k] + Wt[k]*Wt[k]);
+        Re[k] = batch->Ref[k] * W[k];
+        phi[k] = REAL_ATAN(Wa[k]/Wt[k]);
+        alpha[k] = batch->beta[k] - phi[k];
+    }
+
+    //interpolate airfoil aerodynamic coefficients
+    for (int k=0; k<n; ++k) {
+        if (!active[k]) {
+            continue;
+        }
+        double Mach = (batch->a > 0)? sqrt(W[k]/batch->a) : 0.0;
+        PolarPoint operatingpoint;
+        interpolate_airfoil_polars_hint(&operatingpoint, batch->airfoil[k], alpha[k], Re[k], Mach, &(batch->hint[k]));
+        CL[k] = REAL(operatingpoint.CL);
+        CD[k] = REAL(operatingpoint.CD);
+        batch->nevals[k] += 1;
+    }
+
+    //calculate tip losses
+    for (int k=0; k<n; ++k) {
+        lambdaw[k] = batch->rR[k]*(Wa[k]/Wt[k]);
+        qprop_real f = batch->ftip[k] / lambdaw[k];
+        F[k] = (f>0)? REAL_ACOS(REAL_EXP(-f)) * 2 / REAL(PI) : 0;
+    }
+
+    //determine circulation and rotor coefficients
+    for (int k=0; k<n; ++k) {
+        qprop_real vt = batch->Ut[k] - Wt[k];
+        qprop_real lambdaterm = lambdaw[k] * batch->lambdaf[k];
+        Gamma[k] = vt * batch->Gammaf[k] * F[k] * REAL_SQRT(1 + lambdaterm*lambdaterm);
+    }
+    for (int k=0; k<n; ++k) {
+        if (!active[k]) {
+            continue;
+        }
+        output[k].W = W[k];
+        output[k].phi = phi[k];
+        output[k].va = Wa[k] - batch->Ua[k];
+        output[k].vt = batch->Ut[k] - Wt[k];
+        output[k].lambdaw = lambdaw[k];
+        output[k].Gamma = Gamma[k];
+        output[k].residual = Gamma[k] - REAL(0.5) * W[k] * batch->c[k] * CL[k];
+        output[k].Cn = CL[k] * Wt[k] / W[k] - CD[k] * Wa[k] / W[k];
+        output[k].Ct = CL[k] * Wa[k] / W[k] + CD[k] * Wt[k] / W[k];
+    }
+}
+
+//find the values of psi that zero the residual functions of a batch of elements, using the bisection method
+//all the elements perform the same iteration together; each element leaves the loop as soon as
+//it converges (per-element mask), with the same steps and stopping criterion of fzero()
+//the residual outputs at the returned psi values are stored in last
+//INTERNAL USE ONLY
+void fzero_batch(double* psi, ResidualOutput* last, ElementBatch* batch, double tol, int itmax) {
+    const int n = batch->n;
+    double a[QPROP_BATCH_SIZE];
+    double b[QPROP_BATCH_SIZE];
+    double c[QPROP_BATCH_SIZE];
+    double fa[QPROP_BATCH_SIZE];
+    double fb[QPROP_BATCH_SIZE];
+    bool active[QPROP_BATCH_SIZE];
+    ResidualOutput output[QPROP_BATCH_SIZE];
+    int nactive = n;
+    for (int k=0; k<QPROP_BATCH_SIZE; ++k) {
+        a[k] = -PI/2;
+        b[k] = +PI/2;
+        c[k] = 0.0;
+        active[k] = (k < n);
+    }
+    residual_batch(last, a, active, batch);
+    residual_batch(output, b, active, batch);
+    for (int k=0; k<n; ++k) {
+        fa[k] = last[k].residual;
+        fb[k] = output[k].residual;
+        if (fa[k]*fb[k] > 0) {
+            //no sign change: detected from the residual in qprop_solve_elements
+            psi[k] = a[k];
+            active[k] = false;
+            --nactive;
+        }
+    }
+
+    //iterate
+    for (int i=0; i<itmax && nactive>0; ++i) {
+        //evaluate mid points
+        for (int k=0; k<n; ++k) {
+            c[k] = 0.5*(a[k]+b[k]);
+        }
+        residual_batch(output, c, active, batch);
+        for (int k=0; k<n; ++k) {
+            if (!active[k]) {
+                continue;
+            }
+            double fc = output[k].residual;
+            if (fabs(fc) <= tol && 0.5*(b[k]-a[k]) <= tol) {
+                //stopping criterion on residual and convergence
+                psi[k] = c[k];
+                last[k] = output[k];
+                active[k] = false;
+                --nactive;
+                continue;
+            }
+
+            //halve the domain
+            if (fa[k]*fc < 0) {
+                b[k] = c[k];
+                fb[k] = fc;
+            }
+            else {
+                a[k] = c[k];
+                fa[k] = fc;
+            }
+        }
+    }
+    for (int k=0; k<n; ++k) {
+        if (active[k]) {
+            psi[k] = c[k];
+            last[k] = output[k];
+        }
+    }
+}
+
+//solve the k-th batch of QPROP_BATCH_SIZE consecutive blade elements with the bisection method
+//and store the results in the rotor solution
+//INTERNAL USE ONLY
+void solve_rotor_batch(int k, void* rotorsolution) {
+    RotorSolution* sol = (RotorSolution*) rotorsolution;
+    Rotor* rotor = sol->rotor;
+    int first = k*QPROP_BATCH_SIZE;
+    int nelems = rotor->nsections - 1;
+
+    //build the batch of elements
+    ElementBatch batch;
+    batch.n = (nelems-first < QPROP_BATCH_SIZE)? nelems-first : QPROP_BATCH_SIZE;
+    batch.R = rotor->D/2;
+    batch.B = rotor->B;
+    batch.rho = sol->rho;
+    batch.mu = sol->mu;
+    batch.a = sol->a;
+    for (int j=0; j<batch.n; ++j) {
+        int i = first + j;
+        double r = 0.5*(rotor->sections[i].r + rotor->sections[i+1].r);
+        set_batch_element(&batch, j,
+                          0.5*(rotor->sections[i].c + rotor->sections[i+1].c),
+                          0.5*(rotor->sections[i].beta + rotor->sections[i+1].beta),
+                          r,
+                          rotor->sections[i+1].r - rotor->sections[i].r,
+                          sol->Uinf,
+                          sol->Omega*r,
+                          rotor_element_airfoil(rotor, i));
+    }
+
+    //solve all the elements together
+    double psi[QPROP_BATCH_SIZE];
+    ResidualOutput res[QPROP_BATCH_SIZE];
+#if defined(QPROP_SINGLE_PRECISION)
+    //the float residuals locate the roots, which are then refined with the double-precision residual
+    QPropOptions refine = *(sol->opts);
+    refine.solver = QPROP_SOLVER_BRENT;
+    fzero_batch(psi, res, &batch, fmax(sol->opts->tol, REFINE_BRACKET), sol->opts->itmax);
+    for (int j=0; j<batch.n; ++j) {
+        solve_rotor_element_from(sol, first+j, &refine, psi[j], REFINE_BRACKET, true, &(batch.hint[j]), batch.nevals[j], 2);
+    }
+#else
+    fzero_batch(psi, res, &batch, sol->opts->tol, sol->opts->itmax);
+    for (int j=0; j<batch.n; ++j) {
+        store_element_solution(sol, first+j, psi[j], &(res[j]), batch.c[j], batch.r[j], batch.nevals[j]);
+#if defined(QPROP_STATS)
+        store_element_stats(sol, first+j, batch.nevals[j], 2, &(batch.hint[j]));
+#endif
+    }
+#endif
+}
+
+//solve all the blade elements at the given operating point and store the results in perf
+//psi (optional): array of nelems values of psi; if warmstart is true, they are used as
+//initial guesses, and they are overwritten with the converged values
+//nthreads: number of threads used to solve the elements in parallel
+//the airfoils of the elements must be already blended (see qprop_solve)
+//INTERNAL USE ONLY
+bool qprop_solve_elements(RotorPerformance* perf, Rotor* rotor, double Uinf, double Omega, double rho, double mu, double a,
+                          const QPropOptions* opts, double* psi, bool warmstart, int nthreads) {
+    double tol = opts->tol;
+    int nelems = perf->nelems;
+
+    //solve each element in the blade
+    //NOTE: the airfoil polars are already sorted by Re when the rotor sections are built
+    nthreads = element_threads(nelems, nthreads);
+    RotorSolution sol = {perf, rotor, Uinf, Omega, rho, mu, a, opts, psi, warmstart, NULL};
+#if defined(QPROP_STATS)
+    double tstart = stats_wall_time();
+    sol.elementstats = (opts->stats)? calloc(nelems, sizeof(QPropStats)) : NULL;
+#endif
+    if (opts->solver == QPROP_SOLVER_BISECTION && !(psi && warmstart)) {
+        //bisection from the full domain: all the elements perform the same steps, so they are solved in batches
+        int nbatches = (nelems + QPROP_BATCH_SIZE - 1) / QPROP_BATCH_SIZE;
+        parallel_for(nbatches, nthreads, solve_rotor_batch, &sol);
+    }
+    else {
+        parallel_for(nelems, nthreads, solve_rotor_element, &sol);
+    }
+#if defined(QPROP_STATS)
+    double tsolved = stats_wall_time();
+#endif
+
+    //integrate thrust and torque, flagging the elements that did not converge
+    //NOTE: the sum is always performed in the same order, so that the results do not depend on nthreads
+    perf->T = 0.0;
+    perf->Q = 0.0;
+    int nfailed = 0;
+    int firstfailed = -1;
+    const double* dTdr = performance_dTdr(perf);
+    const double* dQdr = performance_dQdr(perf);
+    for (int i=0; i<nelems; ++i) {
+        perf->converged[i] = (fabs(perf->residuals[i]) <= tol);
+        if (!perf->converged[i]) {
+            firstfailed = (nfailed == 0)? i : firstfailed;
+            nfailed += 1;
+        }
+        double dr = rotor->sections[i+1].r - rotor->sections[i].r;
+        perf->T += dTdr[i] * dr;
+        perf->Q += dQdr[i] * dr;
+    }
+    perf->T *= rotor->B;                //total thrust (N)
+    perf->Q *= rotor->B;                //total torque (N-m)
+    double n = Omega/(2*PI);          //revolutions per second (rev/s)
+    perf->CT = perf->T / (rho * pow(n,2) * pow(rotor->D,4));        //thrust coefficient
+    double CQ = perf->Q / (rho * pow(n,2) * pow(rotor->D,5));       //torque coefficient
+    perf->CP = 2*PI * CQ;             //power coefficient
+    perf->J = Uinf / (n * rotor->D);    //advance ratio
+#if defined(QPROP_STATS)
+    if (sol.elementstats) {
+        //merge the statistics of the elements in order, so that they do not depend on nthreads
+        for (int i=0; i<nelems; ++i) {
+            merge_stats(opts->stats, &(sol.elementstats[i]));
+        }
+        free(sol.elementstats);
+        opts->stats->tsolve += tsolved - tstart;
+        opts->stats->tintegrate += stats_wall_time() - tsolved;
+    }
+#endif
+
+    //report the convergence once per call, not from the inner iterations
+    if (nfailed > 0) {
+        perf->status = QPROP_ERROR_NOT_CONVERGED;
+        qprop_log(QPROP_ERROR_NOT_CONVERGED, "ERROR when using qprop: %d blade elements did not converge, the first at blade location #%i (residual=%e exceeds tolerance=%e)", nfailed, firstfailed, perf->residuals[firstfailed], tol);
+        return false;
+    }
+    perf->status = QPROP_OK;
+    return true;
+}
+
+//free a temporary copy of a rotor created by temporary_blended_rotor
+//only the blended airfoils are released: the sections and the other airfoils belong to the rotor
+//INTERNAL USE ONLY
+void free_temporary_blended_rotor(Rotor* blendedrotor, const Rotor* rotor) {
+    for (int k=rotor->nairfoils; k<blendedrotor->nairfoils; ++k) {
+        free_airfoil(blendedrotor->airfoils[k]);
+    }
+    free(blendedrotor->airfoils);
+    free(blendedrotor->elementairfoils);
+    free(blendedrotor);
+}
+
+//create a temporary copy of a rotor with the blended airfoils of the elements
+//returns NULL if the rotor does not need it (or on errors, in which case *failed is set to true)
+//NOTE: the copy shares the sections and the airfoils of the rotor without adding references,
+//so the rotor and its airfoils are only read, even when they are shared with other threads
+//INTERNAL USE ONLY
+Rotor* temporary_blended_rotor(Rotor* rotor, bool* failed) {
+    *failed = false;
+    if (rotor->elementairfoils || !rotor_needs_blending(rotor)) {
+        return NULL;
+    }
+    Rotor* blendedrotor = malloc(sizeof(Rotor));
+    Airfoil** airfoils = malloc(rotor->nairfoils*sizeof(Airfoil*));
+    if (!blendedrotor || !airfoils) {
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: unable to blend the airfoils of the rotor");
+        free(blendedrotor);
+        free(airfoils);
+        *failed = true;
+        return NULL;
+    }
+    *blendedrotor = *rotor;
+    memcpy(airfoils, rotor->airfoils, rotor->nairfoils*sizeof(Airfoil*));
+    blendedrotor->airfoils = airfoils;
+    blendedrotor->elementairfoils = NULL;
+    if (!blend_rotor_airfoils(blendedrotor)) {
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: unable to blend the airfoils of the rotor");
+        free_temporary_blended_rotor(blendedrotor, rotor);
+        *failed = true;
+        return NULL;
+    }
+    return blendedrotor;
+}
+
+//solve all the blade elements at the given operating point and store the results in perf
+//the airfoils of the elements are precomputed by push_rotor_section and by the refinement; they are
+//blended on a temporary copy of the rotor only if its sections were changed in place
+//INTERNAL USE ONLY
+bool qprop_solve(RotorPerformance* perf, Rotor* rotor, double Uinf, double Omega, double rho, double mu, double a,
+                 const QPropOptions* opts, double* psi, bool warmstart, int nthreads) {
+#if defined(QPROP_STATS)
+    double tstart = stats_wall_time();
+#endif
+    bool failed;
+    Rotor* blendedrotor = temporary_blended_rotor(rotor, &failed);
+    if (failed) {
+        perf->status = QPROP_ERROR_MEMORY;
+        return false;
+    }
+#if defined(QPROP_STATS)
+    if (opts->stats) {
+        opts->stats->tsetup += stats_wall_time() - tstart;
+    }
+#endif
+    bool success = qprop_solve_elements(perf, (blendedrotor)? blendedrotor : rotor, Uinf, Omega, rho, mu, a, opts, psi, warmstart, nthreads);
+    if (blendedrotor) {
+        free_temporary_blended_rotor(blendedrotor, rotor);
+    }
+    return success;
+}
+
+//run qprop iterations with user-defined options
+RotorPerformance* qprop_ex(Rotor* rotor, double Uinf, double Omega, double rho, double mu, double a, const QPropOptions* options) {
+    QPropOptions opts = (options)? *options : qprop_default_options();
+    RotorPerformance* perf = new_rotor_performance(rotor->nsections - 1);
+    if (!perf) {
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in qprop_ex()");
+        return NULL;
+    }
+    if (!qprop_solve(perf, rotor, Uinf, Omega, rho, mu, a, &opts, NULL, false, opts.nthreads)
+            && perf->status != QPROP_ERROR_NOT_CONVERGED) {
+        //the outputs that did not converge are returned with their status
+        free_rotor_performance(perf);
+        return NULL;
+    }
+    return perf;
+}
+
+//run qprop iterations filling a previously allocated qprop output
+bool qprop_into(RotorPerformance* perf, Rotor* rotor, double Uinf, double Omega, double rho, double mu, double a, const QPropOptions* options) {
+    if (!perf || perf->nelems != rotor->nsections - 1) {
+        qprop_log(QPROP_ERROR_INVALID_ARGUMENT, "ERROR in qprop_into(): the qprop output was not allocated for this rotor");
+        return false;
+    }
+    QPropOptions opts = (options)? *options : qprop_default_options();
+    return qprop_solve(perf, rotor, Uinf, Omega, rho, mu, a, &opts, NULL, false, opts.nthreads);
+}
+
+//data structure for a sweep over multiple operating points
+//INTERNAL USE ONLY
+typedef struct {
+    RotorPerformance** perfs;
+    Rotor* rotor;
+    const double* Uinf;
+    const double* Omega;
+    int npoints;
+    double rho;
+    double mu;
+    double a;
+    const QPropOptions* opts;
+    QPropStats* chunkstats;     //statistics of each chunk (NULL if not collected)
+} SweepSolution;
+
+//solve the k-th chunk of consecutive operating points of a sweep
+//the first point of each chunk starts cold, the following ones are warm started
+//INTERNAL USE ONLY
+void solve_sweep_chunk(int k, void* sweepsolution) {
+    SweepSolution* sweep = (SweepSolution*) sweepsolution;
+    int nelems = sweep->rotor->nsections - 1;
+    double* psi = calloc(nelems, sizeof(double));
+    if (!psi) {
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in qprop_sweep()");
+        return;
+    }
+    //the statistics of the chunk are collected separately, as the chunks run in parallel
+    QPropOptions opts = *(sweep->opts);
+    opts.stats = (sweep->chunkstats)? &(sweep->chunkstats[k]) : NULL;
+    bool warmstart = false;
+    int last = (k+1)*SWEEP_CHUNK_SIZE;
+    for (int j=k*SWEEP_CHUNK_SIZE; j<last && j<sweep->npoints; ++j) {
+        RotorPerformance* perf = new_rotor_performance(nelems);
+        if (!perf) {
+            qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in qprop_sweep()");
+            continue;
+        }
+        if (!qprop_solve(perf, sweep->rotor, sweep->Uinf[j], sweep->Omega[j], sweep->rho, sweep->mu, sweep->a, &opts, psi, warmstart, 1)) {
+            //keep the outputs with their status, and the last valid psi values for the next point
+            if (perf->status == QPROP_ERROR_NOT_CONVERGED) {
+                sweep->perfs[j] = perf;
+            }
+            else {
+                free_rotor_performance(perf);
+            }
+            continue;
+        }
+        sweep->perfs[j] = perf;
+        warmstart = true;
+    }
+    free(psi);
+}
+
+//run qprop iterations over multiple operating points, warm starting each point from the previous one
+RotorPerformance** qprop_sweep(Rotor* rotor, const double* Uinf, const double* Omega, int npoints, double rho, double mu, double a, const QPropOptions* options) {
+    QPropOptions opts = (options)? *options : qprop_default_options();
+    RotorPerformance** perfs = calloc(npoints, sizeof(RotorPerformance*));
+    if (!perfs) {
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in qprop_sweep()");
+        return NULL;
+    }
+
+    //blend the airfoils of the elements once for all the operating points
+#if defined(QPROP_STATS)
+    double tstart = stats_wall_time();
+#endif
+    bool failed;
+    Rotor* blendedrotor = temporary_blended_rotor(rotor, &failed);
+    if (failed) {
+        free(perfs);
+        return NULL;
+    }
+#if defined(QPROP_STATS)
+    if (opts.stats) {
+        opts.stats->tsetup += stats_wall_time() - tstart;
+    }
+#endif
+
+    //solve chunks of consecutive operating points in parallel
+    //NOTE: the chunk size does not depend on the number of threads, so the results do not either
+    int nchunks = (npoints + SWEEP_CHUNK_SIZE - 1) / SWEEP_CHUNK_SIZE;
+    SweepSolution sweep = {perfs, (blendedrotor)? blendedrotor : rotor, Uinf, Omega, npoints, rho, mu, a, &opts,
+                           new_chunk_stats(&opts, nchunks)};
+    parallel_for(nchunks, opts.nthreads, solve_sweep_chunk, &sweep);
+    merge_chunk_stats(&opts, sweep.chunkstats, nchunks);
+    if (blendedrotor) {
+        free_temporary_blended_rotor(blendedrotor, rotor);
+    }
+    return perfs;
+}
+
+//free allocated memory on the outputs of qprop_sweep
+void free_rotor_performances(RotorPerformance** perfs, int npoints) {
+    if (!perfs) {
+        return;
+    }
+    for (int k=0; k<npoints; ++k) {
+        if (perfs[k]) {
+            free_rotor_performance(perfs[k]);
+            perfs[k] = NULL;
+        }
+    }
+    free(perfs);
+    perfs = NULL;
+}
+
+//data structure for a batch of operating points with totals-only outputs
+//INTERNAL USE ONLY
+typedef struct {
+    Rotor* rotor;
+    int npoints;
+    const double* Uinf;
+    const double* Omega;
+    const double* rho;
+    const double* mu;
+    double a;
+    const QPropOptions* opts;
+    double* T;
+    double* Q;
+    double* CT;
+    double* CP;
+    double* J;
+    bool* converged;
+    int* chunkconverged;    //number of converged points of each chunk
+    QPropStats* chunkstats; //statistics of each chunk (NULL if not collected)
+} BatchSolution;
+
+//solve the k-th chunk of consecutive operating points of a batch, reusing one output
+//INTERNAL USE ONLY
+void solve_batch_chunk(int k, void* batchsolution) {
+    BatchSolution* batch = (BatchSolution*) batchsolution;
+    int nelems = batch->rotor->nsections - 1;
+    double* psi = calloc(nelems, sizeof(double));
+    RotorPerformance* perf = new_rotor_performance_ex(nelems, true);
+    if (!psi || !perf) {
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in qprop_batch()");
+        free(psi);
+        if (perf) {
+            free_rotor_performance(perf);
+        }
+        return;
+    }
+    //the statistics of the chunk are collected separately, as the chunks run in parallel
+    QPropOptions opts = *(batch->opts);
+    opts.stats = (batch->chunkstats)? &(batch->chunkstats[k]) : NULL;
+    bool warmstart = false;
+    int nconverged = 0;
+    int last = (k+1)*SWEEP_CHUNK_SIZE;
+    for (int j=k*SWEEP_CHUNK_SIZE; j<last && j<batch->npoints; ++j) {
+        double rho = (batch->rho)? batch->rho[j] : 1.225;
+        double mu = (batch->mu)? batch->mu[j] : 1.81e-5;
+        bool converged = qprop_solve(perf, batch->rotor, batch->Uinf[j], batch->Omega[j], rho, mu, batch->a, &opts, psi, warmstart, 1);
+        if (batch->T) batch->T[j] = perf->T;
+        if (batch->Q) batch->Q[j] = perf->Q;
+        if (batch->CT) batch->CT[j] = perf->CT;
+        if (batch->CP) batch->CP[j] = perf->CP;
+        if (batch->J) batch->J[j] = perf->J;
+        if (batch->converged) batch->converged[j] = converged;
+        if (converged) {
+            //keep the last valid psi values for the next point
+            warmstart = true;
+            nconverged += 1;
+        }
+    }
+    batch->chunkconverged[k] = nconverged;
+    free(psi);
+    free_rotor_performance(perf);
+}
+
+//run qprop iterations over a batch of operating points, storing only the totals
+bool qprop_batch(Rotor* rotor, int npoints, const double* Uinf, const double* Omega, const double* rho, const double* mu, double a,
+                 const QPropOptions* options, double* T, double* Q, double* CT, double* CP, double* J, bool* converged) {
+    if (!rotor || rotor->nsections < 2 || npoints < 0 || (npoints > 0 && (!Uinf || !Omega))) {
+        qprop_log(QPROP_ERROR_INVALID_ARGUMENT, "ERROR in qprop_batch(): invalid arguments");
+        return false;
+    }
+    QPropOptions opts = (options)? *options : qprop_default_options();
+    int nchunks = (npoints + SWEEP_CHUNK_SIZE - 1) / SWEEP_CHUNK_SIZE;
+    int* chunkconverged = calloc(nchunks + 1, sizeof(int));
+    if (!chunkconverged) {
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in qprop_batch()");
+        return false;
+    }
+
+    //blend the airfoils of the elements once for all the operating points
+#if defined(QPROP_STATS)
+    double tstart = stats_wall_time();
+#endif
+    bool failed;
+    Rotor* blendedrotor = temporary_blended_rotor(rotor, &failed);
+    if (failed) {
+        free(chunkconverged);
+        return false;
+    }
+#if defined(QPROP_STATS)
+    if (opts.stats) {
+        opts.stats->tsetup += stats_wall_time() - tstart;
+    }
+#endif
+
+    //solve chunks of consecutive operating points in parallel, as in qprop_sweep
+    BatchSolution batch = {(blendedrotor)? blendedrotor : rotor, npoints, Uinf, Omega, rho, mu, a, &opts,
+                           T, Q, CT, CP, J, converged, chunkconverged, new_chunk_stats(&opts, nchunks)};
+    parallel_for(nchunks, opts.nthreads, solve_batch_chunk, &batch);
+    merge_chunk_stats(&opts, batch.chunkstats, nchunks);
+    if (blendedrotor) {
+        free_temporary_blended_rotor(blendedrotor, rotor);
+    }
+    int nconverged = 0;
+    for (int k=0; k<nchunks; ++k) {
+        nconverged += chunkconverged[k];
+    }
+    free(chunkconverged);
+    return nconverged == npoints;
+}
+
+//allocate the sensitivities of a rotor, with all the arrays in a single block starting at dTdc
+RotorGradients* alloc_rotor_gradients(Rotor* rotor) {
+    RotorGradients* gradients = calloc(1, sizeof(RotorGradients));
+    double* block = (gradients)? calloc(4*rotor->nsections, sizeof(double)) : NULL;
+    if (!block) {
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in alloc_rotor_gradients()");
+        free(gradients);
+        return NULL;
+    }
+    gradients->nsections = rotor->nsections;
+    gradients->dTdc = block;
+    gradients->dTdbeta = block + rotor->nsections;
+    gradients->dQdc = block + 2*rotor->nsections;
+    gradients->dQdbeta = block + 3*rotor->nsections;
+    return gradients;
+}
+
+//data structure for the sensitivities of a whole rotor at an operating point
+//INTERNAL USE ONLY
+typedef struct {
+    Rotor* rotor;
+    double Uinf;
+    double Omega;
+    double rho;
+    double mu;
+    double a;
+    const double* psi;          //converged psi of each element (NAN if not converged)
+    double* elementgradients;   //8 derivatives of each element, see rotor_element_gradients
+} GradientSolution;
+
+//differentiate the loads of the i-th element at its solution psi, by implicit differentiation of the residual:
+//dpsi/dx = -(dR/dx)/(dR/dpsi), so the total derivative of the loads is d/dx + dpsi/dx * d/dpsi
+//stored: dTdr and dQdr derivatives with respect to the element c, beta, Ua and Ut
+//INTERNAL USE ONLY
+void rotor_element_gradients(int i, void* gradientsolution) {
+    GradientSolution* grad = (GradientSolution*) gradientsolution;
+    double* output = grad->elementgradients + 8*i;
+    for (int k=0; k<8; ++k) {
+        output[k] = 0.0;
+    }
+    if (isnan(grad->psi[i])) {
+        //the derivatives are meaningless at a point that did not converge
+        return;
+    }
+    Element currentelement;
+    set_rotor_element(&currentelement, grad->rotor, i);
+    ResidualArgs args = {grad->Uinf, grad->Omega*currentelement.r, grad->rotor->D/2, grad->rotor->B, &currentelement, grad->rho, grad->mu, grad->a, 0, {0}, {false, 0, 0, 0, 0, 0, 0}};
+    ElementSensitivities sens;
+    residual_sensitivities(&sens, grad->psi[i], &args);
+    if (sens.residual[SENS_PSI] == 0.0) {
+        return;
+    }
+    for (int k=SENS_C; k<NSENS; ++k) {
+        double dpsidx = -sens.residual[k] / sens.residual[SENS_PSI];
+        output[k-1] = sens.dTdr[k] + sens.dTdr[SENS_PSI]*dpsidx;
+        output[4+k-1] = sens.dQdr[k] + sens.dQdr[SENS_PSI]*dpsidx;
+    }
+}
+
+//solve the blade elements and differentiate thrust and torque at the solution
+//psi: initial guesses when warmstart is true, updated with the converged values
+//work: 9*nelems doubles used for the psi of the converged elements and the derivatives of each element
+//NOTE: the airfoils of the elements must be already blended, see temporary_blended_rotor
+//INTERNAL USE ONLY
+bool qprop_solve_gradients(RotorPerformance* perf, RotorGradients* gradients, Rotor* rotor, double Uinf, double Omega, double rho, double mu, double a,
+                           const QPropOptions* opts, double* psi, bool warmstart, double* work) {
+    int nelems = perf->nelems;
+    bool success = qprop_solve_elements(perf, rotor, Uinf, Omega, rho, mu, a, opts, psi, warmstart, opts->nthreads);
+
+    //differentiate each element at its solution
+    for (int i=0; i<nelems; ++i) {
+        work[i] = (perf->converged[i])? psi[i] : NAN;
+    }
+    GradientSolution grad = {rotor, Uinf, Omega, rho, mu, a, work, work + nelems};
+    parallel_for(nelems, element_threads(nelems, opts->nthreads), rotor_element_gradients, &grad);
+
+    //assemble the rotor derivatives, in the same order of the integration of thrust and torque
+    //NOTE: the chord and twist of each element are the mean of its two sections
+    for (int j=0; j<rotor->nsections; ++j) {
+        gradients->dTdc[j] = 0.0;
+        gradients->dTdbeta[j] = 0.0;
+        gradients->dQdc[j] = 0.0;
+        gradients->dQdbeta[j] = 0.0;
+    }
+    gradients->dTdUinf = 0.0;
+    gradients->dQdUinf = 0.0;
+    gradients->dTdOmega = 0.0;
+    gradients->dQdOmega = 0.0;
+    for (int i=0; i<nelems; ++i) {
+        const double* element = grad.elementgradients + 8*i;
+        double dr = rotor->sections[i+1].r - rotor->sections[i].r;
+        double r = 0.5*(rotor->sections[i].r + rotor->sections[i+1].r);
+        double w = rotor->B * dr;
+        for (int j=i; j<=i+1; ++j) {
+            gradients->dTdc[j] += 0.5 * w * element[0];
+            gradients->dTdbeta[j] += 0.5 * w * element[1];
+            gradients->dQdc[j] += 0.5 * w * element[4];
+            gradients->dQdbeta[j] += 0.5 * w * element[5];
+        }
+        gradients->dTdUinf += w * element[2];
+        gradients->dQdUinf += w * element[6];
+        gradients->dTdOmega += w * r * element[3];      //Ut = Omega*r
+        gradients->dQdOmega += w * r * element[7];
+    }
+    return success;
+}
+
+//run qprop iterations and differentiate thrust and torque with respect to the design variables
+RotorPerformance* qprop_with_gradients(Rotor* rotor, double Uinf, double Omega, double rho, double mu, double a,
+                                       const QPropOptions* options, RotorGradients* gradients) {
+    if (!rotor || rotor->nsections < 2 || !gradients || gradients->nsections != rotor->nsections) {
+        qprop_log(QPROP_ERROR_INVALID_ARGUMENT, "ERROR in qprop_with_gradients(): invalid arguments");
+        return NULL;
+    }
+    QPropOptions opts = (options)? *options : qprop_default_options();
+    int nelems = rotor->nsections - 1;
+    RotorPerformance* perf = new_rotor_performance(nelems);
+    double* psi = malloc(10*nelems*sizeof(double));
+    if (!perf || !psi) {
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in qprop_with_gradients()");
+        if (perf) {
+            free_rotor_performance(perf);
+        }
+        free(psi);
+        return NULL;
+    }
+    for (int i=0; i<nelems; ++i) {
+        psi[i] = 0.0;
+    }
+
+    //blend the airfoils of the elements, if not precomputed
+#if defined(QPROP_STATS)
+    double tstart = stats_wall_time();
+#endif
+    bool failed;
+    Rotor* blendedrotor = temporary_blended_rotor(rotor, &failed);
+    if (failed) {
+        free_rotor_performance(perf);
+        free(psi);
+        return NULL;
+    }
+#if defined(QPROP_STATS)
+    if (opts.stats) {
+        opts.stats->tsetup += stats_wall_time() - tstart;
+    }
+#endif
+    qprop_solve_gradients(perf, gradients, (blendedrotor)? blendedrotor : rotor, Uinf, Omega, rho, mu, a, &opts, psi, false, psi + nelems);
+    if (blendedrotor) {
+        free_temporary_blended_rotor(blendedrotor, rotor);
+    }
+    free(psi);
+    if (perf->status != QPROP_OK && perf->status != QPROP_ERROR_NOT_CONVERGED) {
+        free_rotor_performance(perf);
+        return NULL;
+    }
+    return perf;
+}
+
+//evaluate the quantity matched by the trim and its derivative with respect to the trim variable
+//INTERNAL USE ONLY
+double trim_target(const RotorPerformance* perf, const RotorGradients* gradients, double Omega,
+                   QPropTrimTarget target, QPropTrimVariable variable, double* derivative) {
+    double dT = 0.0;
+    double dQ = 0.0;
+    if (variable == QPROP_TRIM_OMEGA) {
+        dT = gradients->dTdOmega;
+        dQ = gradients->dQdOmega;
+    }
+    else {
+        //a collective pitch offset moves the twist of all the sections together
+        for (int j=0; j<gradients->nsections; ++j) {
+            dT += gradients->dTdbeta[j];
+            dQ += gradients->dQdbeta[j];
+        }
+    }
+    switch (target) {
+        case QPROP_TRIM_THRUST:
+            *derivative = dT;
+            return perf->T;
+        case QPROP_TRIM_TORQUE:
+            *derivative = dQ;
+            return perf->Q;
+        default:
+            //P = Q*Omega
+            *derivative = dQ*Omega + ((variable == QPROP_TRIM_OMEGA)? perf->Q : 0.0);
+            return perf->Q*Omega;
+    }
+}
+
+//run qprop iterations adjusting the rotor speed or the collective pitch to match a target thrust, torque or power
+RotorPerformance* qprop_trim(Rotor* rotor, double Uinf, double Omega, double rho, double mu, double a, const QPropOptions* options,
+                             QPropTrimTarget target, double value, QPropTrimVariable variable, double* trimmed) {
+    if (!rotor || rotor->nsections < 2 || !(Omega > 0.0) || !isfinite(value)
+            || (target != QPROP_TRIM_THRUST && target != QPROP_TRIM_TORQUE && target != QPROP_TRIM_POWER)
+            || (variable != QPROP_TRIM_OMEGA && variable != QPROP_TRIM_PITCH)) {
+        qprop_log(QPROP_ERROR_INVALID_ARGUMENT, "ERROR in qprop_trim(): invalid arguments");
+        return NULL;
+    }
+    QPropOptions opts = (options)? *options : qprop_default_options();
+    int nelems = rotor->nsections - 1;
+    RotorPerformance* perf = new_rotor_performance(nelems);
+    RotorGradients* gradients = alloc_rotor_gradients(rotor);
+    double* psi = calloc(10*nelems, sizeof(double));
+    Section* sections = (variable == QPROP_TRIM_PITCH)? malloc(rotor->nsections*sizeof(Section)) : NULL;
+    if (!perf || !gradients || !psi || (variable == QPROP_TRIM_PITCH && !sections)) {
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in qprop_trim()");
+        if (perf) {
+            free_rotor_performance(perf);
+        }
+        if (gradients) {
+            free_rotor_gradients(gradients);
+        }
+        free(psi);
+        free(sections);
+        return NULL;
+    }
+
+    //blend the airfoils of the elements once for all the iterations
+#if defined(QPROP_STATS)
+    double tstart = stats_wall_time();
+#endif
+    bool failed;
+    Rotor* blendedrotor = temporary_blended_rotor(rotor, &failed);
+    if (failed) {
+        free_rotor_performance(perf);
+        free_rotor_gradients(gradients);
+        free(psi);
+        free(sections);
+        return NULL;
+    }
+#if defined(QPROP_STATS)
+    if (opts.stats) {
+        opts.stats->tsetup += stats_wall_time() - tstart;
+    }
+#endif
+    //the pitch offset is applied to a shallow copy of the rotor, sharing its airfoils
+    Rotor trimrotor = (blendedrotor)? *blendedrotor : *rotor;
+    if (sections) {
+        trimrotor.sections = sections;
+    }
+
+    //Newton iterations on the trim variable, warm starting the elements from the previous iteration
+    double x = (variable == QPROP_TRIM_OMEGA)? Omega : 0.0;
+    double xsolved = x;
+    double tol = opts.tol * fmax(fabs(value), 1.0);
+    double error = NAN;
+    bool warmstart = false;
+    bool converged = false;
+    for (int it=0; it<opts.itmax; ++it) {
+        if (sections) {
+            for (int j=0; j<rotor->nsections; ++j) {
+                sections[j] = rotor->sections[j];
+                sections[j].beta += x;
+            }
+        }
+        double Omegait = (variable == QPROP_TRIM_OMEGA)? x : Omega;
+        bool solved = qprop_solve_gradients(perf, gradients, &trimrotor, Uinf, Omegait, rho, mu, a, &opts, psi, warmstart, psi + nelems);
+        warmstart = true;
+        xsolved = x;
+        double derivative;
+        error = trim_target(perf, gradients, Omegait, target, variable, &derivative) - value;
+        if (solved && fabs(error) <= tol) {
+            converged = true;
+            break;
+        }
+        if (derivative == 0.0 || !isfinite(derivative) || !isfinite(error)) {
+            break;
+        }
+        double step = -error/derivative;
+        if (variable == QPROP_TRIM_OMEGA) {
+            x = fmin(fmax(x + step, 0.5*x), 2.0*x);
+        }
+        else {
+            x += fmin(fmax(step, -TRIM_MAX_PITCH_STEP), +TRIM_MAX_PITCH_STEP);
+        }
+    }
+    if (blendedrotor) {
+        free_temporary_blended_rotor(blendedrotor, rotor);
+    }
+    free_rotor_gradients(gradients);
+    free(psi);
+    free(sections);
+    if (trimmed) {
+        *trimmed = xsolved;
+    }
+    if (!converged) {
+        perf->status = QPROP_ERROR_NOT_CONVERGED;
+        qprop_log(QPROP_ERROR_NOT_CONVERGED, "ERROR in qprop_trim(): the trim did not converge (error=%e exceeds tolerance=%e)", error, tol);
+    }
+    return perf;
+}
+
+//entry of an operating point cache
+//INTERNAL USE ONLY
+typedef struct {
+    uint64_t key;               //hash of the fingerprint and of the quantized operating conditions
+    uint64_t fingerprint;       //hash of the rotor key and of the solver options
+    double conditions[5];       //exact operating conditions: Uinf, Omega, rho, mu, a
+    long long lastused;         //tick of the last access, for the least-recently-used eviction
+    RotorPerformance* perf;     //cached outputs (NULL if the entry is empty)
+    double* psi;                //psi of each element, used to warm start the near hits
+} CacheEntry;
+
+//shard of an operating point cache, locked independently from the others
+//INTERNAL USE ONLY
+typedef struct {
+    CacheEntry* entries;
+    int capacity;
+    long long tick;
+    long long hits;
+    long long warmstarts;
+    long long misses;
+    long long evictions;
+#if defined(QPROP_THREADS) && defined(_WIN32)
+    CRITICAL_SECTION lock;
+#elif defined(QPROP_THREADS)
+    pthread_mutex_t lock;
+#endif
+} CacheShard;
+
+//operating point cache (opaque in qprop.h)
+struct QPropCache {
+    CacheShard shards[CACHE_SHARDS];
+    double resolution;          //relative resolution of the quantized operating conditions
+    bool distributions;         //true if the per-element distributions are cached too
+};
+
+//INTERNAL USE ONLY
+void lock_cache_shard(CacheShard* shard) {
+#if defined(QPROP_THREADS) && defined(_WIN32)
+    EnterCriticalSection(&(shard->lock));
+#elif defined(QPROP_THREADS)
+    pthread_mutex_lock(&(shard->lock));
+#else
+    (void) shard;
+#endif
+}
+
+//INTERNAL USE ONLY
+void unlock_cache_shard(CacheShard* shard) {
+#if defined(QPROP_THREADS) && defined(_WIN32)
+    LeaveCriticalSection(&(shard->lock));
+#elif defined(QPROP_THREADS)
+    pthread_mutex_unlock(&(shard->lock));
+#else
+    (void) shard;
+#endif
+}
+
+//mix a 64-bit word into a hash
+//INTERNAL USE ONLY
+uint64_t hash_word(uint64_t h, uint64_t x) {
+    h ^= x;
+    h *= 0x9e3779b97f4a7c15ULL;
+    return h ^ (h >> 29);
+}
+
+//mix an array of doubles into a hash, using their bit patterns
+//INTERNAL USE ONLY
+uint64_t hash_doubles(uint64_t h, const double* x, int n) {
+    for (int i=0; i<n; ++i) {
+        uint64_t bits;
+        memcpy(&bits, &x[i], sizeof(uint64_t));
+        h = hash_word(h, bits);
+    }
+    return h;
+}
+
+//INTERNAL USE ONLY
+uint64_t hash_airfoil(uint64_t h, const Airfoil* airfoil) {
+    //the compiled tables are the ones used by the interpolation, when available
+    const CompiledAirfoil* compiled = airfoil->compiled;
+    if (compiled) {
+        h = hash_word(h, ((uint64_t) compiled->nRe << 32) | (uint64_t) compiled->nalpha);
+        h = hash_doubles(h, compiled->Re, compiled->nRe);
+        h = hash_doubles(h, compiled->alpha, compiled->nalpha);
+        return hash_doubles(h, compiled->CLCD, 2*compiled->nRe*compiled->nalpha);
+    }
+    h = hash_word(h, (uint64_t) airfoil->size);
+    for (int k=0; k<airfoil->size; ++k) {
+        const Polar* polar = airfoil->polars[k];
+        h = hash_doubles(h, &(polar->Re), 1);
+        h = hash_word(h, (uint64_t) polar->size);
+        h = hash_doubles(h, polar->alpha, polar->size);
+        h = hash_doubles(h, polar->CL, polar->size);
+        h = hash_doubles(h, polar->CD, polar->size);
+    }
+    return h;
+}
+
+//fingerprint of the geometry of a rotor: diameter, blades and sections (without the airfoil data)
+//INTERNAL USE ONLY
+uint64_t rotor_geometry_fingerprint(uint64_t h, const Rotor* rotor) {
+    h = hash_doubles(h, &(rotor->D), 1);
+    h = hash_word(h, ((uint64_t) rotor->B << 32) | (uint64_t) rotor->nsections);
+    for (int j=0; j<rotor->nsections; ++j) {
+        const Section* section = &(rotor->sections[j]);
+        double values[3] = {section->c, section->beta, section->r};
+        h = hash_doubles(h, values, 3);
+        h = hash_word(h, (uint64_t) section->airfoil);
+    }
+    return h;
+}
+
+//fingerprint of a rotor: geometry and airfoil data
+//INTERNAL USE ONLY
+uint64_t rotor_fingerprint(const Rotor* rotor) {
+    uint64_t h = rotor_geometry_fingerprint(0xcbf29ce484222325ULL, rotor);
+    for (int k=0; k<rotor->nairfoils; ++k) {
+        h = hash_airfoil(h, rotor->airfoils[k]);
+    }
+    return h;
+}
+
+//quantize an operating condition with the given relative resolution (0: exact value)
+//INTERNAL USE ONLY
+uint64_t quantize_condition(double x, double resolution) {
+    if (resolution <= 0.0 || x == 0.0 || !isfinite(x)) {
+        uint64_t bits;
+        memcpy(&bits, &x, sizeof(uint64_t));
+        return bits;
+    }
+    int exponent;
+    double mantissa = frexp(x, &exponent);
+    return ((uint64_t) (int64_t) exponent << 48) ^ (uint64_t) llround(mantissa/resolution);
+}
+
+//copy the outputs of a qprop analysis, as far as both outputs contain them
+//INTERNAL USE ONLY
+void copy_rotor_performance(RotorPerformance* dest, RotorPerformance* src) {
+    int nelems = src->nelems;
+    dest->T = src->T;
+    dest->Q = src->Q;
+    dest->CT = src->CT;
+    dest->CP = src->CP;
+    dest->J = src->J;
+    dest->status = src->status;
+    memcpy(dest->residuals, src->residuals, nelems*sizeof(double));
+    memcpy(performance_dTdr(dest), performance_dTdr(src), nelems*sizeof(double));
+    memcpy(performance_dQdr(dest), performance_dQdr(src), nelems*sizeof(double));
+    memcpy(dest->nevals, src->nevals, nelems*sizeof(int));
+    memcpy(dest->converged, src->converged, nelems*sizeof(bool));
+    if (dest->Gamma && src->Gamma) {
+        memcpy(dest->Gamma, src->Gamma, nelems*sizeof(double));
+        memcpy(dest->lambdaw, src->lambdaw, nelems*sizeof(double));
+        memcpy(dest->r, src->r, nelems*sizeof(double));
+        memcpy(dest->W, src->W, nelems*sizeof(double));
+        memcpy(dest->phi, src->phi, nelems*sizeof(double));
+    }
+}
+
+//find the entry of a shard with the given key, or NULL if not cached
+//INTERNAL USE ONLY
+CacheEntry* find_cache_entry(CacheShard* shard, uint64_t key, uint64_t fingerprint, int nelems) {
+    for (int k=0; k<shard->capacity; ++k) {
+        CacheEntry* entry = &(shard->entries[k]);
+        if (entry->perf && entry->key == key && entry->fingerprint == fingerprint && entry->perf->nelems == nelems) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+//store the outputs of an analysis in a shard, replacing the entry with the same key or the least recently used one
+//INTERNAL USE ONLY
+void store_cache_entry(QPropCache* cache, CacheShard* shard, uint64_t key, uint64_t fingerprint, const double* conditions,
+                       RotorPerformance* perf, const double* psi) {
+    int nelems = perf->nelems;
+    CacheEntry* entry = find_cache_entry(shard, key, fingerprint, nelems);
+    if (!entry) {
+        entry = &(shard->entries[0]);
+        for (int k=0; k<shard->capacity && entry->perf; ++k) {
+            if (!shard->entries[k].perf || shard->entries[k].lastused < entry->lastused) {
+                entry = &(shard->entries[k]);
+            }
+        }
+        shard->evictions += (entry->perf)? 1 : 0;
+    }
+    if (entry->perf && entry->perf->nelems != nelems) {
+        free_rotor_performance(entry->perf);
+        free(entry->psi);
+        entry->perf = NULL;
+        entry->psi = NULL;
+    }
+    if (!entry->perf) {
+        entry->perf = new_rotor_performance_ex(nelems, !cache->distributions);
+        entry->psi = malloc(nelems*sizeof(double));
+        if (!entry->perf || !entry->psi) {
+            //the analysis is still valid, it is just not cached
+            qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in qprop_cached()");
+            if (entry->perf) {
+                free_rotor_performance(entry->perf);
+            }
+            free(entry->psi);
+            entry->perf = NULL;
+            entry->psi = NULL;
+            return;
+        }
+    }
+    entry->key = key;
+    entry->fingerprint = fingerprint;
+    memcpy(entry->conditions, conditions, 5*sizeof(double));
+    entry->lastused = ++shard->tick;
+    copy_rotor_performance(entry->perf, perf);
+    memcpy(entry->psi, psi, nelems*sizeof(double));
+}
+
+//allocate an operating point cache
+QPropCache* alloc_qprop_cache(int capacity, double resolution, bool distributions) {
+    if (capacity < 1 || !(resolution >= 0.0) || resolution >= 1.0) {
+        qprop_log(QPROP_ERROR_INVALID_ARGUMENT, "ERROR in alloc_qprop_cache(): invalid arguments");
+        return NULL;
+    }
+    QPropCache* cache = calloc(1, sizeof(QPropCache));
+    int shardcapacity = (capacity + CACHE_SHARDS - 1) / CACHE_SHARDS;
+    CacheEntry* entries = (cache)? calloc(CACHE_SHARDS*shardcapacity, sizeof(CacheEntry)) : NULL;
+    if (!entries) {
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in alloc_qprop_cache()");
+        free(cache);
+        return NULL;
+    }
+    cache->resolution = resolution;
+    cache->distributions = distributions;
+    for (int s=0; s<CACHE_SHARDS; ++s) {
+        CacheShard* shard = &(cache->shards[s]);
+        shard->entries = entries + s*shardcapacity;
+        shard->capacity = shardcapacity;
+#if defined(QPROP_THREADS) && defined(_WIN32)
+        InitializeCriticalSection(&(shard->lock));
+#elif defined(QPROP_THREADS)
+        pthread_mutex_init(&(shard->lock), NULL);
+#endif
+    }
+    return cache;
+}
+
+//compute the key identifying a rotor in an operating point cache
+uint64_t qprop_cache_attach(QPropCache* cache, const Rotor* rotor) {
+    if (!cache || !rotor || rotor->nsections < 2) {
+        qprop_log(QPROP_ERROR_INVALID_ARGUMENT, "ERROR in qprop_cache_attach(): invalid arguments");
+        return 0;
+    }
+    //0 is reserved for the invalid keys
+    uint64_t rotorkey = rotor_fingerprint(rotor);
+    return (rotorkey != 0)? rotorkey : 1;
+}
+
+//run qprop iterations through an operating point cache
+bool qprop_cached(QPropCache* cache, uint64_t rotorkey, RotorPerformance* perf, Rotor* rotor, double Uinf, double Omega,
+                  double rho, double mu, double a, const QPropOptions* options) {
+    if (!cache || rotorkey == 0 || !rotor || !perf || perf->nelems != rotor->nsections - 1) {
+        qprop_log(QPROP_ERROR_INVALID_ARGUMENT, "ERROR in qprop_cached(): invalid arguments");
+        return false;
+    }
+    QPropOptions opts = (options)? *options : qprop_default_options();
+    int nelems = perf->nelems;
+
+    //the rotor key, the options and the quantized conditions select the shard and the entry
+    //NOTE: the airfoil data were hashed once by qprop_cache_attach; the geometry is hashed again
+    //      on each call (a few words per section), so that the rotors modified after the attach
+    //      (e.g. chord and twist changed by an optimizer) do not get the results of the old geometry
+    double conditions[5] = {Uinf, Omega, rho, mu, a};
+    uint64_t fingerprint = rotor_geometry_fingerprint(rotorkey, rotor);
+    fingerprint = hash_doubles(fingerprint, &(opts.tol), 1);
+    fingerprint = hash_word(fingerprint, ((uint64_t) opts.itmax << 32) | (uint64_t) opts.solver);
+    uint64_t key = fingerprint;
+    for (int k=0; k<5; ++k) {
+        key = hash_word(key, quantize_condition(conditions[k], cache->resolution));
+    }
+    CacheShard* shard = &(cache->shards[(key >> 32) % CACHE_SHARDS]);
+
+    //psi is kept on the stack, unless the rotor has many elements
+    double psibuffer[CACHE_STACK_ELEMENTS];
+    double* psi = (nelems <= CACHE_STACK_ELEMENTS)? psibuffer : malloc(nelems*sizeof(double));
+    if (!psi) {
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in qprop_cached()");
+        return false;
+    }
+
+    //exact hits are copied, near hits give the initial guesses of psi
+    bool warmstart = false;
+    lock_cache_shard(shard);
+    CacheEntry* entry = find_cache_entry(shard, key, fingerprint, nelems);
+    if (entry) {
+        entry->lastused = ++shard->tick;
+        bool exact = (memcmp(entry->conditions, conditions, 5*sizeof(double)) == 0);
+        if (exact && (entry->perf->Gamma || !perf->Gamma)) {
+            copy_rotor_performance(perf, entry->perf);
+            shard->hits += 1;
+            unlock_cache_shard(shard);
+            if (psi != psibuffer) {
+                free(psi);
+            }
+            return perf->status == QPROP_OK;
         }
-        perf->residuals[i] = res.residual;
-        perf->Gamma[i] = res.Gamma;
-        perf->lambdaw[i] = res.lambdaw;
-        perf->r[i] = currentelement.r;
-        perf->W[i] = res.W;
-        perf->phi[i] = res.phi;
-        perf->dTdr[i] = 0.5 * rho * res.W * res.W * res.Cn * currentelement.c;
-        perf->dQdr[i] = 0.5 * rho * res.W * res.W * res.Ct * currentelement.c * currentelement.r;
-        perf->T += perf->dTdr[i] * currentelement.dr;
-        perf->Q += perf->dQdr[i] * currentelement.dr;
+        memcpy(psi, entry->psi, nelems*sizeof(double));
+        warmstart = true;
+        shard->warmstarts += 1;
     }
-    perf->T *= rotor->B;                //total thrust (N)
-    perf->Q *= rotor->B;                //total torque (N-m)
-    double n = Omega/(2*PI);          //revolutions per second (rev/s)
-    perf->CT = perf->T / (rho * pow(n,2) * pow(rotor->D,4));        //thrust coefficient
-    double CQ = perf->Q / (rho * pow(n,2) * pow(rotor->D,5));       //torque coefficient
-    perf->CP = 2*PI * CQ;             //power coefficient
-    perf->J = Uinf / (n * rotor->D);    //advance ratio
-    return perf;
+    else {
+        memset(psi, 0, nelems*sizeof(double));
+        shard->misses += 1;
+    }
+    unlock_cache_shard(shard);
+
+    //the shard is not locked during the analysis, so the other threads are not stalled
+    bool converged = qprop_solve(perf, rotor, Uinf, Omega, rho, mu, a, &opts, psi, warmstart, opts.nthreads);
+    if (perf->status == QPROP_OK || perf->status == QPROP_ERROR_NOT_CONVERGED) {
+        lock_cache_shard(shard);
+        store_cache_entry(cache, shard, key, fingerprint, conditions, perf, psi);
+        unlock_cache_shard(shard);
+    }
+    if (psi != psibuffer) {
+        free(psi);
+    }
+    return converged;
+}
+
+//get the counters of an operating point cache
+QPropCacheStats qprop_cache_stats(QPropCache* cache) {
+    QPropCacheStats stats = {0, 0, 0, 0, 0};
+    if (!cache) {
+        return stats;
+    }
+    for (int s=0; s<CACHE_SHARDS; ++s) {
+        CacheShard* shard = &(cache->shards[s]);
+        lock_cache_shard(shard);
+        stats.hits += shard->hits;
+        stats.warmstarts += shard->warmstarts;
+        stats.misses += shard->misses;
+        stats.evictions += shard->evictions;
+        for (int k=0; k<shard->capacity; ++k) {
+            stats.entries += (shard->entries[k].perf)? 1 : 0;
+        }
+        unlock_cache_shard(shard);
+    }
+    return stats;
+}
+
+//run qprop iterations
+RotorPerformance* qprop(Rotor* rotor, double Uinf, double Omega, double tol, int itmax, double rho, double mu, double a) {
+    //use the bisection method, as in the original implementation
+    QPropOptions options = qprop_default_options();
+    options.tol = tol;
+    options.itmax = itmax;
+    options.solver = QPROP_SOLVER_BISECTION;
+    return qprop_ex(rotor, Uinf, Omega, rho, mu, a, &options);
 }
 
 //free allocated memory on RotorPerformance
 void free_rotor_performance(RotorPerformance* perf) {
+    //all the arrays are stored in the same block, starting at perf->residuals
     free(perf->residuals);
     perf->residuals = NULL;
-    free(perf->Gamma);
     perf->Gamma = NULL;
-    free(perf->lambdaw);
     perf->lambdaw = NULL;
-    free(perf->r);
     perf->r = NULL;
-    free(perf->W);
     perf->W = NULL;
-    free(perf->phi);
     perf->phi = NULL;
-    free(perf->dTdr);
     perf->dTdr = NULL;
-    free(perf->dQdr);
     perf->dQdr = NULL;
+    perf->nevals = NULL;
+    perf->converged = NULL;
     free(perf);
     perf = NULL;
 }
 
+//free allocated memory on RotorGradients
+void free_rotor_gradients(RotorGradients* gradients) {
+    //all the arrays are stored in the same block, starting at gradients->dTdc
+    free(gradients->dTdc);
+    gradients->dTdc = NULL;
+    gradients->dTdbeta = NULL;
+    gradients->dQdc = NULL;
+    gradients->dQdbeta = NULL;
+    free(gradients);
+    gradients = NULL;
+}
+
+//free allocated memory on QPropCache
+void free_qprop_cache(QPropCache* cache) {
+    if (!cache) {
+        return;
+    }
+    for (int s=0; s<CACHE_SHARDS; ++s) {
+        CacheShard* shard = &(cache->shards[s]);
+        for (int k=0; k<shard->capacity; ++k) {
+            if (shard->entries[k].perf) {
+                free_rotor_performance(shard->entries[k].perf);
+            }
+            free(shard->entries[k].psi);
+        }
+#if defined(QPROP_THREADS) && defined(_WIN32)
+        DeleteCriticalSection(&(shard->lock));
+#elif defined(QPROP_THREADS)
+        pthread_mutex_destroy(&(shard->lock));
+#endif
+    }
+    //all the entries are stored in the same block, starting at the entries of the first shard
+    free(cache->shards[0].entries);
+    free(cache);
+    cache = NULL;
+}
+
+
+//----------------------
+//  PERFORMANCE MAPS
+//----------------------
+//A performance map stores CT and CP of a rotor on a grid of advance ratios and rotor speeds,
+//computed with the full solver. Both coefficients depend weakly on Omega (through Re and Mach),
+//so the bilinear interpolation in (J, Omega) is much more accurate than interpolating T and Q,
+//which are then recovered from the coefficients at the queried rotor speed and air density.
+
+//number of parameters stored after the header of a binary map: rho, mu, a, errCT, errCP, nfailed
+#define BINARY_MAP_PARAMETERS 6
+
+//allocate an empty performance map, with the arrays in the same block of the structure
+//INTERNAL USE ONLY
+RotorMap* new_rotor_map(int nJ, int nOmega) {
+    RotorMap* map = calloc(1, sizeof(RotorMap) + (nJ + nOmega + 2*(size_t)nJ*nOmega)*sizeof(double));
+    if (!map) {
+        return NULL;
+    }
+    map->nJ = nJ;
+    map->nOmega = nOmega;
+    map->J = (double*) (map + 1);
+    map->Omega = map->J + nJ;
+    map->CTCP = map->Omega + nOmega;
+    return map;
+}
+
+//interpolate a performance map
+RotorMapPoint lookup_rotor_map(const RotorMap* map, double Uinf, double Omega, double rho) {
+    RotorMapPoint point;
+    double n = Omega/(2*PI);
+    point.J = Uinf / (n * map->D);
+
+    //queries outside the map are clamped to its edges (the round-off errors at the edges are not reported)
+    double J = fmin(fmax(point.J, map->J[0]), map->J[map->nJ-1]);
+    double Omegaq = fmin(fmax(Omega, map->Omega[0]), map->Omega[map->nOmega-1]);
+    point.inside = (fabs(J - point.J) <= 1e-9*(map->J[map->nJ-1] - map->J[0])
+                    && fabs(Omegaq - Omega) <= 1e-9*(map->Omega[map->nOmega-1] - map->Omega[0]));
+    int i = find_bracket(map->J, map->nJ, J, map->dJ, 0);
+    int k = find_bracket(map->Omega, map->nOmega, Omegaq, map->dOmega, 0);
+    double tJ = (J - map->J[i-1]) / (map->J[i] - map->J[i-1]);
+    double tOmega = (Omegaq - map->Omega[k-1]) / (map->Omega[k] - map->Omega[k-1]);
+
+    //bilinear interpolation of the (CT,CP) pairs at the corners of the cell
+    const double* row1 = map->CTCP + 2*((size_t)(k-1)*map->nJ + i-1);
+    const double* row2 = row1 + 2*map->nJ;
+    point.CT = (1-tOmega)*((1-tJ)*row1[0] + tJ*row1[2]) + tOmega*((1-tJ)*row2[0] + tJ*row2[2]);
+    point.CP = (1-tOmega)*((1-tJ)*row1[1] + tJ*row1[3]) + tOmega*((1-tJ)*row2[1] + tJ*row2[3]);
+    point.T = point.CT * rho * n*n * pow(map->D,4);
+    point.Q = point.CP/(2*PI) * rho * n*n * pow(map->D,5);
+    return point;
+}
+
+//check that a grid of a performance map is sorted in strictly ascending order
+//INTERNAL USE ONLY
+bool rotor_map_grid_sorted(const double* x, int size) {
+    for (int i=0; i<size; ++i) {
+        if (!isfinite(x[i]) || (i > 0 && !(x[i] > x[i-1]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//generate a performance map with the full solver, estimating the interpolation error at the centers of the cells
+RotorMap* generate_rotor_map(Rotor* rotor, const double* J, int nJ, const double* Omega, int nOmega, double rho, double mu, double a,
+                             const QPropOptions* options) {
+    if (!rotor || rotor->nsections < 2 || !J || !Omega || nJ < 2 || nOmega < 2
+            || !rotor_map_grid_sorted(J, nJ) || !rotor_map_grid_sorted(Omega, nOmega) || !(Omega[0] > 0.0)) {
+        qprop_log(QPROP_ERROR_INVALID_ARGUMENT, "ERROR in generate_rotor_map(): invalid arguments");
+        return NULL;
+    }
+    int npoints = nJ*nOmega;
+    RotorMap* map = new_rotor_map(nJ, nOmega);
+    double* work = malloc(npoints*(6*sizeof(double) + sizeof(bool)));
+    if (!map || !work) {
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in generate_rotor_map()");
+        free(map);
+        free(work);
+        return NULL;
+    }
+    double* Uinfs = work;
+    double* Omegas = work + npoints;
+    double* rhos = work + 2*npoints;
+    double* mus = work + 3*npoints;
+    double* CT = work + 4*npoints;
+    double* CP = work + 5*npoints;
+    bool* converged = (bool*) (work + 6*npoints);
+    memcpy(map->J, J, nJ*sizeof(double));
+    memcpy(map->Omega, Omega, nOmega*sizeof(double));
+    map->dJ = uniform_spacing(map->J, nJ);
+    map->dOmega = uniform_spacing(map->Omega, nOmega);
+    map->D = rotor->D;
+    map->rho = rho;
+    map->mu = mu;
+    map->a = a;
+    for (int i=0; i<npoints; ++i) {
+        rhos[i] = rho;
+        mus[i] = mu;
+    }
+
+    //solve the grid as a batch: along each row J is increasing, so the consecutive points are warm started
+    for (int k=0; k<nOmega; ++k) {
+        for (int i=0; i<nJ; ++i) {
+            Uinfs[k*nJ + i] = J[i] * Omega[k]/(2*PI) * rotor->D;
+            Omegas[k*nJ + i] = Omega[k];
+        }
+    }
+    if (!qprop_batch(rotor, npoints, Uinfs, Omegas, rhos, mus, a, options, NULL, NULL, CT, CP, NULL, converged)) {
+        for (int i=0; i<npoints; ++i) {
+            map->nfailed += (converged[i])? 0 : 1;
+        }
+    }
+    for (int i=0; i<npoints; ++i) {
+        map->CTCP[2*i] = CT[i];
+        map->CTCP[2*i+1] = CP[i];
+    }
+
+    //estimate the interpolation error by solving the centers of the cells
+    int ncenters = (nJ-1)*(nOmega-1);
+    for (int k=0; k<nOmega-1; ++k) {
+        double Omegac = 0.5*(Omega[k] + Omega[k+1]);
+        for (int i=0; i<nJ-1; ++i) {
+            Uinfs[k*(nJ-1) + i] = 0.5*(J[i] + J[i+1]) * Omegac/(2*PI) * rotor->D;
+            Omegas[k*(nJ-1) + i] = Omegac;
+        }
+    }
+    qprop_batch(rotor, ncenters, Uinfs, Omegas, rhos, mus, a, options, NULL, NULL, CT, CP, NULL, converged);
+    map->errCT = 0.0;
+    map->errCP = 0.0;
+    for (int i=0; i<ncenters; ++i) {
+        if (converged[i]) {
+            RotorMapPoint point = lookup_rotor_map(map, Uinfs[i], Omegas[i], rho);
+            map->errCT = fmax(map->errCT, fabs(point.CT - CT[i]));
+            map->errCP = fmax(map->errCP, fabs(point.CP - CP[i]));
+        }
+    }
+    free(work);
+    return map;
+}
+
+//save a performance map in a binary file
+bool save_rotor_map_binary(const RotorMap* map, const char* filename) {
+    if (!map || map->nJ < 2 || map->nOmega < 2) {
+        qprop_log(QPROP_ERROR_INVALID_ARGUMENT, "ERROR in save_rotor_map_binary(): invalid performance map");
+        return false;
+    }
+    FILE* fileio = fopen(filename, "wb");
+    if (!fileio) {
+        qprop_log(QPROP_ERROR_FILE, "ERROR opening file %s", filename);
+        return false;
+    }
+    size_t ndata = map->nJ + map->nOmega + 2*(size_t)map->nJ*map->nOmega;
+    size_t filesize = BINARY_HEADER_SIZE + (BINARY_MAP_PARAMETERS + ndata)*sizeof(double);
+    BinaryHeader header;
+    set_binary_header(&header, "QPROPMP", map->nJ, map->nOmega, filesize, map->D);
+    double parameters[BINARY_MAP_PARAMETERS] = {map->rho, map->mu, map->a, map->errCT, map->errCP, (double) map->nfailed};
+    bool success = (fwrite(&header, sizeof(BinaryHeader), 1, fileio) == 1)
+                   && (fwrite(parameters, sizeof(double), BINARY_MAP_PARAMETERS, fileio) == BINARY_MAP_PARAMETERS)
+                   && (fwrite(map->J, sizeof(double), map->nJ, fileio) == (size_t) map->nJ)
+                   && (fwrite(map->Omega, sizeof(double), map->nOmega, fileio) == (size_t) map->nOmega)
+                   && (fwrite(map->CTCP, sizeof(double), 2*(size_t)map->nJ*map->nOmega, fileio) == 2*(size_t)map->nJ*map->nOmega);
+    if (fclose(fileio) != 0 || !success) {
+        qprop_log(QPROP_ERROR_FILE, "ERROR writing file %s", filename);
+        return false;
+    }
+    return true;
+}
+
+//load a performance map from a binary file, mapping it in memory
+RotorMap* load_rotor_map_binary(const char* filename) {
+    size_t mapsize;
+    char* mapping = map_binary_file(filename, &mapsize);
+    if (!mapping) {
+        return NULL;
+    }
+    const BinaryHeader* header = (const BinaryHeader*) mapping;
+    if (!check_binary_header(header, mapsize, "QPROPMP", filename)) {
+        unmap_binary_file(mapping, mapsize);
+        return NULL;
+    }
+    int nJ = header->n1;
+    int nOmega = header->n2;
+    size_t ndata = nJ + nOmega + 2*(size_t)nJ*nOmega;
+    if (nJ < 2 || nOmega < 2 || mapsize != BINARY_HEADER_SIZE + (BINARY_MAP_PARAMETERS + ndata)*sizeof(double)) {
+        qprop_log(QPROP_ERROR_FILE, "ERROR %s is corrupted", filename);
+        unmap_binary_file(mapping, mapsize);
+        return NULL;
+    }
+    RotorMap* map = calloc(1, sizeof(RotorMap));
+    if (!map) {
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in load_rotor_map_binary()");
+        unmap_binary_file(mapping, mapsize);
+        return NULL;
+    }
+
+    //point the arrays to the mapped file
+    const double* parameters = (const double*) (mapping + BINARY_HEADER_SIZE);
+    map->nJ = nJ;
+    map->nOmega = nOmega;
+    map->J = (double*) (parameters + BINARY_MAP_PARAMETERS);
+    map->Omega = map->J + nJ;
+    map->CTCP = map->Omega + nOmega;
+    map->dJ = uniform_spacing(map->J, nJ);
+    map->dOmega = uniform_spacing(map->Omega, nOmega);
+    map->D = header->value;
+    map->rho = parameters[0];
+    map->mu = parameters[1];
+    map->a = parameters[2];
+    map->errCT = parameters[3];
+    map->errCP = parameters[4];
+    map->nfailed = (int) parameters[5];
+    map->mapping = mapping;
+    map->mapsize = mapsize;
+    return map;
+}
+
+//free allocated memory on RotorMap
+void free_rotor_map(RotorMap* map) {
+    if (!map) {
+        return;
+    }
+    if (map->mapping) {
+        //the arrays are stored in a memory-mapped file
+        unmap_binary_file(map->mapping, map->mapsize);
+        map->mapping = NULL;
+    }
+    //otherwise the arrays are stored in the same block of the structure
+    free(map);
+    map = NULL;
+}
+
+
+//-----------------
+//  FLEETS
+//-----------------
+//A fleet analysis solves a catalog of rotors at the same operating points with a single call.
+//The rotors of a catalog are usually imported one by one, each with its own copy of the same polars,
+//so their airfoils are first gathered in a pool without duplicates, and the rotors are solved on
+//temporary copies that point to the pooled airfoils: all the threads then read the same compiled tables.
+//The points of each rotor are split in chunks, like in qprop_batch, and the (rotor, chunk) work items
+//are handed out one at a time by parallel_for, in order of decreasing cost: the most expensive items
+//start first, and the threads that finish early keep picking up the remaining ones instead of
+//waiting idle for a long tail of slow rotors.
+
+//data structure for the distinct airfoils of the rotors of a fleet
+//INTERNAL USE ONLY
+typedef struct {
+    Airfoil** airfoils;     //distinct airfoils, owned by the rotors
+    uint64_t* hashes;       //hashes of the airfoil data - same size as airfoils
+    int size;               //number of distinct airfoils
+} AirfoilPool;
+
+//work item of a fleet analysis: a chunk of consecutive operating points of one rotor
+//INTERNAL USE ONLY
+typedef struct {
+    int rotor;              //index of the rotor
+    int chunk;              //index of the chunk of operating points
+    long long cost;         //estimated cost: number of blade elements times number of points
+} FleetItem;
+
+//data structure for a fleet analysis
+//INTERNAL USE ONLY
+typedef struct {
+    BatchSolution* batches; //batch of operating points of each rotor, writing into the columns of the results
+    FleetItem* items;       //work items in order of decreasing cost
+} FleetSolution;
+
+//get the airfoil of the pool with the same data of the given one, adding it if not found
+//the pool must have room for one more airfoil
+//INTERNAL USE ONLY
+Airfoil* pooled_airfoil(AirfoilPool* pool, Airfoil* airfoil) {
+    uint64_t hash = hash_airfoil(0xcbf29ce484222325ULL, airfoil);
+    for (int k=0; k<pool->size; ++k) {
+        if (pool->hashes[k] == hash && airfoils_identical(pool->airfoils[k], airfoil)) {
+            return pool->airfoils[k];
+        }
+    }
+    pool->airfoils[pool->size] = airfoil;
+    pool->hashes[pool->size] = hash;
+    pool->size += 1;
+    return airfoil;
+}
+
+//free a temporary copy of a rotor created by pooled_rotor_copy
+//INTERNAL USE ONLY
+void free_pooled_rotor_copy(Rotor* pooledrotor) {
+    if (!pooledrotor) {
+        return;
+    }
+    free(pooledrotor->airfoils);
+    free(pooledrotor->elementairfoils);
+    free(pooledrotor);
+}
+
+//create a temporary copy of a rotor whose airfoil table points to the airfoils of the pool
+//NOTE: like temporary_blended_rotor, the copy shares the sections of the rotor without adding references
+//INTERNAL USE ONLY
+Rotor* pooled_rotor_copy(const Rotor* rotor, AirfoilPool* pool) {
+    int nelems = rotor->nsections - 1;
+    Rotor* pooledrotor = malloc(sizeof(Rotor));
+    Airfoil** airfoils = malloc(rotor->nairfoils*sizeof(Airfoil*));
+    Airfoil** elementairfoils = (rotor->elementairfoils)? malloc(nelems*sizeof(Airfoil*)) : NULL;
+    if (!pooledrotor || (rotor->nairfoils > 0 && !airfoils) || (rotor->elementairfoils && !elementairfoils)) {
+        free(pooledrotor);
+        free(airfoils);
+        free(elementairfoils);
+        return NULL;
+    }
+    *pooledrotor = *rotor;
+    for (int k=0; k<rotor->nairfoils; ++k) {
+        airfoils[k] = pooled_airfoil(pool, rotor->airfoils[k]);
+    }
+    //the precomputed blended airfoils are entries of the table, so they are pooled like the others
+    for (int i=0; elementairfoils && i<nelems; ++i) {
+        elementairfoils[i] = rotor->elementairfoils[i];
+        for (int k=0; k<rotor->nairfoils; ++k) {
+            if (rotor->airfoils[k] == rotor->elementairfoils[i]) {
+                elementairfoils[i] = airfoils[k];
+                break;
+            }
+        }
+    }
+    pooledrotor->airfoils = airfoils;
+    pooledrotor->elementairfoils = elementairfoils;
+    return pooledrotor;
+}
+
+//sort the work items of a fleet by decreasing cost, then by rotor and chunk
+//INTERNAL USE ONLY
+int compare_fleet_items(const void* item1, const void* item2) {
+    const FleetItem* a = (const FleetItem*) item1;
+    const FleetItem* b = (const FleetItem*) item2;
+    if (a->cost != b->cost) {
+        return (a->cost > b->cost)? -1 : 1;
+    }
+    if (a->rotor != b->rotor) {
+        return (a->rotor < b->rotor)? -1 : 1;
+    }
+    return (a->chunk < b->chunk)? -1 : (a->chunk > b->chunk);
+}
+
+//solve the i-th work item of a fleet, as a chunk of the batch of its rotor
+//INTERNAL USE ONLY
+void solve_fleet_item(int i, void* fleetsolution) {
+    FleetSolution* fleet = (FleetSolution*) fleetsolution;
+    const FleetItem* item = &(fleet->items[i]);
+    solve_batch_chunk(item->chunk, &(fleet->batches[item->rotor]));
+}
+
+//allocate the results of a fleet analysis, with the columns in the same block of the structure
+//INTERNAL USE ONLY
+FleetResults* new_fleet_results(int nrotors, int npoints) {
+    size_t size = (size_t)nrotors*npoints;
+    FleetResults* results = calloc(1, sizeof(FleetResults) + size*(5*sizeof(double) + sizeof(bool)));
+    if (!results) {
+        return NULL;
+    }
+    results->nrotors = nrotors;
+    results->npoints = npoints;
+    results->T = (double*) (results + 1);
+    results->Q = results->T + size;
+    results->CT = results->Q + size;
+    results->CP = results->CT + size;
+    results->J = results->CP + size;
+    results->converged = (bool*) (results->J + size);
+    return results;
+}
+
+//run qprop iterations for multiple rotors at the same operating points
+FleetResults* qprop_fleet(Rotor** rotors, int nrotors, int npoints, const double* Uinf, const double* Omega,
+                          const double* rho, const double* mu, double a, const QPropOptions* options) {
+    bool valid = (rotors && nrotors >= 0 && npoints >= 0 && (npoints == 0 || (Uinf && Omega)));
+    int ntables = 0;
+    for (int r=0; valid && r<nrotors; ++r) {
+        valid = (rotors[r] && rotors[r]->nsections >= 2);
+        ntables += (valid)? rotors[r]->nairfoils : 0;
+    }
+    if (!valid) {
+        qprop_log(QPROP_ERROR_INVALID_ARGUMENT, "ERROR in qprop_fleet(): invalid arguments");
+        return NULL;
+    }
+    QPropOptions opts = (options)? *options : qprop_default_options();
+    int nchunks = (npoints + SWEEP_CHUNK_SIZE - 1) / SWEEP_CHUNK_SIZE;
+    int nitems = nrotors*nchunks;
+    FleetResults* results = new_fleet_results(nrotors, npoints);
+    AirfoilPool pool = {malloc((ntables + 1)*sizeof(Airfoil*)), malloc((ntables + 1)*sizeof(uint64_t)), 0};
+    Rotor** pooledrotors = calloc(nrotors + 1, sizeof(Rotor*));
+    Rotor** blendedrotors = calloc(nrotors + 1, sizeof(Rotor*));
+    BatchSolution* batches = calloc(nrotors + 1, sizeof(BatchSolution));
+    FleetItem* items = malloc((nitems + 1)*sizeof(FleetItem));
+    int* itemconverged = calloc(nitems + 1, sizeof(int));
+    bool failed = (!results || !pool.airfoils || !pool.hashes || !pooledrotors || !blendedrotors || !batches || !items || !itemconverged);
+    if (failed) {
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in qprop_fleet()");
+    }
+
+    //share the airfoils among the rotors, then blend the airfoils of the elements once for all the points
+#if defined(QPROP_STATS)
+    double tstart = stats_wall_time();
+#endif
+    for (int r=0; !failed && r<nrotors; ++r) {
+        pooledrotors[r] = pooled_rotor_copy(rotors[r], &pool);
+        if (!pooledrotors[r]) {
+            qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in qprop_fleet()");
+            failed = true;
+            break;
+        }
+        blendedrotors[r] = temporary_blended_rotor(pooledrotors[r], &failed);
+    }
+#if defined(QPROP_STATS)
+    if (opts.stats) {
+        opts.stats->tsetup += stats_wall_time() - tstart;
+    }
+#endif
+
+    //solve the work items in parallel, the most expensive ones first
+    //NOTE: the chunks do not depend on the number of threads or on the order, so the results do not either
+    if (!failed) {
+        QPropStats* itemstats = new_chunk_stats(&opts, nitems);
+        for (int r=0; r<nrotors; ++r) {
+            size_t offset = (size_t)r*npoints;
+            BatchSolution batch = {(blendedrotors[r])? blendedrotors[r] : pooledrotors[r], npoints, Uinf, Omega, rho, mu, a, &opts,
+                                   results->T + offset, results->Q + offset, results->CT + offset, results->CP + offset,
+                                   results->J + offset, results->converged + offset, itemconverged + (size_t)r*nchunks,
+                                   (itemstats)? itemstats + (size_t)r*nchunks : NULL};
+            batches[r] = batch;
+            for (int k=0; k<nchunks; ++k) {
+                int last = (k+1)*SWEEP_CHUNK_SIZE;
+                FleetItem item = {r, k, (long long) (rotors[r]->nsections - 1) * (((last < npoints)? last : npoints) - k*SWEEP_CHUNK_SIZE)};
+                items[r*nchunks + k] = item;
+            }
+        }
+        qsort(items, nitems, sizeof(FleetItem), compare_fleet_items);
+        FleetSolution fleet = {batches, items};
+        parallel_for(nitems, opts.nthreads, solve_fleet_item, &fleet);
+        merge_chunk_stats(&opts, itemstats, nitems);
+        results->nairfoils = pool.size;
+        for (size_t i=0; i<(size_t)nrotors*npoints; ++i) {
+            results->nfailed += (results->converged[i])? 0 : 1;
+        }
+    }
+
+    for (int r=0; pooledrotors && r<nrotors; ++r) {
+        if (blendedrotors && blendedrotors[r]) {
+            free_temporary_blended_rotor(blendedrotors[r], pooledrotors[r]);
+        }
+        free_pooled_rotor_copy(pooledrotors[r]);
+    }
+    free(pool.airfoils);
+    free(pool.hashes);
+    free(pooledrotors);
+    free(blendedrotors);
+    free(batches);
+    free(items);
+    free(itemconverged);
+    if (failed) {
+        free(results);
+        return NULL;
+    }
+    return results;
+}
+
+//free allocated memory on FleetResults
+void free_fleet_results(FleetResults* results) {
+    //the columns are stored in the same block of the structure
+    free(results);
+    results = NULL;
+}
+
+
+//-----------------
+//  STREAMING
+//-----------------
+//The sweeps over millions of operating points do not fit in memory as arrays of RotorPerformance,
+//so their results can be streamed to a file through a sink: the rows are buffered in columns of
+//a fixed number of points, and each full buffer is appended to the file as a record batch. The peak
+//memory depends only on the buffer size and on the number of elements, not on the number of points.
+//The CSV files have one row per point, with the distributions spread in one column per element.
+//The binary files start with a BinaryHeader ("QPROPSK") and a table of the columns, followed by the
+//record batches: the number of rows (int64), then the values of each column one after the other.
+//Unlike the other binary files, they are always written in little-endian order, and all the values
+//are 8-byte aligned doubles, so each column of a batch can be wrapped without copies by numpy,
+//Julia or Arrow arrays; the distributions are fixed-size lists, with nelems values per row.
+
+#define SINK_TOTALS_COLUMNS 8   //number of columns of the totals
+#define SINK_COLUMNS 14         //number of columns of the totals and of the distributions
+#define SINK_NAME_LENGTH 12     //size of the column names in the binary files (bytes)
+
+//names of the columns of the sinks, totals first
+//INTERNAL USE ONLY
+static const char* SINK_COLUMN_NAMES[SINK_COLUMNS] = {
+    "Uinf", "Omega", "T", "Q", "CT", "CP", "J", "converged",
+    "r", "W", "phi", "Gamma", "dTdr", "dQdr"
+};
+
+//entry of the table of the columns of the binary sinks
+//INTERNAL USE ONLY
+typedef struct {
+    char name[SINK_NAME_LENGTH];    //name of the column, zero-padded
+    int32_t width;                  //number of values per row: 1 for the totals, nelems for the distributions
+} SinkColumn;
+
+//streaming writer of the results of many operating points
+struct QPropSink {
+    FILE* fileio;               //output file
+    char* filename;             //name of the output file (for the error messages)
+    QPropSinkFormat format;     //file format
+    int nelems;                 //number of elements of the distributions (0: totals only)
+    int ncolumns;               //number of columns
+    int capacity;               //number of rows of the buffer (multiple of SWEEP_CHUNK_SIZE)
+    int nrows;                  //number of rows in the buffer
+    long long npoints;          //number of rows written to the file
+    int64_t filesize;           //number of bytes written to a binary file
+    bool failed;                //true after the first error
+    double* columns[SINK_COLUMNS];  //columns of the buffer, capacity*width values each
+};
+
+//check if the machine stores the numbers in big-endian order
+//INTERNAL USE ONLY
+bool big_endian_host(void) {
+    const uint32_t x = 0x01020304;
+    return *((const uint8_t*) &x) == 0x01;
+}
+
+//convert an array of numbers between the native and the little-endian order, in place
+//INTERNAL USE ONLY
+void swap_little_endian(void* data, size_t size, size_t count) {
+    if (!big_endian_host()) {
+        return;
+    }
+    uint8_t* bytes = (uint8_t*) data;
+    for (size_t k=0; k<count; ++k) {
+        for (size_t i=0; i<size/2; ++i) {
+            uint8_t tmp = bytes[k*size + i];
+            bytes[k*size + i] = bytes[k*size + size - 1 - i];
+            bytes[k*size + size - 1 - i] = tmp;
+        }
+    }
+}
+
+//write the header and the table of the columns of a binary sink at the beginning of the file
+//INTERNAL USE ONLY
+bool write_sink_header(QPropSink* sink, int64_t filesize) {
+    BinaryHeader header;
+    set_binary_header(&header, "QPROPSK", sink->nelems, sink->ncolumns, filesize, (double) sink->npoints);
+    swap_little_endian(&header.version, sizeof(uint32_t), 1);
+    swap_little_endian(&header.endianness, sizeof(uint32_t), 1);
+    swap_little_endian(&header.n1, sizeof(int32_t), 1);
+    swap_little_endian(&header.n2, sizeof(int32_t), 1);
+    swap_little_endian(&header.filesize, sizeof(int64_t), 1);
+    swap_little_endian(&header.value, sizeof(double), 1);
+    SinkColumn table[SINK_COLUMNS];
+    memset(table, 0, sizeof(table));
+    for (int c=0; c<sink->ncolumns; ++c) {
+        strncpy(table[c].name, SINK_COLUMN_NAMES[c], SINK_NAME_LENGTH-1);
+        table[c].width = (c < SINK_TOTALS_COLUMNS)? 1 : sink->nelems;
+        swap_little_endian(&table[c].width, sizeof(int32_t), 1);
+    }
+    return fseek(sink->fileio, 0, SEEK_SET) == 0
+           && fwrite(&header, sizeof(BinaryHeader), 1, sink->fileio) == 1
+           && fwrite(table, sizeof(SinkColumn), sink->ncolumns, sink->fileio) == (size_t) sink->ncolumns;
+}
+
+//open a sink writing the results of many operating points to a file
+QPropSink* open_qprop_sink(const char* filename, QPropSinkFormat format, int nelems, int batchsize) {
+    if (!filename || (format != QPROP_SINK_CSV && format != QPROP_SINK_BINARY) || nelems < 0 || batchsize < 1) {
+        qprop_log(QPROP_ERROR_INVALID_ARGUMENT, "ERROR in open_qprop_sink(): invalid arguments");
+        return NULL;
+    }
+    //the buffer holds whole chunks of points, so that the sweeps are split like in qprop_batch
+    int capacity = ((batchsize + SWEEP_CHUNK_SIZE - 1) / SWEEP_CHUNK_SIZE) * SWEEP_CHUNK_SIZE;
+    int ncolumns = (nelems > 0)? SINK_COLUMNS : SINK_TOTALS_COLUMNS;
+    size_t nvalues = (size_t)capacity*SINK_TOTALS_COLUMNS + (size_t)capacity*nelems*(SINK_COLUMNS - SINK_TOTALS_COLUMNS);
+    size_t namesize = strlen(filename) + 1;
+    QPropSink* sink = calloc(1, sizeof(QPropSink) + nvalues*sizeof(double) + namesize);
+    if (!sink) {
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in open_qprop_sink()");
+        return NULL;
+    }
+    double* buffer = (double*) (sink + 1);
+    for (int c=0; c<ncolumns; ++c) {
+        sink->columns[c] = buffer;
+        buffer += (size_t)capacity*((c < SINK_TOTALS_COLUMNS)? 1 : nelems);
+    }
+    sink->filename = (char*) buffer;
+    memcpy(sink->filename, filename, namesize);
+    sink->format = format;
+    sink->nelems = nelems;
+    sink->ncolumns = ncolumns;
+    sink->capacity = capacity;
+
+    //write the header of the file
+    sink->fileio = fopen(filename, (format == QPROP_SINK_BINARY)? "wb" : "w");
+    if (!sink->fileio) {
+        qprop_log(QPROP_ERROR_FILE, "ERROR opening file %s", filename);
+        free(sink);
+        return NULL;
+    }
+    bool success = true;
+    if (format == QPROP_SINK_BINARY) {
+        //the file size and the number of points are updated when the sink is closed
+        success = write_sink_header(sink, 0);
+        sink->filesize = (int64_t) (sizeof(BinaryHeader) + ncolumns*sizeof(SinkColumn));
+    }
+    else {
+        for (int c=0; c<ncolumns && success; ++c) {
+            if (c < SINK_TOTALS_COLUMNS) {
+                success = (fprintf(sink->fileio, (c > 0)? ",%s" : "%s", SINK_COLUMN_NAMES[c]) > 0);
+            }
+            for (int i=0; c >= SINK_TOTALS_COLUMNS && i<nelems && success; ++i) {
+                success = (fprintf(sink->fileio, ",%s_%d", SINK_COLUMN_NAMES[c], i+1) > 0);
+            }
+        }
+        success = success && (fputc('\n', sink->fileio) != EOF);
+    }
+    if (!success) {
+        qprop_log(QPROP_ERROR_FILE, "ERROR writing file %s", filename);
+        fclose(sink->fileio);
+        free(sink);
+        return NULL;
+    }
+    return sink;
+}
+
+//copy the results of an operating point into a row of the buffer of a sink
+//INTERNAL USE ONLY
+void store_sink_row(QPropSink* sink, int row, const RotorPerformance* perf, double Uinf, double Omega, bool converged) {
+    const double totals[SINK_TOTALS_COLUMNS] = {Uinf, Omega, perf->T, perf->Q, perf->CT, perf->CP, perf->J, (converged)? 1.0 : 0.0};
+    for (int c=0; c<SINK_TOTALS_COLUMNS; ++c) {
+        sink->columns[c][row] = totals[c];
+    }
+    if (sink->nelems > 0) {
+        const double* distributions[SINK_COLUMNS - SINK_TOTALS_COLUMNS] = {perf->r, perf->W, perf->phi, perf->Gamma, perf->dTdr, perf->dQdr};
+        for (int c=SINK_TOTALS_COLUMNS; c<SINK_COLUMNS; ++c) {
+            memcpy(sink->columns[c] + (size_t)row*sink->nelems, distributions[c - SINK_TOTALS_COLUMNS], sink->nelems*sizeof(double));
+        }
+    }
+}
+
+//write a number to a CSV file with 17 significant digits and a decimal point
+//separator: decimal separator of the current locale, replaced by the point
+//comma: true to write a comma before the number
+//INTERNAL USE ONLY
+bool write_csv_number(FILE* fileio, double value, char separator, bool comma) {
+    char buffer[32];
+    int length = snprintf(buffer, sizeof(buffer), (comma)? ",%.17g" : "%.17g", value);
+    if (length <= 0 || length >= (int) sizeof(buffer)) {
+        return false;
+    }
+    char* point = (separator != '.')? memchr(buffer, separator, length) : NULL;
+    if (point) {
+        *point = '.';
+    }
+    return fwrite(buffer, 1, length, fileio) == (size_t) length;
+}
+
+//append the rows of the buffer of a sink to its file, then empty the buffer
+//INTERNAL USE ONLY
+bool flush_qprop_sink(QPropSink* sink) {
+    if (sink->nrows == 0 || sink->failed) {
+        sink->nrows = 0;
+        return !sink->failed;
+    }
+    bool success = true;
+    if (sink->format == QPROP_SINK_BINARY) {
+        //record batch: number of rows, then the columns one after the other
+        int64_t nrows = sink->nrows;
+        swap_little_endian(&nrows, sizeof(int64_t), 1);
+        success = (fwrite(&nrows, sizeof(int64_t), 1, sink->fileio) == 1);
+        sink->filesize += sizeof(int64_t);
+        for (int c=0; c<sink->ncolumns && success; ++c) {
+            size_t nvalues = (size_t)sink->nrows*((c < SINK_TOTALS_COLUMNS)? 1 : sink->nelems);
+            swap_little_endian(sink->columns[c], sizeof(double), nvalues);
+            success = (fwrite(sink->columns[c], sizeof(double), nvalues, sink->fileio) == nvalues);
+            sink->filesize += (int64_t) (nvalues*sizeof(double));
+        }
+    }
+    else {
+        //one line per row, with enough digits to read back the same doubles
+        //and with a decimal point, whatever the locale
+        char separator = locale_decimal_separator();
+        for (int j=0; j<sink->nrows && success; ++j) {
+            for (int c=0; c<SINK_TOTALS_COLUMNS && success; ++c) {
+                double value = sink->columns[c][j];
+                success = (c == SINK_TOTALS_COLUMNS - 1)? (fprintf(sink->fileio, ",%d", (value != 0.0)) > 0)
+                                                        : write_csv_number(sink->fileio, value, separator, (c > 0));
+            }
+            for (int c=SINK_TOTALS_COLUMNS; c<sink->ncolumns && success; ++c) {
+                const double* values = sink->columns[c] + (size_t)j*sink->nelems;
+                for (int i=0; i<sink->nelems && success; ++i) {
+                    success = write_csv_number(sink->fileio, values[i], separator, true);
+                }
+            }
+            success = success && (fputc('\n', sink->fileio) != EOF);
+        }
+    }
+    if (!success) {
+        qprop_log(QPROP_ERROR_FILE, "ERROR writing file %s", sink->filename);
+        sink->failed = true;
+    }
+    sink->npoints += sink->nrows;
+    sink->nrows = 0;
+    return success;
+}
+
+//write the results of one operating point to a sink
+bool qprop_sink_write(QPropSink* sink, const RotorPerformance* perf, double Uinf, double Omega) {
+    if (!sink || !perf || (sink->nelems > 0 && (perf->nelems != sink->nelems || !perf->r || !perf->dTdr))) {
+        qprop_log(QPROP_ERROR_INVALID_ARGUMENT, "ERROR in qprop_sink_write(): invalid arguments");
+        return false;
+    }
+    store_sink_row(sink, sink->nrows, perf, Uinf, Omega, perf->status == QPROP_OK);
+    sink->nrows += 1;
+    if (sink->nrows == sink->capacity) {
+        return flush_qprop_sink(sink);
+    }
+    return !sink->failed;
+}
+
+//flush the buffer of a sink, complete its file and free it
+bool close_qprop_sink(QPropSink* sink) {
+    if (!sink) {
+        return false;
+    }
+    bool success = flush_qprop_sink(sink);
+    if (success && sink->format == QPROP_SINK_BINARY) {
+        //the bytes are counted while writing, since ftell() returns a 32-bit long on Windows
+        success = write_sink_header(sink, sink->filesize);
+        if (!success) {
+            qprop_log(QPROP_ERROR_FILE, "ERROR writing file %s", sink->filename);
+        }
+    }
+    if (fclose(sink->fileio) != 0 && success) {
+        qprop_log(QPROP_ERROR_FILE, "ERROR writing file %s", sink->filename);
+        success = false;
+    }
+    free(sink);
+    sink = NULL;
+    return success;
+}
+
+//data structure for a block of operating points streamed to a sink
+//INTERNAL USE ONLY
+typedef struct {
+    QPropSink* sink;
+    Rotor* rotor;
+    int npoints;            //number of points of the block
+    const double* Uinf;     //first freestream velocity of the block
+    const double* Omega;    //first rotor speed of the block
+    const double* rho;      //first air density of the block (NULL: 1.225)
+    const double* mu;       //first air dynamic viscosity of the block (NULL: 1.81e-5)
+    double a;
+    const QPropOptions* opts;
+    int* chunkconverged;    //number of converged points of each chunk
+    QPropStats* chunkstats; //statistics of each chunk (NULL if not collected)
+} StreamSolution;
+
+//solve the k-th chunk of consecutive operating points of a block, storing them in the rows of the sink buffer
+//INTERNAL USE ONLY
+void solve_stream_chunk(int k, void* streamsolution) {
+    StreamSolution* stream = (StreamSolution*) streamsolution;
+    int nelems = stream->rotor->nsections - 1;
+    double* psi = calloc(nelems, sizeof(double));
+    RotorPerformance* perf = new_rotor_performance_ex(nelems, stream->sink->nelems == 0);
+    if (!psi || !perf) {
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in qprop_stream()");
+        free(psi);
+        if (perf) {
+            free_rotor_performance(perf);
+        }
+        //the rows of the chunk are still written, with zeros as points that did not converge
+        for (int j=k*SWEEP_CHUNK_SIZE; j<(k+1)*SWEEP_CHUNK_SIZE && j<stream->npoints; ++j) {
+            for (int c=0; c<stream->sink->ncolumns; ++c) {
+                size_t width = (c < SINK_TOTALS_COLUMNS)? 1 : stream->sink->nelems;
+                memset(stream->sink->columns[c] + j*width, 0, width*sizeof(double));
+            }
+            stream->sink->columns[0][j] = stream->Uinf[j];
+            stream->sink->columns[1][j] = stream->Omega[j];
+        }
+        return;
+    }
+    //the statistics of the chunk are collected separately, as the chunks run in parallel
+    QPropOptions opts = *(stream->opts);
+    opts.stats = (stream->chunkstats)? &(stream->chunkstats[k]) : NULL;
+    bool warmstart = false;
+    int nconverged = 0;
+    int last = (k+1)*SWEEP_CHUNK_SIZE;
+    for (int j=k*SWEEP_CHUNK_SIZE; j<last && j<stream->npoints; ++j) {
+        double rho = (stream->rho)? stream->rho[j] : 1.225;
+        double mu = (stream->mu)? stream->mu[j] : 1.81e-5;
+        bool converged = qprop_solve(perf, stream->rotor, stream->Uinf[j], stream->Omega[j], rho, mu, stream->a, &opts, psi, warmstart, 1);
+        store_sink_row(stream->sink, j, perf, stream->Uinf[j], stream->Omega[j], converged);
+        if (converged) {
+            //keep the last valid psi values for the next point
+            warmstart = true;
+            nconverged += 1;
+        }
+    }
+    stream->chunkconverged[k] = nconverged;
+    free(psi);
+    free_rotor_performance(perf);
+}
+
+//run qprop iterations over a batch of operating points, streaming the results to a sink
+bool qprop_stream(Rotor* rotor, int npoints, const double* Uinf, const double* Omega, const double* rho, const double* mu, double a,
+                  const QPropOptions* options, QPropSink* sink) {
+    if (!rotor || rotor->nsections < 2 || npoints < 0 || (npoints > 0 && (!Uinf || !Omega)) || !sink
+            || (sink->nelems > 0 && sink->nelems != rotor->nsections - 1)) {
+        qprop_log(QPROP_ERROR_INVALID_ARGUMENT, "ERROR in qprop_stream(): invalid arguments");
+        return false;
+    }
+    QPropOptions opts = (options)? *options : qprop_default_options();
+    int nchunks = sink->capacity / SWEEP_CHUNK_SIZE;
+    int* chunkconverged = calloc(nchunks, sizeof(int));
+    if (!chunkconverged) {
+        qprop_log(QPROP_ERROR_MEMORY, "ERROR: memory allocation error in qprop_stream()");
+        return false;
+    }
+
+    //blend the airfoils of the elements once for all the operating points
+#if defined(QPROP_STATS)
+    double tstart = stats_wall_time();
+#endif
+    bool failed;
+    Rotor* blendedrotor = temporary_blended_rotor(rotor, &failed);
+    if (failed) {
+        free(chunkconverged);
+        return false;
+    }
+#if defined(QPROP_STATS)
+    if (opts.stats) {
+        opts.stats->tsetup += stats_wall_time() - tstart;
+    }
+#endif
+
+    //solve blocks of points as large as the buffer, each split in chunks like in qprop_batch,
+    //then append them to the file; the rows written before by qprop_sink_write are flushed first,
+    //so the blocks start at the beginning of the buffer
+    //NOTE: the blocks are made of whole chunks, so the results are the same as qprop_batch
+    bool success = flush_qprop_sink(sink);
+    int nconverged = 0;
+    for (int start=0; start<npoints && success; start+=sink->capacity) {
+        int nblock = (npoints - start < sink->capacity)? npoints - start : sink->capacity;
+        int nblockchunks = (nblock + SWEEP_CHUNK_SIZE - 1) / SWEEP_CHUNK_SIZE;
+        memset(chunkconverged, 0, nchunks*sizeof(int));
+        StreamSolution stream = {sink, (blendedrotor)? blendedrotor : rotor, nblock, Uinf + start, Omega + start,
+                                 (rho)? rho + start : NULL, (mu)? mu + start : NULL, a, &opts, chunkconverged,
+                                 new_chunk_stats(&opts, nblockchunks)};
+        parallel_for(nblockchunks, opts.nthreads, solve_stream_chunk, &stream);
+        merge_chunk_stats(&opts, stream.chunkstats, nblockchunks);
+        for (int k=0; k<nblockchunks; ++k) {
+            nconverged += chunkconverged[k];
+        }
+        sink->nrows = nblock;
+        success = flush_qprop_sink(sink);
+    }
+    if (blendedrotor) {
+        free_temporary_blended_rotor(blendedrotor, rotor);
+    }
+    free(chunkconverged);
+    return success && nconverged == npoints;
+}
@@ -20,6 +20,9 @@
     Author: Andrea Pavan
     License: MIT
 *******************************************************************************/
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 
 //---------------------
@@ -33,12 +36,37 @@ typedef struct {
     double* CL;         //array of lift coefficients - same size as alpha
     double* CD;         //array of drag coefficients - same size as alpha
     int size;           //number of points in the polar
+    double dalpha;      //uniform spacing of alpha (rad), or 0 if the spacing is not uniform
 } Polar;
 
+//floating point type of the compiled polar tables read by the solver and of the batched residual:
+//float when the library is compiled with QPROP_SINGLE_PRECISION, double otherwise
+#if defined(QPROP_SINGLE_PRECISION)
+typedef float qprop_real;
+#else
+typedef double qprop_real;
+#endif
+
+//data structure for compiled airfoils
+//all the polars are resampled on a common alpha grid and stored in a single contiguous block
+typedef struct {
+    int nRe;            //number of polars
+    int nalpha;         //number of angles of attack, common to all the polars
+    double dalpha;      //uniform spacing of alpha (rad), or 0 if the spacing is not uniform
+    double* Re;         //array of Reynolds numbers in ascending order - size nRe
+    double* alpha;      //array of angles of attack in ascending order (rad) - size nalpha
+    double* CLCD;       //array of interleaved (CL,CD) pairs, one row of nalpha pairs for each Re
+    qprop_real* CLCDr;  //CLCD in the precision of the solver (the same array, unless compiled with QPROP_SINGLE_PRECISION)
+    void* mapping;      //memory-mapped binary file containing the arrays (NULL if allocated on the heap)
+    size_t mapsize;     //size of the memory-mapped file (bytes)
+} CompiledAirfoil;
+
 //data structure for airfoils
 typedef struct {
     Polar** polars;     //array of pointers to polars - typically at different Re
     int size;           //number of polars in the airfoil
+    CompiledAirfoil* compiled;  //compiled polars used for the interpolation (NULL if not compiled)
+    int refcount;       //number of owners (the caller and the rotors), or 0 if managed by the caller
 } Airfoil;
 
 //data structure for blade sections
@@ -46,7 +74,7 @@ typedef struct {
     double c;           //chord length (m)
     double beta;        //twist angle (rad)
     double r;           //radial distance (m)
-    Airfoil airfoil;   //local airfoil data
+    int airfoil;        //index of the local airfoil in the airfoil table of the rotor
 } Section;
 
 //data structure for rotors
@@ -55,8 +83,26 @@ typedef struct {
     int B;              //number of blades
     int nsections;      //number of sections discretizing a blade
     Section* sections;  //array of sections discretizing a blade
+    Airfoil** airfoils; //table of the airfoils used by the sections, without duplicates
+    int nairfoils;      //number of airfoils in the table
+    Airfoil** elementairfoils;  //blended airfoil of each blade element, in the table (NULL if not precomputed)
 } Rotor;
 
+//status codes reported by the library
+typedef enum {
+    QPROP_OK = 0,                       //success
+    QPROP_ERROR_MEMORY = 1,             //memory allocation error
+    QPROP_ERROR_INVALID_ARGUMENT = 2,   //invalid input data
+    QPROP_ERROR_FILE = 3,               //unable to open, read, write or parse a file
+    QPROP_ERROR_NOT_CONVERGED = 4       //some blade elements did not converge
+} QPropStatus;
+
+//user function receiving the messages of the library
+//status: code of the condition that is reported
+//message: description of the condition (valid only during the call)
+//userdata: pointer given to qprop_set_log_callback
+typedef void (*QPropLogCallback)(QPropStatus status, const char* message, void* userdata);
+
 //data structure for qprop output
 typedef struct {
     double T;           //overall thrust (N)
@@ -73,8 +119,137 @@ typedef struct {
     double* dTdr;       //array for blade thrust distribution (N/m)
     double* dQdr;       //array for blade torque distribution (N-m/m)
     int nelems;         //number of elements discretizing a blade
+    int* nevals;        //array of residual evaluations used by each element
+    bool* converged;    //array of elements convergence flags (residual within the tolerance)
+    QPropStatus status; //QPROP_OK if all the elements converged, QPROP_ERROR_NOT_CONVERGED otherwise
 } RotorPerformance;
 
+//data structure for the sensitivities of thrust and torque (see qprop_with_gradients)
+typedef struct {
+    int nsections;      //number of rotor sections
+    double* dTdc;       //array of thrust derivatives with respect to the chord of each section (N/m)
+    double* dTdbeta;    //array of thrust derivatives with respect to the twist of each section (N/rad)
+    double* dQdc;       //array of torque derivatives with respect to the chord of each section (N-m/m)
+    double* dQdbeta;    //array of torque derivatives with respect to the twist of each section (N-m/rad)
+    double dTdUinf;     //thrust derivative with respect to the freestream velocity (N-s/m)
+    double dQdUinf;     //torque derivative with respect to the freestream velocity (N-m-s/m)
+    double dTdOmega;    //thrust derivative with respect to the rotor speed (N-s/rad)
+    double dQdOmega;    //torque derivative with respect to the rotor speed (N-m-s/rad)
+} RotorGradients;
+
+//data structure for rotor performance maps (see generate_rotor_map)
+typedef struct {
+    int nJ;             //number of advance ratios
+    int nOmega;         //number of rotor speeds
+    double* J;          //array of advance ratios in ascending order - size nJ
+    double* Omega;      //array of rotor speeds in ascending order (rad/s) - size nOmega
+    double* CTCP;       //array of interleaved (CT,CP) pairs, one row of nJ pairs for each Omega
+    double dJ;          //uniform spacing of J, or 0 if the spacing is not uniform
+    double dOmega;      //uniform spacing of Omega (rad/s), or 0 if the spacing is not uniform
+    double D;           //rotor diameter (m)
+    double rho;         //air density used to generate the map (kg/m3)
+    double mu;          //air dynamic viscosity used to generate the map (Pa-s)
+    double a;           //speed of sound used to generate the map (m/s), 0 without Mach correction
+    double errCT;       //maximum error of the interpolated CT, measured at the centers of the cells
+    double errCP;       //maximum error of the interpolated CP, measured at the centers of the cells
+    int nfailed;        //number of grid points that did not converge
+    void* mapping;      //memory-mapped binary file containing the arrays (NULL if allocated on the heap)
+    size_t mapsize;     //size of the memory-mapped file (bytes)
+} RotorMap;
+
+//output of a performance map lookup (see lookup_rotor_map)
+typedef struct {
+    double T;           //thrust (N)
+    double Q;           //torque (N-m)
+    double CT;          //thrust coefficient
+    double CP;          //power coefficient
+    double J;           //advance ratio
+    bool inside;        //false if the query is outside the map and was clamped to its edges
+} RotorMapPoint;
+
+//data structure for the results of a fleet analysis (see qprop_fleet)
+//all the columns are stored in a single block: the value of rotor i at point j is at index i*npoints + j
+typedef struct {
+    int nrotors;        //number of rotors
+    int npoints;        //number of operating points of each rotor
+    double* T;          //column of thrusts (N) - size nrotors*npoints
+    double* Q;          //column of torques (N-m) - size nrotors*npoints
+    double* CT;         //column of thrust coefficients - size nrotors*npoints
+    double* CP;         //column of power coefficients - size nrotors*npoints
+    double* J;          //column of advance ratios - size nrotors*npoints
+    bool* converged;    //column of flags, true if all the blade elements converged - size nrotors*npoints
+    int nairfoils;      //number of distinct airfoils in the pool shared by the rotors
+    int nfailed;        //number of points that did not converge
+} FleetResults;
+
+//root finding algorithms available for the blade element solution
+typedef enum {
+    QPROP_SOLVER_BISECTION = 0,     //bisection method: robust, linear convergence
+    QPROP_SOLVER_BRENT = 1          //Brent's method: bracketed, superlinear convergence
+} QPropSolver;
+
+//radial distributions of the sections available for the rotor refinement
+typedef enum {
+    QPROP_SPACING_UNIFORM = 0,      //equally-spaced sections
+    QPROP_SPACING_COSINE = 1,       //cosine spacing: sections clustered at the hub and at the tip
+    QPROP_SPACING_TIP = 2           //half-cosine spacing: sections clustered at the tip
+} QPropSpacing;
+
+//quantities that can be matched by the trim solver (see qprop_trim)
+typedef enum {
+    QPROP_TRIM_THRUST = 0,          //thrust T (N)
+    QPROP_TRIM_TORQUE = 1,          //torque Q (N-m)
+    QPROP_TRIM_POWER = 2            //shaft power P = Q*Omega (W)
+} QPropTrimTarget;
+
+//variables adjusted by the trim solver (see qprop_trim)
+typedef enum {
+    QPROP_TRIM_OMEGA = 0,           //rotor speed Omega (rad/s)
+    QPROP_TRIM_PITCH = 1            //collective pitch: uniform offset added to the twist of all the sections (rad)
+} QPropTrimVariable;
+
+//statistics of the analyses, collected only when the library is compiled with QPROP_STATS defined
+typedef struct {
+    long long nelements;        //number of blade element solutions
+    long long niterations;      //number of root finding iterations (residual evaluations after the bracketing)
+    long long nevals;           //number of residual evaluations
+    long long nalphaclamped;    //polar queries beyond the alpha range (extrapolated to CD=2.0 at +-90 deg)
+    long long nReclamped;       //polar queries beyond the Re range (clamped to the lowest or highest polar)
+    double tsetup;              //wall time spent preparing the analyses, e.g. blending the airfoils (s)
+    double tsolve;              //wall time spent solving the blade elements (s)
+    double tintegrate;          //wall time spent integrating thrust and torque (s)
+} QPropStats;
+
+//operating point cache (see alloc_qprop_cache), whose content is private to the library
+typedef struct QPropCache QPropCache;
+
+//file formats of the streaming writers (see open_qprop_sink)
+typedef enum {
+    QPROP_SINK_CSV = 0,             //comma-separated text with a header line, one line per operating point
+    QPROP_SINK_BINARY = 1           //little-endian columnar binary file ("QPROPSK"), in record batches
+} QPropSinkFormat;
+
+//streaming writer of the results of many operating points (see open_qprop_sink), whose content is private to the library
+typedef struct QPropSink QPropSink;
+
+//counters of an operating point cache
+typedef struct {
+    long long hits;             //analyses copied from an entry with the same operating conditions
+    long long warmstarts;       //analyses warm started from an entry with close operating conditions
+    long long misses;           //analyses started cold
+    long long evictions;        //entries replaced to make room for new ones
+    int entries;                //number of cached operating points
+} QPropCacheStats;
+
+//data structure for qprop_ex options
+typedef struct {
+    double tol;         //stopping criterion tolerance (suggested value: 1e-6)
+    int itmax;          //maximum number of iterations (suggested value: 100)
+    QPropSolver solver; //root finding algorithm used for each blade element
+    int nthreads;       //number of threads (1: serial, 0: all the available cores)
+    QPropStats* stats;  //statistics accumulated by the analyses (NULL: not collected)
+} QPropOptions;
+
 
 //-----------------
 //  FREE MEMORY
@@ -92,13 +267,37 @@ void free_polar(Polar* currentpolar);
 //  - currentairfoil (Airfoil*): pointer to an airfoil that is no longer needed
 //Output:
 //  - none
+//Notes:
+//  - airfoils are reference-counted: the memory is released only when the
+//    airfoil is no longer used by any rotor, so rotors and airfoils can be
+//    freed in any order
 void free_airfoil(Airfoil* currentairfoil);
 
+//FREE_AIRFOILS frees the memory allocated in an array of airfoils
+//Input:
+//  - airfoils (Airfoil**): array of airfoils that are no longer needed
+//  - number_of_airfoils (int): number of airfoils in the array
+//Output:
+//  - none
+void free_airfoils(Airfoil** airfoils, int number_of_airfoils);
+
+//FREE_COMPILED_AIRFOIL frees the memory allocated in a CompiledAirfoil structure
+//Input:
+//  - compiled (CompiledAirfoil*): pointer to a compiled airfoil that is no longer needed
+//Output:
+//  - none
+//Notes:
+//  - free_airfoil(...) already frees the compiled polars of the airfoil
+void free_compiled_airfoil(CompiledAirfoil* compiled);
+
 //FREE_ROTOR frees the memory allocated in a Rotor structure
 //Input:
 //  - currentrotor (Rotor*): pointer to a rotor that is no longer needed
 //Output:
 //  - none
+//Notes:
+//  - the rotor releases its references to the airfoils in its table; the
+//    airfoils with refcount=0 are managed by the caller and are not freed
 void free_rotor(Rotor* currentrotor);
 
 //FREE_ROTOR_PERFORMANCE frees the memory allocated in a qprop output
@@ -108,6 +307,44 @@ void free_rotor(Rotor* currentrotor);
 //  - none
 void free_rotor_performance(RotorPerformance* perf);
 
+//FREE_ROTOR_PERFORMANCES frees the memory allocated in an array of qprop outputs
+//Input:
+//  - perfs (RotorPerformance**): array of qprop outputs that are no longer needed
+//  - npoints (int): number of outputs in the array
+//Output:
+//  - none
+void free_rotor_performances(RotorPerformance** perfs, int npoints);
+
+//FREE_ROTOR_GRADIENTS frees the memory allocated in the sensitivities of a rotor
+//Input:
+//  - gradients (RotorGradients*): pointer to sensitivities that are no longer needed
+//Output:
+//  - none
+void free_rotor_gradients(RotorGradients* gradients);
+
+//FREE_ROTOR_MAP frees the memory allocated in a performance map
+//Input:
+//  - map (RotorMap*): pointer to a performance map that is no longer needed
+//Output:
+//  - none
+//Notes:
+//  - the maps loaded by load_rotor_map_binary release their memory-mapped file
+void free_rotor_map(RotorMap* map);
+
+//FREE_FLEET_RESULTS frees the memory allocated in the results of a fleet analysis
+//Input:
+//  - results (FleetResults*): pointer to the results that are no longer needed
+//Output:
+//  - none
+void free_fleet_results(FleetResults* results);
+
+//FREE_QPROP_CACHE frees the memory allocated in an operating point cache
+//Input:
+//  - cache (QPropCache*): pointer to the cache that must be freed
+//Output:
+//  - none
+void free_qprop_cache(QPropCache* cache);
+
 
 //---------------------------
 //  FUNCTION DECLARATIONS
@@ -138,6 +375,20 @@ double deg2rad(double deg);
 //    unload_polar_from_memory(Polar*) when it is no longer needed
 Polar* read_xfoil_polar_from_file(const char *filename);
 
+//READ_XFOIL_POLAR_FROM_BUFFER parses an airfoil polar from a text buffer in memory
+//Input:
+//  - buffer (array of char): content of a polar file, not necessarily null-terminated
+//  - size (size_t): number of characters in the buffer
+//Output:
+//  - (Polar*): pointer to the polar data, or NULL if the buffer cannot be parsed
+//Notes:
+//  - The buffer is assumed to be in the XFoil/XFLR5 format
+//    (see the notes above "read_xfoil_polar_from_file")
+//  - Useful when the polar is embedded in the program or downloaded at runtime,
+//    for example in the web GUI
+//  - The returned polar must be freed with free_polar(Polar*)
+Polar* read_xfoil_polar_from_buffer(const char* buffer, size_t size);
+
 //IMPORT_XFOIL_POLARS imports airfoil polars from multiple text files
 //Input:
 //  - filenames (array of (array of char)): list of files containing polar data
@@ -155,6 +406,52 @@ Polar* read_xfoil_polar_from_file(const char *filename);
 //    needed, by calling unload_airfoil_from_memory(Airfoil*)
 Airfoil* import_xfoil_polars(const char *filenames[], int number_of_files);
 
+//IMPORT_XFOIL_POLARS_PARALLEL imports several airfoils at once, reading the polar files in parallel
+//Input:
+//  - filenames (array of (array of (array of char))): for each airfoil, list of files containing its polars
+//  - number_of_files (array of int): number of files of each airfoil
+//  - number_of_airfoils (int): number of airfoils
+//  - reynolds_from_filename (bool): if true, the Reynolds number is taken from the XFLR5 file
+//    name when it contains the pattern "_Re0.300_" (see reynolds_number_from_filename)
+//  - nthreads (int): number of threads (1: serial, 0: all the available cores)
+//  - loaded (array of bool): output, set to true for each file that was read successfully;
+//    same order of the files in filenames, flattened - set to NULL to ignore
+//Output:
+//  - (Airfoil**): array of number_of_airfoils pointers to the imported airfoils
+//Notes:
+//  - the files that cannot be read are skipped; the airfoils without any valid
+//    polar are set to NULL
+//  - the polars of each airfoil are sorted by Re and compiled
+//  - multithreading requires the library to be compiled with QPROP_THREADS
+//    defined, otherwise the files are read serially
+//  - It is the caller's responsibility to free the airfoils when they are no
+//    longer needed, by calling free_airfoils(airfoils, number_of_airfoils)
+Airfoil** import_xfoil_polars_parallel(const char** filenames[], const int number_of_files[], int number_of_airfoils,
+                                       bool reynolds_from_filename, int nthreads, bool* loaded);
+
+//REYNOLDS_NUMBER_FROM_FILENAME infers the Reynolds number from the name of a XFLR5 polar file
+//Input:
+//  - filename (array of char): name of the file, e.g. "NACA 4412_T1_Re0.300_M0.00_N6.0.txt"
+//Output:
+//  - (double): Reynolds number (e.g. 300000), or 0 if the name does not contain the pattern "_Re0.300_"
+double reynolds_number_from_filename(const char* filename);
+
+//COMPILE_AIRFOIL resamples all the polars of an airfoil on a common alpha grid
+//and stores them in a single contiguous table, used to speed up the interpolation
+//Input:
+//  - airfoil (Airfoil*): pointer to an airfoil
+//Output:
+//  - (CompiledAirfoil*): pointer to the compiled polars, also stored in airfoil->compiled
+//Notes:
+//  - import_xfoil_polars(...) and analytic_polar_curves(...) already compile the airfoil
+//  - the common grid contains the angles of attack of all the polars, so the
+//    interpolated coefficients are the same of the original polars
+//  - the compiled table is read-only, so it can be shared between threads;
+//    it must be compiled again if the polars of the airfoil are modified
+//  - rotors refer to the airfoil through their airfoil table, so the compiled
+//    table is used also by the rotors built before the compilation
+CompiledAirfoil* compile_airfoil(Airfoil* airfoil);
+
 //ANALYTIC_POLAR_CURVES generates polars using the simple analytic model
 //described by Drela in the QPROP user guide
 //Input:
@@ -203,8 +500,135 @@ Rotor* import_rotor_geometry_uiuc(const char *filename, Airfoil* airfoil, double
 //  - nsections (int): desired number of sections
 //Output:
 //  - newrotor (Rotor*): pointer to the new rotor geometry
+//Notes:
+//  - the airfoils are blended linearly along the span: a new section between
+//    two old sections with different airfoils gets a blended airfoil
+//  - the blended airfoils of the elements are precomputed (see blend_rotor_airfoils)
 Rotor* refine_rotor_sections(Rotor* oldrotor, int nsections);
 
+//REFINE_ROTOR_SECTIONS_EX creates a propeller geometry with the specified number
+//of sections and radial distribution
+//Input:
+//  - oldrotor (Rotor*): pointer to the reference rotor geometry
+//  - nsections (int): desired number of sections
+//  - spacing (QPropSpacing): radial distribution of the sections
+//Output:
+//  - newrotor (Rotor*): pointer to the new rotor geometry
+//Notes:
+//  - clustering the sections at the tip, where the Prandtl factor changes sharply,
+//    gives the same accuracy of equally-spaced sections with fewer elements
+Rotor* refine_rotor_sections_ex(Rotor* oldrotor, int nsections, QPropSpacing spacing);
+
+//REFINE_ROTOR_SECTIONS_ADAPTIVE creates a propeller geometry with sections added
+//only where the thrust distribution changes sharply at the given operating point
+//Input:
+//  - oldrotor (Rotor*): pointer to the reference rotor geometry
+//  - Uinf (double): freestream velocity in m/s
+//  - Omega (double): rotor speed in rad/s
+//  - rho (double): air density in kg/m3 (suggested value: 1.225)
+//  - mu (double): air dynamic viscosity in Pa-s (suggested value: 1.81e-5)
+//  - a (double): speed of sound in m/s (suggested value: 340.0) - set to 0 to disable Mach correction
+//  - tol (double): relative tolerance on the thrust and torque (suggested value: 1e-3)
+//  - maxsections (int): maximum number of sections
+//  - options (QPropOptions*): pointer to the solver options - set to NULL to use the default ones
+//Output:
+//  - newrotor (Rotor*): pointer to the new rotor geometry
+//Notes:
+//  - starting from a coarse discretization, the elements where dT/dr changes
+//    by more than tol times the blade thrust are split in two, until the
+//    thrust and torque change by less than tol between two refinements
+//  - the last discretization is returned if maxsections would be exceeded
+Rotor* refine_rotor_sections_adaptive(Rotor* oldrotor, double Uinf, double Omega, double rho, double mu, double a,
+                                      double tol, int maxsections, const QPropOptions* options);
+
+//BLEND_AIRFOILS creates an airfoil blending the coefficients of two airfoils
+//Input:
+//  - airfoil1 (Airfoil*): pointer to the first airfoil
+//  - airfoil2 (Airfoil*): pointer to the second airfoil
+//  - w (double): blending weight (0: airfoil1, 1: airfoil2)
+//Output:
+//  - (Airfoil*): pointer to the blended airfoil, whose coefficients are
+//    (1-w)*airfoil1 + w*airfoil2 at any alpha and Re
+//Notes:
+//  - the polars are tabulated on the union of the Re and alpha grids of the
+//    two compiled airfoils, so the blend is exact and its interpolation is
+//    as fast as the one of a single airfoil
+//  - It is the caller's responsibility to free the airfoil by calling free_airfoil(Airfoil*)
+Airfoil* blend_airfoils(Airfoil* airfoil1, Airfoil* airfoil2, double w);
+
+//BLEND_ROTOR_AIRFOILS precomputes the airfoil of each blade element, blending
+//the airfoils of the two sections bounding the element
+//Input:
+//  - rotor (Rotor*): pointer to a rotor
+//Output:
+//  - (bool): true if the airfoils were blended successfully
+//Notes:
+//  - the blended airfoils are stored in the airfoil table of the rotor and in
+//    rotor->elementairfoils
+//  - the rotors created by the library (imported, refined, loaded or built with
+//    push_rotor_section) are already blended: call this function only after
+//    changing the airfoils of the sections in place
+//  - rotors with different airfoils and without precomputed blends are blended
+//    on a temporary copy at each analysis (sweeps are blended once)
+bool blend_rotor_airfoils(Rotor* rotor);
+
+//COPY_ROTOR creates a copy of a propeller geometry
+//Input:
+//  - oldrotor (Rotor*): pointer to the rotor to be copied
+//Output:
+//  - (Rotor*): pointer to the new rotor geometry
+//Notes:
+//  - the sections are copied, while the airfoils are shared with the original
+//    rotor (only a reference is added), so copies are cheap, e.g. in optimizers
+//  - It is the caller's responsibility to free the copy by calling free_rotor(Rotor*)
+Rotor* copy_rotor(Rotor* oldrotor);
+
+//SAVE_AIRFOIL_BINARY saves an airfoil in a compact binary file
+//Input:
+//  - airfoil (Airfoil*): pointer to an airfoil
+//  - filename (array of char): name of the binary file to be written
+//Output:
+//  - (bool): true if the file was written successfully
+//Notes:
+//  - both the polars and the compiled table are saved; the airfoil is compiled
+//    first if needed
+//  - the file is written in the native byte order, so it can only be loaded
+//    on machines with the same architecture
+bool save_airfoil_binary(Airfoil* airfoil, const char* filename);
+
+//LOAD_AIRFOIL_BINARY loads an airfoil from a binary file written by save_airfoil_binary
+//Input:
+//  - filename (array of char): name of the binary file
+//Output:
+//  - (Airfoil*): pointer to the loaded airfoil, or NULL if the file is not valid
+//Notes:
+//  - the file is memory-mapped and used without copies: loading is almost
+//    instantaneous, and processes loading the same file share its memory
+//  - the polars and the compiled table are read-only and must not be modified
+//  - free_airfoil(Airfoil*) releases the mapping when the airfoil is no longer needed
+Airfoil* load_airfoil_binary(const char* filename);
+
+//SAVE_ROTOR_BINARY saves the geometry of a rotor in a compact binary file
+//Input:
+//  - rotor (Rotor*): pointer to a rotor
+//  - filename (array of char): name of the binary file to be written
+//Output:
+//  - (bool): true if the file was written successfully
+//Notes:
+//  - the airfoils of the sections are not saved, use save_airfoil_binary(...)
+//  - the file stores a single airfoil layout: the rotors whose sections use more than one
+//    airfoil (e.g. with blended airfoils) are rejected, as they could not be loaded back
+bool save_rotor_binary(Rotor* rotor, const char* filename);
+
+//LOAD_ROTOR_BINARY loads the geometry of a rotor from a binary file written by save_rotor_binary
+//Input:
+//  - filename (array of char): name of the binary file
+//  - airfoil (Airfoil*): pointer to the airfoil of all the sections
+//Output:
+//  - (Rotor*): pointer to the loaded rotor, or NULL if the file is not valid or the rotor
+//    cannot be built (e.g. NULL airfoil or memory allocation error)
+Rotor* load_rotor_binary(const char* filename, Airfoil* airfoil);
+
 //QPROP runs the QProp algorithm as described by Drela for each blade element
 //Input:
 //  - rotor (Rotor*): pointer to a rotor
@@ -216,9 +640,442 @@ Rotor* refine_rotor_sections(Rotor* oldrotor, int nsections);
 //  - mu (double): air dynamic viscosity in Pa-s (suggested value: 1.81e-5)
 //  - a (double): speed of sound in m/s (suggested value: 340.0) - set to 0 to disable Mach correction
 //Output:
-//  - (RotorPerformance*): pointer to the QProp outputs
+//  - (RotorPerformance*): pointer to the QProp outputs, or NULL on errors
 //Notes:
 //  - the current implementation assumes that there is no externally-induced
 //    tangential velocity (Ut = 0)
+//  - when some blade elements do not converge, the outputs are returned anyway
+//    with status QPROP_ERROR_NOT_CONVERGED and the flags of the elements in converged
 RotorPerformance* qprop(Rotor* rotor, double Uinf, double Omega, double tol, int itmax, double rho, double mu, double a);
 
+//QPROP_SET_LOG_CALLBACK selects the function receiving the messages of the library
+//Input:
+//  - callback (QPropLogCallback): user function - set to NULL to print the messages on stdout
+//  - userdata (void*): pointer passed to each call of the callback
+//Output:
+//  - none
+//Notes:
+//  - the callback should be set before starting the analyses, not while other
+//    threads are using the library
+//  - the callback may be called concurrently by the threads of a parallel analysis
+//  - the solvers do not report anything from the inner iterations: the
+//    convergence of each call is reported once, and stored in the outputs
+void qprop_set_log_callback(QPropLogCallback callback, void* userdata);
+
+//QPROP_DEFAULT_OPTIONS returns the default options for qprop_ex
+//Input:
+//  - none
+//Output:
+//  - (QPropOptions): default options (tol=1e-6, itmax=100, Brent's method, 1 thread, no statistics)
+QPropOptions qprop_default_options(void);
+
+//QPROP_STATS_ENABLED checks if the library collects the statistics of the analyses
+//Input:
+//  - none
+//Output:
+//  - (bool): true if the library is compiled with QPROP_STATS defined
+//Notes:
+//  - the statistics are accumulated in the QPropStats pointed by options->stats,
+//    which must be zeroed by the caller before the first analysis
+//  - the counters are merged in a fixed order, so they do not depend on nthreads;
+//    the wall times of parallel analyses are summed over the threads
+//  - without QPROP_STATS, options->stats is ignored and the solver has no overhead
+bool qprop_stats_enabled(void);
+
+//QPROP_SINGLE_PRECISION checks if the library uses single precision in the solver kernels
+//Input:
+//  - none
+//Output:
+//  - (bool): true if the library is compiled with QPROP_SINGLE_PRECISION defined
+//Notes:
+//  - in single precision, the polars are interpolated from a float copy of the compiled tables,
+//    and the bisection method evaluates the blade elements in batches of float residuals
+//  - the roots of the bisection are refined with the double-precision residual, so the results
+//    meet the same tolerance of the double-precision build
+//  - T and Q are always integrated in double precision
+bool qprop_single_precision(void);
+
+//QPROP_FAST_MATH checks if the residual functions use fast approximations of sin, cos, atan, exp and acos
+//Input:
+//  - none
+//Output:
+//  - (bool): true if the library is compiled with QPROP_FAST_MATH defined
+//Notes:
+//  - the approximations are polynomials tuned to the arguments of the residual functions, with
+//    maximum errors below 1e-13, so the results match the build without the flag within the solver tolerance
+//  - the functions of libm are used everywhere else (geometry, sensitivities, polar models)
+bool qprop_fast_math(void);
+
+//QPROP_EX runs the QProp algorithm with user-defined options
+//Input:
+//  - rotor (Rotor*): pointer to a rotor
+//  - Uinf (double): freestream velocity in m/s
+//  - Omega (double): rotor speed in rad/s
+//  - rho (double): air density in kg/m3 (suggested value: 1.225)
+//  - mu (double): air dynamic viscosity in Pa-s (suggested value: 1.81e-5)
+//  - a (double): speed of sound in m/s (suggested value: 340.0) - set to 0 to disable Mach correction
+//  - options (QPropOptions*): pointer to the solver options - set to NULL to use the default ones
+//Output:
+//  - (RotorPerformance*): pointer to the QProp outputs, or NULL on errors
+//Notes:
+//  - the number of residual evaluations used by each element is stored in the
+//    output array nevals
+//  - the convergence is reported in status and converged, as in qprop(...)
+//  - qprop(...) is equivalent to qprop_ex(...) with the bisection method
+//  - when options->nthreads > 1, the blade elements are solved in parallel;
+//    the results are identical for any number of threads
+//  - each thread solves at least 32 elements, so rotors with fewer than 64 elements
+//    are always solved serially
+//  - multithreading requires the library to be compiled with QPROP_THREADS
+//    defined, otherwise options->nthreads is ignored
+RotorPerformance* qprop_ex(Rotor* rotor, double Uinf, double Omega, double rho, double mu, double a, const QPropOptions* options);
+
+//ALLOC_ROTOR_PERFORMANCE allocates a QProp output that can be reused by qprop_into
+//Input:
+//  - rotor (Rotor*): pointer to the rotor that will be analyzed
+//  - totals_only (bool): if true, only T, Q, CT, CP and J are computed
+//Output:
+//  - (RotorPerformance*): pointer to the allocated QProp output
+//Notes:
+//  - all the per-element arrays are allocated in a single contiguous block
+//  - in totals-only mode, the per-element distributions (Gamma, lambdaw, r, W,
+//    phi, dTdr and dQdr) are not available and their pointers are set to NULL;
+//    residuals and nevals are always available
+//  - It is the caller's responsibility to free this memory when it is no longer
+//    needed, by calling free_rotor_performance(RotorPerformance*)
+RotorPerformance* alloc_rotor_performance(Rotor* rotor, bool totals_only);
+
+//QPROP_INTO runs the QProp algorithm and stores the results in a previously allocated output
+//Input:
+//  - perf (RotorPerformance*): pointer to an output allocated by alloc_rotor_performance
+//  - rotor (Rotor*): pointer to a rotor - same number of sections used in the allocation
+//  - Uinf (double): freestream velocity in m/s
+//  - Omega (double): rotor speed in rad/s
+//  - rho (double): air density in kg/m3 (suggested value: 1.225)
+//  - mu (double): air dynamic viscosity in Pa-s (suggested value: 1.81e-5)
+//  - a (double): speed of sound in m/s (suggested value: 340.0) - set to 0 to disable Mach correction
+//  - options (QPropOptions*): pointer to the solver options - set to NULL to use the default ones
+//Output:
+//  - (bool): true if all the blade elements converged
+//Notes:
+//  - no memory is allocated, so it can be called repeatedly in optimization loops
+//  - the content of perf is overwritten at each call
+bool qprop_into(RotorPerformance* perf, Rotor* rotor, double Uinf, double Omega, double rho, double mu, double a, const QPropOptions* options);
+
+//QPROP_SWEEP runs the QProp algorithm over multiple operating points
+//Input:
+//  - rotor (Rotor*): pointer to a rotor
+//  - Uinf (array of double): freestream velocities in m/s
+//  - Omega (array of double): rotor speeds in rad/s - same size as Uinf
+//  - npoints (int): number of operating points
+//  - rho (double): air density in kg/m3 (suggested value: 1.225)
+//  - mu (double): air dynamic viscosity in Pa-s (suggested value: 1.81e-5)
+//  - a (double): speed of sound in m/s (suggested value: 340.0) - set to 0 to disable Mach correction
+//  - options (QPropOptions*): pointer to the solver options - set to NULL to use the default ones
+//Output:
+//  - (RotorPerformance**): array of npoints pointers to the QProp outputs
+//Notes:
+//  - the operating points are solved in the given order: the psi values found at
+//    one point are used as initial guesses for the next one, with a narrow
+//    bracket that is widened only when needed. Neighbouring points should
+//    therefore be close to each other (e.g. a performance curve)
+//  - the points that did not converge have status QPROP_ERROR_NOT_CONVERGED;
+//    the entries are set to NULL only on errors
+//  - when options->nthreads > 1, chunks of consecutive points are solved in
+//    parallel; the chunks do not depend on nthreads, so neither do the results
+//  - It is the caller's responsibility to free the outputs when they are no
+//    longer needed, by calling free_rotor_performances(perfs, npoints)
+RotorPerformance** qprop_sweep(Rotor* rotor, const double* Uinf, const double* Omega, int npoints, double rho, double mu, double a, const QPropOptions* options);
+
+//QPROP_BATCH runs the QProp algorithm over a batch of operating points,
+//storing only the overall performance in caller-provided arrays
+//Input:
+//  - rotor (Rotor*): pointer to a rotor
+//  - npoints (int): number of operating points
+//  - Uinf (array of double): freestream velocities in m/s
+//  - Omega (array of double): rotor speeds in rad/s - same size as Uinf
+//  - rho (array of double): air densities in kg/m3 - set to NULL to use 1.225 for all the points
+//  - mu (array of double): air dynamic viscosities in Pa-s - set to NULL to use 1.81e-5 for all the points
+//  - a (double): speed of sound in m/s (suggested value: 340.0) - set to 0 to disable Mach correction
+//  - options (QPropOptions*): pointer to the solver options - set to NULL to use the default ones
+//  - T, Q, CT, CP, J (arrays of double): outputs of each point (thrust, torque,
+//    thrust coefficient, power coefficient, advance ratio) - set to NULL the unneeded ones
+//  - converged (array of bool): true if all the blade elements of the point converged - can be NULL
+//Output:
+//  - (bool): true if all the operating points converged
+//Notes:
+//  - no output is allocated, so a whole sweep costs a single call from the bindings
+//  - the points are solved like in qprop_sweep (warm started chunks, in parallel)
+bool qprop_batch(Rotor* rotor, int npoints, const double* Uinf, const double* Omega, const double* rho, const double* mu, double a,
+                 const QPropOptions* options, double* T, double* Q, double* CT, double* CP, double* J, bool* converged);
+
+//ALLOC_ROTOR_GRADIENTS allocates the sensitivities of a rotor, to be filled by qprop_with_gradients
+//Input:
+//  - rotor (Rotor*): pointer to the rotor that will be analyzed
+//Output:
+//  - (RotorGradients*): pointer to the allocated sensitivities
+//Notes:
+//  - all the arrays are allocated in a single contiguous block
+//  - It is the caller's responsibility to free this memory when it is no longer
+//    needed, by calling free_rotor_gradients(RotorGradients*)
+RotorGradients* alloc_rotor_gradients(Rotor* rotor);
+
+//QPROP_WITH_GRADIENTS runs the QProp algorithm and computes the derivatives of thrust and torque
+//with respect to the chord and twist of each section, the freestream velocity and the rotor speed
+//Input:
+//  - rotor (Rotor*): pointer to a rotor
+//  - Uinf (double): freestream velocity in m/s
+//  - Omega (double): rotor speed in rad/s
+//  - rho (double): air density in kg/m3 (suggested value: 1.225)
+//  - mu (double): air dynamic viscosity in Pa-s (suggested value: 1.81e-5)
+//  - a (double): speed of sound in m/s (suggested value: 340.0) - set to 0 to disable Mach correction
+//  - options (QPropOptions*): pointer to the solver options - set to NULL to use the default ones
+//  - gradients (RotorGradients*): output, sensitivities allocated by alloc_rotor_gradients(rotor)
+//Output:
+//  - (RotorPerformance*): pointer to the QProp outputs, as in qprop_ex(...), or NULL on errors
+//Notes:
+//  - the residual of each element is differentiated analytically at its solution
+//    (implicit function theorem), so the gradients cost about one extra residual
+//    evaluation per element instead of one or two additional analyses per design variable
+//  - the polars are interpolated linearly, so thrust and torque are only piecewise
+//    smooth: at the polar breakpoints the derivatives are one-sided
+//  - the elements that did not converge do not contribute to the derivatives
+RotorPerformance* qprop_with_gradients(Rotor* rotor, double Uinf, double Omega, double rho, double mu, double a,
+                                       const QPropOptions* options, RotorGradients* gradients);
+
+//QPROP_TRIM finds the rotor speed or the collective pitch that gives a target thrust, torque or power
+//Input:
+//  - rotor (Rotor*): pointer to a rotor
+//  - Uinf (double): freestream velocity in m/s
+//  - Omega (double): rotor speed in rad/s - initial guess when variable is QPROP_TRIM_OMEGA
+//  - rho (double): air density in kg/m3 (suggested value: 1.225)
+//  - mu (double): air dynamic viscosity in Pa-s (suggested value: 1.81e-5)
+//  - a (double): speed of sound in m/s (suggested value: 340.0) - set to 0 to disable Mach correction
+//  - options (QPropOptions*): pointer to the solver options - set to NULL to use the default ones
+//  - target (QPropTrimTarget): quantity to be matched (thrust, torque or power)
+//  - value (double): required value of the target quantity (N, N-m or W)
+//  - variable (QPropTrimVariable): variable to be adjusted (rotor speed or collective pitch)
+//  - trimmed (double*): output, trimmed rotor speed (rad/s) or pitch offset (rad) - can be NULL
+//Output:
+//  - (RotorPerformance*): pointer to the QProp outputs at the trimmed point, or NULL on errors
+//Notes:
+//  - Newton iterations on the variable, with the derivative given by the analytic
+//    sensitivities of qprop_with_gradients; the psi of each element is warm started
+//    from the previous iteration, so a trim usually costs a few cheap analyses
+//  - the trim converges when |F - value| <= options->tol * max(|value|, 1), and
+//    performs at most options->itmax iterations; otherwise status is set to
+//    QPROP_ERROR_NOT_CONVERGED and the outputs of the last iteration are returned
+//  - the steps are limited to a factor 2 on Omega and to 0.1 rad on the pitch
+//  - the pitch offset is applied to a temporary copy of the sections: the rotor is not modified
+//  - It is the caller's responsibility to free this memory when it is no longer
+//    needed, by calling free_rotor_performance(RotorPerformance*)
+RotorPerformance* qprop_trim(Rotor* rotor, double Uinf, double Omega, double rho, double mu, double a, const QPropOptions* options,
+                             QPropTrimTarget target, double value, QPropTrimVariable variable, double* trimmed);
+
+//ALLOC_QPROP_CACHE allocates a cache of operating points, to be used by qprop_cached
+//Input:
+//  - capacity (int): maximum number of cached operating points
+//  - resolution (double): relative resolution of the operating conditions considered close
+//    to each other (suggested value: 1e-3) - set to 0 to reuse only identical conditions
+//  - distributions (bool): if true, the per-element distributions are cached too
+//Output:
+//  - (QPropCache*): pointer to the allocated cache, or NULL on errors
+//Notes:
+//  - the cache can be shared by multiple rotors and multiple threads: the entries are
+//    split in independently locked shards, and no lock is held during the analyses
+//  - the least recently used entries are replaced when a shard is full
+//  - It is the caller's responsibility to free this memory when it is no longer
+//    needed, by calling free_qprop_cache(QPropCache*)
+QPropCache* alloc_qprop_cache(int capacity, double resolution, bool distributions);
+
+//QPROP_CACHE_ATTACH computes the key identifying a rotor in an operating point cache
+//Input:
+//  - cache (QPropCache*): pointer to a cache allocated by alloc_qprop_cache
+//  - rotor (Rotor*): pointer to a rotor
+//Output:
+//  - (uint64_t): key of the rotor, to be passed to qprop_cached - 0 on errors
+//Notes:
+//  - the key is a fingerprint of the rotor geometry and of its airfoil data; the airfoil data
+//    are hashed only here, so that the cache lookups of qprop_cached do not depend on their size
+//  - qprop_cached hashes the geometry (diameter, blades and sections) again on each call, so the
+//    rotor geometry can be modified without computing the key again; the key must be computed
+//    again after the airfoils are modified, otherwise the cache returns the results of the old ones
+//  - the rotors with the same geometry and airfoil data have the same key, and share the entries
+uint64_t qprop_cache_attach(QPropCache* cache, const Rotor* rotor);
+
+//QPROP_CACHED runs the QProp algorithm through an operating point cache
+//Input:
+//  - cache (QPropCache*): pointer to a cache allocated by alloc_qprop_cache
+//  - rotorkey (uint64_t): key of the rotor returned by qprop_cache_attach
+//  - perf (RotorPerformance*): pointer to an output allocated by alloc_rotor_performance
+//  - rotor (Rotor*): pointer to a rotor - same number of sections used in the allocation of perf
+//  - Uinf (double): freestream velocity in m/s
+//  - Omega (double): rotor speed in rad/s
+//  - rho (double): air density in kg/m3 (suggested value: 1.225)
+//  - mu (double): air dynamic viscosity in Pa-s (suggested value: 1.81e-5)
+//  - a (double): speed of sound in m/s (suggested value: 340.0) - set to 0 to disable Mach correction
+//  - options (QPropOptions*): pointer to the solver options - set to NULL to use the default ones
+//Output:
+//  - (bool): true if all the blade elements converged
+//Notes:
+//  - the entries are identified by the rotor key and the options tol, itmax and solver,
+//    together with the quantized operating conditions
+//  - exact hits (identical conditions) are copied into perf without running the solver
+//    nor allocating memory;
+//    when perf needs the distributions and the cache does not store them, and for near hits
+//    (conditions within the resolution), the analysis is run with psi warm started from the entry
+//  - warm started analyses agree with the cold ones within the tolerance options->tol
+bool qprop_cached(QPropCache* cache, uint64_t rotorkey, RotorPerformance* perf, Rotor* rotor, double Uinf, double Omega,
+                  double rho, double mu, double a, const QPropOptions* options);
+
+//QPROP_CACHE_STATS returns the counters of an operating point cache
+//Input:
+//  - cache (QPropCache*): pointer to a cache allocated by alloc_qprop_cache
+//Output:
+//  - (QPropCacheStats): hits, warm starts, misses, evictions and number of entries
+QPropCacheStats qprop_cache_stats(QPropCache* cache);
+
+//GENERATE_ROTOR_MAP computes a performance map of a rotor on a grid of advance ratios and rotor speeds
+//Input:
+//  - rotor (Rotor*): pointer to a rotor
+//  - J (array of double): advance ratios in strictly ascending order
+//  - nJ (int): number of advance ratios (at least 2)
+//  - Omega (array of double): rotor speeds in rad/s, positive and in strictly ascending order
+//  - nOmega (int): number of rotor speeds (at least 2)
+//  - rho (double): air density in kg/m3 (suggested value: 1.225)
+//  - mu (double): air dynamic viscosity in Pa-s (suggested value: 1.81e-5)
+//  - a (double): speed of sound in m/s (suggested value: 340.0) - set to 0 to disable Mach correction
+//  - options (QPropOptions*): pointer to the solver options - set to NULL to use the default ones
+//Output:
+//  - (RotorMap*): pointer to the performance map, or NULL on errors
+//Notes:
+//  - the grid is solved with qprop_batch, so the consecutive advance ratios are warm
+//    started and options->nthreads threads are used
+//  - the centers of the cells are solved too, and the largest differences from the
+//    interpolated CT and CP are stored in errCT and errCP
+//  - the grid points that did not converge are counted in nfailed
+//  - It is the caller's responsibility to free this memory when it is no longer
+//    needed, by calling free_rotor_map(RotorMap*)
+RotorMap* generate_rotor_map(Rotor* rotor, const double* J, int nJ, const double* Omega, int nOmega, double rho, double mu, double a,
+                             const QPropOptions* options);
+
+//LOOKUP_ROTOR_MAP interpolates a performance map
+//Input:
+//  - map (RotorMap*): pointer to a performance map
+//  - Uinf (double): freestream velocity in m/s
+//  - Omega (double): rotor speed in rad/s
+//  - rho (double): air density in kg/m3
+//Output:
+//  - (RotorMapPoint): thrust, torque, CT, CP and J at the operating point
+//Notes:
+//  - CT and CP are interpolated bilinearly in (J, Omega), then T and Q are computed
+//    at the given Omega and rho; the Reynolds number effects of a different rho are neglected
+//  - the queries outside the map are clamped to its edges, reported by inside = false
+//  - no memory is allocated and no lock is taken, so it can be called from real-time loops
+RotorMapPoint lookup_rotor_map(const RotorMap* map, double Uinf, double Omega, double rho);
+
+//SAVE_ROTOR_MAP_BINARY saves a performance map in a compact binary file
+//Input:
+//  - map (RotorMap*): pointer to a performance map
+//  - filename (array of char): name of the binary file to be written
+//Output:
+//  - (bool): true if the file was written successfully
+//Notes:
+//  - the file is written in the native byte order, so it can only be loaded
+//    on machines with the same architecture
+bool save_rotor_map_binary(const RotorMap* map, const char* filename);
+
+//LOAD_ROTOR_MAP_BINARY loads a performance map from a binary file written by save_rotor_map_binary
+//Input:
+//  - filename (array of char): name of the binary file
+//Output:
+//  - (RotorMap*): pointer to the loaded performance map, or NULL if the file is not valid
+//Notes:
+//  - the file is memory-mapped and used without copies, as in load_airfoil_binary(...)
+//  - free_rotor_map(RotorMap*) releases the mapping when the map is no longer needed
+RotorMap* load_rotor_map_binary(const char* filename);
+
+//QPROP_FLEET runs the QProp algorithm for multiple rotors at the same operating points
+//Input:
+//  - rotors (array of Rotor*): pointers to the rotors, e.g. a catalog of propellers
+//  - nrotors (int): number of rotors
+//  - npoints (int): number of operating points
+//  - Uinf (array of double): freestream velocities in m/s
+//  - Omega (array of double): rotor speeds in rad/s - same size as Uinf
+//  - rho (array of double): air densities in kg/m3 - set to NULL to use 1.225 for all the points
+//  - mu (array of double): air dynamic viscosities in Pa-s - set to NULL to use 1.81e-5 for all the points
+//  - a (double): speed of sound in m/s (suggested value: 340.0) - set to 0 to disable Mach correction
+//  - options (QPropOptions*): pointer to the solver options - set to NULL to use the default ones
+//Output:
+//  - (FleetResults*): pointer to the columnar results of all the rotors at all the points, or NULL on errors
+//Notes:
+//  - the airfoils with identical polars are shared by all the rotors, even when they were
+//    imported separately for each rotor; the rotors and their airfoils are not modified
+//  - the points of each rotor are solved like in qprop_batch (warm started chunks), so the
+//    results are the same as calling qprop_batch for each rotor
+//  - when options->nthreads > 1, the (rotor, chunk) work items are shared among the threads
+//    one at a time, starting from the most expensive ones; the results do not depend on nthreads
+//  - It is the caller's responsibility to free this memory when it is no longer
+//    needed, by calling free_fleet_results(FleetResults*)
+FleetResults* qprop_fleet(Rotor** rotors, int nrotors, int npoints, const double* Uinf, const double* Omega,
+                          const double* rho, const double* mu, double a, const QPropOptions* options);
+
+//OPEN_QPROP_SINK opens a file where the results of many operating points are streamed
+//Input:
+//  - filename (array of char): name of the file to be written
+//  - format (QPropSinkFormat): QPROP_SINK_CSV or QPROP_SINK_BINARY
+//  - nelems (int): number of blade elements of the distributions r, W, phi, Gamma, dTdr and dQdr
+//    - set to 0 to write only the totals Uinf, Omega, T, Q, CT, CP, J and converged
+//  - batchsize (int): number of points buffered in memory before they are written (suggested value: 1024)
+//Output:
+//  - (QPropSink*): pointer to the sink, or NULL on errors
+//Notes:
+//  - the buffer holds batchsize points, rounded up to a multiple of 16, so the memory used
+//    does not depend on the number of points written
+//  - the CSV files have one column for each element of the distributions (r_1, r_2, ...)
+//  - the binary files are little-endian on all the machines: after a 64-byte header and a table
+//    of 16-byte column entries (zero-padded name, int32 width), each record batch stores its
+//    number of rows (int64) followed by the columns of doubles, each a contiguous block of
+//    rows*width values (see read_qprop_sink in the Python and Julia bindings)
+//  - the sink is not thread safe, and the file is complete only after close_qprop_sink(QPropSink*)
+QPropSink* open_qprop_sink(const char* filename, QPropSinkFormat format, int nelems, int batchsize);
+
+//QPROP_SINK_WRITE writes the results of one operating point to a sink
+//Input:
+//  - sink (QPropSink*): pointer to a sink opened by open_qprop_sink
+//  - perf (RotorPerformance*): pointer to the qprop output of the point - it must have
+//    the distributions when the sink has them, with the same number of elements
+//  - Uinf (double): freestream velocity of the point in m/s
+//  - Omega (double): rotor speed of the point in rad/s
+//Output:
+//  - (bool): false if the arguments are not valid or if the file could not be written
+bool qprop_sink_write(QPropSink* sink, const RotorPerformance* perf, double Uinf, double Omega);
+
+//CLOSE_QPROP_SINK writes the buffered points of a sink, completes its file and frees the sink
+//Input:
+//  - sink (QPropSink*): pointer to a sink opened by open_qprop_sink
+//Output:
+//  - (bool): true if all the points were written successfully
+bool close_qprop_sink(QPropSink* sink);
+
+//QPROP_STREAM runs the QProp algorithm over a batch of operating points, streaming the results to a sink
+//Input:
+//  - rotor (Rotor*): pointer to a rotor - nsections-1 elements if the sink has the distributions
+//  - npoints (int): number of operating points
+//  - Uinf (array of double): freestream velocities in m/s
+//  - Omega (array of double): rotor speeds in rad/s - same size as Uinf
+//  - rho (array of double): air densities in kg/m3 - set to NULL to use 1.225 for all the points
+//  - mu (array of double): air dynamic viscosities in Pa-s - set to NULL to use 1.81e-5 for all the points
+//  - a (double): speed of sound in m/s (suggested value: 340.0) - set to 0 to disable Mach correction
+//  - options (QPropOptions*): pointer to the solver options - set to NULL to use the default ones
+//  - sink (QPropSink*): pointer to a sink opened by open_qprop_sink
+//Output:
+//  - (bool): true if all the points converged and were written successfully
+//Notes:
+//  - the points are solved in blocks as large as the buffer of the sink, each written to the
+//    file before the next one starts; the rows are in the same order as the inputs
+//  - the blocks are split in warm started chunks like in qprop_batch, so the results are the
+//    same as qprop_batch and qprop_sweep, and do not depend on options->nthreads or on batchsize
+//  - it can be called multiple times on the same sink, e.g. for multiple rotors
+bool qprop_stream(Rotor* rotor, int npoints, const double* Uinf, const double* Omega, const double* rho, const double* mu, double a,
+                  const QPropOptions* options, QPropSink* sink);
@@ -28,6 +28,15 @@ int main() {
     else {
         printf("TEST 1.1 - FAILED :(\n");
     }
+
+    //test #2: find root of f1 in [-1,0] using Brent's method
+    double x2 = fzero_brent(f1, -1.0, 0.0, 1e-6, 100, NULL);
+    if (fabs(x2 + 0.5812517) < 1e-5) {
+        printf("TEST 1.2 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 1.2 - FAILED :(\n");
+    }
     
     return 0;
 }
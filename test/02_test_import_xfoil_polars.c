@@ -8,6 +8,7 @@
     Author: Andrea Pavan
     License: MIT
 *******************************************************************************/
+#include <locale.h>
 #include <stdio.h>
 #include "../src/qprop.c"
 
@@ -120,6 +121,93 @@ int main() {
         return 0;
     }
 
+    //test #6: parse a polar from a buffer in memory, without a trailing newline
+    const char buffer6[] =
+        " Calculated polar for: FX 63-120\n"
+        "\n"
+        " Mach =   0.000     Re =     0.150 e 6     Ncrit =   9.000\n"
+        "\n"
+        "   alpha    CL        CD       CDp       CM     Top_Xtr  Bot_Xtr\n"
+        "  ------ -------- --------- --------- -------- -------- --------\n"
+        "  -1.000   0.6815   0.01192   0.00563  -0.1795   0.7688   0.5419\n"
+        "   0.000   0.8022   0.01019   0.00422  -0.1836   0.7434   0.5993\n"
+        "   1.500   0.9534   1.25e-2   0.00435  -0.1860   0.7001   1.0000";
+    Polar* polar6 = read_xfoil_polar_from_buffer(buffer6, sizeof(buffer6)-1);
+    Polar* polar6empty = read_xfoil_polar_from_buffer(buffer6, 60);
+    if (polar6 && !polar6empty
+                && polar6->Re == 150000
+                && polar6->size == 3
+                && polar6->alpha[0] == deg2rad(-1.000)
+                && polar6->alpha[2] == deg2rad(1.500)
+                && polar6->CL[1] == 0.8022
+                && polar6->CD[2] == 0.0125) {
+        printf("TEST 2.6 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 2.6 - FAILED :(\n");
+    }
+    if (polar6) {
+        free_polar(polar6);
+    }
+
+    //test #7: import two airfoils at once, skipping a missing file and taking Re from the file names
+    const char* filenames7a[] = {
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.200_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.030_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.500_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.100_M0.00_N6.0.txt"
+    };
+    const char* filenames7b[] = {
+        "02_airfoil_polar_FX63-120_Re0.300_M0.00_N9.0.txt",
+        "02_missing_polar_Re0.100_M0.00_N9.0.txt"
+    };
+    const char** filenames7[] = {filenames7a, filenames7b};
+    const int number_of_files7[] = {4, 2};
+    bool loaded7[6];
+    Airfoil** airfoils7 = import_xfoil_polars_parallel(filenames7, number_of_files7, 2, true, 0, loaded7);
+    bool passed7 = (airfoils7 && airfoils7[0] && airfoils7[1]
+                    && airfoils7[0]->size == 4 && airfoils7[1]->size == 1
+                    && loaded7[0] && loaded7[1] && loaded7[2] && loaded7[3] && loaded7[4] && !loaded7[5]
+                    && airfoils7[0]->compiled && airfoils7[1]->compiled
+                    && airfoils7[1]->polars[0]->Re == polar1->Re
+                    && reynolds_number_from_filename("NACA 4412_T1_Re0.030_M0.00_N6.0.txt") == 30000
+                    && reynolds_number_from_filename("NACA 4412_T1.txt") == 0);
+    for (int j=0; passed7 && j<4; ++j) {
+        const Polar* polar = airfoils7[0]->polars[j];
+        const Polar* reference = airfoil5->polars[j];
+        passed7 = (polar->Re == reference->Re && polar->size == reference->size
+                   && memcmp(polar->CL, reference->CL, polar->size*sizeof(double)) == 0
+                   && memcmp(polar->CD, reference->CD, polar->size*sizeof(double)) == 0);
+    }
+    if (passed7) {
+        printf("TEST 2.7 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 2.7 - FAILED :(\n");
+    }
+    free_airfoils(airfoils7, 2);
+
+    //test #8: numbers with more than 19 digits are parsed in the same way when the locale uses a comma
+    //NOTE: the comma locales are optional, so only the "C" locale is checked when none is installed
+    const char number8[] = "0.12345678901234567890123";
+    const char* end8 = NULL;
+    double value8 = parse_number(number8, number8 + sizeof(number8)-1, &end8);
+    bool passed8 = (value8 == strtod(number8, NULL) && end8 == number8 + sizeof(number8)-1);
+    const char* locales8[] = {"de_DE.UTF-8", "de_DE.utf8", "it_IT.UTF-8", "it_IT.utf8", "fr_FR.UTF-8", "fr_FR.utf8"};
+    for (int k=0; k<6; ++k) {
+        if (setlocale(LC_NUMERIC, locales8[k])) {
+            passed8 = passed8 && (parse_number(number8, number8 + sizeof(number8)-1, &end8) == value8);
+            setlocale(LC_NUMERIC, "C");
+            break;
+        }
+    }
+    if (passed8) {
+        printf("TEST 2.8 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 2.8 - FAILED :(\n");
+    }
+
     free_polar(polar1);
     free_polar(polar2);
     free_airfoil(airfoil3);
@@ -94,6 +94,93 @@ int main() {
     }
     free(polarpoint5);
 
+    //test #6: allocation-free interpolation in between polars
+    PolarPoint polarpoint6;
+    interpolate_airfoil_polars_into(&polarpoint6, airfoil1, deg2rad(+4.5), 150000, 0.0);
+    if (fabs(polarpoint6.CL - 0.93785) <= 1e-6 && fabs(polarpoint6.CD - 0.015125) <= 1e-6) {
+        printf("TEST 3.6 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 3.6 - FAILED :(\n");
+        free_airfoil(airfoil1);
+        return 0;
+    }
+
+    //test #7: bracket search restarting from the previous hit gives the same results
+    InterpolationHint hint7 = {0};
+    bool passed7 = true;
+    for (int k=0; k<=400 && passed7; ++k) {
+        double alpha7 = deg2rad(-25.0 + 0.125*k);
+        double Re7 = 20000 + 1500*k;
+        PolarPoint polarpoint7a;
+        PolarPoint polarpoint7b;
+        interpolate_airfoil_polars_hint(&polarpoint7a, airfoil1, alpha7, Re7, 0.0, &hint7);
+        interpolate_airfoil_polars_into(&polarpoint7b, airfoil1, alpha7, Re7, 0.0);
+        if (polarpoint7a.CL != polarpoint7b.CL || polarpoint7a.CD != polarpoint7b.CD) {
+            passed7 = false;
+        }
+    }
+    if (passed7) {
+        printf("TEST 3.7 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 3.7 - FAILED :(\n");
+        free_airfoil(airfoil1);
+        return 0;
+    }
+
+    //test #8: direct indexing on a uniformly-spaced polar
+    double alpha8[41];
+    double CL8[41];
+    double CD8[41];
+    for (int i=0; i<41; ++i) {
+        alpha8[i] = deg2rad(-10.0 + 0.5*i);
+        CL8[i] = 0.4 + 2*PI*alpha8[i];
+        CD8[i] = 0.01 + alpha8[i]*alpha8[i];
+    }
+    Polar polar8 = {100000, alpha8, CL8, CD8, 41, 0.0};
+    update_polar_spacing(&polar8);
+    PolarPoint polarpoint8a;
+    PolarPoint polarpoint8b;
+    interpolate_polar_into(&polarpoint8a, &polar8, deg2rad(+2.3));
+    interpolate_polar_into(&polarpoint8b, &polar8, deg2rad(+2.5));
+    if (fabs(polar8.dalpha - deg2rad(0.5)) <= 1e-12
+            && fabs(polarpoint8a.CL - (0.4 + 2*PI*deg2rad(+2.3))) <= 1e-9
+            && polarpoint8b.CL == CL8[25] && polarpoint8b.CD == CD8[25]
+            && find_bracket(alpha8, 41, alpha8[25], polar8.dalpha, 0) == 25
+            && find_bracket(alpha8, 41, alpha8[25], 0.0, 0) == 25) {
+        printf("TEST 3.8 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 3.8 - FAILED :(\n");
+        free_airfoil(airfoil1);
+        return 0;
+    }
+
+    //test #9: the compiled polars interpolate to the same coefficients of the original polars
+    Airfoil airfoil9 = *airfoil1;
+    airfoil9.compiled = NULL;
+    bool passed9 = (airfoil1->compiled != NULL && airfoil1->compiled->nRe == 4);
+    for (int k=0; k<=720 && passed9; ++k) {
+        double alpha9 = deg2rad(-90.0 + 0.25*k);
+        double Re9 = 10000 + 1000*k;
+        PolarPoint polarpoint9a;
+        PolarPoint polarpoint9b;
+        interpolate_airfoil_polars_into(&polarpoint9a, airfoil1, alpha9, Re9, 0.0);
+        interpolate_airfoil_polars_into(&polarpoint9b, &airfoil9, alpha9, Re9, 0.0);
+        if (fabs(polarpoint9a.CL - polarpoint9b.CL) > 1e-12 || fabs(polarpoint9a.CD - polarpoint9b.CD) > 1e-12) {
+            passed9 = false;
+        }
+    }
+    if (passed9) {
+        printf("TEST 3.9 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 3.9 - FAILED :(\n");
+        free_airfoil(airfoil1);
+        return 0;
+    }
+
     free_airfoil(airfoil1);
     return 0;
 }
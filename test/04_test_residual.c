@@ -67,7 +67,10 @@ int main() {
         &tipelement,
         1.225,
         1.81e-5,
-        0.0
+        0.0,
+        0,                          //residual evaluations counter
+        {0},                        //interpolation hint
+        {false, 0, 0, 0, 0, 0, 0}   //element invariants (computed at the first evaluation)
     };
     ResidualOutput residual2;
     residual(&residual2, deg2rad(+45.0), &args2);
@@ -91,6 +94,48 @@ int main() {
     //      W = 73.65017452473688,
     //      Γ = 0.7753023257108531
 
+
+    //test #3: batched residual on three elements, with the second one masked out
+    ElementBatch batch3;
+    batch3.n = 3;
+    batch3.R = 0.5 * apc10x7sf->D;
+    batch3.B = apc10x7sf->B;
+    batch3.rho = 1.225;
+    batch3.mu = 1.81e-5;
+    batch3.a = 0.0;
+    const double psi3[QPROP_BATCH_SIZE] = {deg2rad(+45.0), deg2rad(+10.0), deg2rad(-20.0)};
+    const bool active3[QPROP_BATCH_SIZE] = {true, false, true};
+    for (int k=0; k<3; ++k) {
+        double r3 = tipelement.r - 0.02*k;
+        set_batch_element(&batch3, k, tipelement.c, tipelement.beta + 0.1*k, r3, tipelement.dr, Uinf, Omega*r3, naca4412);
+    }
+    ResidualOutput residual3[QPROP_BATCH_SIZE];
+    residual_batch(residual3, psi3, active3, &batch3);
+    bool passed3 = (batch3.nevals[0] == 1 && batch3.nevals[1] == 0 && batch3.nevals[2] == 1);
+    for (int k=0; k<3 && passed3; k+=2) {
+        Element element3 = {batch3.c[k], batch3.beta[k], batch3.r[k], batch3.dr[k], naca4412};
+        ResidualArgs args3 = args2;
+        args3.Ut = batch3.Ut[k];
+        args3.currentelement = &element3;
+        args3.inv.prepared = false;
+        ResidualOutput residual3ref;
+        residual(&residual3ref, psi3[k], &args3);
+        if (fabs(residual3[k].residual - residual3ref.residual) > 1e-12
+                || fabs(residual3[k].Cn - residual3ref.Cn) > 1e-12
+                || fabs(residual3[k].Ct - residual3ref.Ct) > 1e-12) {
+            passed3 = false;
+        }
+    }
+    if (passed3) {
+        printf("TEST 4.3 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 4.3 - FAILED :(\n");
+        free_rotor(apc10x7sf);
+        free_airfoil(naca4412);
+        return 0;
+    }
+
     free_rotor(apc10x7sf);
     free_airfoil(naca4412);
     return 0;
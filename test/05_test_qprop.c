@@ -12,6 +12,13 @@
 #include <stdio.h>
 #include "../src/qprop.c"
 
+//log callback counting the messages of each status
+void count_messages(QPropStatus status, const char* message, void* userdata) {
+    (void) message;
+    ((int*) userdata)[status] += 1;
+    //printf("%d: %s\n", status, message);
+}
+
 int main() {
     //load NACA-4412 polars
     const char* filenames1[10] = {
@@ -103,9 +110,129 @@ int main() {
     Uinf = 19.09445 m/s  -  Thrust = 1.1348963862887862 N  -  Torque = 0.05252953779296362 N-m
     */
 
+    //test #3: J = 0.05 using Brent's method
+    Uinf = 1.2729633333333334;
+    QPropOptions options3 = qprop_default_options();
+    options3.tol = tol;
+    options3.itmax = itmax;
+    RotorPerformance* perf3 = qprop_ex(apc10x7sf, Uinf, Omega, rho, mu, a, &options3);
+    int nevals1 = 0;
+    int nevals3 = 0;
+    for (int i=0; i<perf3->nelems; ++i) {
+        nevals1 += perf1->nevals[i];
+        nevals3 += perf3->nevals[i];
+    }
+    //printf("Residual evaluations: %i (bisection) - %i (Brent)\n", nevals1, nevals3);
+    if (fabs(perf3->T - 7.811303879404407) <= 1e-6 && fabs(perf3->Q - 0.14308075154669447) <= 1e-6 && nevals3 < nevals1) {
+        printf("TEST 5.3 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 5.3 - FAILED :(\n");
+        free_rotor(apc10x7sf);
+        free_airfoil(naca4412);
+        free_rotor_performance(perf1);
+        free_rotor_performance(perf2);
+        free_rotor_performance(perf3);
+        return 0;
+    }
+
+    //test #4: reuse the same output, with and without the per-element distributions
+    QPropOptions options4 = qprop_default_options();
+    RotorPerformance* perf4 = alloc_rotor_performance(apc10x7sf, false);
+    RotorPerformance* perf4totals = alloc_rotor_performance(apc10x7sf, true);
+    bool passed4 = (perf4 && perf4totals && perf4totals->dTdr == NULL && perf4totals->Gamma == NULL);
+    for (int k=0; k<3 && passed4; ++k) {
+        Uinf = 1.2729633333333334 * (1+k);
+        RotorPerformance* perf4ref = qprop_ex(apc10x7sf, Uinf, Omega, rho, mu, a, &options4);
+        if (!qprop_into(perf4, apc10x7sf, Uinf, Omega, rho, mu, a, &options4)
+                || !qprop_into(perf4totals, apc10x7sf, Uinf, Omega, rho, mu, a, &options4)
+                || !perf4ref
+                || perf4->T != perf4ref->T || perf4->Q != perf4ref->Q || perf4->dTdr[10] != perf4ref->dTdr[10]
+                || perf4totals->T != perf4ref->T || perf4totals->CP != perf4ref->CP) {
+            passed4 = false;
+        }
+        if (perf4ref) {
+            free_rotor_performance(perf4ref);
+        }
+    }
+    if (passed4) {
+        printf("TEST 5.4 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 5.4 - FAILED :(\n");
+    }
+    if (perf4) {
+        free_rotor_performance(perf4);
+    }
+    if (perf4totals) {
+        free_rotor_performance(perf4totals);
+    }
+
+    //test #5: an output that did not converge is returned with its status, and reported once
+    int nmessages5[5] = {0, 0, 0, 0, 0};
+    qprop_set_log_callback(count_messages, nmessages5);
+    RotorPerformance* perf5 = qprop(apc10x7sf, 1.2729633333333334, Omega, tol, 2, rho, mu, a);
+    RotorPerformance* perf5ok = qprop(apc10x7sf, 1.2729633333333334, Omega, tol, itmax, rho, mu, a);
+    qprop_set_log_callback(NULL, NULL);
+    bool passed5 = (perf5 && perf5ok
+                    && perf5->status == QPROP_ERROR_NOT_CONVERGED && perf5ok->status == QPROP_OK
+                    && nmessages5[QPROP_ERROR_NOT_CONVERGED] == 1 && nmessages5[QPROP_OK] == 0
+                    && isfinite(perf5->T) && isfinite(perf5->Q));
+    for (int i=0; passed5 && i<perf5->nelems; ++i) {
+        if (perf5->converged[i] != (fabs(perf5->residuals[i]) <= tol) || !perf5ok->converged[i]) {
+            passed5 = false;
+        }
+    }
+    if (passed5) {
+        printf("TEST 5.5 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 5.5 - FAILED :(\n");
+    }
+    if (perf5) {
+        free_rotor_performance(perf5);
+    }
+    if (perf5ok) {
+        free_rotor_performance(perf5ok);
+    }
+
+    //test #6: the sections pushed with an unsorted, uncompiled airfoil share a single sorted copy
+    Airfoil* unsorted6 = calloc(1, sizeof(Airfoil));
+    unsorted6->polars = calloc(10, sizeof(Polar*));
+    unsorted6->refcount = 1;
+    for (int j=0; j<10; ++j) {
+        unsorted6->polars[j] = read_xfoil_polar_from_file(filenames1[9-j]);
+        unsorted6->size += 1;
+    }
+    Rotor* rotor6 = calloc(1, sizeof(Rotor));
+    rotor6->D = apc10x7sf->D;
+    rotor6->B = apc10x7sf->B;
+    for (int i=0; i<apc10x7sf->nsections; ++i) {
+        Section* section6 = &(apc10x7sf->sections[i]);
+        push_rotor_section(rotor6, section6->c, section6->beta, section6->r, unsorted6);
+    }
+    bool passed6 = (rotor6->nairfoils == 1 && rotor6->airfoils[0] != unsorted6 && !rotor_needs_blending(rotor6)
+                    && !unsorted6->compiled && !airfoil_polars_sorted(unsorted6)
+                    && save_rotor_binary(rotor6, "05_unsorted.bin"));
+    RotorPerformance* perf6 = qprop(rotor6, 1.2729633333333334, Omega, tol, itmax, rho, mu, a);
+    //printf("%f %f %d\n", perf6->T, perf1->T, rotor6->nairfoils);
+    if (passed6 && perf6 && perf6->status == QPROP_OK && fabs(perf6->T - perf1->T) <= 1e-9*fabs(perf1->T)) {
+        printf("TEST 5.6 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 5.6 - FAILED :(\n");
+    }
+    if (perf6) {
+        free_rotor_performance(perf6);
+    }
+    remove("05_unsorted.bin");
+    free_rotor(rotor6);
+    free_airfoil(unsorted6);
+
     free_rotor(apc10x7sf);
     free_airfoil(naca4412);
     free_rotor_performance(perf1);
     free_rotor_performance(perf2);
+    free_rotor_performance(perf3);
     return 0;
 }
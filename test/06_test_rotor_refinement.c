@@ -1,5 +1,6 @@
 /*******************************************************************************
-    Testing program for the refine_rotor_sections() function
+    Testing program for the refine_rotor_sections(), copy_rotor() and
+    blend_rotor_airfoils() functions, with uniform, clustered and adaptive spacing
 
     How to run:
     gcc 06_test_rotor_refinement.c -o 06_test_rotor_refinement -lm -Wall -Wextra
@@ -121,10 +122,225 @@ int main() {
         return 0;
     }
 
+    //test #5: copies share the airfoil table, which is released by the last owner
+    Rotor* rotor5 = copy_rotor(rotor2);
+    bool passed5 = (rotor5 && rotor5->nsections == rotor2->nsections && rotor5->nairfoils == 1
+                    && rotor5->airfoils[0] == naca4412 && apc10x7sf->nairfoils == 1
+                    && naca4412->refcount == 5
+                    && rotor5->sections[7].c == rotor2->sections[7].c);
+    free_airfoil(naca4412);         //the airfoil is still used by the rotors
+    RotorPerformance* perf5 = (passed5)? qprop(rotor5, Uinf, Omega, tol, itmax, rho, mu, a) : NULL;
+    if (perf5 && perf5->T == perf2->T && naca4412->refcount == 4) {
+        printf("TEST 6.5 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 6.5 - FAILED :(\n");
+    }
+    if (perf5) {
+        free_rotor_performance(perf5);
+    }
+    if (rotor5) {
+        free_rotor(rotor5);
+    }
+
+
+    //test #6: spanwise blending of two airfoils
+    Airfoil* analytic6 = analytic_polar_curves(0.50, 5.8, -0.3, 1.2, 0.028, 0.050, 0.020, 0.5, 70000, -0.7);
+    Airfoil* blended6 = blend_airfoils(naca4412, analytic6, 0.3);
+    bool passed6 = (blended6 != NULL);
+    for (int k=0; k<40 && passed6; ++k) {
+        double alpha6 = deg2rad(-30.0 + 1.7*k);
+        double Re6 = 20000 + 15000*k;
+        PolarPoint point1, point2, point6;
+        interpolate_airfoil_polars_into(&point1, naca4412, alpha6, Re6, 0.0);
+        interpolate_airfoil_polars_into(&point2, analytic6, alpha6, Re6, 0.0);
+        interpolate_airfoil_polars_into(&point6, blended6, alpha6, Re6, 0.0);
+        if (fabs(point6.CL - (0.7*point1.CL + 0.3*point2.CL)) > 1e-12
+                || fabs(point6.CD - (0.7*point1.CD + 0.3*point2.CD)) > 1e-12) {
+            passed6 = false;
+        }
+    }
+    //use the analytic airfoil on the outer half of the blade
+    Rotor* rotor6 = copy_rotor(apc10x7sf);
+    int analytic6_idx = rotor_airfoil_index(rotor6, analytic6);
+    for (int i=rotor6->nsections/2; i<rotor6->nsections; ++i) {
+        rotor6->sections[i].airfoil = analytic6_idx;
+    }
+    Rotor* rotor6b = copy_rotor(rotor6);
+    passed6 = passed6 && blend_rotor_airfoils(rotor6b) && rotor6b->nairfoils == 3 && !rotor6->elementairfoils;
+    Airfoil* elementairfoil6 = (passed6)? rotor6b->elementairfoils[rotor6b->nsections/2 - 1] : NULL;
+    //blending again reuses the blends already in the airfoil table
+    passed6 = passed6 && blend_rotor_airfoils(rotor6b) && blend_rotor_airfoils(rotor6b) && rotor6b->nairfoils == 3
+              && rotor6b->elementairfoils[rotor6b->nsections/2 - 1] == elementairfoil6;
+    Rotor* rotor6c = refine_rotor_sections(rotor6, 30);
+    passed6 = passed6 && rotor6c && rotor6c->elementairfoils;
+    RotorPerformance* perf6 = qprop(rotor6, Uinf, Omega, tol, itmax, rho, mu, a);
+    RotorPerformance* perf6b = qprop(rotor6b, Uinf, Omega, tol, itmax, rho, mu, a);
+    RotorPerformance* perf6c = (rotor6c)? qprop(rotor6c, Uinf, Omega, tol, itmax, rho, mu, a) : NULL;
+    //printf("Thrust (blended on the fly): %f N\n", perf6->T);
+    //printf("Thrust (precomputed blends): %f N\n", perf6b->T);
+    //printf("Thrust (refined): %f N\n", perf6c->T);
+    if (passed6 && perf6 && perf6b && perf6c
+            && perf6->T == perf6b->T
+            && fabs(perf6c->T - perf6->T) <= 0.05*fabs(perf6->T)
+            && perf6->T != perf1->T) {
+        printf("TEST 6.6 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 6.6 - FAILED :(\n");
+    }
+    if (perf6) {
+        free_rotor_performance(perf6);
+    }
+    if (perf6b) {
+        free_rotor_performance(perf6b);
+    }
+    if (perf6c) {
+        free_rotor_performance(perf6c);
+    }
+    if (rotor6c) {
+        free_rotor(rotor6c);
+    }
+    free_rotor(rotor6);
+    free_rotor(rotor6b);
+    if (blended6) {
+        free_airfoil(blended6);
+    }
+    free_airfoil(analytic6);
+
+    //test #7: cosine and tip-clustered spacing
+    Rotor* rotor7a = refine_rotor_sections_ex(apc10x7sf, 20, QPROP_SPACING_COSINE);
+    Rotor* rotor7b = refine_rotor_sections_ex(apc10x7sf, 20, QPROP_SPACING_TIP);
+    double rhub = apc10x7sf->sections[0].r;
+    double rtip = apc10x7sf->sections[apc10x7sf->nsections-1].r;
+    double dr7 = (rtip - rhub) / 19;
+    bool passed7 = (rotor7a && rotor7b && rotor7a->nsections == 20 && rotor7b->nsections == 20);
+    for (int i=0; i<19 && passed7; ++i) {
+        if (rotor7a->sections[i+1].r <= rotor7a->sections[i].r || rotor7b->sections[i+1].r <= rotor7b->sections[i].r) {
+            passed7 = false;
+        }
+    }
+    if (passed7
+            && fabs(rotor7a->sections[0].r - rhub) <= 1e-12 && fabs(rotor7a->sections[19].r - rtip) <= 1e-12
+            && fabs(rotor7b->sections[0].r - rhub) <= 1e-12 && fabs(rotor7b->sections[19].r - rtip) <= 1e-12
+            && rotor7a->sections[1].r - rotor7a->sections[0].r < dr7
+            && rotor7a->sections[19].r - rotor7a->sections[18].r < dr7
+            && rotor7b->sections[1].r - rotor7b->sections[0].r > dr7
+            && rotor7b->sections[19].r - rotor7b->sections[18].r < dr7) {
+        printf("TEST 6.7 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 6.7 - FAILED :(\n");
+    }
+    if (rotor7a) {
+        free_rotor(rotor7a);
+    }
+    if (rotor7b) {
+        free_rotor(rotor7b);
+    }
+
+    //test #8: adaptive refinement against a very fine equally-spaced discretization
+    Rotor* rotor8ref = refine_rotor_sections(apc10x7sf, 1000);
+    Rotor* rotor8 = refine_rotor_sections_adaptive(apc10x7sf, Uinf, Omega, rho, mu, a, 1e-4, 400, NULL);
+    RotorPerformance* perf8ref = qprop(rotor8ref, Uinf, Omega, tol, itmax, rho, mu, a);
+    RotorPerformance* perf8 = (rotor8)? qprop(rotor8, Uinf, Omega, tol, itmax, rho, mu, a) : NULL;
+    //printf("Sections: %i\n", rotor8->nsections);
+    //printf("Thrust error: %e\n", fabs(perf8->T - perf8ref->T) / perf8ref->T);
+    //printf("Torque error: %e\n", fabs(perf8->Q - perf8ref->Q) / perf8ref->Q);
+    if (perf8 && perf8ref
+            && rotor8->nsections < 100
+            && fabs(perf8->T - perf8ref->T) <= 1e-4*perf8ref->T
+            && fabs(perf8->Q - perf8ref->Q) <= 1e-4*perf8ref->Q) {
+        printf("TEST 6.8 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 6.8 - FAILED :(\n");
+    }
+    if (perf8) {
+        free_rotor_performance(perf8);
+    }
+    if (rotor8) {
+        free_rotor(rotor8);
+    }
+    free_rotor_performance(perf8ref);
+    free_rotor(rotor8ref);
+
+    //test #9: refined sections between the same pair of airfoils share their blends
+    //NOTE: the sections alternate between two airfoils at dyadic radii, so the blend weights of the refined
+    //      sections are exact and they repeat in each interval: 2 airfoils + 3 section blends + 4 element blends
+    Airfoil* analytic9 = analytic_polar_curves(0.50, 5.8, -0.3, 1.2, 0.028, 0.050, 0.020, 0.5, 70000, -0.7);
+    Rotor* rotor9 = calloc(1, sizeof(Rotor));
+    rotor9->D = 1.0;
+    rotor9->B = 2;
+    for (int i=0; i<4; ++i) {
+        push_rotor_section(rotor9, 0.03, 0.3, 0.125*(i+1), (i%2 == 0)? naca4412 : analytic9);
+    }
+    Rotor* rotor9refined = refine_rotor_sections(rotor9, 13);
+    RotorPerformance* perf9 = (rotor9refined)? qprop(rotor9refined, Uinf, Omega, tol, itmax, rho, mu, a) : NULL;
+    if (perf9 && rotor9refined->nairfoils == 9 && rotor9refined->elementairfoils
+            && rotor9refined->elementairfoils[0] == rotor9refined->elementairfoils[8]
+            && rotor9refined->elementairfoils[0] == rotor9refined->elementairfoils[7]) {
+        printf("TEST 6.9 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 6.9 - FAILED :(\n");
+    }
+    if (perf9) {
+        free_rotor_performance(perf9);
+    }
+    if (rotor9refined) {
+        free_rotor(rotor9refined);
+    }
+    free_rotor(rotor9);
+    free_airfoil(analytic9);
+
+
+    //test #10: a rotor built with push_rotor_section is blended once, while its sections are pushed,
+    //and the analyses give the same results of the blends computed on the fly
+    Airfoil* analytic10 = analytic_polar_curves(0.50, 5.8, -0.3, 1.2, 0.028, 0.050, 0.020, 0.5, 70000, -0.7);
+    Rotor* rotor10 = calloc(1, sizeof(Rotor));
+    rotor10->D = 0.254;
+    rotor10->B = 2;
+    bool passed10 = true;
+    for (int i=0; i<8; ++i) {
+        push_rotor_section(rotor10, 0.02, deg2rad(30.0 - 2.0*i), 0.015 + 0.014*i, (i < 3 || i == 5)? naca4412 : analytic10);
+        //the first element is bounded by the same airfoil, so nothing is precomputed until the third one
+        passed10 = passed10 && (rotor10->elementairfoils != NULL) == (i >= 3);
+    }
+    //2 airfoils + 1 blend: the elements with the same pair reuse it, and the blend of the opposite pair
+    //at mid-span has the same data, so it is found in the table
+    passed10 = passed10 && rotor10->nairfoils == 3 && rotor10->elementairfoils[2] == rotor10->elementairfoils[5]
+               && rotor10->elementairfoils[2] == rotor10->elementairfoils[4]
+               && rotor10->elementairfoils[0] == naca4412 && rotor10->elementairfoils[3] == analytic10;
+    Rotor* rotor10b = copy_rotor(rotor10);
+    if (rotor10b) {
+        free(rotor10b->elementairfoils);
+        rotor10b->elementairfoils = NULL;
+    }
+    RotorPerformance* perf10 = qprop(rotor10, 8.0, Omega, tol, itmax, rho, mu, a);
+    RotorPerformance* perf10b = (rotor10b)? qprop(rotor10b, 8.0, Omega, tol, itmax, rho, mu, a) : NULL;
+    if (passed10 && perf10 && perf10b && perf10->T == perf10b->T && perf10->Q == perf10b->Q
+            && rotor10->nairfoils == 3 && !rotor10b->elementairfoils) {
+        printf("TEST 6.10 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 6.10 - FAILED :(\n");
+    }
+    if (perf10) {
+        free_rotor_performance(perf10);
+    }
+    if (perf10b) {
+        free_rotor_performance(perf10b);
+    }
+    if (rotor10b) {
+        free_rotor(rotor10b);
+    }
+    free_rotor(rotor10);
+    free_airfoil(analytic10);
+
     free_rotor(apc10x7sf);
     free_rotor(rotor2);
     free_rotor(rotor3);
-    free_airfoil(naca4412);
     free_rotor_performance(perf1);
     free_rotor_performance(perf2);
     free_rotor_performance(perf3);
@@ -0,0 +1,137 @@
+/*******************************************************************************
+    Testing program for the qprop_sweep() and qprop_batch() functions
+
+    How to run:
+    gcc 07_test_qprop_sweep.c -o 07_test_qprop_sweep -lm -Wall -Wextra
+    ./07_test_qprop_sweep
+
+    Author: Andrea Pavan
+    License: MIT
+*******************************************************************************/
+#include <math.h>
+#include <stdio.h>
+#include "../src/qprop.c"
+
+int main() {
+    //load NACA-4412 polars
+    const char* filenames1[10] = {
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.030_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.040_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.060_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.080_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.100_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.130_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.160_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.200_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.300_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.500_M0.00_N6.0.txt"
+    };
+    Airfoil* naca4412 = import_xfoil_polars(filenames1, 10);
+
+    //load propeller geometry from APC file
+    Rotor* apc10x7sf = import_rotor_geometry_apc("../validation/apc_10x7sf/10x7SF-PERF.PE0", naca4412);
+    double tol = 1e-6;
+    int itmax = 100;
+    double rho = 1.225;
+    double mu = 1.81e-5;
+    double a = 0.0;
+
+    //Julia results (J from 0.05 to 0.75)
+    const double Tref[15] = {
+        7.811303879404407, 7.5809187450271835, 7.32061016853633, 7.02562891997085, 6.6646208983089545,
+        6.245346524572363, 5.797827666347191, 5.321703109325795, 4.813713635410416, 4.279056143723284,
+        3.7151404055268156, 3.1285953514663483, 2.472376199831624, 1.7951408123607697, 1.1348963862887862
+    };
+    const double Qref[15] = {
+        0.14308075154669447, 0.14524469873222853, 0.14681290420213122, 0.1477194182109727, 0.14733995874807745,
+        0.14523447152924293, 0.1417658418125231, 0.13687424390996958, 0.13036405148150873, 0.122229083381802,
+        0.11227835761023904, 0.10054394413268984, 0.08568417842799038, 0.06960429493382134, 0.05252953779296362
+    };
+    double Uinf[15];
+    double Omega[15];
+    for (int k=0; k<15; ++k) {
+        Uinf[k] = 1.2729633333333334*(k+1);
+        Omega[k] = 6014*M_PI/30;
+    }
+
+    //test #1: warm-started sweep over the advance ratio
+    QPropOptions options = qprop_default_options();
+    options.tol = tol;
+    options.itmax = itmax;
+    RotorPerformance** perfs1 = qprop_sweep(apc10x7sf, Uinf, Omega, 15, rho, mu, a, &options);
+    bool passed1 = (perfs1 != NULL);
+    for (int k=0; passed1 && k<15; ++k) {
+        //printf("Uinf = %f m/s  -  Thrust = %f N  -  Torque = %f N-m\n", Uinf[k], perfs1[k]->T, perfs1[k]->Q);
+        if (!perfs1[k] || fabs(perfs1[k]->T - Tref[k]) > 1e-5 || fabs(perfs1[k]->Q - Qref[k]) > 1e-6) {
+            passed1 = false;
+        }
+    }
+    if (passed1) {
+        printf("TEST 7.1 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 7.1 - FAILED :(\n");
+        free_rotor(apc10x7sf);
+        free_airfoil(naca4412);
+        free_rotor_performances(perfs1, 15);
+        return 0;
+    }
+
+    //test #2: warm starting reduces the number of residual evaluations
+    int nevals_sweep = 0;
+    int nevals_cold = 0;
+    for (int k=0; k<15; ++k) {
+        RotorPerformance* perf2 = qprop(apc10x7sf, Uinf[k], Omega[k], tol, itmax, rho, mu, a);
+        for (int i=0; i<perf2->nelems; ++i) {
+            nevals_sweep += perfs1[k]->nevals[i];
+            nevals_cold += perf2->nevals[i];
+        }
+        free_rotor_performance(perf2);
+    }
+    //printf("Residual evaluations: %i (sweep) - %i (cold bisection)\n", nevals_sweep, nevals_cold);
+    if (3*nevals_sweep < nevals_cold) {
+        printf("TEST 7.2 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 7.2 - FAILED :(\n");
+        free_rotor(apc10x7sf);
+        free_airfoil(naca4412);
+        free_rotor_performances(perfs1, 15);
+        return 0;
+    }
+
+    //test #3: batched totals match the sweep, with per-point air properties
+    double T3[15], Q3[15], CT3[15], CP3[15], J3[15];
+    bool converged3[15];
+    double rho3[15], mu3[15];
+    for (int k=0; k<15; ++k) {
+        rho3[k] = rho;
+        mu3[k] = mu;
+    }
+    rho3[14] = 1.0;
+    bool allconverged3 = qprop_batch(apc10x7sf, 15, Uinf, Omega, rho3, mu3, a, &options, T3, Q3, CT3, CP3, J3, converged3);
+    bool passed3 = allconverged3;
+    for (int k=0; k<14 && passed3; ++k) {
+        if (!converged3[k] || T3[k] != perfs1[k]->T || Q3[k] != perfs1[k]->Q
+                || CT3[k] != perfs1[k]->CT || CP3[k] != perfs1[k]->CP || J3[k] != perfs1[k]->J) {
+            passed3 = false;
+        }
+    }
+    RotorPerformance* perf3 = qprop_ex(apc10x7sf, Uinf[14], Omega[14], 1.0, mu, a, &options);
+    if (passed3 && perf3 && fabs(T3[14] - perf3->T) <= 1e-6*fabs(perf3->T)
+            && qprop_batch(apc10x7sf, 15, Uinf, Omega, NULL, NULL, a, &options, T3, NULL, NULL, NULL, NULL, NULL)
+            && T3[3] == perfs1[3]->T) {
+        printf("TEST 7.3 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 7.3 - FAILED :(\n");
+    }
+    if (perf3) {
+        free_rotor_performance(perf3);
+    }
+
+    free_rotor(apc10x7sf);
+    free_airfoil(naca4412);
+    free_rotor_performances(perfs1, 15);
+    return 0;
+}
@@ -0,0 +1,185 @@
+/*******************************************************************************
+    Testing program for the multithreaded qprop_ex(), qprop_sweep() and import_xfoil_polars_parallel()
+
+    How to run:
+    gcc 08_test_threads.c -o 08_test_threads -lm -pthread -Wall -Wextra
+    ./08_test_threads
+
+    Author: Andrea Pavan
+    License: MIT
+*******************************************************************************/
+#include <math.h>
+#include <stdio.h>
+#define QPROP_THREADS
+#include "../src/qprop.c"
+
+//analysis of the same rotor from several threads at once
+typedef struct {
+    Rotor* rotor;
+    double Uinf;
+    double Omega;
+    double T[8];
+} SharedAnalysis;
+
+void run_shared_analysis(int k, void* sharedanalysis) {
+    SharedAnalysis* analysis = (SharedAnalysis*) sharedanalysis;
+    RotorPerformance* perf = qprop_ex(analysis->rotor, analysis->Uinf, analysis->Omega, 1.225, 1.81e-5, 0.0, NULL);
+    analysis->T[k] = (perf)? perf->T : 0.0;
+    if (perf) {
+        free_rotor_performance(perf);
+    }
+}
+
+int main() {
+    //load NACA-4412 polars
+    const char* filenames1[10] = {
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.030_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.040_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.060_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.080_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.100_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.130_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.160_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.200_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.300_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.500_M0.00_N6.0.txt"
+    };
+    Airfoil* naca4412 = import_xfoil_polars(filenames1, 10);
+
+    //load propeller geometry from APC file
+    Rotor* apc10x7sf = import_rotor_geometry_apc("../validation/apc_10x7sf/10x7SF-PERF.PE0", naca4412);
+    double Uinf = 1.2729633333333334;
+    double Omega = 6014*M_PI/30;
+
+
+    //test #1: the elements solved in parallel give the same results of the serial loop
+    //NOTE: the rotor is refined so that every thread gets enough elements, and the analysis is
+    //      repeated with a different number of threads to reuse and grow the thread pool
+    Rotor* rotor1 = refine_rotor_sections(apc10x7sf, 201);
+    QPropOptions options1 = qprop_default_options();
+    RotorPerformance* perf1serial = qprop_ex(rotor1, Uinf, Omega, 1.225, 1.81e-5, 0.0, &options1);
+    bool passed1 = (perf1serial != NULL);
+    const int nthreads1[4] = {2, 4, 3, 4};
+    for (int k=0; passed1 && k<4; ++k) {
+        options1.nthreads = nthreads1[k];
+        RotorPerformance* perf1parallel = qprop_ex(rotor1, Uinf, Omega, 1.225, 1.81e-5, 0.0, &options1);
+        passed1 = (perf1parallel
+                   && perf1serial->T == perf1parallel->T
+                   && perf1serial->Q == perf1parallel->Q);
+        for (int i=0; passed1 && i<perf1serial->nelems; ++i) {
+            if (perf1serial->dTdr[i] != perf1parallel->dTdr[i] || perf1serial->nevals[i] != perf1parallel->nevals[i]) {
+                passed1 = false;
+            }
+        }
+        if (perf1parallel) {
+            free_rotor_performance(perf1parallel);
+        }
+    }
+    if (perf1serial) {
+        free_rotor_performance(perf1serial);
+    }
+    free_rotor(rotor1);
+    if (passed1) {
+        printf("TEST 8.1 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 8.1 - FAILED :(\n");
+        free_rotor(apc10x7sf);
+        free_airfoil(naca4412);
+        return 0;
+    }
+
+
+    //test #2: the sweep results do not depend on the number of threads
+    double Uinf2[40];
+    double Omega2[40];
+    for (int k=0; k<40; ++k) {
+        Uinf2[k] = 0.5*(k+1);
+        Omega2[k] = 6014*M_PI/30;
+    }
+    QPropOptions options2 = qprop_default_options();
+    RotorPerformance** perfs2serial = qprop_sweep(apc10x7sf, Uinf2, Omega2, 40, 1.225, 1.81e-5, 0.0, &options2);
+    options2.nthreads = 3;
+    RotorPerformance** perfs2parallel = qprop_sweep(apc10x7sf, Uinf2, Omega2, 40, 1.225, 1.81e-5, 0.0, &options2);
+    bool passed2 = (perfs2serial && perfs2parallel);
+    for (int k=0; passed2 && k<40; ++k) {
+        if ((perfs2serial[k] == NULL) != (perfs2parallel[k] == NULL)) {
+            passed2 = false;
+        }
+        else if (perfs2serial[k] && (perfs2serial[k]->T != perfs2parallel[k]->T || perfs2serial[k]->Q != perfs2parallel[k]->Q)) {
+            passed2 = false;
+        }
+    }
+    free_rotor_performances(perfs2serial, 40);
+    free_rotor_performances(perfs2parallel, 40);
+    if (passed2) {
+        printf("TEST 8.2 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 8.2 - FAILED :(\n");
+        free_rotor(apc10x7sf);
+        free_airfoil(naca4412);
+        return 0;
+    }
+
+    //test #3: the polar files imported in parallel give the same airfoil
+    const char** filenames3[] = {filenames1};
+    const int number_of_files3[] = {10};
+    Airfoil** airfoils3 = import_xfoil_polars_parallel(filenames3, number_of_files3, 1, false, 4, NULL);
+    bool passed3 = (airfoils3 && airfoils3[0] && airfoils3[0]->size == naca4412->size
+                    && airfoils3[0]->compiled->nalpha == naca4412->compiled->nalpha
+                    && memcmp(airfoils3[0]->compiled->CLCD, naca4412->compiled->CLCD,
+                              2*naca4412->compiled->nRe*naca4412->compiled->nalpha*sizeof(double)) == 0);
+    free_airfoils(airfoils3, 1);
+    if (passed3) {
+        printf("TEST 8.3 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 8.3 - FAILED :(\n");
+        free_rotor(apc10x7sf);
+        free_airfoil(naca4412);
+        return 0;
+    }
+
+    //test #4: threads analyzing the same rotor (with blended airfoils) do not modify the shared data
+    Airfoil* airfoil4 = blend_airfoils(naca4412, naca4412, 0.5);
+    Rotor* rotor4 = calloc(1, sizeof(Rotor));
+    rotor4->D = apc10x7sf->D;
+    rotor4->B = apc10x7sf->B;
+    for (int i=0; i<apc10x7sf->nsections; ++i) {
+        Section* section4 = &(apc10x7sf->sections[i]);
+        push_rotor_section(rotor4, section4->c, section4->beta, section4->r, (i%2 == 0)? naca4412 : airfoil4);
+    }
+    //the blends precomputed by push_rotor_section are discarded, so that the threads blend on the fly
+    free(rotor4->elementairfoils);
+    rotor4->elementairfoils = NULL;
+    int nairfoils4 = rotor4->nairfoils;
+    int refcount4 = naca4412->refcount;
+    CompiledAirfoil* compiled4 = naca4412->compiled;
+    SharedAnalysis analysis4 = {rotor4, Uinf, Omega, {0}};
+    parallel_for(8, 4, run_shared_analysis, &analysis4);
+    RotorPerformance* perf4 = qprop_ex(rotor4, Uinf, Omega, 1.225, 1.81e-5, 0.0, NULL);
+    bool passed4 = (perf4 && naca4412->refcount == refcount4 && naca4412->compiled == compiled4
+                    && rotor4->nairfoils == nairfoils4 && rotor4->elementairfoils == NULL);
+    for (int k=0; passed4 && k<8; ++k) {
+        passed4 = (analysis4.T[k] == perf4->T);
+    }
+    if (perf4) {
+        free_rotor_performance(perf4);
+    }
+    free_rotor(rotor4);
+    free_airfoil(airfoil4);
+    if (passed4) {
+        printf("TEST 8.4 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 8.4 - FAILED :(\n");
+        free_rotor(apc10x7sf);
+        free_airfoil(naca4412);
+        return 0;
+    }
+
+    free_rotor(apc10x7sf);
+    free_airfoil(naca4412);
+    return 0;
+}
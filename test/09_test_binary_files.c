@@ -0,0 +1,121 @@
+/*******************************************************************************
+    Testing program for the binary airfoil and rotor files
+
+    How to run:
+    gcc 09_test_binary_files.c -o 09_test_binary_files -lm -Wall -Wextra
+    ./09_test_binary_files
+
+    Author: Andrea Pavan
+    License: MIT
+*******************************************************************************/
+#include <math.h>
+#include <stdio.h>
+#include "../src/qprop.c"
+
+int main() {
+    //load NACA-4412 polars
+    const char* filenames1[10] = {
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.030_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.040_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.060_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.080_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.100_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.130_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.160_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.200_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.300_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.500_M0.00_N6.0.txt"
+    };
+    Airfoil* naca4412 = import_xfoil_polars(filenames1, 10);
+
+    //load propeller geometry from APC file
+    Rotor* apc10x7sf = import_rotor_geometry_apc("../validation/apc_10x7sf/10x7SF-PERF.PE0", naca4412);
+    double Uinf = 1.2729633333333334;
+    double Omega = 6014*M_PI/30;
+
+
+    //test #1: save and load the airfoil, the polars and the compiled table must be identical
+    Airfoil* airfoil1 = NULL;
+    if (save_airfoil_binary(naca4412, "09_naca4412.bin")) {
+        airfoil1 = load_airfoil_binary("09_naca4412.bin");
+    }
+    bool passed1 = (airfoil1 && airfoil1->size == naca4412->size && airfoil1->compiled && airfoil1->compiled->mapping
+                    && airfoil1->compiled->nRe == naca4412->compiled->nRe
+                    && airfoil1->compiled->nalpha == naca4412->compiled->nalpha
+                    && airfoil1->compiled->dalpha == naca4412->compiled->dalpha);
+    for (int j=0; passed1 && j<naca4412->size; ++j) {
+        const Polar* polar = naca4412->polars[j];
+        const Polar* loaded = airfoil1->polars[j];
+        passed1 = (loaded->Re == polar->Re && loaded->size == polar->size && loaded->dalpha == polar->dalpha
+                   && memcmp(loaded->alpha, polar->alpha, polar->size*sizeof(double)) == 0
+                   && memcmp(loaded->CL, polar->CL, polar->size*sizeof(double)) == 0
+                   && memcmp(loaded->CD, polar->CD, polar->size*sizeof(double)) == 0);
+    }
+    if (passed1) {
+        const CompiledAirfoil* compiled = naca4412->compiled;
+        passed1 = (memcmp(airfoil1->compiled->Re, compiled->Re, compiled->nRe*sizeof(double)) == 0
+                   && memcmp(airfoil1->compiled->alpha, compiled->alpha, compiled->nalpha*sizeof(double)) == 0
+                   && memcmp(airfoil1->compiled->CLCD, compiled->CLCD, 2*compiled->nRe*compiled->nalpha*sizeof(double)) == 0);
+    }
+    if (passed1) {
+        printf("TEST 9.1 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 9.1 - FAILED :(\n");
+        if (airfoil1) {
+            free_airfoil(airfoil1);
+        }
+        free_rotor(apc10x7sf);
+        free_airfoil(naca4412);
+        remove("09_naca4412.bin");
+        return 0;
+    }
+
+
+    //test #2: a rotor loaded from binary files gives the same performance
+    Rotor* rotor2 = NULL;
+    if (save_rotor_binary(apc10x7sf, "09_apc10x7sf.bin")) {
+        rotor2 = load_rotor_binary("09_apc10x7sf.bin", airfoil1);
+    }
+    RotorPerformance* perf2ref = qprop(apc10x7sf, Uinf, Omega, 1e-6, 100, 1.225, 1.81e-5, 0.0);
+    RotorPerformance* perf2 = (rotor2)? qprop(rotor2, Uinf, Omega, 1e-6, 100, 1.225, 1.81e-5, 0.0) : NULL;
+    if (perf2 && rotor2->nsections == apc10x7sf->nsections && rotor2->B == apc10x7sf->B && rotor2->D == apc10x7sf->D
+            && perf2->T == perf2ref->T && perf2->Q == perf2ref->Q) {
+        printf("TEST 9.2 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 9.2 - FAILED :(\n");
+    }
+    if (perf2) {
+        free_rotor_performance(perf2);
+    }
+    if (rotor2) {
+        free_rotor(rotor2);
+    }
+    free_rotor_performance(perf2ref);
+
+
+    //test #3: files in a different format, rotors with more than one airfoil and rotors that cannot be
+    //         built (no airfoil) are rejected
+    Airfoil* airfoil3 = load_airfoil_binary("09_apc10x7sf.bin");
+    Rotor* rotor3 = load_rotor_binary("02_airfoil_polar_FX63-120_Re0.300_M0.00_N9.0.txt", naca4412);
+    Rotor* rotor3noairfoil = load_rotor_binary("09_apc10x7sf.bin", NULL);
+    Rotor* rotor3mixed = copy_rotor(apc10x7sf);
+    push_rotor_section(rotor3mixed, 0.01, 0.1, 0.5*apc10x7sf->D + 0.01, airfoil1);
+    bool saved3mixed = save_rotor_binary(rotor3mixed, "09_mixed.bin");
+    free_rotor(rotor3mixed);
+    remove("09_mixed.bin");
+    if (!airfoil3 && !rotor3 && !rotor3noairfoil && !saved3mixed) {
+        printf("TEST 9.3 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 9.3 - FAILED :(\n");
+    }
+
+    free_airfoil(airfoil1);
+    free_rotor(apc10x7sf);
+    free_airfoil(naca4412);
+    remove("09_naca4412.bin");
+    remove("09_apc10x7sf.bin");
+    return 0;
+}
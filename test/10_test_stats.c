@@ -0,0 +1,139 @@
+/*******************************************************************************
+    Testing program for the statistics collected with QPROP_STATS
+
+    How to run:
+    gcc 10_test_stats.c -o 10_test_stats -lm -pthread -Wall -Wextra
+    ./10_test_stats
+
+    Author: Andrea Pavan
+    License: MIT
+*******************************************************************************/
+#include <math.h>
+#include <stdio.h>
+#define QPROP_STATS
+#define QPROP_THREADS
+#include "../src/qprop.c"
+
+int main() {
+    //load NACA-4412 polars
+    const char* filenames1[10] = {
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.030_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.040_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.060_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.080_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.100_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.130_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.160_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.200_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.300_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.500_M0.00_N6.0.txt"
+    };
+    Airfoil* naca4412 = import_xfoil_polars(filenames1, 10);
+
+    //load propeller geometry from APC file
+    Rotor* apc10x7sf = import_rotor_geometry_apc("../validation/apc_10x7sf/10x7SF-PERF.PE0", naca4412);
+    double Uinf = 1.2729633333333334;
+    double Omega = 6014*M_PI/30;
+
+
+    //test #1: the counters of a single analysis match its outputs
+    QPropStats stats1 = {0};
+    QPropOptions options1 = qprop_default_options();
+    options1.stats = &stats1;
+    RotorPerformance* perf1 = qprop_ex(apc10x7sf, Uinf, Omega, 1.225, 1.81e-5, 0.0, &options1);
+    long long nevals1 = 0;
+    for (int i=0; perf1 && i<perf1->nelems; ++i) {
+        nevals1 += perf1->nevals[i];
+    }
+    //printf("%lld %lld %lld %lld %lld\n", stats1.nelements, stats1.niterations, stats1.nevals, stats1.nalphaclamped, stats1.nReclamped);
+    //printf("%e %e %e\n", stats1.tsetup, stats1.tsolve, stats1.tintegrate);
+    if (qprop_stats_enabled() && perf1
+            && stats1.nelements == perf1->nelems
+            && stats1.nevals == nevals1
+            && stats1.niterations > 0 && stats1.niterations < stats1.nevals
+            && stats1.tsetup >= 0.0 && stats1.tsolve > 0.0 && stats1.tintegrate >= 0.0) {
+        printf("TEST 10.1 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 10.1 - FAILED :(\n");
+        if (perf1) {
+            free_rotor_performance(perf1);
+        }
+        free_rotor(apc10x7sf);
+        free_airfoil(naca4412);
+        return 0;
+    }
+    free_rotor_performance(perf1);
+
+
+    //test #2: the polar queries out of range are counted
+    //at low rotor speed the Re is below the lowest polar, while at high Uinf the elements are at negative alpha
+    QPropStats stats2low = {0};
+    QPropStats stats2windmill = {0};
+    QPropOptions options2 = qprop_default_options();
+    options2.solver = QPROP_SOLVER_BISECTION;
+    options2.stats = &stats2low;
+    RotorPerformance* perf2low = qprop_ex(apc10x7sf, 0.0, 500*M_PI/30, 1.225, 1.81e-5, 0.0, &options2);
+    options2.stats = &stats2windmill;
+    RotorPerformance* perf2windmill = qprop_ex(apc10x7sf, 60.0, Omega, 1.225, 1.81e-5, 0.0, &options2);
+    //printf("%lld %lld\n", stats2low.nReclamped, stats2low.nevals);
+    //printf("%lld %lld\n", stats2windmill.nalphaclamped, stats2windmill.nevals);
+    bool passed2 = (perf2low && perf2windmill
+                    && stats2low.nReclamped == stats2low.nevals
+                    && stats2windmill.nalphaclamped > 0 && stats2windmill.nalphaclamped <= stats2windmill.nevals
+                    && stats1.nalphaclamped < stats2windmill.nalphaclamped);
+    if (perf2low) {
+        free_rotor_performance(perf2low);
+    }
+    if (perf2windmill) {
+        free_rotor_performance(perf2windmill);
+    }
+    if (passed2) {
+        printf("TEST 10.2 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 10.2 - FAILED :(\n");
+        free_rotor(apc10x7sf);
+        free_airfoil(naca4412);
+        return 0;
+    }
+
+
+    //test #3: the counters of a sweep do not depend on the number of threads
+    double Uinf3[40];
+    double Omega3[40];
+    for (int k=0; k<40; ++k) {
+        Uinf3[k] = 0.5*k;
+        Omega3[k] = Omega;
+    }
+    QPropStats stats3serial = {0};
+    QPropStats stats3parallel = {0};
+    QPropOptions options3 = qprop_default_options();
+    options3.stats = &stats3serial;
+    RotorPerformance** perfs3serial = qprop_sweep(apc10x7sf, Uinf3, Omega3, 40, 1.225, 1.81e-5, 0.0, &options3);
+    options3.stats = &stats3parallel;
+    options3.nthreads = 4;
+    RotorPerformance** perfs3parallel = qprop_sweep(apc10x7sf, Uinf3, Omega3, 40, 1.225, 1.81e-5, 0.0, &options3);
+    bool passed3 = (perfs3serial && perfs3parallel
+                    && stats3serial.nelements == 40*(apc10x7sf->nsections-1)
+                    && stats3serial.nelements == stats3parallel.nelements
+                    && stats3serial.niterations == stats3parallel.niterations
+                    && stats3serial.nevals == stats3parallel.nevals
+                    && stats3serial.nalphaclamped == stats3parallel.nalphaclamped
+                    && stats3serial.nReclamped == stats3parallel.nReclamped);
+    free_rotor_performances(perfs3serial, 40);
+    free_rotor_performances(perfs3parallel, 40);
+    if (passed3) {
+        printf("TEST 10.3 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 10.3 - FAILED :(\n");
+        free_rotor(apc10x7sf);
+        free_airfoil(naca4412);
+        return 0;
+    }
+
+    free_rotor(apc10x7sf);
+    free_airfoil(naca4412);
+    return 0;
+}
@@ -0,0 +1,173 @@
+/*******************************************************************************
+    Testing program for the qprop_with_gradients() function
+
+    How to run:
+    gcc 11_test_gradients.c -o 11_test_gradients -lm -Wall -Wextra
+    ./11_test_gradients
+
+    Author: Andrea Pavan
+    License: MIT
+*******************************************************************************/
+#include <math.h>
+#include <stdio.h>
+#include "../src/qprop.c"
+
+int main() {
+    //load NACA-4412 polars
+    const char* filenames1[10] = {
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.030_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.040_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.060_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.080_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.100_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.130_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.160_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.200_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.300_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.500_M0.00_N6.0.txt"
+    };
+    Airfoil* naca4412 = import_xfoil_polars(filenames1, 10);
+
+    //load propeller geometry from APC file
+    Rotor* apc10x7sf = import_rotor_geometry_apc("../validation/apc_10x7sf/10x7SF-PERF.PE0", naca4412);
+    double Uinf = 5.0;
+    double Omega = 6014*M_PI/30;
+    QPropOptions options = qprop_default_options();
+    options.tol = 1e-12;
+
+
+    //test #1: derivatives of the residual of an element compared with central finite differences
+    Element element1;
+    set_rotor_element(&element1, apc10x7sf, 30);
+    ResidualArgs args1 = {Uinf, Omega*element1.r, apc10x7sf->D/2, apc10x7sf->B, &element1, 1.225, 1.81e-5, 340.0, 0, {0}, {false, 0, 0, 0, 0, 0, 0}};
+    double psi1 = 0.3;
+    ElementSensitivities sens1;
+    residual_sensitivities(&sens1, psi1, &args1);
+    bool passed1 = true;
+    for (int k=0; k<NSENS; ++k) {
+        double h = 1e-7;
+        double outputs[2][3];
+        for (int side=0; side<2; ++side) {
+            double step = (side == 0)? +h : -h;
+            Element element1fd = element1;
+            ResidualArgs args1fd = args1;
+            args1fd.currentelement = &element1fd;
+            args1fd.inv.prepared = false;
+            double psi1fd = psi1 + ((k == SENS_PSI)? step : 0.0);
+            element1fd.c += (k == SENS_C)? step*element1.c : 0.0;
+            element1fd.beta += (k == SENS_BETA)? step : 0.0;
+            args1fd.Ua += (k == SENS_UA)? step*Uinf : 0.0;
+            args1fd.Ut += (k == SENS_UT)? step*args1.Ut : 0.0;
+            ResidualOutput res1;
+            residual(&res1, psi1fd, &args1fd);
+            outputs[side][0] = res1.residual;
+            outputs[side][1] = 0.5 * 1.225 * res1.W * res1.W * res1.Cn * element1fd.c;
+            outputs[side][2] = 0.5 * 1.225 * res1.W * res1.W * res1.Ct * element1fd.c * element1.r;
+        }
+        double scale = (k == SENS_C)? element1.c : (k == SENS_UA)? Uinf : (k == SENS_UT)? args1.Ut : 1.0;
+        double fd[3];
+        for (int j=0; j<3; ++j) {
+            fd[j] = (outputs[0][j] - outputs[1][j]) / (2*h*scale);
+        }
+        //printf("%d %e %e %e %e %e %e\n", k, sens1.residual[k], fd[0], sens1.dTdr[k], fd[1], sens1.dQdr[k], fd[2]);
+        if (fabs(sens1.residual[k] - fd[0]) > 1e-5*fmax(1.0, fabs(fd[0]))
+                || fabs(sens1.dTdr[k] - fd[1]) > 1e-5*fmax(1.0, fabs(fd[1]))
+                || fabs(sens1.dQdr[k] - fd[2]) > 1e-5*fmax(1.0, fabs(fd[2]))) {
+            passed1 = false;
+        }
+    }
+    if (passed1) {
+        printf("TEST 11.1 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 11.1 - FAILED :(\n");
+        free_rotor(apc10x7sf);
+        free_airfoil(naca4412);
+        return 0;
+    }
+
+
+    //test #2: sensitivities to the chord and twist of each section compared with central finite differences of qprop_ex
+    RotorGradients* gradients2 = alloc_rotor_gradients(apc10x7sf);
+    RotorPerformance* perf2 = qprop_with_gradients(apc10x7sf, Uinf, Omega, 1.225, 1.81e-5, 0.0, &options, gradients2);
+    RotorPerformance* perf2ref = qprop_ex(apc10x7sf, Uinf, Omega, 1.225, 1.81e-5, 0.0, &options);
+    bool passed2 = (perf2 && perf2->status == QPROP_OK && perf2->T == perf2ref->T && perf2->Q == perf2ref->Q);
+    double maxerror2[4] = {0.0, 0.0, 0.0, 0.0};
+    double maxvalue2[4] = {0.0, 0.0, 0.0, 0.0};
+    for (int j=0; j<apc10x7sf->nsections && passed2; ++j) {
+        for (int v=0; v<2; ++v) {
+            double h = 1e-6;
+            double* x = (v == 0)? &(apc10x7sf->sections[j].c) : &(apc10x7sf->sections[j].beta);
+            double x0 = *x;
+            *x = x0 + h;
+            RotorPerformance* perf2plus = qprop_ex(apc10x7sf, Uinf, Omega, 1.225, 1.81e-5, 0.0, &options);
+            *x = x0 - h;
+            RotorPerformance* perf2minus = qprop_ex(apc10x7sf, Uinf, Omega, 1.225, 1.81e-5, 0.0, &options);
+            *x = x0;
+            double dTfd = (perf2plus->T - perf2minus->T) / (2*h);
+            double dQfd = (perf2plus->Q - perf2minus->Q) / (2*h);
+            double dT = (v == 0)? gradients2->dTdc[j] : gradients2->dTdbeta[j];
+            double dQ = (v == 0)? gradients2->dQdc[j] : gradients2->dQdbeta[j];
+            //printf("%d %d %e %e %e %e\n", j, v, dT, dTfd, dQ, dQfd);
+            maxerror2[2*v] = fmax(maxerror2[2*v], fabs(dT - dTfd));
+            maxvalue2[2*v] = fmax(maxvalue2[2*v], fabs(dTfd));
+            maxerror2[2*v+1] = fmax(maxerror2[2*v+1], fabs(dQ - dQfd));
+            maxvalue2[2*v+1] = fmax(maxvalue2[2*v+1], fabs(dQfd));
+            free_rotor_performance(perf2plus);
+            free_rotor_performance(perf2minus);
+        }
+    }
+    for (int v=0; v<4; ++v) {
+        //printf("%e\n", maxerror2[v]/maxvalue2[v]);
+        passed2 = passed2 && (maxerror2[v] <= 1e-6*maxvalue2[v]);
+    }
+    if (passed2) {
+        printf("TEST 11.2 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 11.2 - FAILED :(\n");
+        if (perf2) {
+            free_rotor_performance(perf2);
+        }
+        free_rotor_performance(perf2ref);
+        free_rotor_gradients(gradients2);
+        free_rotor(apc10x7sf);
+        free_airfoil(naca4412);
+        return 0;
+    }
+
+
+    //test #3: sensitivities to the operating point compared with central finite differences of qprop_ex
+    double hU = 1e-5;
+    double hOmega = 1e-3;
+    RotorPerformance* perf3Uplus = qprop_ex(apc10x7sf, Uinf+hU, Omega, 1.225, 1.81e-5, 0.0, &options);
+    RotorPerformance* perf3Uminus = qprop_ex(apc10x7sf, Uinf-hU, Omega, 1.225, 1.81e-5, 0.0, &options);
+    RotorPerformance* perf3Omegaplus = qprop_ex(apc10x7sf, Uinf, Omega+hOmega, 1.225, 1.81e-5, 0.0, &options);
+    RotorPerformance* perf3Omegaminus = qprop_ex(apc10x7sf, Uinf, Omega-hOmega, 1.225, 1.81e-5, 0.0, &options);
+    double dTdUinf3 = (perf3Uplus->T - perf3Uminus->T) / (2*hU);
+    double dQdUinf3 = (perf3Uplus->Q - perf3Uminus->Q) / (2*hU);
+    double dTdOmega3 = (perf3Omegaplus->T - perf3Omegaminus->T) / (2*hOmega);
+    double dQdOmega3 = (perf3Omegaplus->Q - perf3Omegaminus->Q) / (2*hOmega);
+    //printf("%e %e %e %e\n", gradients2->dTdUinf, dTdUinf3, gradients2->dQdUinf, dQdUinf3);
+    //printf("%e %e %e %e\n", gradients2->dTdOmega, dTdOmega3, gradients2->dQdOmega, dQdOmega3);
+    if (fabs(gradients2->dTdUinf - dTdUinf3) <= 1e-6*fabs(dTdUinf3)
+            && fabs(gradients2->dQdUinf - dQdUinf3) <= 1e-6*fabs(dQdUinf3)
+            && fabs(gradients2->dTdOmega - dTdOmega3) <= 1e-6*fabs(dTdOmega3)
+            && fabs(gradients2->dQdOmega - dQdOmega3) <= 1e-6*fabs(dQdOmega3)) {
+        printf("TEST 11.3 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 11.3 - FAILED :(\n");
+    }
+    free_rotor_performance(perf3Uplus);
+    free_rotor_performance(perf3Uminus);
+    free_rotor_performance(perf3Omegaplus);
+    free_rotor_performance(perf3Omegaminus);
+    free_rotor_performance(perf2);
+    free_rotor_performance(perf2ref);
+    free_rotor_gradients(gradients2);
+
+    free_rotor(apc10x7sf);
+    free_airfoil(naca4412);
+    return 0;
+}
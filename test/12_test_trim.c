@@ -0,0 +1,145 @@
+/*******************************************************************************
+    Testing program for the qprop_trim() function
+
+    How to run:
+    gcc 12_test_trim.c -o 12_test_trim -lm -Wall -Wextra
+    ./12_test_trim
+
+    Author: Andrea Pavan
+    License: MIT
+*******************************************************************************/
+#include <math.h>
+#include <stdio.h>
+#define QPROP_STATS
+#include "../src/qprop.c"
+
+int main() {
+    //load NACA-4412 polars
+    const char* filenames1[10] = {
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.030_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.040_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.060_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.080_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.100_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.130_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.160_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.200_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.300_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.500_M0.00_N6.0.txt"
+    };
+    Airfoil* naca4412 = import_xfoil_polars(filenames1, 10);
+
+
+    //load propeller geometry from APC file
+    Rotor* apc10x7sf = import_rotor_geometry_apc("../validation/apc_10x7sf/10x7SF-PERF.PE0", naca4412);
+    double Uinf = 5.0;
+    double Omega = 6014*M_PI/30;
+    QPropOptions options = qprop_default_options();
+    options.tol = 1e-10;
+
+
+    //test #1: rotor speed giving the thrust of a reference analysis, starting from a distant guess
+    RotorPerformance* perf1ref = qprop_ex(apc10x7sf, Uinf, Omega, 1.225, 1.81e-5, 0.0, &options);
+    QPropStats stats1 = {0};
+    QPropOptions options1 = options;
+    options1.stats = &stats1;
+    double Omega1 = 0.0;
+    RotorPerformance* perf1 = qprop_trim(apc10x7sf, Uinf, 4000*M_PI/30, 1.225, 1.81e-5, 0.0, &options1,
+                                         QPROP_TRIM_THRUST, perf1ref->T, QPROP_TRIM_OMEGA, &Omega1);
+    //printf("%f %f %f %f\n", Omega1, Omega, perf1->T, perf1ref->T);
+    //printf("%lld %lld\n", stats1.nelements/(apc10x7sf->nsections-1), stats1.nevals);
+    if (perf1 && perf1->status == QPROP_OK
+            && fabs(Omega1 - Omega) <= 1e-6*Omega
+            && fabs(perf1->T - perf1ref->T) <= 1e-9*perf1ref->T
+            && fabs(perf1->Q - perf1ref->Q) <= 1e-6*perf1ref->Q
+            && stats1.nelements <= 8*(apc10x7sf->nsections-1)) {
+        printf("TEST 12.1 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 12.1 - FAILED :(\n");
+        free_rotor_performance(perf1ref);
+        if (perf1) {
+            free_rotor_performance(perf1);
+        }
+        free_rotor(apc10x7sf);
+        free_airfoil(naca4412);
+        return 0;
+    }
+    free_rotor_performance(perf1);
+
+
+    //test #2: rotor speed giving the shaft power of the reference analysis
+    double Omega2 = 0.0;
+    RotorPerformance* perf2 = qprop_trim(apc10x7sf, Uinf, 9000*M_PI/30, 1.225, 1.81e-5, 0.0, &options,
+                                         QPROP_TRIM_POWER, perf1ref->Q*Omega, QPROP_TRIM_OMEGA, &Omega2);
+    //printf("%f %f\n", Omega2, Omega);
+    bool passed2 = (perf2 && perf2->status == QPROP_OK && fabs(Omega2 - Omega) <= 1e-6*Omega);
+    if (perf2) {
+        free_rotor_performance(perf2);
+    }
+    free_rotor_performance(perf1ref);
+    if (passed2) {
+        printf("TEST 12.2 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 12.2 - FAILED :(\n");
+        free_rotor(apc10x7sf);
+        free_airfoil(naca4412);
+        return 0;
+    }
+
+
+    //test #3: collective pitch giving the torque of a rotor with all the sections twisted by 2 degrees
+    Rotor* apc10x7sf3 = copy_rotor(apc10x7sf);
+    for (int j=0; j<apc10x7sf3->nsections; ++j) {
+        apc10x7sf3->sections[j].beta += deg2rad(2.0);
+    }
+    RotorPerformance* perf3ref = qprop_ex(apc10x7sf3, Uinf, Omega, 1.225, 1.81e-5, 0.0, &options);
+    double pitch3 = 0.0;
+    RotorPerformance* perf3 = qprop_trim(apc10x7sf, Uinf, Omega, 1.225, 1.81e-5, 0.0, &options,
+                                         QPROP_TRIM_TORQUE, perf3ref->Q, QPROP_TRIM_PITCH, &pitch3);
+    //printf("%f %f\n", pitch3*180/M_PI, perf3->T - perf3ref->T);
+    bool passed3 = (perf3 && perf3->status == QPROP_OK
+                    && fabs(pitch3 - deg2rad(2.0)) <= 1e-6
+                    && fabs(perf3->T - perf3ref->T) <= 1e-6*perf3ref->T
+                    && apc10x7sf->sections[0].beta == apc10x7sf3->sections[0].beta - deg2rad(2.0));
+    if (perf3) {
+        free_rotor_performance(perf3);
+    }
+    free_rotor_performance(perf3ref);
+    free_rotor(apc10x7sf3);
+    if (passed3) {
+        printf("TEST 12.3 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 12.3 - FAILED :(\n");
+        free_rotor(apc10x7sf);
+        free_airfoil(naca4412);
+        return 0;
+    }
+
+
+    //test #4: unreachable targets and invalid arguments
+    //a static rotor cannot produce a negative thrust by changing its speed
+    RotorPerformance* perf4 = qprop_trim(apc10x7sf, 0.0, Omega, 1.225, 1.81e-5, 0.0, &options,
+                                         QPROP_TRIM_THRUST, -1.0, QPROP_TRIM_OMEGA, NULL);
+    RotorPerformance* perf4invalid = qprop_trim(apc10x7sf, Uinf, 0.0, 1.225, 1.81e-5, 0.0, &options,
+                                                QPROP_TRIM_THRUST, 1.0, QPROP_TRIM_OMEGA, NULL);
+    bool passed4 = (perf4 && perf4->status == QPROP_ERROR_NOT_CONVERGED && !perf4invalid);
+    if (perf4) {
+        free_rotor_performance(perf4);
+    }
+    if (passed4) {
+        printf("TEST 12.4 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 12.4 - FAILED :(\n");
+        free_rotor(apc10x7sf);
+        free_airfoil(naca4412);
+        return 0;
+    }
+
+    free_rotor(apc10x7sf);
+    free_airfoil(naca4412);
+    return 0;
+}
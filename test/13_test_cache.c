@@ -0,0 +1,216 @@
+/*******************************************************************************
+    Testing program for the operating point cache (qprop_cached)
+
+    How to run:
+    gcc 13_test_cache.c -o 13_test_cache -lm -Wall -Wextra
+    ./13_test_cache
+
+    Author: Andrea Pavan
+    License: MIT
+*******************************************************************************/
+#include <math.h>
+#include <stdio.h>
+#define QPROP_THREADS
+#include "../src/qprop.c"
+
+//analyses of the same operating points from multiple threads
+typedef struct {
+    QPropCache* cache;
+    uint64_t rotorkey;
+    Rotor* rotor;
+    RotorPerformance** perfs;
+    double* Uinf;
+    double Omega;
+    bool* converged;
+} CacheTest;
+
+void cached_analysis(int k, void* ctx) {
+    CacheTest* test = (CacheTest*) ctx;
+    test->converged[k] = qprop_cached(test->cache, test->rotorkey, test->perfs[k], test->rotor, test->Uinf[k], test->Omega, 1.225, 1.81e-5, 0.0, NULL);
+}
+
+int main() {
+    //load NACA-4412 polars
+    const char* filenames1[10] = {
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.030_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.040_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.060_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.080_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.100_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.130_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.160_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.200_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.300_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.500_M0.00_N6.0.txt"
+    };
+    Airfoil* naca4412 = import_xfoil_polars(filenames1, 10);
+
+    //load propeller geometry from APC file
+    Rotor* apc10x7sf = import_rotor_geometry_apc("../validation/apc_10x7sf/10x7SF-PERF.PE0", naca4412);
+    double Uinf = 5.0;
+    double Omega = 6014*M_PI/30;
+
+
+    //test #1: the second analysis of an operating point is copied from the cache
+    QPropCache* cache1 = alloc_qprop_cache(64, 1e-3, true);
+    uint64_t key1 = qprop_cache_attach(cache1, apc10x7sf);
+    RotorPerformance* perf1ref = qprop_ex(apc10x7sf, Uinf, Omega, 1.225, 1.81e-5, 0.0, NULL);
+    RotorPerformance* perf1 = alloc_rotor_performance(apc10x7sf, false);
+    bool converged1a = qprop_cached(cache1, key1, perf1, apc10x7sf, Uinf, Omega, 1.225, 1.81e-5, 0.0, NULL);
+    perf1->T = 0.0;
+    perf1->dTdr[10] = 0.0;
+    bool converged1b = qprop_cached(cache1, key1, perf1, apc10x7sf, Uinf, Omega, 1.225, 1.81e-5, 0.0, NULL);
+    QPropCacheStats stats1 = qprop_cache_stats(cache1);
+    //printf("%f %f %lld %lld %lld\n", perf1->T, perf1ref->T, stats1.hits, stats1.warmstarts, stats1.misses);
+    if (cache1 && key1 != 0 && converged1a && converged1b
+            && perf1->T == perf1ref->T && perf1->Q == perf1ref->Q
+            && perf1->dTdr[10] == perf1ref->dTdr[10]
+            && perf1->Gamma[20] == perf1ref->Gamma[20]
+            && perf1->nevals[5] == perf1ref->nevals[5]
+            && stats1.hits == 1 && stats1.warmstarts == 0 && stats1.misses == 1 && stats1.entries == 1) {
+        printf("TEST 13.1 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 13.1 - FAILED :(\n");
+        free_rotor_performance(perf1ref);
+        free_rotor_performance(perf1);
+        free_qprop_cache(cache1);
+        free_rotor(apc10x7sf);
+        free_airfoil(naca4412);
+        return 0;
+    }
+
+
+    //test #2: close operating points are warm started, different rotors are not mixed up
+    RotorPerformance* perf2ref = qprop_ex(apc10x7sf, Uinf*(1+1e-5), Omega, 1.225, 1.81e-5, 0.0, NULL);
+    RotorPerformance* perf2 = alloc_rotor_performance(apc10x7sf, true);
+    qprop_cached(cache1, key1, perf2, apc10x7sf, Uinf*(1+1e-5), Omega, 1.225, 1.81e-5, 0.0, NULL);
+    int nevals2 = 0;
+    int nevals2ref = 0;
+    for (int i=0; i<perf2->nelems; ++i) {
+        nevals2 += perf2->nevals[i];
+        nevals2ref += perf2ref->nevals[i];
+    }
+    Rotor* apc10x7sf2 = copy_rotor(apc10x7sf);
+    apc10x7sf2->sections[20].beta += deg2rad(1.0);
+    uint64_t key2twisted = qprop_cache_attach(cache1, apc10x7sf2);
+    RotorPerformance* perf2twisted = alloc_rotor_performance(apc10x7sf2, true);
+    qprop_cached(cache1, key2twisted, perf2twisted, apc10x7sf2, Uinf, Omega, 1.225, 1.81e-5, 0.0, NULL);
+    QPropCacheStats stats2 = qprop_cache_stats(cache1);
+    //printf("%f %f %d %d %f\n", perf2->T, perf2ref->T, nevals2, nevals2ref, perf2twisted->T);
+    bool passed2 = (fabs(perf2->T - perf2ref->T) <= 1e-6*perf2ref->T
+                    && nevals2 < nevals2ref && key2twisted != key1
+                    && qprop_cache_attach(cache1, NULL) == 0
+                    && perf2twisted->T > perf1ref->T
+                    && stats2.hits == 1 && stats2.warmstarts == 1 && stats2.misses == 2);
+    free_rotor_performance(perf1ref);
+    free_rotor_performance(perf1);
+    free_rotor_performance(perf2ref);
+    free_rotor_performance(perf2);
+    free_rotor_performance(perf2twisted);
+    free_rotor(apc10x7sf2);
+    free_qprop_cache(cache1);
+    if (passed2) {
+        printf("TEST 13.2 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 13.2 - FAILED :(\n");
+        free_rotor(apc10x7sf);
+        free_airfoil(naca4412);
+        return 0;
+    }
+
+
+    //test #3: the least recently used entries are evicted when the cache is full
+    QPropCache* cache3 = alloc_qprop_cache(16, 0.0, false);
+    uint64_t key3 = qprop_cache_attach(cache3, apc10x7sf);
+    RotorPerformance* perf3 = alloc_rotor_performance(apc10x7sf, true);
+    for (int k=0; k<40; ++k) {
+        qprop_cached(cache3, key3, perf3, apc10x7sf, 0.25*k, Omega, 1.225, 1.81e-5, 0.0, NULL);
+    }
+    QPropCacheStats stats3 = qprop_cache_stats(cache3);
+    //printf("%lld %lld %d\n", stats3.misses, stats3.evictions, stats3.entries);
+    bool passed3 = (stats3.misses == 40 && stats3.entries <= 16 && stats3.evictions == 40 - stats3.entries);
+    free_rotor_performance(perf3);
+    free_qprop_cache(cache3);
+    if (passed3) {
+        printf("TEST 13.3 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 13.3 - FAILED :(\n");
+        free_rotor(apc10x7sf);
+        free_airfoil(naca4412);
+        return 0;
+    }
+
+
+    //test #4: a cache shared by multiple threads gives the same results as the serial analyses
+    QPropCache* cache4 = alloc_qprop_cache(256, 1e-3, false);
+    RotorPerformance* perfs4[64];
+    double Uinf4[64];
+    bool converged4[64];
+    for (int k=0; k<64; ++k) {
+        perfs4[k] = alloc_rotor_performance(apc10x7sf, true);
+        Uinf4[k] = 0.5*(k % 32);        //each operating point is analyzed twice
+    }
+    CacheTest test4 = {cache4, qprop_cache_attach(cache4, apc10x7sf), apc10x7sf, perfs4, Uinf4, Omega, converged4};
+    parallel_for(64, 4, cached_analysis, &test4);
+    QPropCacheStats stats4 = qprop_cache_stats(cache4);
+    bool passed4 = (stats4.hits + stats4.warmstarts + stats4.misses == 64 && stats4.hits >= 1 && stats4.entries == 32);
+    for (int k=0; k<64 && passed4; ++k) {
+        RotorPerformance* perf4ref = qprop_ex(apc10x7sf, Uinf4[k], Omega, 1.225, 1.81e-5, 0.0, NULL);
+        if (!converged4[k] || fabs(perfs4[k]->T - perf4ref->T) > 1e-6*fabs(perf4ref->T) + 1e-9) {
+            passed4 = false;
+        }
+        free_rotor_performance(perf4ref);
+    }
+    for (int k=0; k<64; ++k) {
+        free_rotor_performance(perfs4[k]);
+    }
+    free_qprop_cache(cache4);
+    if (passed4) {
+        printf("TEST 13.4 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 13.4 - FAILED :(\n");
+        free_rotor(apc10x7sf);
+        free_airfoil(naca4412);
+        return 0;
+    }
+
+    //test #5: a rotor modified after the attach does not get the results of its old geometry,
+    //         and it gets them back when the geometry is restored
+    QPropCache* cache5 = alloc_qprop_cache(64, 0.0, false);
+    Rotor* rotor5 = copy_rotor(apc10x7sf);
+    uint64_t key5 = qprop_cache_attach(cache5, rotor5);
+    RotorPerformance* perf5 = alloc_rotor_performance(rotor5, true);
+    qprop_cached(cache5, key5, perf5, rotor5, Uinf, Omega, 1.225, 1.81e-5, 0.0, NULL);
+    double T5 = perf5->T;
+    double c5 = rotor5->sections[10].c;
+    rotor5->sections[10].c = 1.2*c5;
+    qprop_cached(cache5, key5, perf5, rotor5, Uinf, Omega, 1.225, 1.81e-5, 0.0, NULL);
+    RotorPerformance* perf5ref = qprop_ex(rotor5, Uinf, Omega, 1.225, 1.81e-5, 0.0, NULL);
+    QPropCacheStats stats5modified = qprop_cache_stats(cache5);
+    bool passed5 = (perf5ref && perf5->T == perf5ref->T && perf5->T != T5
+                    && stats5modified.hits == 0 && stats5modified.misses == 2);
+    rotor5->sections[10].c = c5;
+    qprop_cached(cache5, key5, perf5, rotor5, Uinf, Omega, 1.225, 1.81e-5, 0.0, NULL);
+    QPropCacheStats stats5restored = qprop_cache_stats(cache5);
+    passed5 = passed5 && perf5->T == T5 && stats5restored.hits == 1 && stats5restored.misses == 2;
+    if (perf5ref) {
+        free_rotor_performance(perf5ref);
+    }
+    free_rotor_performance(perf5);
+    free_rotor(rotor5);
+    free_qprop_cache(cache5);
+    if (passed5) {
+        printf("TEST 13.5 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 13.5 - FAILED :(\n");
+    }
+
+    free_rotor(apc10x7sf);
+    free_airfoil(naca4412);
+    return 0;
+}
@@ -0,0 +1,140 @@
+/*******************************************************************************
+    Testing program for the rotor performance maps
+
+    How to run:
+    gcc 14_test_maps.c -o 14_test_maps -lm -Wall -Wextra
+    ./14_test_maps
+
+    Author: Andrea Pavan
+    License: MIT
+*******************************************************************************/
+#include <math.h>
+#include <stdio.h>
+#include "../src/qprop.c"
+
+int main() {
+    //load NACA-4412 polars
+    const char* filenames1[10] = {
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.030_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.040_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.060_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.080_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.100_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.130_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.160_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.200_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.300_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.500_M0.00_N6.0.txt"
+    };
+    Airfoil* naca4412 = import_xfoil_polars(filenames1, 10);
+
+    //load propeller geometry from APC file
+    Rotor* apc10x7sf = import_rotor_geometry_apc("../validation/apc_10x7sf/10x7SF-PERF.PE0", naca4412);
+    double J[17];
+    double Omega[5];
+    for (int i=0; i<17; ++i) {
+        J[i] = 0.05*i;
+    }
+    for (int k=0; k<5; ++k) {
+        Omega[k] = (3000 + 1500*k)*M_PI/30;
+    }
+
+
+    //test #1: the map reproduces the full solver at the grid points and within the error bounds elsewhere
+    QPropOptions options = qprop_default_options();
+    options.nthreads = 2;
+    RotorMap* map1 = generate_rotor_map(apc10x7sf, J, 17, Omega, 5, 1.225, 1.81e-5, 0.0, &options);
+    bool passed1 = (map1 && map1->nfailed == 0 && map1->dJ > 0.0 && map1->dOmega > 0.0
+                    && map1->errCT > 0.0 && map1->errCT < 1e-2 && map1->errCP > 0.0 && map1->errCP < 1e-2);
+    //printf("%e %e\n", map1->errCT, map1->errCP);
+    for (int k=0; k<5 && passed1; ++k) {
+        for (int i=0; i<17 && passed1; i+=4) {
+            double Uinf = J[i]*Omega[k]/(2*M_PI)*apc10x7sf->D;
+            RotorMapPoint point = lookup_rotor_map(map1, Uinf, Omega[k], 1.225);
+            RotorPerformance* perf = qprop_ex(apc10x7sf, Uinf, Omega[k], 1.225, 1.81e-5, 0.0, NULL);
+            //printf("%f %f %f\n", J[i], point.T, perf->T);
+            passed1 = (point.inside && fabs(point.J - J[i]) <= 1e-12
+                       && fabs(point.T - perf->T) <= 1e-5*(1.0 + fabs(perf->T))
+                       && fabs(point.Q - perf->Q) <= 1e-5*(1.0 + fabs(perf->Q)));
+            free_rotor_performance(perf);
+        }
+    }
+    for (int k=0; k<4 && passed1; ++k) {
+        //operating points inside the cells, away from their centers
+        double Omegaq = 0.75*Omega[k] + 0.25*Omega[k+1];
+        double Uinf = 0.33*Omegaq/(2*M_PI)*apc10x7sf->D;
+        RotorMapPoint point = lookup_rotor_map(map1, Uinf, Omegaq, 1.225);
+        RotorPerformance* perf = qprop_ex(apc10x7sf, Uinf, Omegaq, 1.225, 1.81e-5, 0.0, NULL);
+        //printf("%e %e\n", fabs(point.CT - perf->CT), fabs(point.CP - perf->CP));
+        passed1 = (point.inside && fabs(point.CT - perf->CT) <= map1->errCT && fabs(point.CP - perf->CP) <= map1->errCP);
+        free_rotor_performance(perf);
+    }
+    if (passed1) {
+        printf("TEST 14.1 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 14.1 - FAILED :(\n");
+        if (map1) {
+            free_rotor_map(map1);
+        }
+        free_rotor(apc10x7sf);
+        free_airfoil(naca4412);
+        return 0;
+    }
+
+
+    //test #2: thrust and torque scale with the air density, queries outside the map are clamped
+    RotorMapPoint point2 = lookup_rotor_map(map1, 4.0, 5000*M_PI/30, 1.225);
+    RotorMapPoint point2rho = lookup_rotor_map(map1, 4.0, 5000*M_PI/30, 1.0);
+    RotorMapPoint point2fast = lookup_rotor_map(map1, 4.0, 12000*M_PI/30, 1.225);
+    RotorMapPoint point2clamped = lookup_rotor_map(map1, 4.0*Omega[4]/(12000*M_PI/30), Omega[4], 1.225);
+    RotorMapPoint point2negative = lookup_rotor_map(map1, -1.0, 5000*M_PI/30, 1.225);
+    if (point2.inside && point2rho.inside
+            && fabs(point2rho.T - point2.T/1.225) <= 1e-12 && point2rho.CT == point2.CT
+            && !point2fast.inside && point2clamped.inside && fabs(point2fast.CT - point2clamped.CT) <= 1e-12
+            && !point2negative.inside && point2negative.J < 0.0
+            && point2negative.CT == lookup_rotor_map(map1, 0.0, 5000*M_PI/30, 1.225).CT) {
+        printf("TEST 14.2 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 14.2 - FAILED :(\n");
+        free_rotor_map(map1);
+        free_rotor(apc10x7sf);
+        free_airfoil(naca4412);
+        return 0;
+    }
+
+
+    //test #3: the maps saved in binary files are loaded without changes, invalid arguments are rejected
+    bool saved3 = save_rotor_map_binary(map1, "14_apc10x7sf_map.bin");
+    RotorMap* map3 = load_rotor_map_binary("14_apc10x7sf_map.bin");
+    RotorMap* map3invalid = load_rotor_map_binary("../validation/apc_10x7sf/10x7SF-PERF.PE0");
+    double Jinvalid[3] = {0.0, 0.2, 0.1};
+    RotorMap* map3unsorted = generate_rotor_map(apc10x7sf, Jinvalid, 3, Omega, 5, 1.225, 1.81e-5, 0.0, NULL);
+    bool passed3 = (saved3 && map3 && map3->mapping && !map3invalid && !map3unsorted
+                    && map3->nJ == map1->nJ && map3->nOmega == map1->nOmega
+                    && map3->errCT == map1->errCT && map3->errCP == map1->errCP && map3->dJ == map1->dJ);
+    for (int k=0; k<20 && passed3; ++k) {
+        RotorMapPoint point = lookup_rotor_map(map1, 0.3*k, (2000 + 400*k)*M_PI/30, 1.225);
+        RotorMapPoint point3 = lookup_rotor_map(map3, 0.3*k, (2000 + 400*k)*M_PI/30, 1.225);
+        passed3 = (point.T == point3.T && point.Q == point3.Q && point.inside == point3.inside);
+    }
+    if (map3) {
+        free_rotor_map(map3);
+    }
+    free_rotor_map(map1);
+    remove("14_apc10x7sf_map.bin");
+    if (passed3) {
+        printf("TEST 14.3 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 14.3 - FAILED :(\n");
+        free_rotor(apc10x7sf);
+        free_airfoil(naca4412);
+        return 0;
+    }
+
+    free_rotor(apc10x7sf);
+    free_airfoil(naca4412);
+    return 0;
+}
@@ -0,0 +1,159 @@
+/*******************************************************************************
+    Testing program for the single-precision build (QPROP_SINGLE_PRECISION)
+
+    How to run:
+    gcc 15_test_single_precision.c -o 15_test_single_precision -lm -Wall -Wextra
+    ./15_test_single_precision
+
+    Author: Andrea Pavan
+    License: MIT
+*******************************************************************************/
+#include <math.h>
+#include <stdio.h>
+#define QPROP_SINGLE_PRECISION
+#include "../src/qprop.c"
+
+int main() {
+    //load NACA-4412 polars
+    const char* filenames1[10] = {
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.030_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.040_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.060_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.080_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.100_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.130_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.160_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.200_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.300_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.500_M0.00_N6.0.txt"
+    };
+    Airfoil* naca4412 = import_xfoil_polars(filenames1, 10);
+
+    //load propeller geometry from APC file
+    Rotor* apc10x7sf = import_rotor_geometry_apc("../validation/apc_10x7sf/10x7SF-PERF.PE0", naca4412);
+    double Omega = 6014*M_PI/30;
+
+
+    //test #1: the compiled polars have a float copy, rounded from the double table
+    const CompiledAirfoil* compiled1 = naca4412->compiled;
+    bool passed1 = (qprop_single_precision() && compiled1 && (void*) compiled1->CLCDr != (void*) compiled1->CLCD);
+    for (int i=0; passed1 && i<2*compiled1->nRe*compiled1->nalpha; ++i) {
+        if (compiled1->CLCDr[i] != (float) compiled1->CLCD[i]) {
+            passed1 = false;
+        }
+    }
+    if (passed1) {
+        printf("TEST 15.1 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 15.1 - FAILED :(\n");
+        free_rotor(apc10x7sf);
+        free_airfoil(naca4412);
+        return 0;
+    }
+
+
+    //test #2: single-precision results against the double-precision results of test 5
+    //(Brent with the scalar residual, bisection with the batched residual)
+    const double T2ref[15] = {
+        7.811303879404407, 7.5809187450271835, 7.32061016853633, 7.02562891997085, 6.6646208983089545,
+        6.245346524572363, 5.797827666347191, 5.321703109325795, 4.813713635410416, 4.279056143723284,
+        3.7151404055268156, 3.1285953514663483, 2.472376199831624, 1.7951408123607697, 1.1348963862887862
+    };
+    const double Q2ref[15] = {
+        0.14308075154669447, 0.14524469873222853, 0.14681290420213122, 0.1477194182109727, 0.14733995874807745,
+        0.14523447152924293, 0.1417658418125231, 0.13687424390996958, 0.13036405148150873, 0.122229083381802,
+        0.11227835761023904, 0.10054394413268984, 0.08568417842799038, 0.06960429493382134, 0.05252953779296362
+    };
+    QPropOptions options2 = qprop_default_options();
+    double maxerr2 = 0.0;
+    bool passed2 = true;
+    for (int solver=0; solver<2 && passed2; ++solver) {
+        options2.solver = (solver == 0)? QPROP_SOLVER_BRENT : QPROP_SOLVER_BISECTION;
+        for (int k=0; k<15; ++k) {
+            RotorPerformance* perf2 = qprop_ex(apc10x7sf, 1.2729633333333334*(k+1), Omega, 1.225, 1.81e-5, 0.0, &options2);
+            if (!perf2 || perf2->status != QPROP_OK) {
+                passed2 = false;
+                if (perf2) {
+                    free_rotor_performance(perf2);
+                }
+                break;
+            }
+            maxerr2 = fmax(maxerr2, fabs(perf2->T - T2ref[k])/T2ref[k]);
+            maxerr2 = fmax(maxerr2, fabs(perf2->Q - Q2ref[k])/Q2ref[k]);
+            free_rotor_performance(perf2);
+        }
+    }
+    //printf("%e\n", maxerr2);
+    if (passed2 && maxerr2 <= 1e-6) {
+        printf("TEST 15.2 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 15.2 - FAILED :(\n");
+        free_rotor(apc10x7sf);
+        free_airfoil(naca4412);
+        return 0;
+    }
+
+
+    //test #3: accuracy against the UIUC wind tunnel data of the validation case
+    //the mean errors of the double-precision build are 0.0064042 on CT and 0.0083880 on CP (118 points)
+    const char* filenames3[7] = {
+        "../validation/apc_10x7sf/uiuc_data/apcsf_10x7_kt0828_3008.txt",
+        "../validation/apc_10x7sf/uiuc_data/apcsf_10x7_kt0829_4011.txt",
+        "../validation/apc_10x7sf/uiuc_data/apcsf_10x7_kt0830_3999.txt",
+        "../validation/apc_10x7sf/uiuc_data/apcsf_10x7_kt0831_5003.txt",
+        "../validation/apc_10x7sf/uiuc_data/apcsf_10x7_kt0832_5006.txt",
+        "../validation/apc_10x7sf/uiuc_data/apcsf_10x7_kt0833_6006.txt",
+        "../validation/apc_10x7sf/uiuc_data/apcsf_10x7_kt0834_6014.txt"
+    };
+    const double rpm3[7] = {3008, 4011, 3999, 5003, 5006, 6006, 6014};
+    double errCT3 = 0.0;
+    double errCP3 = 0.0;
+    int npoints3 = 0;
+    bool passed3 = true;
+    for (int j=0; j<7 && passed3; ++j) {
+        FILE* fileio = fopen(filenames3[j], "r");
+        char header[MAX_LINE_LENGTH];
+        if (!fileio || !fgets(header, MAX_LINE_LENGTH, fileio)) {
+            passed3 = false;
+            if (fileio) {
+                fclose(fileio);
+            }
+            break;
+        }
+        double J, CT, CP, eta;
+        while (fscanf(fileio, "%lf %lf %lf %lf", &J, &CT, &CP, &eta) == 4) {
+            double Omega3 = rpm3[j]*M_PI/30;
+            double Uinf3 = J * Omega3/(2*M_PI) * apc10x7sf->D;
+            RotorPerformance* perf3 = qprop_ex(apc10x7sf, Uinf3, Omega3, 1.225, 1.81e-5, 0.0, NULL);
+            if (!perf3) {
+                passed3 = false;
+                break;
+            }
+            errCT3 += fabs(perf3->CT - CT);
+            errCP3 += fabs(perf3->CP - CP);
+            npoints3 += 1;
+            free_rotor_performance(perf3);
+        }
+        fclose(fileio);
+    }
+    errCT3 /= (npoints3 > 0)? npoints3 : 1;
+    errCP3 /= (npoints3 > 0)? npoints3 : 1;
+    //printf("%d %.7f %.7f\n", npoints3, errCT3, errCP3);
+    if (passed3 && npoints3 > 0
+            && fabs(errCT3 - 0.0064042) <= 1e-6
+            && fabs(errCP3 - 0.0083880) <= 1e-6) {
+        printf("TEST 15.3 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 15.3 - FAILED :(\n");
+        free_rotor(apc10x7sf);
+        free_airfoil(naca4412);
+        return 0;
+    }
+
+    free_rotor(apc10x7sf);
+    free_airfoil(naca4412);
+    return 0;
+}
@@ -0,0 +1,134 @@
+/*******************************************************************************
+    Testing program for the fast approximations of the transcendental functions (QPROP_FAST_MATH)
+
+    How to run:
+    gcc 16_test_fast_math.c -o 16_test_fast_math -lm -Wall -Wextra
+    ./16_test_fast_math
+
+    Author: Andrea Pavan
+    License: MIT
+*******************************************************************************/
+#include <math.h>
+#include <stdio.h>
+#define QPROP_FAST_MATH
+#include "../src/qprop.c"
+
+int main() {
+    //load NACA-4412 polars
+    const char* filenames1[10] = {
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.030_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.040_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.060_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.080_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.100_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.130_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.160_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.200_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.300_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.500_M0.00_N6.0.txt"
+    };
+    Airfoil* naca4412 = import_xfoil_polars(filenames1, 10);
+
+    //load propeller geometry from APC file
+    Rotor* apc10x7sf = import_rotor_geometry_apc("../validation/apc_10x7sf/10x7SF-PERF.PE0", naca4412);
+    double Omega = 6014*M_PI/30;
+
+
+    //test #1: maximum errors of the approximations against libm, in the ranges used by the residual
+    double errsin1 = 0.0;
+    double errcos1 = 0.0;
+    double erratan1 = 0.0;
+    double errexp1 = 0.0;
+    double erracos1 = 0.0;
+    for (int k=0; k<=200000; ++k) {
+        double t = k/200000.0;
+        double s, c;
+        fast_sincos(M_PI*(t - 0.5), &s, &c);
+        errsin1 = fmax(errsin1, fabs(s - sin(M_PI*(t - 0.5))));
+        errcos1 = fmax(errcos1, fabs(c - cos(M_PI*(t - 0.5))));
+        double x = tan(M_PI*(t - 0.5)*0.999999);
+        erratan1 = fmax(erratan1, fabs(fast_atan(x) - atan(x)));
+        errexp1 = fmax(errexp1, fabs(fast_exp(-50*t) - exp(-50*t))/exp(-50*t));
+        erracos1 = fmax(erracos1, fabs(fast_acos(t) - acos(t)));
+    }
+    //printf("%e %e %e %e %e\n", errsin1, errcos1, erratan1, errexp1, erracos1);
+    if (qprop_fast_math()
+            && errsin1 <= 1e-13 && errcos1 <= 1e-13 && erratan1 <= 1e-13 && errexp1 <= 1e-13 && erracos1 <= 1e-13
+            && fast_atan(0.0) == 0.0 && fabs(fast_atan(INFINITY) - M_PI/2) <= 1e-15
+            && fast_exp(-1000.0) >= 0.0 && fast_exp(-1000.0) < 1e-300 && isnan(fast_exp(NAN)) && fast_exp(INFINITY) > 1e307) {
+        printf("TEST 16.1 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 16.1 - FAILED :(\n");
+        free_rotor(apc10x7sf);
+        free_airfoil(naca4412);
+        return 0;
+    }
+
+
+    //test #2: tip loss factor F = acos(exp(-f))*2/pi, from the hub (large f) to the tip (f -> 0)
+    double errF2 = 0.0;
+    for (int k=1; k<=100000; ++k) {
+        double f = 1e-6*pow(5e7, k/100000.0);
+        double F = fast_acos(fast_exp(-f)) * 2.0 / PI;
+        errF2 = fmax(errF2, fabs(F - acos(exp(-f)) * 2.0 / PI));
+    }
+    //printf("%e\n", errF2);
+    if (errF2 <= 1e-13) {
+        printf("TEST 16.2 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 16.2 - FAILED :(\n");
+        free_rotor(apc10x7sf);
+        free_airfoil(naca4412);
+        return 0;
+    }
+
+
+    //test #3: results against the results of test 5, computed with the functions of libm
+    //(Brent with the scalar residual, bisection with the batched residual)
+    const double T3ref[15] = {
+        7.811303879404407, 7.5809187450271835, 7.32061016853633, 7.02562891997085, 6.6646208983089545,
+        6.245346524572363, 5.797827666347191, 5.321703109325795, 4.813713635410416, 4.279056143723284,
+        3.7151404055268156, 3.1285953514663483, 2.472376199831624, 1.7951408123607697, 1.1348963862887862
+    };
+    const double Q3ref[15] = {
+        0.14308075154669447, 0.14524469873222853, 0.14681290420213122, 0.1477194182109727, 0.14733995874807745,
+        0.14523447152924293, 0.1417658418125231, 0.13687424390996958, 0.13036405148150873, 0.122229083381802,
+        0.11227835761023904, 0.10054394413268984, 0.08568417842799038, 0.06960429493382134, 0.05252953779296362
+    };
+    QPropOptions options3 = qprop_default_options();
+    double maxerr3 = 0.0;
+    bool passed3 = true;
+    for (int solver=0; solver<2 && passed3; ++solver) {
+        options3.solver = (solver == 0)? QPROP_SOLVER_BRENT : QPROP_SOLVER_BISECTION;
+        for (int k=0; k<15; ++k) {
+            RotorPerformance* perf3 = qprop_ex(apc10x7sf, 1.2729633333333334*(k+1), Omega, 1.225, 1.81e-5, 0.0, &options3);
+            if (!perf3 || perf3->status != QPROP_OK) {
+                passed3 = false;
+                if (perf3) {
+                    free_rotor_performance(perf3);
+                }
+                break;
+            }
+            maxerr3 = fmax(maxerr3, fabs(perf3->T - T3ref[k])/T3ref[k]);
+            maxerr3 = fmax(maxerr3, fabs(perf3->Q - Q3ref[k])/Q3ref[k]);
+            free_rotor_performance(perf3);
+        }
+    }
+    //printf("%e\n", maxerr3);
+    if (passed3 && maxerr3 <= 1e-6) {
+        printf("TEST 16.3 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 16.3 - FAILED :(\n");
+        free_rotor(apc10x7sf);
+        free_airfoil(naca4412);
+        return 0;
+    }
+
+
+    free_rotor(apc10x7sf);
+    free_airfoil(naca4412);
+    return 0;
+}
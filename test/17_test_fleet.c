@@ -0,0 +1,148 @@
+/*******************************************************************************
+    Testing program for the fleet analyses of multiple rotors
+
+    How to run:
+    gcc 17_test_fleet.c -o 17_test_fleet -lm -pthread -Wall -Wextra
+    ./17_test_fleet
+
+    Author: Andrea Pavan
+    License: MIT
+*******************************************************************************/
+#include <math.h>
+#include <stdio.h>
+#define QPROP_THREADS
+#include "../src/qprop.c"
+
+int main() {
+    //load NACA-4412 polars twice (two identical airfoils) and Clark-Y polars
+    const char* filenames1[10] = {
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.030_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.040_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.060_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.080_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.100_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.130_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.160_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.200_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.300_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.500_M0.00_N6.0.txt"
+    };
+    const char* filenames2[10] = {
+        "../validation/apc_4.2x4/airfoil_polar_clarky_Ncrit=7/CLARK Y AIRFOIL_T1_Re0.030_M0.00_N7.0.txt",
+        "../validation/apc_4.2x4/airfoil_polar_clarky_Ncrit=7/CLARK Y AIRFOIL_T1_Re0.040_M0.00_N7.0.txt",
+        "../validation/apc_4.2x4/airfoil_polar_clarky_Ncrit=7/CLARK Y AIRFOIL_T1_Re0.060_M0.00_N7.0.txt",
+        "../validation/apc_4.2x4/airfoil_polar_clarky_Ncrit=7/CLARK Y AIRFOIL_T1_Re0.080_M0.00_N7.0.txt",
+        "../validation/apc_4.2x4/airfoil_polar_clarky_Ncrit=7/CLARK Y AIRFOIL_T1_Re0.100_M0.00_N7.0.txt",
+        "../validation/apc_4.2x4/airfoil_polar_clarky_Ncrit=7/CLARK Y AIRFOIL_T1_Re0.130_M0.00_N7.0.txt",
+        "../validation/apc_4.2x4/airfoil_polar_clarky_Ncrit=7/CLARK Y AIRFOIL_T1_Re0.160_M0.00_N7.0.txt",
+        "../validation/apc_4.2x4/airfoil_polar_clarky_Ncrit=7/CLARK Y AIRFOIL_T1_Re0.200_M0.00_N7.0.txt",
+        "../validation/apc_4.2x4/airfoil_polar_clarky_Ncrit=7/CLARK Y AIRFOIL_T1_Re0.300_M0.00_N7.0.txt",
+        "../validation/apc_4.2x4/airfoil_polar_clarky_Ncrit=7/CLARK Y AIRFOIL_T1_Re0.500_M0.00_N7.0.txt"
+    };
+    Airfoil* naca4412 = import_xfoil_polars(filenames1, 10);
+    Airfoil* naca4412copy = import_xfoil_polars(filenames1, 10);
+    Airfoil* clarky = import_xfoil_polars(filenames2, 10);
+
+    //load a small catalog of propellers, from APC and UIUC files
+    Rotor* rotors[4] = {
+        import_rotor_geometry_apc("../validation/apc_10x7sf/10x7SF-PERF.PE0", naca4412),
+        import_rotor_geometry_uiuc("../validation/apc_10x7sf/uiuc_data/apcsf_10x7_geom.txt", naca4412copy, 10*0.0254, 2),
+        import_rotor_geometry_apc("../validation/apc_16x8e/16x8E-PERF.PE0", naca4412copy),
+        import_rotor_geometry_apc("../validation/apc_4.2x4/42x4-PERF.PE0", clarky)
+    };
+    double Uinf[40];
+    double Omega[40];
+    for (int j=0; j<40; ++j) {
+        Uinf[j] = 0.5*j;
+        Omega[j] = 6014*M_PI/30;
+    }
+
+
+    //test #1: a serial fleet analysis gives the same results of qprop_batch for each rotor,
+    //with the identical airfoils shared by the rotors
+    QPropOptions options = qprop_default_options();
+    FleetResults* fleet1 = qprop_fleet(rotors, 4, 40, Uinf, Omega, NULL, NULL, 0.0, &options);
+    bool passed1 = (fleet1 && fleet1->nrotors == 4 && fleet1->npoints == 40 && fleet1->nairfoils == 2);
+    int nfailed1 = 0;
+    for (int i=0; i<4 && passed1; ++i) {
+        double T[40], Q[40], CT[40], CP[40], J[40];
+        bool converged[40];
+        qprop_batch(rotors[i], 40, Uinf, Omega, NULL, NULL, 0.0, &options, T, Q, CT, CP, J, converged);
+        for (int j=0; j<40; ++j) {
+            int k = i*40 + j;
+            //printf("%d %d %f %f %d\n", i, j, fleet1->T[k], T[j], converged[j]);
+            nfailed1 += (converged[j])? 0 : 1;
+            if (fleet1->T[k] != T[j] || fleet1->Q[k] != Q[j] || fleet1->CT[k] != CT[j] || fleet1->CP[k] != CP[j]
+                    || fleet1->J[k] != J[j] || fleet1->converged[k] != converged[j]) {
+                passed1 = false;
+            }
+        }
+    }
+    if (passed1 && fleet1->nfailed == nfailed1) {
+        printf("TEST 17.1 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 17.1 - FAILED :(\n");
+        free_fleet_results(fleet1);
+        for (int i=0; i<4; ++i) {
+            free_rotor(rotors[i]);
+        }
+        free_airfoil(naca4412);
+        free_airfoil(naca4412copy);
+        free_airfoil(clarky);
+        return 0;
+    }
+
+
+    //test #2: the results do not depend on the number of threads
+    options.nthreads = 3;
+    FleetResults* fleet2 = qprop_fleet(rotors, 4, 40, Uinf, Omega, NULL, NULL, 0.0, &options);
+    bool passed2 = (fleet2 && fleet2->nairfoils == fleet1->nairfoils && fleet2->nfailed == fleet1->nfailed);
+    for (int k=0; k<4*40 && passed2; ++k) {
+        passed2 = (fleet2->T[k] == fleet1->T[k] && fleet2->Q[k] == fleet1->Q[k] && fleet2->converged[k] == fleet1->converged[k]);
+    }
+    free_fleet_results(fleet1);
+    free_fleet_results(fleet2);
+    if (passed2) {
+        printf("TEST 17.2 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 17.2 - FAILED :(\n");
+        for (int i=0; i<4; ++i) {
+            free_rotor(rotors[i]);
+        }
+        free_airfoil(naca4412);
+        free_airfoil(naca4412copy);
+        free_airfoil(clarky);
+        return 0;
+    }
+
+
+    //test #3: invalid arguments and empty fleets
+    Rotor* rotors3[2] = {rotors[0], NULL};
+    FleetResults* fleet3invalid = qprop_fleet(rotors3, 2, 40, Uinf, Omega, NULL, NULL, 0.0, NULL);
+    FleetResults* fleet3empty = qprop_fleet(rotors, 4, 0, NULL, NULL, NULL, NULL, 0.0, NULL);
+    bool passed3 = (!fleet3invalid && fleet3empty && fleet3empty->nrotors == 4 && fleet3empty->npoints == 0 && fleet3empty->nfailed == 0);
+    free_fleet_results(fleet3empty);
+    if (passed3) {
+        printf("TEST 17.3 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 17.3 - FAILED :(\n");
+        for (int i=0; i<4; ++i) {
+            free_rotor(rotors[i]);
+        }
+        free_airfoil(naca4412);
+        free_airfoil(naca4412copy);
+        free_airfoil(clarky);
+        return 0;
+    }
+
+    for (int i=0; i<4; ++i) {
+        free_rotor(rotors[i]);
+    }
+    free_airfoil(naca4412);
+    free_airfoil(naca4412copy);
+    free_airfoil(clarky);
+    return 0;
+}
@@ -0,0 +1,219 @@
+/*******************************************************************************
+    Testing program for the streaming of the results to CSV and binary files
+
+    How to run:
+    gcc 18_test_streaming.c -o 18_test_streaming -lm -pthread -Wall -Wextra
+    ./18_test_streaming
+
+    Author: Andrea Pavan
+    License: MIT
+*******************************************************************************/
+#include <locale.h>
+#include <math.h>
+#include <stdio.h>
+#define QPROP_THREADS
+#include "../src/qprop.c"
+
+int main() {
+    //load NACA-4412 polars
+    const char* filenames1[10] = {
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.030_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.040_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.060_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.080_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.100_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.130_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.160_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.200_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.300_M0.00_N6.0.txt",
+        "./airfoil_polar_naca4412_Ncrit=6/NACA 4412_T1_Re0.500_M0.00_N6.0.txt"
+    };
+    Airfoil* naca4412 = import_xfoil_polars(filenames1, 10);
+
+    //load propeller geometry from APC file
+    Rotor* apc10x7sf = import_rotor_geometry_apc("../validation/apc_10x7sf/10x7SF-PERF.PE0", naca4412);
+    int nelems = apc10x7sf->nsections - 1;
+    double Uinf[100];
+    double Omega[100];
+    for (int j=0; j<100; ++j) {
+        Uinf[j] = 0.25*j;
+        Omega[j] = 6014*M_PI/30;
+    }
+
+
+    //test #1: a binary file streamed in batches of 32 points by 4 threads contains the same
+    //totals and distributions of qprop_sweep, and no batch is larger than the buffer
+    QPropOptions options1 = qprop_default_options();
+    options1.nthreads = 4;
+    QPropSink* sink1 = open_qprop_sink("18_apc10x7sf_sweep.bin", QPROP_SINK_BINARY, nelems, 20);
+    bool converged1 = qprop_stream(apc10x7sf, 100, Uinf, Omega, NULL, NULL, 0.0, &options1, sink1);
+    bool closed1 = close_qprop_sink(sink1);
+    RotorPerformance** perfs1 = qprop_sweep(apc10x7sf, Uinf, Omega, 100, 1.225, 1.81e-5, 0.0, NULL);
+    bool allconverged1 = true;
+    for (int j=0; j<100; ++j) {
+        allconverged1 = allconverged1 && perfs1[j] && perfs1[j]->status == QPROP_OK;
+    }
+    size_t filesize1 = 0;
+    FILE* fileio1 = fopen("18_apc10x7sf_sweep.bin", "rb");
+    char* data1 = malloc(BINARY_HEADER_SIZE + SINK_COLUMNS*sizeof(SinkColumn) + 100*(SINK_TOTALS_COLUMNS + 6*nelems)*sizeof(double) + 64*sizeof(int64_t));
+    if (fileio1 && data1) {
+        filesize1 = fread(data1, 1, BINARY_HEADER_SIZE + SINK_COLUMNS*sizeof(SinkColumn) + 100*(SINK_TOTALS_COLUMNS + 6*nelems)*sizeof(double) + 64*sizeof(int64_t), fileio1);
+        fclose(fileio1);
+    }
+    const BinaryHeader* header1 = (const BinaryHeader*) data1;
+    bool passed1 = (sink1 && closed1 && converged1 == allconverged1 && data1
+                    && check_binary_header(header1, filesize1, "QPROPSK", "18_apc10x7sf_sweep.bin")
+                    && header1->n1 == nelems && header1->n2 == SINK_COLUMNS && header1->value == 100.0
+                    && header1->filesize == (int64_t) filesize1);
+    const SinkColumn* table1 = (const SinkColumn*) (data1 + BINARY_HEADER_SIZE);
+    for (int c=0; c<SINK_COLUMNS && passed1; ++c) {
+        passed1 = (strcmp(table1[c].name, SINK_COLUMN_NAMES[c]) == 0 && table1[c].width == ((c < SINK_TOTALS_COLUMNS)? 1 : nelems));
+    }
+    size_t offset1 = BINARY_HEADER_SIZE + SINK_COLUMNS*sizeof(SinkColumn);
+    int nbatches1 = 0;
+    int npoints1 = 0;
+    while (passed1 && offset1 < filesize1) {
+        int64_t nrows = *((const int64_t*) (data1 + offset1));
+        const double* columns = (const double*) (data1 + offset1 + sizeof(int64_t));
+        if (nrows < 1 || nrows > 32 || npoints1 + nrows > 100) {
+            passed1 = false;
+            break;
+        }
+        for (int j=0; j<nrows; ++j) {
+            const RotorPerformance* perf = perfs1[npoints1 + j];
+            const double* distributions[6] = {perf->r, perf->W, perf->phi, perf->Gamma, perf->dTdr, perf->dQdr};
+            //printf("%d %f %f\n", npoints1 + j, columns[2*nrows + j], perf->T);
+            passed1 = passed1 && (columns[j] == Uinf[npoints1 + j] && columns[nrows + j] == Omega[npoints1 + j]
+                                  && columns[2*nrows + j] == perf->T && columns[3*nrows + j] == perf->Q
+                                  && columns[4*nrows + j] == perf->CT && columns[5*nrows + j] == perf->CP
+                                  && columns[6*nrows + j] == perf->J && columns[7*nrows + j] == (perf->status == QPROP_OK));
+            for (int d=0; d<6 && passed1; ++d) {
+                const double* column = columns + SINK_TOTALS_COLUMNS*nrows + d*nrows*nelems;
+                passed1 = (memcmp(column + j*nelems, distributions[d], nelems*sizeof(double)) == 0);
+            }
+        }
+        offset1 += sizeof(int64_t) + (SINK_TOTALS_COLUMNS + 6*nelems)*nrows*sizeof(double);
+        npoints1 += nrows;
+        nbatches1 += 1;
+    }
+    free(data1);
+    free_rotor_performances(perfs1, 100);
+    remove("18_apc10x7sf_sweep.bin");
+    if (passed1 && offset1 == filesize1 && npoints1 == 100 && nbatches1 == 4) {
+        printf("TEST 18.1 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 18.1 - FAILED :(\n");
+        free_rotor(apc10x7sf);
+        free_airfoil(naca4412);
+        return 0;
+    }
+
+
+    //test #2: a CSV file with the totals of single points and of a streamed batch reads back
+    //the same values of qprop_ex and qprop_batch
+    double rho2[40];
+    for (int j=0; j<40; ++j) {
+        rho2[j] = 1.225 - 0.005*j;
+    }
+    QPropSink* sink2 = open_qprop_sink("18_apc10x7sf_sweep.csv", QPROP_SINK_CSV, 0, 16);
+    RotorPerformance* perf2 = qprop_ex(apc10x7sf, 5.0, Omega[0], 1.225, 1.81e-5, 0.0, NULL);
+    bool written2 = qprop_sink_write(sink2, perf2, 5.0, Omega[0]);
+    bool converged2 = qprop_stream(apc10x7sf, 40, Uinf, Omega, rho2, NULL, 0.0, NULL, sink2);
+    bool closed2 = close_qprop_sink(sink2);
+    double T2[40], Q2[40], CT2[40], CP2[40], J2[40];
+    bool converged2ref[40];
+    bool allconverged2 = qprop_batch(apc10x7sf, 40, Uinf, Omega, rho2, NULL, 0.0, NULL, T2, Q2, CT2, CP2, J2, converged2ref);
+    FILE* fileio2 = fopen("18_apc10x7sf_sweep.csv", "r");
+    char header2[MAX_LINE_LENGTH] = "";
+    bool passed2 = (sink2 && perf2 && written2 && closed2 && converged2 == allconverged2 && fileio2
+                    && fgets(header2, MAX_LINE_LENGTH, fileio2) && strcmp(header2, "Uinf,Omega,T,Q,CT,CP,J,converged\n") == 0);
+    int npoints2 = 0;
+    double row2[7];
+    int flag2;
+    while (passed2 && fscanf(fileio2, "%lf,%lf,%lf,%lf,%lf,%lf,%lf,%d", &row2[0], &row2[1], &row2[2], &row2[3], &row2[4], &row2[5], &row2[6], &flag2) == 8) {
+        if (npoints2 == 0) {
+            passed2 = (row2[0] == 5.0 && row2[2] == perf2->T && row2[3] == perf2->Q && row2[6] == perf2->J && flag2 == (perf2->status == QPROP_OK));
+        }
+        else if (npoints2 <= 40) {
+            int j = npoints2 - 1;
+            passed2 = (row2[0] == Uinf[j] && row2[1] == Omega[j] && row2[2] == T2[j] && row2[3] == Q2[j]
+                       && row2[4] == CT2[j] && row2[5] == CP2[j] && row2[6] == J2[j] && flag2 == converged2ref[j]);
+        }
+        npoints2 += 1;
+    }
+    if (fileio2) {
+        fclose(fileio2);
+    }
+    if (perf2) {
+        free_rotor_performance(perf2);
+    }
+    remove("18_apc10x7sf_sweep.csv");
+    if (passed2 && npoints2 == 41) {
+        printf("TEST 18.2 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 18.2 - FAILED :(\n");
+        free_rotor(apc10x7sf);
+        free_airfoil(naca4412);
+        return 0;
+    }
+
+
+    //test #3: invalid arguments are rejected
+    QPropSink* sink3invalid = open_qprop_sink("18_invalid.csv", QPROP_SINK_CSV, nelems, 0);
+    QPropSink* sink3 = open_qprop_sink("18_invalid.csv", QPROP_SINK_CSV, nelems + 1, 16);
+    RotorPerformance* perf3 = alloc_rotor_performance(apc10x7sf, true);
+    bool stream3 = qprop_stream(apc10x7sf, 10, Uinf, Omega, NULL, NULL, 0.0, NULL, sink3);
+    bool written3 = qprop_sink_write(sink3, perf3, 0.0, Omega[0]);
+    bool closed3 = close_qprop_sink(sink3);
+    bool passed3 = (!sink3invalid && sink3 && perf3 && !stream3 && !written3 && closed3);
+    if (perf3) {
+        free_rotor_performance(perf3);
+    }
+    remove("18_invalid.csv");
+    if (passed3) {
+        printf("TEST 18.3 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 18.3 - FAILED :(\n");
+        free_rotor(apc10x7sf);
+        free_airfoil(naca4412);
+        return 0;
+    }
+
+
+
+    //test #4: the numbers of the CSV files are written with a decimal point, also when the locale uses a comma
+    //NOTE: the comma locales are optional, so only the "C" locale is checked when none is installed
+    const char* locales4[] = {"", "de_DE.UTF-8", "de_DE.utf8", "it_IT.UTF-8", "it_IT.utf8", "fr_FR.UTF-8", "fr_FR.utf8"};
+    bool passed4 = true;
+    for (int k=0; k<7 && passed4; ++k) {
+        if (k > 0 && !setlocale(LC_NUMERIC, locales4[k])) {
+            continue;
+        }
+        FILE* fileio4 = tmpfile();
+        char line4[64] = "";
+        passed4 = (fileio4 && write_csv_number(fileio4, 0.1, locale_decimal_separator(), false)
+                   && write_csv_number(fileio4, -2.5e-300, locale_decimal_separator(), true)
+                   && fseek(fileio4, 0, SEEK_SET) == 0 && fgets(line4, sizeof(line4), fileio4)
+                   && strcmp(line4, "0.10000000000000001,-2.5e-300") == 0);
+        if (fileio4) {
+            fclose(fileio4);
+        }
+        setlocale(LC_NUMERIC, "C");
+        if (k > 0) {
+            break;
+        }
+    }
+    if (passed4) {
+        printf("TEST 18.4 - PASSED :)\n");
+    }
+    else {
+        printf("TEST 18.4 - FAILED :(\n");
+    }
+
+    free_rotor(apc10x7sf);
+    free_airfoil(naca4412);
+    return 0;
+}
@@ -0,0 +1,260 @@
+/*******************************************************************************
+    Benchmark of the qprop.c hot paths
+
+    It reports, for each case, the time per call, the residual evaluations per
+    call and the memory allocations per call, as CSV lines on the standard
+    output, so that results can be compared across releases.
+
+    How to run (from the test folder):
+    gcc benchmark/benchmark_qprop.c -o benchmark_qprop -lm -O2 -Wall -Wextra
+    ./benchmark_qprop [scale]
+
+    The optional scale (default: 1.0) multiplies the number of calls of each case.
+
+    Author: Andrea Pavan
+    License: MIT
+*******************************************************************************/
+#define _POSIX_C_SOURCE 199309L
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+//count the memory allocations performed by qprop.c
+static long nallocs = 0;
+static void* counted_malloc(size_t size) {
+    nallocs += 1;
+    return malloc(size);
+}
+static void* counted_calloc(size_t count, size_t size) {
+    nallocs += 1;
+    return calloc(count, size);
+}
+static void* counted_realloc(void* ptr, size_t size) {
+    nallocs += 1;
+    return realloc(ptr, size);
+}
+#define malloc(size) counted_malloc(size)
+#define calloc(count, size) counted_calloc(count, size)
+#define realloc(ptr, size) counted_realloc(ptr, size)
+#include "../../src/qprop.c"
+#undef malloc
+#undef calloc
+#undef realloc
+
+//data structure for the measurements of a benchmark case
+typedef struct {
+    double start;       //starting time (s)
+    long nallocs;       //allocations counter at the start
+    long nevals;        //residual evaluations (-1: not available)
+} Measurement;
+
+//get the current time in seconds
+double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1e-9*ts.tv_nsec;
+}
+
+//start measuring a benchmark case
+void start_measurement(Measurement* m) {
+    m->nevals = 0;
+    m->nallocs = nallocs;
+    m->start = now();
+}
+
+//stop measuring a benchmark case and print the results
+void stop_measurement(Measurement* m, const char* name, const char* solver, long ncalls) {
+    double elapsed = now() - m->start;
+    char evals[32] = "";
+    if (m->nevals >= 0) {
+        snprintf(evals, sizeof(evals), "%.1f", (double) m->nevals/ncalls);
+    }
+    printf("%s%s%s,%s,%ld,%.3f,%s,%.2f\n", name, (qprop_single_precision())? "_float" : "",
+           (qprop_fast_math())? "_fast" : "", solver, ncalls,
+           1e6*elapsed/ncalls, evals, (double) (nallocs - m->nallocs)/ncalls);
+}
+
+//count the residual evaluations of a qprop output
+long count_evals(RotorPerformance* perf) {
+    long nevals = 0;
+    for (int i=0; i<perf->nelems; ++i) {
+        nevals += perf->nevals[i];
+    }
+    return nevals;
+}
+
+int main(int argc, char* argv[]) {
+    double scale = (argc > 1)? atof(argv[1]) : 1.0;
+    if (!(scale > 0)) {
+        scale = 1.0;
+    }
+
+    //load NACA-4412 polars
+    const char* filenames[10] = {
+        "../webgui/airfoil_polars/naca4412_Ncrit=6/NACA 4412_T1_Re0.030_M0.00_N6.0.txt",
+        "../webgui/airfoil_polars/naca4412_Ncrit=6/NACA 4412_T1_Re0.040_M0.00_N6.0.txt",
+        "../webgui/airfoil_polars/naca4412_Ncrit=6/NACA 4412_T1_Re0.060_M0.00_N6.0.txt",
+        "../webgui/airfoil_polars/naca4412_Ncrit=6/NACA 4412_T1_Re0.080_M0.00_N6.0.txt",
+        "../webgui/airfoil_polars/naca4412_Ncrit=6/NACA 4412_T1_Re0.100_M0.00_N6.0.txt",
+        "../webgui/airfoil_polars/naca4412_Ncrit=6/NACA 4412_T1_Re0.130_M0.00_N6.0.txt",
+        "../webgui/airfoil_polars/naca4412_Ncrit=6/NACA 4412_T1_Re0.160_M0.00_N6.0.txt",
+        "../webgui/airfoil_polars/naca4412_Ncrit=6/NACA 4412_T1_Re0.200_M0.00_N6.0.txt",
+        "../webgui/airfoil_polars/naca4412_Ncrit=6/NACA 4412_T1_Re0.300_M0.00_N6.0.txt",
+        "../webgui/airfoil_polars/naca4412_Ncrit=6/NACA 4412_T1_Re0.500_M0.00_N6.0.txt"
+    };
+    Airfoil* naca4412 = import_xfoil_polars(filenames, 10);
+    Rotor* apc10x7sf = import_rotor_geometry_apc("../validation/apc_10x7sf/10x7SF-PERF.PE0", naca4412);
+    Rotor* apc16x8e = import_rotor_geometry_apc("../validation/apc_16x8e/16x8E-PERF.PE0", naca4412);
+    if (!naca4412 || !apc10x7sf || !apc16x8e) {
+        printf("ERROR: unable to load the benchmark data (run from the test folder)\n");
+        return 1;
+    }
+    Rotor* apc16x8e_refined = refine_rotor_sections(apc16x8e, 250);
+    double Omega = 6014*PI/30;
+    double rho = 1.225;
+    double mu = 1.81e-5;
+    QPropOptions brent = qprop_default_options();
+    Measurement m;
+    printf("benchmark,solver,calls,time_per_call_us,evals_per_call,allocs_per_call\n");
+
+    //single operating point
+    long ncalls = (long) (2000*scale) + 1;
+    start_measurement(&m);
+    for (long k=0; k<ncalls; ++k) {
+        RotorPerformance* perf = qprop(apc10x7sf, 5.0, Omega, 1e-6, 100, rho, mu, 0.0);
+        m.nevals += count_evals(perf);
+        free_rotor_performance(perf);
+    }
+    stop_measurement(&m, "qprop_single_10x7sf", "bisection", ncalls);
+
+    start_measurement(&m);
+    for (long k=0; k<ncalls; ++k) {
+        RotorPerformance* perf = qprop_ex(apc10x7sf, 5.0, Omega, rho, mu, 0.0, &brent);
+        m.nevals += count_evals(perf);
+        free_rotor_performance(perf);
+    }
+    stop_measurement(&m, "qprop_single_10x7sf", "brent", ncalls);
+
+    RotorPerformance* workspace = alloc_rotor_performance(apc10x7sf, true);
+    start_measurement(&m);
+    for (long k=0; k<ncalls; ++k) {
+        qprop_into(workspace, apc10x7sf, 5.0, Omega, rho, mu, 0.0, &brent);
+        m.nevals += count_evals(workspace);
+    }
+    stop_measurement(&m, "qprop_into_totals_10x7sf", "brent", ncalls);
+    free_rotor_performance(workspace);
+
+    //dense sweep over the advance ratio
+    const int npoints = 200;
+    double Uinf[200];
+    double Omegas[200];
+    for (int j=0; j<npoints; ++j) {
+        Uinf[j] = 0.1 + 0.1*j;
+        Omegas[j] = Omega;
+    }
+    ncalls = (long) (20*scale) + 1;
+    start_measurement(&m);
+    for (long k=0; k<ncalls; ++k) {
+        for (int j=0; j<npoints; ++j) {
+            RotorPerformance* perf = qprop_ex(apc10x7sf, Uinf[j], Omegas[j], rho, mu, 0.0, &brent);
+            if (perf) {
+                m.nevals += count_evals(perf);
+                free_rotor_performance(perf);
+            }
+        }
+    }
+    stop_measurement(&m, "sweep200_cold_10x7sf", "brent", ncalls);
+
+    start_measurement(&m);
+    for (long k=0; k<ncalls; ++k) {
+        RotorPerformance** perfs = qprop_sweep(apc10x7sf, Uinf, Omegas, npoints, rho, mu, 0.0, &brent);
+        for (int j=0; j<npoints; ++j) {
+            if (perfs[j]) {
+                m.nevals += count_evals(perfs[j]);
+            }
+        }
+        free_rotor_performances(perfs, npoints);
+    }
+    stop_measurement(&m, "sweep200_warm_10x7sf", "brent", ncalls);
+
+    //fleet of four rotors at the points of the sweep, with the airfoils of the catalog shared
+    //NOTE: the fleet results do not include the residual evaluations, so they are not reported
+    Rotor* fleet[4] = {apc10x7sf, apc16x8e, apc10x7sf, apc16x8e};
+    start_measurement(&m);
+    m.nevals = -1;
+    for (long k=0; k<ncalls; ++k) {
+        FleetResults* results = qprop_fleet(fleet, 4, npoints, Uinf, Omegas, NULL, NULL, 0.0, &brent);
+        free_fleet_results(results);
+    }
+    stop_measurement(&m, "fleet4x200_10x7sf_16x8e", "brent", ncalls);
+
+    //heavily refined rotor
+    ncalls = (long) (200*scale) + 1;
+    start_measurement(&m);
+    for (long k=0; k<ncalls; ++k) {
+        RotorPerformance* perf = qprop(apc16x8e_refined, 5.0, Omega, 1e-6, 100, rho, mu, 0.0);
+        m.nevals += count_evals(perf);
+        free_rotor_performance(perf);
+    }
+    stop_measurement(&m, "qprop_refined250_16x8e", "bisection", ncalls);
+
+    start_measurement(&m);
+    for (long k=0; k<ncalls; ++k) {
+        RotorPerformance* perf = qprop_ex(apc16x8e_refined, 5.0, Omega, rho, mu, 0.0, &brent);
+        m.nevals += count_evals(perf);
+        free_rotor_performance(perf);
+    }
+    stop_measurement(&m, "qprop_refined250_16x8e", "brent", ncalls);
+
+    //performance map lookup, with a 41x9 map of the 10x7SF rotor
+    double Jmap[41];
+    double Omegamap[9];
+    for (int i=0; i<41; ++i) {
+        Jmap[i] = 0.02*i;
+    }
+    for (int k=0; k<9; ++k) {
+        Omegamap[k] = (2000 + 1000*k)*PI/30;
+    }
+    RotorMap* map = generate_rotor_map(apc10x7sf, Jmap, 41, Omegamap, 9, rho, mu, 0.0, &brent);
+    ncalls = (long) (1000000*scale) + 1;
+    double checksum = 0.0;
+    start_measurement(&m);
+    for (long k=0; k<ncalls; ++k) {
+        RotorMapPoint point = lookup_rotor_map(map, 0.01*(k%1000), (3000 + 5*(k%997))*PI/30, rho);
+        checksum += point.T;
+    }
+    stop_measurement(&m, "lookup_rotor_map_10x7sf", "none", ncalls);
+    free_rotor_map(map);
+
+    //isolated polar interpolation
+    checksum = 0.0;
+    start_measurement(&m);
+    for (long k=0; k<ncalls; ++k) {
+        PolarPoint point;
+        interpolate_airfoil_polars_into(&point, naca4412, deg2rad(-20.0 + 40.0*(k%1000)/1000), 20000 + 500*(k%1000), 0.0);
+        checksum += point.CL;
+    }
+    m.nevals = ncalls;
+    stop_measurement(&m, "interpolate_compiled_naca4412", "none", ncalls);
+
+    Airfoil naca4412_raw = *naca4412;
+    naca4412_raw.compiled = NULL;
+    start_measurement(&m);
+    for (long k=0; k<ncalls; ++k) {
+        PolarPoint point;
+        interpolate_airfoil_polars_into(&point, &naca4412_raw, deg2rad(-20.0 + 40.0*(k%1000)/1000), 20000 + 500*(k%1000), 0.0);
+        checksum -= point.CL;
+    }
+    m.nevals = ncalls;
+    stop_measurement(&m, "interpolate_polars_naca4412", "none", ncalls);
+    if (fabs(checksum) > 1e-6*ncalls) {
+        printf("ERROR: compiled and original polars give different results\n");
+    }
+
+    free_rotor(apc16x8e_refined);
+    free_rotor(apc16x8e);
+    free_rotor(apc10x7sf);
+    free_airfoil(naca4412);
+    return 0;
+}
@@ -0,0 +1,41 @@
+#!/bin/bash
+#-------------------------------------------------------------------------------
+#   This script compiles and runs all the benchmarks in the benchmark folder.
+#   The results are printed as CSV lines (one per case) with the following
+#   columns: benchmark, solver, calls, time_per_call_us, evals_per_call,
+#   allocs_per_call. The evals_per_call column is left empty for the cases
+#   that do not report the residual evaluations (e.g. qprop_fleet).
+#   How to run:
+#       ./run_benchmarks.sh
+#   You can scale the number of calls of each case by setting BENCHMARK_SCALE:
+#       BENCHMARK_SCALE=0.1 ./run_benchmarks.sh
+#   and save the results to a file by redirecting the output:
+#       ./run_benchmarks.sh > results.csv
+#   Each benchmark is also compiled with QPROP_SINGLE_PRECISION and with
+#   QPROP_FAST_MATH, and the names of its cases get the suffixes "_float" and
+#   "_fast" respectively.
+#
+#   Author: Andrea Pavan
+#   License: MIT
+#-------------------------------------------------------------------------------
+
+BENCHMARK_SCALE=${BENCHMARK_SCALE:-1.0}
+
+#compile and run all C files in the benchmark folder (in double precision, single precision and with fast math)
+C_FILES=benchmark/*.c
+for cfile in $C_FILES; do
+    filename="$(basename "${cfile%.c}")"
+    for variant in "" "-DQPROP_SINGLE_PRECISION" "-DQPROP_FAST_MATH"; do
+        gcc "$cfile" -o "${filename}" -lm -O2 -Wall -Wextra ${variant}
+        if [ $? -ne 0 ]; then
+            echo "Compilation of ${cfile} failed." >&2
+            exit 1
+        fi
+        ./${filename} "${BENCHMARK_SCALE}"
+        if [ $? -ne 0 ]; then
+            echo "Benchmark ${filename} failed." >&2
+            exit 1
+        fi
+        rm -f "${filename}"
+    done
+done
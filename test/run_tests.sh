@@ -26,7 +26,7 @@ for cfile in $C_FILES; do
     echo ""
     echo "--- TEST ${filename} ---"
     echo ""
-    gcc "$cfile" -o "${filename}" -lm -Wall -Wextra
+    gcc "$cfile" -o "${filename}" -lm -pthread -Wall -Wextra
     if [ $? -ne 0 ]; then
         echo "Compilation of ${cfile} failed."
         exit 1
@@ -92,6 +92,34 @@ function main()
         println("TEST J6 - FAILED :(");
         return;
     end
+
+    #test 7 - analyze a prepared rotor, writing the results without copies
+    prepared7 = QProp.prepare_rotor(apc10x7sf_refined);
+    result7 = QProp.alloc_rotor_performance(prepared7);
+    converged7 = QProp.qprop_into!(result7, prepared7, Uinf, Omega);
+    result7b = QProp.qprop_ex(prepared7, Uinf, Omega);
+    if (converged7
+                && result7.T == result7b.T
+                && result7.dTdr == result7b.dTdr
+                && result7.nevals == result7b.nevals
+                && abs(result7.T - result6.T) <= 1e-5)
+        println("TEST J7 - PASSED :)");
+    else
+        println("TEST J7 - FAILED :(");
+        return;
+    end
+
+    #test 8 - batch of operating points in a single call
+    result8 = QProp.qprop_batch(prepared7, [Uinf, 2*Uinf, 3*Uinf], Omega);
+    if (size(result8.T) == (3,)
+                && all(result8.converged)
+                && abs(result8.T[1] - result6.T) <= 1e-5
+                && result8.T[3] < result8.T[2] < result8.T[1])
+        println("TEST J8 - PASSED :)");
+    else
+        println("TEST J8 - FAILED :(");
+        return;
+    end
 end
 
 main();
@@ -7,6 +7,10 @@
 #   Author: Andrea Pavan
 #   License: MIT
 #-------------------------------------------------------------------------------
+import array
+import ctypes
+import csv
+import gc
 import os
 import sys
 sys.path.insert(0, "../src/bindings/")
@@ -105,6 +109,237 @@ def main():
         qprop.free_rotor_performance(result6)
         return
 
+    #test 7 - analyze APC propeller at J=0.05 using Brent's method
+    options7 = qprop.qprop_default_options()
+    options7.solver = qprop.QPROP_SOLVER_BRENT
+    result7 = qprop.qprop_ex(apc10x7sf_refined, Uinf, Omega, options=options7)
+    if abs(result7.T - result6.T) <= 1e-5 \
+                and abs(result7.Q - result6.Q) <= 1e-6 \
+                and sum(result7.nevals[i] for i in range(result7.nelems)) < sum(result6.nevals[i] for i in range(result6.nelems)):
+        print("TEST P7 - PASSED :)")
+    else:
+        print("TEST P7 - FAILED :(")
+        qprop.free_polar(polar2)
+        qprop.free_airfoil(naca4412)
+        qprop.free_rotor(apc10x7sf)
+        qprop.free_rotor(apc10x7sf_refined)
+        qprop.free_rotor(apc10x7sf_uiuc)
+        qprop.free_rotor_performance(result6)
+        qprop.free_rotor_performance(result7)
+        return
+
+    #test 8 - reuse a totals-only output
+    result8 = qprop.alloc_rotor_performance(apc10x7sf_refined, True)
+    converged8 = qprop.qprop_into(result8, apc10x7sf_refined, Uinf, Omega, options=options7)
+    if converged8 and result8.T == result7.T and result8.Q == result7.Q and not result8.dTdr:
+        print("TEST P8 - PASSED :)")
+    else:
+        print("TEST P8 - FAILED :(")
+    qprop.free_rotor_performance(result8)
+
+    #test 9 - zero-copy input buffers and per-element arrays backed by C memory
+    polar9 = naca4412.polars[4].contents
+    alpha9 = array.array("d", [polar9.alpha[i] for i in range(polar9.size)])
+    CL9 = array.array("d", [polar9.CL[i] for i in range(polar9.size)])
+    CD9 = array.array("d", [polar9.CD[i] for i in range(polar9.size)])
+    polar9b = qprop.create_polar(polar9.Re, alpha9, CL9, CD9, polar9.size)
+    airfoil9 = qprop.create_airfoil([polar9b], 1)
+    CL9[3] += 0.1           #the C polar shares the memory of the buffers
+    result9 = qprop.qprop_sweep(apc10x7sf_refined, array.array("d", [Uinf, 2*Uinf]), [Omega, Omega], options=options7)
+    arrays9 = qprop.rotor_performance_arrays(result9[0])
+    if ctypes.addressof(polar9b.alpha.contents) == alpha9.buffer_info()[0] \
+                and airfoil9.polars[0].contents.CL[3] == CL9[3] \
+                and result9[0].T == result7.T \
+                and len(arrays9["dTdr"]) == result7.nelems \
+                and all(arrays9["dTdr"][i] == result7.dTdr[i] for i in range(result7.nelems)) \
+                and arrays9["nevals"][0] == result9[0].nevals[0] \
+                and result9[1].T < result9[0].T:
+        print("TEST P9 - PASSED :)")
+    else:
+        print("TEST P9 - FAILED :(")
+    del arrays9, result9        #the sweep outputs are freed by their finalizer
+
+    #test 10 - batch of operating points in a single call
+    result10 = qprop.qprop_batch(apc10x7sf_refined, [Uinf, 2*Uinf, 3*Uinf], Omega, options=options7)
+    if len(result10["T"]) == 3 \
+                and all(result10["converged"]) \
+                and abs(result10["T"][0] - result7.T) <= 1e-12 \
+                and result10["T"][2] < result10["T"][1] < result10["T"][0] \
+                and abs(result10["J"][1] - 2*result7.J) <= 1e-12:
+        print("TEST P10 - PASSED :)")
+    else:
+        print("TEST P10 - FAILED :(")
+
+    #test 11 - an output that did not converge is returned with its status and reported to the callback
+    messages11 = []
+    qprop.set_log_callback(lambda status, message: messages11.append((status, message)))
+    result11 = qprop.qprop(apc10x7sf_refined, Uinf, Omega, itmax=2)
+    qprop.set_log_callback(None)
+    arrays11 = qprop.rotor_performance_arrays(result11, free_on_release=True)
+    if result11.status == qprop.QPROP_ERROR_NOT_CONVERGED \
+                and not all(arrays11["converged"]) \
+                and len(messages11) == 1 \
+                and messages11[0][0] == qprop.QPROP_ERROR_NOT_CONVERGED \
+                and "did not converge" in messages11[0][1]:
+        print("TEST P11 - PASSED :)")
+    else:
+        print("TEST P11 - FAILED :(")
+    del arrays11, result11
+
+    #test 12 - statistics of the analyses (zero when the library is compiled without QPROP_STATS)
+    stats12 = qprop.QPropStats()
+    options12 = qprop.qprop_default_options()
+    options12.solver = qprop.QPROP_SOLVER_BRENT
+    options12.stats = ctypes.pointer(stats12)
+    result12 = qprop.qprop_ex(apc10x7sf_refined, Uinf, Omega, options=options12)
+    if abs(result12.T - result7.T) <= 1e-12 \
+                and (stats12.nelements == result12.nelems if qprop.stats_enabled() else stats12.nelements == 0) \
+                and stats12.nevals == (sum(result12.nevals[i] for i in range(result12.nelems)) if qprop.stats_enabled() else 0):
+        print("TEST P12 - PASSED :)")
+    else:
+        print("TEST P12 - FAILED :(")
+    qprop.free_rotor_performance(result12)
+
+    #test 13 - analytic derivatives of thrust and torque compared with finite differences
+    options13 = qprop.qprop_default_options()
+    options13.solver = qprop.QPROP_SOLVER_BRENT
+    options13.tol = 1e-12
+    result13, gradients13 = qprop.qprop_with_gradients(apc10x7sf_refined, Uinf, Omega, options=options13)
+    result13plus = qprop.qprop_ex(apc10x7sf_refined, Uinf+1e-5, Omega, options=options13)
+    result13minus = qprop.qprop_ex(apc10x7sf_refined, Uinf-1e-5, Omega, options=options13)
+    dTdUinf13 = (result13plus.T - result13minus.T)/2e-5
+    #print(result13.T, result7.T, gradients13["dTdUinf"], dTdUinf13)
+    if abs(result13.T - result7.T) <= 1e-6 \
+                and len(gradients13["dTdc"]) == apc10x7sf_refined.nsections \
+                and len(gradients13["dQdbeta"]) == apc10x7sf_refined.nsections \
+                and gradients13["dTdUinf"] < 0 \
+                and abs(gradients13["dTdUinf"] - dTdUinf13) <= 1e-6*abs(dTdUinf13):
+        print("TEST P13 - PASSED :)")
+    else:
+        print("TEST P13 - FAILED :(")
+    qprop.free_rotor_performance(result13)
+    qprop.free_rotor_performance(result13plus)
+    qprop.free_rotor_performance(result13minus)
+
+    #test 14 - rotor speed giving the thrust of test 7, starting from a different speed
+    result14, Omega14 = qprop.qprop_trim(apc10x7sf_refined, Uinf, 0.7*Omega, qprop.QPROP_TRIM_THRUST, result7.T, options=options13)
+    #print(Omega14, Omega, result14.T, result7.T)
+    if result14.status == qprop.QPROP_OK \
+                and abs(Omega14 - Omega) <= 1e-6*Omega \
+                and abs(result14.T - result7.T) <= 1e-6*result7.T:
+        print("TEST P14 - PASSED :)")
+    else:
+        print("TEST P14 - FAILED :(")
+    qprop.free_rotor_performance(result14)
+
+    #test 15 - repeated operating points are copied from the cache
+    cache15 = qprop.alloc_qprop_cache(capacity=64)
+    key15 = qprop.qprop_cache_attach(cache15, apc10x7sf_refined)
+    result15 = qprop.alloc_rotor_performance(apc10x7sf_refined, totals_only=True)
+    converged15 = [qprop.qprop_cached(cache15, key15, result15, apc10x7sf_refined, Uinf, Omega, options=options7) for k in range(3)]
+    stats15 = qprop.qprop_cache_stats(cache15)
+    if all(converged15) \
+                and result15.T == result7.T \
+                and stats15.hits == 2 and stats15.misses == 1 and stats15.entries == 1:
+        print("TEST P15 - PASSED :)")
+    else:
+        print("TEST P15 - FAILED :(")
+    qprop.free_rotor_performance(result15)
+    qprop.free_qprop_cache(cache15)
+
+    #test 16 - performance map lookup at a grid point and after a binary roundtrip
+    map16 = qprop.generate_rotor_map(apc10x7sf_refined, [0.0, result7.J, 2*result7.J], [0.8*Omega, Omega], options=options7)
+    point16 = qprop.lookup_rotor_map(map16, Uinf, Omega)
+    saved16 = qprop.save_rotor_map_binary(map16, "test_python_binding_map.bin")
+    loaded16 = qprop.load_rotor_map_binary("test_python_binding_map.bin")
+    pointloaded16 = qprop.lookup_rotor_map(loaded16, 1.1*Uinf, 0.9*Omega)
+    pointmap16 = qprop.lookup_rotor_map(map16, 1.1*Uinf, 0.9*Omega)
+    #print(point16.T, result7.T, map16.errCT, map16.errCP)
+    if saved16 and point16.inside \
+                and map16.nfailed == 0 and map16.errCT > 0 \
+                and abs(point16.T - result7.T) <= 1e-6*result7.T \
+                and abs(point16.Q - result7.Q) <= 1e-6*result7.Q \
+                and pointloaded16.T == pointmap16.T and pointloaded16.Q == pointmap16.Q:
+        print("TEST P16 - PASSED :)")
+    else:
+        print("TEST P16 - FAILED :(")
+    qprop.free_rotor_map(map16)
+    qprop.free_rotor_map(loaded16)
+    os.remove("test_python_binding_map.bin")
+
+    #test 17 - fleet analysis of two rotors sharing the same airfoil
+    Uinf17 = [0.5*Uinf, Uinf, 2*Uinf]
+    fleet17 = qprop.qprop_fleet([apc10x7sf_refined, apc10x7sf], Uinf17, Omega, options=options7)
+    batch17 = [qprop.qprop_batch(rotor, Uinf17, Omega, options=options7) for rotor in (apc10x7sf_refined, apc10x7sf)]
+    #print(fleet17["nairfoils"], fleet17["T"][0][1], result7.T)
+    if fleet17["nairfoils"] == 1 and fleet17["nfailed"] == 0 \
+                and all(list(fleet17[name][i]) == list(batch17[i][name]) for name in ("T", "Q", "CT", "CP", "J") for i in range(2)) \
+                and abs(fleet17["T"][0][1] - result7.T) <= 1e-6*result7.T:
+        print("TEST P17 - PASSED :)")
+    else:
+        print("TEST P17 - FAILED :(")
+
+    #test 18 - streaming of a sweep with distributions to a binary file and of a single point to a CSV file
+    Uinf18 = [Uinf*(1 + 0.05*k) for k in range(40)]
+    sink18 = qprop.open_qprop_sink("test_python_binding_sweep.bin", qprop.QPROP_SINK_BINARY, result7.nelems, 16)
+    streamed18 = qprop.qprop_stream(sink18, apc10x7sf_refined, Uinf18, Omega, options=options7)
+    closed18 = qprop.close_qprop_sink(sink18)
+    columns18 = qprop.read_qprop_sink("test_python_binding_sweep.bin")
+    batch18 = qprop.qprop_batch(apc10x7sf_refined, Uinf18, Omega, options=options7)
+    csv18 = qprop.open_qprop_sink("test_python_binding_sweep.csv", qprop.QPROP_SINK_CSV)
+    written18 = qprop.qprop_sink_write(csv18, result7, Uinf, Omega)
+    closedcsv18 = qprop.close_qprop_sink(csv18)
+    with open("test_python_binding_sweep.csv", "r") as fileio:
+        rows18 = list(csv.DictReader(fileio))
+    #print(columns18["T"][0], result7.T, rows18)
+    if streamed18 and closed18 and written18 and closedcsv18 \
+                and all(list(columns18[name]) == list(batch18[name]) for name in ("T", "Q", "CT", "CP", "J", "converged")) \
+                and list(columns18["Uinf"]) == Uinf18 and len(columns18["dTdr"]) == 40 \
+                and all(abs(columns18["dTdr"][0][i] - result7.dTdr[i]) <= 1e-6*result7.T for i in range(result7.nelems)) \
+                and len(rows18) == 1 and float(rows18[0]["T"]) == result7.T and rows18[0]["converged"] == "1":
+        print("TEST P18 - PASSED :)")
+    else:
+        print("TEST P18 - FAILED :(")
+    os.remove("test_python_binding_sweep.bin")
+    os.remove("test_python_binding_sweep.csv")
+
+    #test 19 - an output freed on release stays valid after its arrays are dropped, until its last reference
+    result19 = qprop.qprop_ex(apc10x7sf_refined, Uinf, Omega, options=options7)
+    arrays19 = qprop.rotor_performance_arrays(result19, free_on_release=True)
+    dTdr19 = list(arrays19["dTdr"])
+    finalizer19 = result19.owner.finalizer
+    del arrays19
+    gc.collect()
+    valid19 = finalizer19.alive and result19.T == result7.T \
+              and all(result19.dTdr[i] == dTdr19[i] for i in range(result19.nelems))
+    del result19
+    gc.collect()
+    if valid19 and not finalizer19.alive:
+        print("TEST P19 - PASSED :)")
+    else:
+        print("TEST P19 - FAILED :(")
+
+    #test 20 - a rotor with two airfoils is blended once by create_rotor, with the results of the blends on the fly
+    analytic20 = qprop.analytic_polar_curves(0.50, 5.8, -0.3, 1.2, 0.028, 0.050, 0.020, 0.5, 70000, -0.7)
+    sections20 = [qprop.create_section(0.02, qprop.deg2rad(30.0 - 2.0*i), 0.015 + 0.014*i,
+                                       naca4412 if i < 4 else analytic20) for i in range(8)]
+    rotor20 = qprop.create_rotor(0.254, 2, 8, sections20)
+    rotor20b = qprop.create_rotor(0.254, 2, 8, sections20)
+    rotor20b.elementairfoils = None
+    rotor20b.nairfoils = 2
+    result20 = qprop.qprop(rotor20, 8.0, Omega)
+    result20b = qprop.qprop(rotor20b, 8.0, Omega)
+    if rotor20.nairfoils == 3 and rotor20.elementairfoils and ctypes.addressof(rotor20.elementairfoils[3].contents) == ctypes.addressof(rotor20.airfoils[2].contents) \
+            and result20.T == result20b.T and result20.Q == result20b.Q:
+        print("TEST P20 - PASSED :)")
+    else:
+        print("TEST P20 - FAILED :(")
+    qprop.free_rotor_performance(result20)
+    qprop.free_rotor_performance(result20b)
+    del rotor20, rotor20b
+    gc.collect()
+    qprop.free_airfoil(analytic20)
+
     #completed
     qprop.free_polar(polar2)
     qprop.free_airfoil(naca4412)
@@ -112,6 +347,7 @@ def main():
     qprop.free_rotor(apc10x7sf_refined)
     qprop.free_rotor(apc10x7sf_uiuc)
     qprop.free_rotor_performance(result6)
+    qprop.free_rotor_performance(result7)
 
 if __name__ == "__main__":
     main()
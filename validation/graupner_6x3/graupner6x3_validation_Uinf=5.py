@@ -66,7 +66,7 @@ def main():
     Uinf = 5.0;                         #freestream velocity (m/s)
     Omega = 14020*math.pi/30;           #rotor speed (rad/s)
     qpropc_results = qprop.qprop(graupner6x3, Uinf, Omega, 1e-6, 200)
-    for i in range(nelems):
+    for i in range(qpropc_results.nelems):
         if abs(qpropc_results.residuals[i]) > 1e-6:
             print("ERROR while running qprop: convergence not reached in one or more elements")
             break
@@ -89,8 +89,8 @@ def main():
     #compare thrust distributions
     plt1 = plt.figure(figsize=(6,4), dpi=100)       #600x400px
     plt.plot(
-        [qpropc_results.r[i] / (D/2)        for i in range(nelems)],
-        [qpropc_results.dTdr[i]             for i in range(nelems)],
+        [qpropc_results.r[i] / (D/2)        for i in range(qpropc_results.nelems)],
+        [qpropc_results.dTdr[i]             for i in range(qpropc_results.nelems)],
         label = "qprop.c",
         linewidth = 2
     )
@@ -113,8 +113,8 @@ def main():
     #compare torque distributions
     plt2 = plt.figure(figsize=(6,4), dpi=100)       #600x400px
     plt.plot(
-        [qpropc_results.r[i] / (D/2)        for i in range(nelems)],
-        [qpropc_results.dQdr[i]             for i in range(nelems)],
+        [qpropc_results.r[i] / (D/2)        for i in range(qpropc_results.nelems)],
+        [qpropc_results.dQdr[i]             for i in range(qpropc_results.nelems)],
         label = "qprop.c",
         linewidth = 2
     )
@@ -10,9 +10,71 @@
 #include "../src/qprop.c"
 
 Airfoil* available_airfoils[] = {NULL, NULL, NULL, NULL};
-Rotor* rotor_geometry = NULL;
+//polar files of the available airfoils, loaded the first time a section uses them
+const char* available_airfoil_filenames[4][10] = {
+    {
+        "./airfoil_polars/naca4412_Ncrit=6/NACA 4412_T1_Re0.030_M0.00_N6.0.txt",
+        "./airfoil_polars/naca4412_Ncrit=6/NACA 4412_T1_Re0.040_M0.00_N6.0.txt",
+        "./airfoil_polars/naca4412_Ncrit=6/NACA 4412_T1_Re0.060_M0.00_N6.0.txt",
+        "./airfoil_polars/naca4412_Ncrit=6/NACA 4412_T1_Re0.080_M0.00_N6.0.txt",
+        "./airfoil_polars/naca4412_Ncrit=6/NACA 4412_T1_Re0.100_M0.00_N6.0.txt",
+        "./airfoil_polars/naca4412_Ncrit=6/NACA 4412_T1_Re0.130_M0.00_N6.0.txt",
+        "./airfoil_polars/naca4412_Ncrit=6/NACA 4412_T1_Re0.160_M0.00_N6.0.txt",
+        "./airfoil_polars/naca4412_Ncrit=6/NACA 4412_T1_Re0.200_M0.00_N6.0.txt",
+        "./airfoil_polars/naca4412_Ncrit=6/NACA 4412_T1_Re0.300_M0.00_N6.0.txt",
+        "./airfoil_polars/naca4412_Ncrit=6/NACA 4412_T1_Re0.500_M0.00_N6.0.txt"
+    },
+    {
+        "./airfoil_polars/naca0012_Ncrit=6/NACA 0012_T1_Re0.030_M0.00_N6.0.txt",
+        "./airfoil_polars/naca0012_Ncrit=6/NACA 0012_T1_Re0.040_M0.00_N6.0.txt",
+        "./airfoil_polars/naca0012_Ncrit=6/NACA 0012_T1_Re0.060_M0.00_N6.0.txt",
+        "./airfoil_polars/naca0012_Ncrit=6/NACA 0012_T1_Re0.080_M0.00_N6.0.txt",
+        "./airfoil_polars/naca0012_Ncrit=6/NACA 0012_T1_Re0.100_M0.00_N6.0.txt",
+        "./airfoil_polars/naca0012_Ncrit=6/NACA 0012_T1_Re0.130_M0.00_N6.0.txt",
+        "./airfoil_polars/naca0012_Ncrit=6/NACA 0012_T1_Re0.160_M0.00_N6.0.txt",
+        "./airfoil_polars/naca0012_Ncrit=6/NACA 0012_T1_Re0.200_M0.00_N6.0.txt",
+        "./airfoil_polars/naca0012_Ncrit=6/NACA 0012_T1_Re0.300_M0.00_N6.0.txt",
+        "./airfoil_polars/naca0012_Ncrit=6/NACA 0012_T1_Re0.500_M0.00_N6.0.txt"
+    },
+    {
+        "./airfoil_polars/eppler_e63_Ncrit=6/E63_T1_Re0.030_M0.00_N6.0.txt",
+        "./airfoil_polars/eppler_e63_Ncrit=6/E63_T1_Re0.040_M0.00_N6.0.txt",
+        "./airfoil_polars/eppler_e63_Ncrit=6/E63_T1_Re0.060_M0.00_N6.0.txt",
+        "./airfoil_polars/eppler_e63_Ncrit=6/E63_T1_Re0.080_M0.00_N6.0.txt",
+        "./airfoil_polars/eppler_e63_Ncrit=6/E63_T1_Re0.100_M0.00_N6.0.txt",
+        "./airfoil_polars/eppler_e63_Ncrit=6/E63_T1_Re0.130_M0.00_N6.0.txt",
+        "./airfoil_polars/eppler_e63_Ncrit=6/E63_T1_Re0.160_M0.00_N6.0.txt",
+        "./airfoil_polars/eppler_e63_Ncrit=6/E63_T1_Re0.200_M0.00_N6.0.txt",
+        "./airfoil_polars/eppler_e63_Ncrit=6/E63_T1_Re0.300_M0.00_N6.0.txt",
+        "./airfoil_polars/eppler_e63_Ncrit=6/E63_T1_Re0.500_M0.00_N6.0.txt"
+    },
+    {
+        "./airfoil_polars/clark_y_Ncrit=7/CLARK Y AIRFOIL_T1_Re0.030_M0.00_N7.0.txt",
+        "./airfoil_polars/clark_y_Ncrit=7/CLARK Y AIRFOIL_T1_Re0.040_M0.00_N7.0.txt",
+        "./airfoil_polars/clark_y_Ncrit=7/CLARK Y AIRFOIL_T1_Re0.060_M0.00_N7.0.txt",
+        "./airfoil_polars/clark_y_Ncrit=7/CLARK Y AIRFOIL_T1_Re0.080_M0.00_N7.0.txt",
+        "./airfoil_polars/clark_y_Ncrit=7/CLARK Y AIRFOIL_T1_Re0.100_M0.00_N7.0.txt",
+        "./airfoil_polars/clark_y_Ncrit=7/CLARK Y AIRFOIL_T1_Re0.130_M0.00_N7.0.txt",
+        "./airfoil_polars/clark_y_Ncrit=7/CLARK Y AIRFOIL_T1_Re0.160_M0.00_N7.0.txt",
+        "./airfoil_polars/clark_y_Ncrit=7/CLARK Y AIRFOIL_T1_Re0.200_M0.00_N7.0.txt",
+        "./airfoil_polars/clark_y_Ncrit=7/CLARK Y AIRFOIL_T1_Re0.300_M0.00_N7.0.txt",
+        "./airfoil_polars/clark_y_Ncrit=7/CLARK Y AIRFOIL_T1_Re0.500_M0.00_N7.0.txt"
+    }
+};
+Rotor* rotor_geometry = NULL;           //geometry entered by the user, kept between the analyses
+Rotor* rotor_refined = NULL;            //geometry used by the analyses (rotor_geometry itself or its refinement)
+int rotor_refined_npanels = -1;         //number of panels of rotor_refined (-1: to be rebuilt)
+
+void free_refined_geometry() {
+    if (rotor_refined && rotor_refined != rotor_geometry) {
+        free_rotor(rotor_refined);
+    }
+    rotor_refined = NULL;
+    rotor_refined_npanels = -1;
+}
 
 void initialize_geometry(double D, double B) {
+    free_refined_geometry();
     if (rotor_geometry) {
         free_rotor(rotor_geometry);
     }
@@ -27,29 +89,62 @@ void initialize_geometry(double D, double B) {
     rotor_geometry->sections = NULL;
 }
 
+//get an available airfoil, importing its polars at the first use
+Airfoil* get_available_airfoil(int airfoil_idx) {
+    if (!available_airfoils[airfoil_idx]) {
+        available_airfoils[airfoil_idx] = import_xfoil_polars(available_airfoil_filenames[airfoil_idx], 10);
+    }
+    return available_airfoils[airfoil_idx];
+}
+
 void add_geometry_section(double c, double beta, double r, int airfoil_idx) {
-    if (airfoil_idx >= 4) {
+    if (airfoil_idx < 0 || airfoil_idx >= 4) {
         printf("ERROR while running add_section(): the provided airfoil_idx (%d) exceed the number of available airfoils\n", airfoil_idx);
         return;
     }
-    push_rotor_section(rotor_geometry, c, beta, r, available_airfoils[airfoil_idx]);
+    if (!rotor_geometry) {
+        printf("ERROR while running add_section(): the geometry is not initialized\n");
+        return;
+    }
+    Airfoil* airfoil = get_available_airfoil(airfoil_idx);
+    if (!airfoil) {
+        printf("ERROR while running add_section(): unable to load the polars of airfoil #%d\n", airfoil_idx);
+        return;
+    }
+    free_refined_geometry();
+    push_rotor_section(rotor_geometry, c, beta, r, airfoil);
     rotor_geometry->D = (2*r > rotor_geometry->D)? 2*r : rotor_geometry->D;
     //printf("Added section #%d (r=%fm)\n", rotor_geometry->nsections-1, rotor_geometry->sections[rotor_geometry->nsections-1].r);
 }
 
-void run_analysis(double Omega, double Uinf, double rho, double mu, int Npanels) {
-    //create rotor
-    if (!rotor_geometry || (rotor_geometry && rotor_geometry->nsections <= 0)) {
-        printf("Invalid rotor geometry");
-        return;
+//return the geometry refined with Npanels panels, rebuilding it only when the geometry or Npanels change
+Rotor* get_refined_geometry(int Npanels) {
+    if (!rotor_geometry || rotor_geometry->nsections <= 0) {
+        printf("Invalid rotor geometry\n");
+        return NULL;
+    }
+    if (rotor_refined && rotor_refined_npanels == Npanels) {
+        return rotor_refined;
     }
-    Rotor* rotor_refined = NULL;
+    free_refined_geometry();
     if (Npanels+1 > rotor_geometry->nsections) {
         rotor_refined = refine_rotor_sections(rotor_geometry, Npanels+1);
     }
     else {
         rotor_refined = rotor_geometry;
     }
+    if (rotor_refined) {
+        rotor_refined_npanels = Npanels;
+    }
+    return rotor_refined;
+}
+
+void run_analysis(double Omega, double Uinf, double rho, double mu, int Npanels) {
+    //the geometry and its refinement stay resident: they are released by initialize_geometry()
+    Rotor* rotor = get_refined_geometry(Npanels);
+    if (!rotor) {
+        return;
+    }
     
     //run qprop
     EM_ASM({
@@ -58,20 +153,19 @@ void run_analysis(double Omega, double Uinf, double rho, double mu, int Npanels)
         `;
     }, "running...");
     double tol = 1e-6;
-    RotorPerformance* perf = qprop(rotor_refined, Uinf, Omega, tol, 100, rho, mu, 340.0);
+    RotorPerformance* perf = qprop(rotor, Uinf, Omega, tol, 100, rho, mu, 340.0);
     
     //check convergence
-    for (int i=0; i<perf->nelems; ++i) {
-        if (perf->residuals[i] > tol) {
-            EM_ASM({
-                document.getElementById("results").innerHTML = `
-                    <p>Status: ` + Module.UTF8ToString($0) + `</p>
-                `;
-            }, "unable to converge, please rerun the analysis");
+    if (!perf || perf->status != QPROP_OK) {
+        EM_ASM({
+            document.getElementById("results").innerHTML = `
+                <p>Status: ` + Module.UTF8ToString($0) + `</p>
+            `;
+        }, "unable to converge, please rerun the analysis");
+        if (perf) {
             free_rotor_performance(perf);
-            free_rotor(rotor_refined);
-            return;
         }
+        return;
     }
 
     //update values in results-container
@@ -84,72 +178,12 @@ void run_analysis(double Omega, double Uinf, double rho, double mu, int Npanels)
             <p>Advance Ratio J: ` + $6.toFixed(4) + `</p>
         `;
     }, "converged", perf->T, perf->CT, perf->Q, perf->Q*Omega, perf->CP, perf->J);
-    free_rotor(rotor_refined);
     free_rotor_performance(perf);
-    free_rotor(rotor_geometry);
 }
 
 int main() {
     printf("WASM Module qprop_web_interface running\n");
     initialize_geometry(0, 0);
-
-    //load airfoil polars
-    const char* naca4412_filenames[10] = {
-        "./airfoil_polars/naca4412_Ncrit=6/NACA 4412_T1_Re0.030_M0.00_N6.0.txt",
-        "./airfoil_polars/naca4412_Ncrit=6/NACA 4412_T1_Re0.040_M0.00_N6.0.txt",
-        "./airfoil_polars/naca4412_Ncrit=6/NACA 4412_T1_Re0.060_M0.00_N6.0.txt",
-        "./airfoil_polars/naca4412_Ncrit=6/NACA 4412_T1_Re0.080_M0.00_N6.0.txt",
-        "./airfoil_polars/naca4412_Ncrit=6/NACA 4412_T1_Re0.100_M0.00_N6.0.txt",
-        "./airfoil_polars/naca4412_Ncrit=6/NACA 4412_T1_Re0.130_M0.00_N6.0.txt",
-        "./airfoil_polars/naca4412_Ncrit=6/NACA 4412_T1_Re0.160_M0.00_N6.0.txt",
-        "./airfoil_polars/naca4412_Ncrit=6/NACA 4412_T1_Re0.200_M0.00_N6.0.txt",
-        "./airfoil_polars/naca4412_Ncrit=6/NACA 4412_T1_Re0.300_M0.00_N6.0.txt",
-        "./airfoil_polars/naca4412_Ncrit=6/NACA 4412_T1_Re0.500_M0.00_N6.0.txt"
-    };
-    available_airfoils[0] = import_xfoil_polars(naca4412_filenames, 10);
-    const char* naca0012_filenames[10] = {
-        "./airfoil_polars/naca0012_Ncrit=6/NACA 0012_T1_Re0.030_M0.00_N6.0.txt",
-        "./airfoil_polars/naca0012_Ncrit=6/NACA 0012_T1_Re0.040_M0.00_N6.0.txt",
-        "./airfoil_polars/naca0012_Ncrit=6/NACA 0012_T1_Re0.060_M0.00_N6.0.txt",
-        "./airfoil_polars/naca0012_Ncrit=6/NACA 0012_T1_Re0.080_M0.00_N6.0.txt",
-        "./airfoil_polars/naca0012_Ncrit=6/NACA 0012_T1_Re0.100_M0.00_N6.0.txt",
-        "./airfoil_polars/naca0012_Ncrit=6/NACA 0012_T1_Re0.130_M0.00_N6.0.txt",
-        "./airfoil_polars/naca0012_Ncrit=6/NACA 0012_T1_Re0.160_M0.00_N6.0.txt",
-        "./airfoil_polars/naca0012_Ncrit=6/NACA 0012_T1_Re0.200_M0.00_N6.0.txt",
-        "./airfoil_polars/naca0012_Ncrit=6/NACA 0012_T1_Re0.300_M0.00_N6.0.txt",
-        "./airfoil_polars/naca0012_Ncrit=6/NACA 0012_T1_Re0.500_M0.00_N6.0.txt"
-    };
-    available_airfoils[1] = import_xfoil_polars(naca0012_filenames, 10);
-    const char* eppler_e63_filenames[10] = {
-        "./airfoil_polars/eppler_e63_Ncrit=6/E63_T1_Re0.030_M0.00_N6.0.txt",
-        "./airfoil_polars/eppler_e63_Ncrit=6/E63_T1_Re0.040_M0.00_N6.0.txt",
-        "./airfoil_polars/eppler_e63_Ncrit=6/E63_T1_Re0.060_M0.00_N6.0.txt",
-        "./airfoil_polars/eppler_e63_Ncrit=6/E63_T1_Re0.080_M0.00_N6.0.txt",
-        "./airfoil_polars/eppler_e63_Ncrit=6/E63_T1_Re0.100_M0.00_N6.0.txt",
-        "./airfoil_polars/eppler_e63_Ncrit=6/E63_T1_Re0.130_M0.00_N6.0.txt",
-        "./airfoil_polars/eppler_e63_Ncrit=6/E63_T1_Re0.160_M0.00_N6.0.txt",
-        "./airfoil_polars/eppler_e63_Ncrit=6/E63_T1_Re0.200_M0.00_N6.0.txt",
-        "./airfoil_polars/eppler_e63_Ncrit=6/E63_T1_Re0.300_M0.00_N6.0.txt",
-        "./airfoil_polars/eppler_e63_Ncrit=6/E63_T1_Re0.500_M0.00_N6.0.txt"
-    };
-    available_airfoils[2] = import_xfoil_polars(eppler_e63_filenames, 10);
-    const char* clark_y_filenames[10] = {
-        "./airfoil_polars/clark_y_Ncrit=7/CLARK Y AIRFOIL_T1_Re0.030_M0.00_N7.0.txt",
-        "./airfoil_polars/clark_y_Ncrit=7/CLARK Y AIRFOIL_T1_Re0.040_M0.00_N7.0.txt",
-        "./airfoil_polars/clark_y_Ncrit=7/CLARK Y AIRFOIL_T1_Re0.060_M0.00_N7.0.txt",
-        "./airfoil_polars/clark_y_Ncrit=7/CLARK Y AIRFOIL_T1_Re0.080_M0.00_N7.0.txt",
-        "./airfoil_polars/clark_y_Ncrit=7/CLARK Y AIRFOIL_T1_Re0.100_M0.00_N7.0.txt",
-        "./airfoil_polars/clark_y_Ncrit=7/CLARK Y AIRFOIL_T1_Re0.130_M0.00_N7.0.txt",
-        "./airfoil_polars/clark_y_Ncrit=7/CLARK Y AIRFOIL_T1_Re0.160_M0.00_N7.0.txt",
-        "./airfoil_polars/clark_y_Ncrit=7/CLARK Y AIRFOIL_T1_Re0.200_M0.00_N7.0.txt",
-        "./airfoil_polars/clark_y_Ncrit=7/CLARK Y AIRFOIL_T1_Re0.300_M0.00_N7.0.txt",
-        "./airfoil_polars/clark_y_Ncrit=7/CLARK Y AIRFOIL_T1_Re0.500_M0.00_N7.0.txt"
-    };
-    available_airfoils[3] = import_xfoil_polars(clark_y_filenames, 10);
-    if (available_airfoils[0] && available_airfoils[1] && available_airfoils[2] && available_airfoils[3]) {
-        printf("Airfoil polars loaded correctly\n");
-        //printf("TEST - NACA4412 Re[0] CL[0] = %f\n", available_airfoils[0]->polars[0]->CL[0]);
-    }
+    //the airfoil polars are imported by add_geometry_section(), only for the airfoils in use
     return 0;
 }
-